@@ -0,0 +1,30 @@
+# Generates a large source file for measuring compile time on its own:
+#     python3 compile_large.py > compile_large.yasl
+#     yasl -C compile_large.yasl
+
+NUM_FNS = 1000
+
+print('const values = []')
+for i in range(NUM_FNS):
+    print(f'''
+if true {{
+    fn f{i}(a, b, c) {{
+        let x{i} = a + b * c
+        let total = 0
+        for let i = 0; i < a; i += 1 {{
+            let y = x{i} - i
+            if y > b {{
+                total += y
+            }} else {{
+                const z = y * c
+                total -= z
+            }}
+        }}
+        fn inner(d) {{
+            return total + x{i} + d
+        }}
+        return inner(total)
+    }}
+    const g{i} = f{i}({i % 100}, 2, 3)
+    values->push(g{i})
+}}''')
@@ -0,0 +1,71 @@
+#include "arena.h"
+
+#include <string.h>
+
+#define ARENA_MIN_CHUNK_SIZE 8192
+
+union ArenaAlign {
+	void *p;
+	double d;
+	long long l;
+};
+
+struct ArenaChunk {
+	struct ArenaChunk *next;
+	size_t size;
+	size_t used;
+	union ArenaAlign data[];
+};
+
+#define ARENA_ROUND(size) (((size) + sizeof(union ArenaAlign) - 1) / sizeof(union ArenaAlign) * sizeof(union ArenaAlign))
+
+static struct ArenaChunk *arena_new_chunk(struct ArenaChunk *const next, const size_t size) {
+	struct ArenaChunk *chunk = (struct ArenaChunk *)malloc(sizeof(struct ArenaChunk) + size);
+	chunk->next = next;
+	chunk->size = size;
+	chunk->used = 0;
+	return chunk;
+}
+
+void *arena_alloc(struct Arena *const arena, const size_t size) {
+	const size_t rounded = ARENA_ROUND(size);
+	struct ArenaChunk *chunk = arena->chunks;
+	if (!chunk || chunk->size - chunk->used < rounded) {
+		size_t chunk_size = chunk ? chunk->size * 2 : ARENA_MIN_CHUNK_SIZE;
+		while (chunk_size < rounded) {
+			chunk_size *= 2;
+		}
+		chunk = arena->chunks = arena_new_chunk(chunk, chunk_size);
+	}
+	void *ptr = (char *)chunk->data + chunk->used;
+	chunk->used += rounded;
+	return ptr;
+}
+
+char *arena_strndup(struct Arena *const arena, const char *const str, const size_t len) {
+	char *copy = (char *)arena_alloc(arena, len + 1);
+	memcpy(copy, str, len);
+	copy[len] = '\0';
+	return copy;
+}
+
+static void arena_free_chunks(struct ArenaChunk *chunk) {
+	while (chunk) {
+		struct ArenaChunk *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+}
+
+void arena_reset(struct Arena *const arena) {
+	if (!arena->chunks)
+		return;
+	arena_free_chunks(arena->chunks->next);
+	arena->chunks->next = NULL;
+	arena->chunks->used = 0;
+}
+
+void arena_cleanup(struct Arena *const arena) {
+	arena_free_chunks(arena->chunks);
+	arena->chunks = NULL;
+}
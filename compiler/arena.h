@@ -0,0 +1,26 @@
+#ifndef YASL_ARENA_H_
+#define YASL_ARENA_H_
+
+#include <stdlib.h>
+
+#define NEW_ARENA() ((struct Arena) {\
+	.chunks = NULL,\
+})
+
+/*
+ * Bump allocator for memory that lives exactly as long as one compilation, such as AST nodes.
+ * Individual allocations are never freed; everything is released at once by arena_reset or arena_cleanup.
+ */
+struct ArenaChunk;
+
+struct Arena {
+	struct ArenaChunk *chunks;  // newest chunk first, OWN
+};
+
+void *arena_alloc(struct Arena *const arena, const size_t size);
+char *arena_strndup(struct Arena *const arena, const char *const str, const size_t len);
+/* Releases every allocation, but keeps the newest chunk around for reuse. */
+void arena_reset(struct Arena *const arena);
+void arena_cleanup(struct Arena *const arena);
+
+#endif
@@ -5,52 +5,18 @@
 #include "debug.h"
 #include "yasl_conf.h"
 
-void parser_register_node(struct Parser *parser, struct Node *node);
-void parser_unregister_node(struct Parser *parser, struct Node *node);
-
-struct Node *node_clone(const struct Node *const node) {
-	if (node == NULL) return NULL;
-	struct Node *clone = (struct Node *)malloc(sizeof(struct Node) + node->children_len * sizeof(struct Node *));
-	clone->nodetype = node->nodetype;
-	clone->children_len = node->children_len;
-	for (size_t i = 0; i < clone->children_len; i++) {
-		clone->children[i] = node_clone(node->children[i]);
-	}
-
-	switch (node->nodetype) {
-	case N_BINOP:
-		clone->value.binop = node->value.binop;
-		clone->value.binop.left = node_clone(node->value.binop.left);
-		clone->value.binop.right = node_clone(node->value.binop.right);
-		break;
-	case N_UNOP:
-		clone->value.unop = node->value.unop;
-		clone->value.unop.expr = node_clone(node->value.unop.expr);
-		break;
-	case N_TRIOP:
-		clone->value.type = node->value.type;
-		break;
-	case N_INT:
-	case N_BOOL:
-	case N_FLOAT:
-	case N_CALL:
-		clone->value.ival = node->value.ival;
-		break;
-	default:
-		clone->value.sval.str_len = node->value.sval.str_len;
-		clone->value.sval.str = (char *) malloc(node->value.sval.str_len + 1);
-		clone->value.sval.str[clone->value.sval.str_len] = '\0';
-		memcpy(clone->value.sval.str, node->value.sval.str, clone->value.sval.str_len);
-	}
+void *parser_alloc(struct Parser *parser, const size_t size);
+char *parser_copy_str(struct Parser *parser, const char *const str, const size_t len);
+size_t parser_intern_name(struct Parser *parser, const char *const name, const size_t len);
+const char *parser_get_name(struct Parser *parser, const size_t id);
 
-	clone->line = node->line;
-	return clone;
+static struct Node *alloc_node(struct Parser *parser, const size_t n) {
+	return (struct Node *)parser_alloc(parser, sizeof(struct Node) + sizeof(struct Node *) * n);
 }
 
 static struct Node *new_Node(struct Parser *parser, const enum NodeType nodetype, const size_t line, const size_t name_len,
-		char *const name /* OWN */, const size_t n, ... /* OWN */) {
-	struct Node *const node = (struct Node *)malloc(sizeof(struct Node) + sizeof(struct Node *) * n);
-	node->next = NULL;
+		char *const name, const size_t n, ...) {
+	struct Node *const node = alloc_node(parser, n);
 	node->nodetype = nodetype;
 	node->children_len = n;
 
@@ -65,7 +31,19 @@ static struct Node *new_Node(struct Parser *parser, const enum NodeType nodetype
 	}
 	va_end(children);
 
-	parser_register_node(parser, node);
+	return node;
+}
+
+/*
+ * Sets the name of a node to the interned copy of name, so that nodes never own their names.
+ */
+static struct Node *set_name(struct Parser *parser, struct Node *const node, const char *const name) {
+	if (name) {
+		node->value.sval.id = parser_intern_name(parser, name, node->value.sval.str_len);
+		node->value.sval.str = (char *)parser_get_name(parser, node->value.sval.id);
+	} else {
+		node->value.sval.id = 0;
+	}
 	return node;
 }
 
@@ -145,32 +123,43 @@ DEF_GETTER(name, E, b, 1)
 
 #define DEF_NODE_ZSTR0(name, E) \
 struct Node *new_##name(struct Parser *parser, char *name, const size_t line) {\
-	return new_Node_0(parser, E, name, name ? strlen(name) : 0, line);\
+	const size_t len = name ? strlen(name) : 0;\
+	return set_name(parser, new_Node_0(parser, E, NULL, len, line), name);\
 }\
 DEF_GETNAME(name, E)
 
 #define DEF_NODE_ZSTR1(name, E, a) \
 struct Node *new_##name(struct Parser *parser, const struct Node *const a, char *name, const size_t line) {\
-	return new_Node_1(parser, E, a, name, name ? strlen(name) : 0, line);\
+	const size_t len = name ? strlen(name) : 0;\
+	return set_name(parser, new_Node_1(parser, E, a, NULL, len, line), name);\
 }\
 DEF_GETNAME(name, E)\
 DEF_GETTER(name, E, a, 0)
 
 #define DEF_NODE_ZSTR2(name, E, a, b) \
 struct Node *new_##name(struct Parser *parser, const struct Node *const a, const struct Node *const b, char *name, const size_t line) {\
-	return new_Node_2(parser, E, a, b, name, name ? strlen(name) : 0, line);\
+	const size_t len = name ? strlen(name) : 0;\
+	return set_name(parser, new_Node_2(parser, E, a, b, NULL, len, line), name);\
 }\
 DEF_GETNAME(name, E)\
 DEF_GETTER(name, E, a, 0)\
 DEF_GETTER(name, E, b, 1)
 
 
+/*
+ * Bodies start out with no children and grow by doubling, so a body with n children has room for the next power of
+ * two. Nodes live in the parser's arena, so the old allocation is simply abandoned when the body moves.
+ */
 void body_append(struct Parser *parser, struct Node **node, struct Node *const child) {
 	YASL_COMPILE_DEBUG_LOG("%s\n", "appending to block");
-	parser_unregister_node(parser, *node);
-	*node = (struct Node*)realloc(*node, sizeof(struct Node) + (++(*node)->children_len) * sizeof(struct Node *));
-	parser_register_node(parser, *node);
-	(*node)->children[(*node)->children_len - 1] = child;
+	const size_t len = (*node)->children_len;
+	if ((len & (len - 1)) == 0) {
+		struct Node *grown = alloc_node(parser, len ? 2 * len : 1);
+		memcpy(grown, *node, sizeof(struct Node) + len * sizeof(struct Node *));
+		*node = grown;
+	}
+	(*node)->children[len] = child;
+	(*node)->children_len = len + 1;
 }
 
 struct Node *body_last(struct Node *body) {
@@ -214,8 +203,7 @@ DEF_NODE_ZSTR(Let, N_LET, expr)
 DEF_NODE_ZSTR(Const, N_CONST, expr)
 
 struct Node *new_TriOp(struct Parser *parser, enum Token op, struct Node *left, struct Node *middle, struct Node *right, const size_t line) {
-	struct Node *const node = (struct Node *)malloc(sizeof(struct Node) + sizeof(struct Node *) * 3);
-	node->next = NULL;
+	struct Node *const node = alloc_node(parser, 3);
 	node->nodetype = N_TRIOP;
 	node->children_len = 3;
 	node->value.type = op;
@@ -224,36 +212,37 @@ struct Node *new_TriOp(struct Parser *parser, enum Token op, struct Node *left,
 	node->children[1] = middle;
 	node->children[2] = right;
 
-	parser_register_node(parser, node);
 	return node;
 }
 
 struct Node *new_BinOp(struct Parser *parser, enum Token op, struct Node *left, struct Node *right, const size_t line) {
-	struct Node *const node = (struct Node *)malloc(sizeof(struct Node) + sizeof(struct Node *) * 2);
-	node->next = NULL;
+	struct Node *const node = alloc_node(parser, 0);
 	node->nodetype = N_BINOP;
 	node->children_len = 0;
 	node->value.binop = ((struct BinOpNode) { op, left, right });
 	node->line = line;
 
-	parser_register_node(parser, node);
 	return node;
 }
 
 struct Node *new_UnOp(struct Parser *parser, enum Token op, struct Node *child, const size_t line) {
-	struct Node *const node = (struct Node *)malloc(sizeof(struct Node) + sizeof(struct Node *) * 1);
-	node->next = NULL;
+	struct Node *const node = alloc_node(parser, 0);
 	node->nodetype = N_UNOP;
 	node->children_len = 0;
 	node->value.unop = ((struct UnOpNode) { op, child });
 	node->line = line;
 
-	parser_register_node(parser, node);
 	return node;
 }
 
 DEF_NODE_ZSTR(Assign, N_ASSIGN, expr)
 DEF_NODE_ZSTR(Var, N_VAR)
+
+size_t Var_get_id(const struct Node *const node) {
+	YASL_ASSERT(node->nodetype == N_VAR, "Expected Var");
+	return node->value.sval.id;
+}
+
 DEF_NODE(Undef, N_UNDEF)
 
 struct Node *new_Float(struct Parser *parser, yasl_float val, const size_t line) {
@@ -274,8 +263,8 @@ struct Node *new_Boolean(struct Parser *parser, int val, const size_t line) {
 	return node;
 }
 
-struct Node *new_String(struct Parser *parser, char *value, size_t len, const size_t line) {
-	return new_Node_0(parser, N_STR, value, len, line);
+struct Node *new_String(struct Parser *parser, const char *value, size_t len, const size_t line) {
+	return new_Node_0(parser, N_STR, parser_copy_str(parser, value, len), len, line);
 }
 
 DEF_NODE(List, N_LIST, values)
@@ -293,37 +282,6 @@ struct Node *new_VariadicContext(struct Node *const expr, const int expected) {
 	}
 }
 
-void node_del(struct Node *node) {
-	if (!node) return;
-	node_del(node->next);
-	switch (node->nodetype) {
-	case N_PATALT:
-	case N_BINOP:
-	case N_UNOP:
-	case N_TRIOP:
-	case N_BOOL:
-	case N_INT:
-	case N_FLOAT:
-	case N_PATBOOL:
-	case N_PATINT:
-	case N_PATFL:
-	case N_CALL:
-		break;
-	case N_VAR:
-	case N_LET:
-	case N_STR:
-	case N_CONST:
-	case N_LETITER:
-	case N_PATCONST:
-	case N_PATLET:
-	case N_PATSTR:
-		free(node->value.sval.str);
-	default:
-		break;
-	}
-	free(node);
-}
-
 struct Node *Block_get_block(const struct Node *const node) {
 	YASL_ASSERT(node->nodetype == N_BLOCK, "Expected Block");
 	return node->children[0];
@@ -348,6 +306,11 @@ char *Decl_get_name(const struct Node *const node) {
 	return node->value.sval.str;
 }
 
+size_t Decl_get_id(const struct Node *const node) {
+	YASL_ASSERT(node->nodetype == N_LET || node->nodetype == N_CONST || node->nodetype == N_PATLET || node->nodetype == N_PATCONST, "Expected let or const");
+	return node->value.sval.id;
+}
+
 struct Node *UnOp_get_expr(const struct Node *const node) {
 	return ((node)->value.unop.expr);
 }
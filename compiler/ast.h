@@ -51,12 +51,12 @@ struct BodyNode {
 };
 
 struct Node {
-	struct Node *next;
 	enum NodeType nodetype;
 	union {
 		struct {
 			char *str;
 			size_t str_len;
+			size_t id;     // interned name, only set for nodes that bind or reference a variable
 		} sval;
 		yasl_int ival;
 		yasl_float dval;
@@ -74,8 +74,6 @@ struct Parser;
 void body_append(struct Parser *parser, struct Node **node, struct Node *const child);
 struct Node *body_last(struct Node *node);
 
-struct Node *node_clone(const struct Node *const node);
-
 bool will_var_expand(struct Node *node);
 
 #define FOR_CHILDREN(i, child, node) struct Node *child;\
@@ -169,12 +167,13 @@ struct Node *new_UnOp(struct Parser *parser, enum Token op, struct Node *child,
 struct Node *new_Float(struct Parser *parser, yasl_float val, const size_t line);
 struct Node *new_Integer(struct Parser *parser, yasl_int val, const size_t line);
 struct Node *new_Boolean(struct Parser *parser, int value, const size_t line);
-struct Node *new_String(struct Parser *parser, char *value, size_t len, const size_t line);
+struct Node *new_String(struct Parser *parser, const char *value, size_t len, const size_t line);
 
 size_t Body_get_len(const struct Node *const node);
 struct Node *Comp_get_expr(const struct Node *const node);
 struct Node *Decl_get_expr(const struct Node *const node);
 char *Decl_get_name(const struct Node *const node);
+size_t Decl_get_id(const struct Node *const node);
 char *MethodCall_get_name(const struct Node *const node);
 struct Node *MethodCall_get_params(const struct Node *const node);
 struct Node *MethodCall_get_object(const struct Node *const node);
@@ -194,7 +193,6 @@ yasl_int Integer_get_int(const struct Node *const node);
 yasl_float Float_get_float(const struct Node *const node);
 bool Boolean_get_bool(const struct Node *const node);
 char *Var_get_name(const struct Node *const node);
-
-void node_del(struct Node *node);
+size_t Var_get_id(const struct Node *const node);
 
 #endif
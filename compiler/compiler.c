@@ -47,8 +47,8 @@ static void compiler_buffers_del(const struct Compiler *const compiler) {
 
 void compiler_cleanup(struct Compiler *const compiler) {
 	compiler_tables_del(compiler);
-	scope_del(compiler->globals);
-	scope_del(compiler->stack);
+	scope_cleanup(&compiler->globals);
+	scope_cleanup(&compiler->stack);
 	env_del(compiler->params);
 	parser_cleanup(&compiler->parser);
 	compiler_buffers_del(compiler);
@@ -71,17 +71,24 @@ static inline void compiler_add_int(struct Compiler *const compiler, yasl_int n)
 	YASL_ByteBuffer_add_int(compiler->buffer, n);
 }
 
+static bool in_global_scope(const struct Compiler *const compiler) {
+	return !in_function(compiler) && compiler->stack.depth == 0;
+}
+
+static const char *get_name(const struct Compiler *const compiler, const size_t id) {
+	return names_get(&compiler->parser.names, id);
+}
+
+static struct Scope *get_scope_in_use(struct Compiler *const compiler) {
+	return in_function(compiler) ? &compiler->params->scope : &compiler->stack;
+}
+
 static void enter_scope(struct Compiler *const compiler) {
-	struct Scope **lval = in_function(compiler) ? &compiler->params->scope : &compiler->stack;
-	*lval = scope_new(*lval);
+	scope_enter(get_scope_in_use(compiler));
 }
 
 static void exit_scope(struct Compiler *const compiler) {
-	struct Scope **lval = in_function(compiler) ? &compiler->params->scope : &compiler->stack;
-	struct Scope *tmp = *lval;
-	 *lval = tmp->parent;
-	size_t num_locals = scope_num_vars_cur_only(tmp); // ->vars.count;
-	scope_del_cur_only(tmp);
+	size_t num_locals = scope_exit(get_scope_in_use(compiler));
 	while (num_locals-- > 0) {
 		compiler_add_byte(compiler, O_POP);
 	}
@@ -122,54 +129,50 @@ static inline int64_t get_index(const int64_t value) {
 	return is_const(value) ? ~value : value;
 }
 
-static struct Scope *get_scope_in_use(const struct Compiler *const compiler) {
-	return in_function(compiler) ? compiler->params->scope : compiler->stack;
-}
-
-static struct Env *get_nearest(struct Env *env, const char *const name) {
-	while (!env_contains_cur_only(env, name)) {
+static struct Env *get_nearest(struct Env *env, const size_t id) {
+	while (!env_contains_cur_only(env, id)) {
 		env = env->parent;
 	}
 	return env;
 }
 
-static void load_var_local(struct Compiler *const compiler, const struct Scope *scope, const char *const name) {
-	int64_t index = get_index(scope_get(scope, name));
+static void load_var_local(struct Compiler *const compiler, const struct Scope *scope, const size_t id) {
+	int64_t index = get_index(scope_get(scope, id));
 	compiler_add_byte(compiler, O_LLOAD);
 	compiler_add_byte(compiler, (unsigned char) index);
 }
 
-static void load_var_from_upval(struct Compiler *const compiler, const char *const name) {
+static void load_var_from_upval(struct Compiler *const compiler, const size_t id) {
 	compiler->params->isclosure = true;
 	compiler_add_byte(compiler, O_ULOAD);
-	yasl_int tmp = env_resolve_upval_index(compiler->params, compiler->stack, name);
+	yasl_int tmp = env_resolve_upval_index(compiler->params, &compiler->stack, id);
 	compiler_add_byte(compiler, (unsigned char) tmp);
 }
 
-static void load_var(struct Compiler *const compiler, const char *const name, const size_t line) {
-	if (in_function(compiler) && env_contains_cur_only(compiler->params, name)) {   // fn-local var
-		load_var_local(compiler, compiler->params->scope, name);
-	} else if (env_contains(compiler->params, name)) {                         // closure over fn-local variable
-		struct Env *curr = get_nearest(compiler->params, name);
+static void load_var(struct Compiler *const compiler, const size_t id, const size_t line) {
+	if (in_function(compiler) && env_contains_cur_only(compiler->params, id)) {   // fn-local var
+		load_var_local(compiler, &compiler->params->scope, id);
+	} else if (env_contains(compiler->params, id)) {                         // closure over fn-local variable
+		struct Env *curr = get_nearest(compiler->params, id);
 		curr->usedinclosure = true;
-		load_var_from_upval(compiler, name);
-	} else if (in_function(compiler) && scope_contains(compiler->stack, name)) {    // closure over file-local var
-		load_var_from_upval(compiler, name);
-	} else if (scope_contains(compiler->stack, name)) {                        // file-local vars
-		load_var_local(compiler, compiler->stack, name);
-	} else if (scope_contains(compiler->globals, name)) {                      // global vars
+		load_var_from_upval(compiler, id);
+	} else if (in_function(compiler) && scope_contains(&compiler->stack, id)) {    // closure over file-local var
+		load_var_from_upval(compiler, id);
+	} else if (scope_contains(&compiler->stack, id)) {                        // file-local vars
+		load_var_local(compiler, &compiler->stack, id);
+	} else if (scope_contains(&compiler->globals, id)) {                      // global vars
 		compiler_add_byte(compiler, O_GLOAD_8);
-		compiler_add_int(compiler, YASL_Table_search_zstring_int(compiler->strings, name).value.ival);
+		compiler_add_int(compiler, get_index(scope_get(&compiler->globals, id)));
 	} else {
-		compiler_print_err_undeclared_var(compiler, name, line);
+		compiler_print_err_undeclared_var(compiler, get_name(compiler, id), line);
 		handle_error(compiler);
 	}
 }
 
-static void store_var_cur_scope(struct Compiler *const compiler, const struct Scope *const scope, const char *const name, const size_t line) {
-	int64_t index = scope_get(scope, name);
+static void store_var_cur_scope(struct Compiler *const compiler, const struct Scope *const scope, const size_t id, const size_t line) {
+	int64_t index = scope_get(scope, id);
 	if (is_const(index)) {
-		compiler_print_err_const(compiler, name, line);
+		compiler_print_err_const(compiler, get_name(compiler, id), line);
 		handle_error(compiler);
 		return;
 	}
@@ -177,80 +180,76 @@ static void store_var_cur_scope(struct Compiler *const compiler, const struct Sc
 	compiler_add_byte(compiler, (unsigned char) index);
 }
 
-static void store_var_in_upval(struct Compiler *const compiler, const char *const name) {
+static void store_var_in_upval(struct Compiler *const compiler, const size_t id) {
 	compiler->params->isclosure = true;
-	yasl_int index = env_resolve_upval_index(compiler->params, compiler->stack, name);
+	yasl_int index = env_resolve_upval_index(compiler->params, &compiler->stack, id);
 	compiler_add_byte(compiler, O_USTORE);
 	compiler_add_byte(compiler, (unsigned char) index);
 }
 
-static void store_var(struct Compiler *const compiler, const char *const name, const size_t line) {
-	if (in_function(compiler) && env_contains_cur_only(compiler->params, name)) { // fn-local variable
-		store_var_cur_scope(compiler, compiler->params->scope, name, line);
-	} else if (env_contains(compiler->params, name)) {                            // closure over fn-local variable
-		struct Env *curr = get_nearest(compiler->params, name);
+static void store_var(struct Compiler *const compiler, const size_t id, const size_t line) {
+	if (in_function(compiler) && env_contains_cur_only(compiler->params, id)) { // fn-local variable
+		store_var_cur_scope(compiler, &compiler->params->scope, id, line);
+	} else if (env_contains(compiler->params, id)) {                            // closure over fn-local variable
+		struct Env *curr = get_nearest(compiler->params, id);
 		curr->usedinclosure = true;
-		int64_t index = scope_get(curr->scope, name);
+		int64_t index = scope_get(&curr->scope, id);
 		if (is_const(index))
 			goto handle_const_err;
-		store_var_in_upval(compiler, name);
-	} else if (in_function(compiler) && scope_contains(compiler->stack, name)) {  // closure over file-local var
-		int64_t index = scope_get(compiler->stack, name);
+		store_var_in_upval(compiler, id);
+	} else if (in_function(compiler) && scope_contains(&compiler->stack, id)) {  // closure over file-local var
+		int64_t index = scope_get(&compiler->stack, id);
 		if (is_const(index))
 			goto handle_const_err;
-		store_var_in_upval(compiler, name);
-	} else if (scope_contains(compiler->stack, name)) {                           // file-local vars
-		store_var_cur_scope(compiler, compiler->stack, name, line);
-	} else if (scope_contains(compiler->globals, name)) {                         // global vars
-		int64_t index = scope_get(compiler->globals, name);
+		store_var_in_upval(compiler, id);
+	} else if (scope_contains(&compiler->stack, id)) {                           // file-local vars
+		store_var_cur_scope(compiler, &compiler->stack, id, line);
+	} else if (scope_contains(&compiler->globals, id)) {                         // global vars
+		int64_t index = scope_get(&compiler->globals, id);
 		if (is_const(index))
 			goto handle_const_err;
 		compiler_add_byte(compiler, O_GSTORE_8);
-		compiler_add_int(compiler, YASL_Table_search_zstring_int(compiler->strings, name).value.ival);
+		compiler_add_int(compiler, index);
 	} else {
-		compiler_print_err_undeclared_var(compiler, name, line);
+		compiler_print_err_undeclared_var(compiler, get_name(compiler, id), line);
 		handle_error(compiler);
 	}
 	return;
 
 	handle_const_err:
-	compiler_print_err_const(compiler, name, line);
+	compiler_print_err_const(compiler, get_name(compiler, id), line);
 	handle_error(compiler);
 }
 
-static int contains_var_in_current_scope(const struct Compiler *const compiler, const char *const name) {
-	return in_function(compiler) ?
-	       scope_contains_cur_only(compiler->params->scope, name) :
-	       compiler->stack ?
-	       scope_contains_cur_only(compiler->stack, name) :
-	       scope_contains_cur_only(compiler->globals, name);
+static int contains_var_in_current_scope(struct Compiler *const compiler, const size_t id) {
+	return in_global_scope(compiler) ?
+	       scope_contains_cur_only(&compiler->globals, id) :
+	       scope_contains_cur_only(get_scope_in_use(compiler), id);
 }
 
-static int contains_var(const struct Compiler *const compiler, const char *const name) {
-	if (scope_contains(compiler->stack, name)) return true;
-	if (env_contains(compiler->params, name)) return true;
-	return scope_contains_cur_only(compiler->globals, name);
+static int contains_var(const struct Compiler *const compiler, const size_t id) {
+	if (scope_contains(&compiler->stack, id)) return true;
+	if (env_contains(compiler->params, id)) return true;
+	return scope_contains_cur_only(&compiler->globals, id);
 }
 
-static void decl_var(struct Compiler *const compiler, const char *const name, const size_t line) {
-	const size_t name_len = strlen(name);
-	struct Scope *scope = get_scope_in_use(compiler);
-	if (scope) {
-		int64_t index = scope_decl_var(scope, name);
-		if (index > 255) {
+static void decl_var(struct Compiler *const compiler, const size_t id, const size_t line) {
+	if (!in_global_scope(compiler)) {
+		// index is the new variable's slot, counting from 0, so at most 255 locals fit in a scope.
+		int64_t index = scope_decl_var(get_scope_in_use(compiler), id);
+		if (index >= 255) {
 			compiler_print_err_syntax(compiler, "Too many variables in current scope (line %" PRI_SIZET ").\n",  line);
 			handle_error(compiler);
 		}
 	} else {
-		compiler_intern_string(compiler, name, name_len);
-		scope_decl_var(compiler->globals, name);
+		// globals are looked up by name at runtime, so keep the index of the name's string constant.
+		const char *name = get_name(compiler, id);
+		scope_decl_var_with_index(&compiler->globals, id, compiler_intern_string(compiler, name, strlen(name)));
 	}
 }
 
-static void make_const(const struct Compiler * const compiler, const char *const name) {
-	struct Scope *scope = get_scope_in_use(compiler);
-	if (scope) scope_make_const(scope, name);
-	else scope_make_const(compiler->globals, name);
+static void make_const(struct Compiler * const compiler, const size_t id) {
+	scope_make_const(in_global_scope(compiler) ? &compiler->globals : get_scope_in_use(compiler), id);
 }
 
 static unsigned char *return_bytes(const struct Compiler *const compiler) {
@@ -295,6 +294,16 @@ static unsigned char *return_bytes(const struct Compiler *const compiler) {
 	return bytecode;
 }
 
+/*
+ * The AST is released in one go once a compilation finishes. Inlinable fns are AST nodes too, so they are forgotten
+ * along with it; later compilations (e.g. in the REPL) just call them normally.
+ */
+static void release_nodes(struct Compiler *const compiler) {
+	scope_clear_inline(&compiler->globals);
+	scope_clear_inline(&compiler->stack);
+	parser_release_nodes(&compiler->parser);
+}
+
 unsigned char *compile(struct Compiler *const compiler) {
 	struct Node *node;
 	gettok(&compiler->parser.lex);
@@ -304,11 +313,13 @@ unsigned char *compile(struct Compiler *const compiler) {
 		node = parse(&compiler->parser);
 		if (compiler->parser.status) {
 			compiler->status |= compiler->parser.status;
+			release_nodes(compiler);
 			return NULL;
 		}
 		eattok(&compiler->parser, T_SEMI);
 		if (compiler->parser.status) {
 			compiler->status |= compiler->parser.status;
+			release_nodes(compiler);
 			return NULL;
 		}
 		visit(compiler, node);
@@ -316,6 +327,7 @@ unsigned char *compile(struct Compiler *const compiler) {
 		compiler->buffer->count = 0;
 	}
 	exit_scope(compiler);
+	release_nodes(compiler);
 
 	return return_bytes(compiler);
 }
@@ -337,6 +349,7 @@ unsigned char *compile_REPL(struct Compiler *const compiler) {
 			compiler->buffer->count = 0;
 		}
 	}
+	release_nodes(compiler);
 
 	return return_bytes(compiler);
 }
@@ -369,9 +382,9 @@ static void visit_FnDecl(struct Compiler *const compiler, const struct Node *con
 	enter_scope(compiler);
 
 	FOR_CHILDREN(i, child, FnDecl_get_params(node)) {
-		decl_var(compiler, Decl_get_name(child), child->line);
+		decl_var(compiler, Decl_get_id(child), child->line);
 		if (child->nodetype == N_CONST) {
-			make_const(compiler, Decl_get_name(child));
+			make_const(compiler, Decl_get_id(child));
 		}
 	}
 
@@ -396,17 +409,10 @@ static void visit_FnDecl(struct Compiler *const compiler, const struct Node *con
 
 	if (compiler->params->isclosure) {
 		compiler->buffer->items[old_size - sizeof(yasl_int) - 1] = O_CCONST;
-		const size_t count = compiler->params->upval_indices.count;
+		const size_t count = compiler->params->num_upvals;
 		compiler_add_byte(compiler, (unsigned char) count);
-		const size_t start = compiler->buffer->count;
-		// TODO what's below is wrong. We need to get the right bytes for the upvals.
 		for (size_t i = 0; i < count; i++) {
-			compiler_add_byte(compiler, 0);
-		}
-		FOR_TABLE(i, item, &compiler->params->upval_indices) {
-			int64_t index = item->value.value.ival;
-			int64_t value = YASL_Table_search(&compiler->params->upval_values, item->key).value.ival;
-			compiler->buffer->items[start + index] = value;
+			compiler_add_byte(compiler, (unsigned char) compiler->params->upvals[i].value);
 		}
 	}
 
@@ -416,15 +422,138 @@ static void visit_FnDecl(struct Compiler *const compiler, const struct Node *con
 	compiler->params = tmp;
 }
 
-static void visit_Call(struct Compiler *const compiler, const struct Node *const node) {
+#define INLINE_MAX_NODES 16
+
+static int64_t param_index(const struct Node *const params, const size_t id) {
+	// later params shadow earlier ones with the same name, so search from the back.
+	for (size_t i = params->children_len; i-- > 0;) {
+		if (Decl_get_id(params->children[i]) == id) {
+			return (int64_t) i;
+		}
+	}
+	return -1;
+}
+
+static bool is_inlinable_expr(const struct Node *const node, const struct Node *const params, size_t *const budget) {
+	if ((*budget)-- == 0) return false;
+	switch (node->nodetype) {
+	case N_INT:
+	case N_FLOAT:
+	case N_BOOL:
+	case N_STR:
+	case N_UNDEF:
+		return true;
+	case N_VAR:
+		return param_index(params, Var_get_id(node)) >= 0;
+	case N_UNOP:
+		return is_inlinable_expr(UnOp_get_expr(node), params, budget);
+	case N_BINOP:
+		return is_inlinable_expr(BinOp_get_left(node), params, budget) &&
+		       is_inlinable_expr(BinOp_get_right(node), params, budget);
+	case N_TRIOP:
+		return is_inlinable_expr(TriOp_get_left(node), params, budget) &&
+		       is_inlinable_expr(TriOp_get_middle(node), params, budget) &&
+		       is_inlinable_expr(TriOp_get_right(node), params, budget);
+	default:
+		return false;
+	}
+}
+
+/*
+ * A fn can be inlined if its body is a single `return` of a small expression made up of only literals, operators and
+ * its own params. Such a fn can't recurse, close over anything, or have side effects of its own.
+ */
+static bool is_inlinable_fn(const struct Node *const fn) {
+	const struct Node *const body = FnDecl_get_body(fn);
+	if (Body_get_len(body) != 1 || body->children[0]->nodetype != N_RET) {
+		return false;
+	}
+	size_t budget = INLINE_MAX_NODES;
+	return is_inlinable_expr(Return_get_expr(body->children[0]), FnDecl_get_params(fn), &budget);
+}
+
+static bool is_inlinable_arg(const struct Node *const node) {
+	switch (node->nodetype) {
+	case N_INT:
+	case N_FLOAT:
+	case N_BOOL:
+	case N_STR:
+	case N_UNDEF:
+	case N_VAR:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Returns the declaration of the fn being called if the call can be inlined, otherwise NULL. We only substitute args
+ * that are literals or variables, since evaluating those has no side effects, so it doesn't matter where (or how many
+ * times) they end up in the inlined expression.
+ */
+static const struct Node *get_inline_fn(const struct Compiler *const compiler, const struct Node *const node) {
+	const struct Node *const object = Call_get_object(node);
+	const struct Node *const args = Call_get_params(node);
+	if (object->nodetype != N_VAR || (node->value.ival != 1 && node->value.ival != -1)) {
+		return NULL;
+	}
+
+	// resolve the name the same way load_var does, so that shadowing is respected.
+	const size_t id = Var_get_id(object);
+	const struct Scope *scope = NULL;
+	for (const struct Env *env = compiler->params; env != NULL && scope == NULL; env = env->parent) {
+		if (scope_contains(&env->scope, id)) scope = &env->scope;
+	}
+	if (scope == NULL && scope_contains(&compiler->stack, id)) scope = &compiler->stack;
+	if (scope == NULL && scope_contains(&compiler->globals, id)) scope = &compiler->globals;
+	if (scope == NULL) return NULL;
+
+	const struct Node *const fn = (const struct Node *) scope_get_inline(scope, id);
+	if (fn == NULL || Body_get_len(FnDecl_get_params(fn)) != Body_get_len(args)) {
+		return NULL;
+	}
+
+	FOR_CHILDREN(i, arg, args) {
+		if (!is_inlinable_arg(arg)) return NULL;
+	}
+
+	return fn;
+}
+
+static void visit_Call_inline(struct Compiler *const compiler, const struct Node *const node, const struct Node *const fn) {
+	const struct Node *const args = Call_get_params(node);
+
+	// make sure args are declared, even if the corresponding param is never used.
+	FOR_CHILDREN(i, arg, args) {
+		if (arg->nodetype == N_VAR) validate(compiler, arg);
+	}
+
+	compiler->inline_params = FnDecl_get_params(fn);
+	compiler->inline_args = args;
+	visit(compiler, Return_get_expr(FnDecl_get_body(fn)->children[0]));
+	compiler->inline_params = NULL;
+	compiler->inline_args = NULL;
+}
+
+static void visit_Call_helper(struct Compiler *const compiler, const struct Node *const node, const enum Opcode call) {
+	const struct Node *const fn = get_inline_fn(compiler, node);
+	if (fn) {
+		visit_Call_inline(compiler, node, fn);
+		return;
+	}
+
 	visit(compiler, Call_get_object(node));
 	compiler_add_byte(compiler, O_INIT_CALL);
 	compiler_add_byte(compiler, (unsigned char)node->value.ival);
 	visit_Body(compiler, Call_get_params(node));
-	compiler_add_byte(compiler, O_CALL);
+	compiler_add_byte(compiler, call);
 }
 
-static void visit_MethodCall(struct Compiler *const compiler, const struct Node *const node) {
+static void visit_Call(struct Compiler *const compiler, const struct Node *const node) {
+	visit_Call_helper(compiler, node, O_CALL);
+}
+
+static void visit_MethodCall_helper(struct Compiler *const compiler, const struct Node *const node, const enum Opcode call) {
 	char *str = MethodCall_get_name(node);
 	size_t len = strlen(str);
 	visit(compiler, MethodCall_get_object(node));
@@ -436,7 +565,11 @@ static void visit_MethodCall(struct Compiler *const compiler, const struct Node
 	compiler_add_int(compiler, index);
 
 	visit_Body(compiler, MethodCall_get_params(node));
-	compiler_add_byte(compiler, O_CALL);
+	compiler_add_byte(compiler, call);
+}
+
+static void visit_MethodCall(struct Compiler *const compiler, const struct Node *const node) {
+	visit_MethodCall_helper(compiler, node, O_CALL);
 }
 
 static void visit_Return(struct Compiler *const compiler, const struct Node *const node) {
@@ -445,7 +578,18 @@ static void visit_Return(struct Compiler *const compiler, const struct Node *con
 		handle_error(compiler);
 		return;
 	}
-	visit(compiler, Return_get_expr(node));
+
+	const struct Node *const expr = Return_get_expr(node);
+	if (expr->nodetype == N_CALL && !get_inline_fn(compiler, expr)) {
+		visit_Call_helper(compiler, expr, O_TCALL);
+		return;
+	}
+	if (expr->nodetype == N_MCALL) {
+		visit_MethodCall_helper(compiler, expr, O_TCALL);
+		return;
+	}
+
+	visit(compiler, expr);
 	compiler_add_byte(compiler, compiler->params->usedinclosure ? O_CRET : O_RET);
 	compiler_add_byte(compiler, (unsigned char)scope_len(get_scope_in_use(compiler)));
 }
@@ -463,7 +607,7 @@ static void visit_MultiReturn(struct Compiler *const compiler, const struct Node
 }
 
 static void visit_Export(struct Compiler *const compiler, const struct Node *const node) {
-	if (in_function(compiler) || compiler->stack && compiler->stack->parent) {
+	if (in_function(compiler) || compiler->stack.depth > 1) {
 		compiler_print_err_syntax(compiler, "`export` statement must be at top level of module (line %" PRI_SIZET ").\n", node->line);
 		handle_error(compiler);
 		return;
@@ -503,6 +647,44 @@ static inline void branch_back(struct Compiler *const compiler, int64_t index) {
 	compiler_add_int(compiler, index - compiler->buffer->count - 8);
 }
 
+/*
+ * Loops over `range(...)` skip building the range object: O_INITRANGE checks at runtime that the callee really is the
+ * builtin range, and otherwise calls it and starts an ordinary loop over the result.
+ */
+static bool is_range_call(const struct Compiler *const compiler, const struct Node *const node) {
+	if (node->nodetype != N_CALL || get_inline_fn(compiler, node)) {
+		return false;
+	}
+	const struct Node *const object = Call_get_object(node);
+	const struct Node *const args = Call_get_params(node);
+	if (object->nodetype != N_VAR || strcmp(Var_get_name(object), "range") ||
+	    Body_get_len(args) < 1 || Body_get_len(args) > 3) {
+		return false;
+	}
+	FOR_CHILDREN(i, arg, args) {
+		if (arg->nodetype == N_CALL || arg->nodetype == N_MCALL) return false;
+	}
+	return true;
+}
+
+/*
+ * Pushes a loop frame over collection. Returns true if it is a native range loop.
+ */
+static bool visit_iterable(struct Compiler *const compiler, const struct Node *const collection) {
+	if (is_range_call(compiler, collection)) {
+		const struct Node *const args = Call_get_params(collection);
+		visit(compiler, Call_get_object(collection));
+		visit_Body(compiler, args);
+		compiler_add_byte(compiler, O_INITRANGE);
+		compiler_add_byte(compiler, (unsigned char) Body_get_len(args));
+		return true;
+	}
+
+	visit(compiler, collection);
+	compiler_add_byte(compiler, O_INITFOR);
+	return false;
+}
+
 static void visit_Comp_cond(struct Compiler *const compiler, const struct Node *const cond, const struct Node *const expr) {
 	if (cond) {
 		int64_t index_third;
@@ -526,13 +708,11 @@ static void visit_Comp(struct Compiler *const compiler, const struct Node *const
 
 	struct Node *collection = LetIter_get_collection(iter);
 
-	char *name = iter->value.sval.str;
-
-	visit(compiler, collection);
+	const size_t id = iter->value.sval.id;
 
-	compiler_add_byte(compiler, O_INITFOR);
+	visit_iterable(compiler, collection);
 	compiler_add_byte(compiler, O_END);
-	decl_var(compiler, name, iter->line);
+	decl_var(compiler, id, iter->line);
 	compiler_add_byte(compiler, O_END);
 
 	int64_t index_start = compiler->buffer->count;
@@ -542,7 +722,7 @@ static void visit_Comp(struct Compiler *const compiler, const struct Node *const
 	int64_t index_second;
 	enter_conditional_false(compiler, &index_second);
 
-	store_var(compiler, name, iter->line);
+	store_var(compiler, id, iter->line);
 
 	visit_Comp_cond(compiler, cond, expr);
 
@@ -573,31 +753,56 @@ static void visit_ForIter(struct Compiler *const compiler, const struct Node *co
 	struct Node *body = ForIter_get_body(node);
 
 	struct Node *collection = LetIter_get_collection(iter);
-	char *name = iter->value.sval.str;
-
-	visit(compiler, collection);
+	const size_t id = iter->value.sval.id;
 
-	compiler_add_byte(compiler, O_INITFOR);
+	const bool isrange = visit_iterable(compiler, collection);
 	compiler_add_byte(compiler, O_END);
-	decl_var(compiler, name, iter->line);
+	decl_var(compiler, id, iter->line);
 
-	size_t index_start = compiler->buffer->count;
-	add_checkpoint(compiler, index_start);
+	if (isrange) {
+		// the break target (a BRF, like the one after O_ITER_1) sits ahead of the loop head, so that O_ITERRANGE can
+		// test, store and advance the loop variable in one instruction.
+		compiler_add_byte(compiler, O_BR_8);
+		compiler_add_int(compiler, 9);
 
-	compiler_add_byte(compiler, O_ITER_1);
+		int64_t index_break = compiler->buffer->count;
+		int64_t index_break_exit;
+		enter_conditional_false(compiler, &index_break_exit);
 
-	add_checkpoint(compiler, compiler->buffer->count);
+		int64_t index_start = compiler->buffer->count;
+		add_checkpoint(compiler, index_start);
+		add_checkpoint(compiler, index_break);
 
-	int64_t index_second;
-	enter_conditional_false(compiler, &index_second);
+		compiler_add_byte(compiler, O_ITERRANGE);
+		compiler_add_byte(compiler, (unsigned char) get_index(scope_get(get_scope_in_use(compiler), id)));
+		int64_t index_exit = compiler->buffer->count;
+		compiler_add_int(compiler, 0);
 
-	store_var(compiler, name, iter->line);
+		visit(compiler, body);
 
-	visit(compiler, body);
+		branch_back(compiler, index_start);
 
-	branch_back(compiler, index_start);
+		exit_conditional_false(compiler, &index_exit);
+		exit_conditional_false(compiler, &index_break_exit);
+	} else {
+		size_t index_start = compiler->buffer->count;
+		add_checkpoint(compiler, index_start);
 
-	exit_conditional_false(compiler, &index_second);
+		compiler_add_byte(compiler, O_ITER_1);
+
+		add_checkpoint(compiler, compiler->buffer->count);
+
+		int64_t index_second;
+		enter_conditional_false(compiler, &index_second);
+
+		store_var(compiler, id, iter->line);
+
+		visit(compiler, body);
+
+		branch_back(compiler, index_start);
+
+		exit_conditional_false(compiler, &index_second);
+	}
 
 	compiler_add_byte(compiler, O_ENDFOR);
 	exit_scope(compiler);
@@ -820,25 +1025,26 @@ static void visit_VariadicListPattern(struct Compiler *const compiler, const str
 
 static void visit_DeclPattern(struct Compiler *const compiler, const struct Node *const node, const bool isconst) {
 	char *name = Decl_get_name(node);
+	const size_t id = Decl_get_id(node);
 	YASL_Table_insert_zstring_int(&compiler->seen_bindings, name, 1);
 	if (!compiler->leftmost_pattern) {
-		if (!contains_var_in_current_scope(compiler, name)) {
+		if (!contains_var_in_current_scope(compiler, id)) {
 			compiler_print_err_syntax(compiler, "%s not bound on left side of | (line %" PRI_SIZET ").\n", name, node->line);
 			handle_error(compiler);
 			return;
 		}
 	} else {
-		if (contains_var_in_current_scope(compiler, name)) {
+		if (contains_var_in_current_scope(compiler, id)) {
 			compiler_print_err_syntax(compiler, "Illegal rebinding of %s (line %" PRI_SIZET ").\n", name, node->line);
 			handle_error(compiler);
 			return;
 		}
-		decl_var(compiler, name, node->line);
-		if (isconst) make_const(compiler, Decl_get_name(node));
+		decl_var(compiler, id, node->line);
+		if (isconst) make_const(compiler, id);
 	}
 
 	compiler_add_byte(compiler, P_BIND);
-	int64_t index = scope_get(get_scope_in_use(compiler), name);
+	int64_t index = scope_get(get_scope_in_use(compiler), id);
 	if (is_const(index) != isconst) {
 		compiler_print_err_syntax(compiler, "%s must be bound with either `const` or `let` on both sides of | (line %" PRI_SIZET ").\n", name, node->line);
 		handle_error(compiler);
@@ -1058,9 +1264,9 @@ static void visit_Echo(struct Compiler *const compiler, const struct Node *const
 }
 
 static void declare_with_let_or_const(struct Compiler *const compiler, const struct Node *const node) {
-	char *name = Decl_get_name(node);
-	if (contains_var_in_current_scope(compiler, name)) {
-		compiler_print_err_syntax(compiler, "Illegal redeclaration of %s (line %" PRI_SIZET ").\n", name, node->line);
+	const size_t id = Decl_get_id(node);
+	if (contains_var_in_current_scope(compiler, id)) {
+		compiler_print_err_syntax(compiler, "Illegal redeclaration of %s (line %" PRI_SIZET ").\n", Decl_get_name(node), node->line);
 		handle_error(compiler);
 		return;
 	}
@@ -1069,19 +1275,17 @@ static void declare_with_let_or_const(struct Compiler *const compiler, const str
 	if (expr &&
 	    expr->nodetype == N_FNDECL &&
 	    expr->value.sval.str != NULL) {
-		decl_var(compiler, name, node->line);
+		decl_var(compiler, id, node->line);
 		visit(compiler, expr);
 	} else {
 		if (expr) visit(compiler, expr);
 		else compiler_add_byte(compiler, O_NCONST);
 
-		decl_var(compiler, name, node->line);
+		decl_var(compiler, id, node->line);
 	}
 
-	struct Scope *scope = get_scope_in_use(compiler);
-
-	if (!(scope_contains(scope, name))) {
-		store_var(compiler, name, node->line);
+	if (in_global_scope(compiler)) {
+		store_var(compiler, id, node->line);
 	}
 }
 
@@ -1091,7 +1295,13 @@ static void visit_Let(struct Compiler *const compiler, const struct Node *const
 
 static void visit_Const(struct Compiler *const compiler, const struct Node *const node) {
 	declare_with_let_or_const(compiler, node);
-	make_const(compiler, Decl_get_name(node));
+	make_const(compiler, Decl_get_id(node));
+
+	const struct Node *const expr = Decl_get_expr(node);
+	if (expr && expr->nodetype == N_FNDECL && is_inlinable_fn(expr)) {
+		struct Scope *scope = in_global_scope(compiler) ? &compiler->globals : get_scope_in_use(compiler);
+		scope_set_inline(scope, Decl_get_id(node), expr);
+	}
 }
 
 static void visit_Decl(struct Compiler *const compiler, const struct Node *const node) {
@@ -1099,15 +1309,16 @@ static void visit_Decl(struct Compiler *const compiler, const struct Node *const
 
 	FOR_CHILDREN(i, child, Decl_get_lvals(node)) {
 		const char *name = child->value.sval.str;
+		const size_t id = child->value.sval.id;
 		if (child->nodetype == N_ASSIGN) {
-			if (!contains_var(compiler, name)) {
+			if (!contains_var(compiler, id)) {
 				compiler_print_err_undeclared_var(compiler, name, node->line);
 				handle_error(compiler);
 				return;
 			}
 			compiler_add_byte(compiler, O_MOVEUP_FP);
 			compiler_add_byte(compiler, (unsigned char)scope_len(get_scope_in_use(compiler)));
-			store_var(compiler, name, node->line);
+			store_var(compiler, id, node->line);
 		} else if (child->nodetype == N_SET) {
 			visit(compiler, Set_get_collection(child));
 			visit(compiler, Set_get_key(child));
@@ -1115,18 +1326,18 @@ static void visit_Decl(struct Compiler *const compiler, const struct Node *const
 			compiler_add_byte(compiler, (unsigned char)scope_len(get_scope_in_use(compiler)));
 			compiler_add_byte(compiler, O_SET);
 		} else {
-			if (contains_var_in_current_scope(compiler, name)) {
+			if (contains_var_in_current_scope(compiler, id)) {
 				compiler_print_err_syntax(compiler, "Illegal redeclaration of %s (line %" PRI_SIZET ").\n", name, node->line);
 				handle_error(compiler);
 				return;
 			}
-			decl_var(compiler, name, child->line);
-			if (!in_function(compiler) && !compiler->stack) {
+			decl_var(compiler, id, child->line);
+			if (in_global_scope(compiler)) {
 				compiler_add_byte(compiler, O_MOVEUP_FP);
 				compiler_add_byte(compiler, (unsigned char)0);
-				store_var(compiler, name, node->line);
+				store_var(compiler, id, node->line);
 			}
-			if (child->nodetype == N_CONST) make_const(compiler, name);
+			if (child->nodetype == N_CONST) make_const(compiler, id);
 		}
 	}
 }
@@ -1279,18 +1490,32 @@ static void visit_UnOp(struct Compiler *const compiler, const struct Node *const
 }
 
 static void visit_Assign(struct Compiler *const compiler, const struct Node *const node) {
-	char *name = node->value.sval.str;
-	if (!contains_var(compiler, name)) {
-		compiler_print_err_undeclared_var(compiler, name, node->line);
+	const size_t id = node->value.sval.id;
+	if (!contains_var(compiler, id)) {
+		compiler_print_err_undeclared_var(compiler, node->value.sval.str, node->line);
 		handle_error(compiler);
 		return;
 	}
 	visit(compiler, Assign_get_expr(node));
-	store_var(compiler, name, node->line);
+	store_var(compiler, id, node->line);
 }
 
 static void visit_Var(struct Compiler *const compiler, const struct Node *const node) {
-	load_var(compiler, Var_get_name(node), node->line);
+	if (compiler->inline_params) {
+		const struct Node *const params = compiler->inline_params;
+		const struct Node *const args = compiler->inline_args;
+		const int64_t index = param_index(params, Var_get_id(node));
+		YASL_ASSERT(index >= 0, "inlined fns may only refer to their own params.");
+
+		// args are resolved in the caller's scope, not substituted again.
+		compiler->inline_params = NULL;
+		compiler->inline_args = NULL;
+		visit(compiler, args->children[index]);
+		compiler->inline_params = params;
+		compiler->inline_args = args;
+		return;
+	}
+	load_var(compiler, Var_get_id(node), node->line);
 }
 
 static void visit_Undef(struct Compiler *const compiler, const struct Node *const node) {
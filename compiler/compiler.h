@@ -5,6 +5,7 @@
 
 #include "data-structures/YASL_Buffer.h"
 #include "data-structures/YASL_ByteBuffer.h"
+#include "data-structures/YASL_Table.h"
 #include "debug.h"
 #include "env.h"
 #include "parser.h"
@@ -21,11 +22,13 @@ DECL_BUFFER(size_t)
 #define NEW_COMPILER(fp)\
 ((struct Compiler) {\
 	.parser = NEW_PARSER(fp),\
-	.globals = scope_new(NULL),\
-	.stack = NULL,\
+	.globals = NEW_SCOPE(),\
+	.stack = NEW_SCOPE(),\
 	.params = NULL,\
 	.expected_returns = 1,\
 	.leftmost_pattern = true,\
+	.inline_params = NULL,\
+	.inline_args = NULL,\
 	.seen_bindings = NEW_TABLE(),\
 	.strings = YASL_Table_new(),\
 	.buffer = YASL_ByteBuffer_new(16),\
@@ -40,11 +43,13 @@ DECL_BUFFER(size_t)
 
 struct Compiler {
 	struct Parser parser;
-	struct Scope *globals;
-	struct Scope *stack;
+	struct Scope globals;
+	struct Scope stack;
 	struct Env *params;
 	int expected_returns;
 	bool leftmost_pattern;
+	const struct Node *inline_params;  // params of the fn currently being inlined, if any
+	const struct Node *inline_args;    // args substituted for the above params
 	struct YASL_Table seen_bindings;
 	struct YASL_Table *strings;
 	YASL_ByteBuffer *buffer;    // temporary buffer during code-gen
@@ -1,98 +1,114 @@
 #include "env.h"
 
-#include <stdio.h>
-#include <string.h>
-#include <stdlib.h>
-#include <interpreter/YASL_Object.h>
-
 #include "debug.h"
-#include "data-structures/YASL_String.h"
 
 struct Env *env_new(struct Env *const parent) {
 	struct Env *env = (struct Env *)malloc(sizeof(struct Env));
-	env->scope = NULL;
-	env->upval_indices = NEW_TABLE();
-	env->upval_values = NEW_TABLE();
+	env->scope = NEW_SCOPE();
+	env->upvals = NULL;
+	env->num_upvals = 0;
+	env->upvals_size = 0;
 	env->usedinclosure = false;
 	env->isclosure = false;
 	env->parent = parent;
 	return env;
 }
 
-static void YASL_Table_string_int_cleanup(struct YASL_Table *const table) {
-	for (size_t i = 0; i < table->size; i++) {
-		struct YASL_Table_Item *item = &table->items[i];
-		if (item->key.type != Y_END && item->key.type != Y_UNDEF) {
-			str_del(item->key.value.sval);
-		}
-	}
-	free(table->items);
-}
-
 void env_del(struct Env *const env) {
 	if (env == NULL) return;
-	scope_del(env->scope);
-	YASL_Table_string_int_cleanup(&env->upval_indices);
-	YASL_Table_string_int_cleanup(&env->upval_values);
+	scope_cleanup(&env->scope);
+	free(env->upvals);
 	env_del(env->parent);
 	free(env);
 }
 
-struct Scope *scope_new(struct Scope *const parent) {
-	struct Scope *scope = (struct Scope *)malloc(sizeof(struct Scope));
-	scope->parent = parent;
-	scope->vars = NEW_TABLE();
-	return scope;
+void scope_cleanup(struct Scope *const scope) {
+	free(scope->vars);
+	free(scope->starts);
+	free(scope->lookup);
 }
 
-void scope_del(struct Scope *const scope) {
-	if (scope == NULL) return;
-	scope_del(scope->parent);
-	free(scope->parent);
-	scope_del_cur_only(scope);
+static inline size_t scope_hash(const size_t id) {
+	return id * 2654435761u;
 }
 
-void scope_del_cur_only(struct Scope *const scope) {
-	YASL_Table_string_int_cleanup(&scope->vars);
-	free(scope);
+static int64_t scope_find(const struct Scope *const scope, const size_t id) {
+	if (scope->lookup_size == 0) return -1;
+	const size_t mask = scope->lookup_size - 1;
+	for (size_t i = scope_hash(id) & mask; scope->lookup[i].key != 0; i = (i + 1) & mask) {
+		if (scope->lookup[i].key == id + 1) return scope->lookup[i].pos;
+	}
+	return -1;
+}
+
+static struct ScopeSlot *scope_find_slot(struct Scope *const scope, const size_t id) {
+	const size_t mask = scope->lookup_size - 1;
+	size_t i = scope_hash(id) & mask;
+	while (scope->lookup[i].key != 0 && scope->lookup[i].key != id + 1) {
+		i = (i + 1) & mask;
+	}
+	return scope->lookup + i;
+}
+
+static void scope_resize_lookup(struct Scope *const scope) {
+	struct ScopeSlot *old = scope->lookup;
+	const size_t old_size = scope->lookup_size;
+	scope->lookup_size = old_size ? old_size * 2 : 16;
+	scope->lookup = (struct ScopeSlot *)calloc(scope->lookup_size, sizeof(struct ScopeSlot));
+	for (size_t i = 0; i < old_size; i++) {
+		if (old[i].key != 0) {
+			*scope_find_slot(scope, old[i].key - 1) = old[i];
+		}
+	}
+	free(old);
+}
+
+void scope_enter(struct Scope *const scope) {
+	if (scope->depth >= scope->starts_size) {
+		scope->starts_size = scope->starts_size ? scope->starts_size * 2 : 8;
+		scope->starts = (size_t *)realloc(scope->starts, scope->starts_size * sizeof(size_t));
+	}
+	scope->starts[scope->depth++] = scope->count;
+}
+
+size_t scope_exit(struct Scope *const scope) {
+	YASL_ASSERT(scope->depth > 0, "Cannot exit the outermost scope.");
+	const size_t start = scope->starts[--scope->depth];
+	const size_t num_vars = scope->count - start;
+	while (scope->count > start) {
+		const struct Binding *binding = scope->vars + --scope->count;
+		scope_find_slot(scope, binding->id)->pos = binding->shadowed;
+	}
+	return num_vars;
 }
 
 size_t scope_num_vars_cur_only(const struct Scope *const scope) {
-	return scope->vars.count;
+	return scope->count - (scope->depth ? scope->starts[scope->depth - 1] : 0);
 }
 
 size_t scope_len(const struct Scope *const scope) {
-	if (scope == NULL)
-		return 0;
-	return scope_num_vars_cur_only(scope) + scope_len(scope->parent);
+	return scope->count;
 }
 
-bool scope_contains_cur_only(const struct Scope *const scope, const char *const name) {
-	return YASL_Table_contains_zstring_int(&scope->vars, name);
+bool scope_contains_cur_only(const struct Scope *const scope, const size_t id) {
+	const int64_t pos = scope_find(scope, id);
+	return pos >= 0 && (size_t)pos >= scope->count - scope_num_vars_cur_only(scope);
 }
 
-bool scope_contains(const struct Scope *const scope, const char *const name) {
-	if (scope == NULL) return false;
-
-	const bool contains = scope_contains_cur_only(scope, name);
-	if (!contains && scope->parent == NULL) {
-		return false;
-	}
-	if (!contains)
-		return scope_contains(scope->parent, name);
-	return true;
+bool scope_contains(const struct Scope *const scope, const size_t id) {
+	return scope_find(scope, id) >= 0;
 }
 
-bool env_contains(const struct Env *env, const char *const name) {
+bool env_contains(const struct Env *env, const size_t id) {
 	while (env != NULL) {
-		if (scope_contains(env->scope, name)) return true;
+		if (scope_contains(&env->scope, id)) return true;
 		env = env->parent;
 	}
 	return false;
 }
 
-bool env_contains_cur_only(const struct Env *const env, const char *const name) {
-	return scope_contains(env->scope, name);
+bool env_contains_cur_only(const struct Env *const env, const size_t id) {
+	return scope_contains(&env->scope, id);
 }
 
 static int is_const(const int64_t value) {
@@ -104,81 +120,123 @@ static inline int64_t get_index(const int64_t value) {
 	return is_const(value) ? ~value : value;
 }
 
-static int64_t env_add_upval_kv(struct Env *env, const char *const name, yasl_int value) {
-	YASL_Table_insert_zstring_int(&env->upval_values, name, value);
-	int64_t index = env->upval_indices.count;
-	YASL_Table_insert_zstring_int(&env->upval_indices, name, index);
-	return index;
+static int64_t env_find_upval(const struct Env *const env, const size_t id) {
+	for (size_t i = 0; i < env->num_upvals; i++) {
+		if (env->upvals[i].id == id) return (int64_t)i;
+	}
+	return -1;
+}
+
+static int64_t env_add_upval_kv(struct Env *env, const size_t id, const int64_t value) {
+	if (env->num_upvals >= env->upvals_size) {
+		env->upvals_size = env->upvals_size ? env->upvals_size * 2 : 4;
+		env->upvals = (struct Upval *)realloc(env->upvals, env->upvals_size * sizeof(struct Upval));
+	}
+	env->upvals[env->num_upvals].id = id;
+	env->upvals[env->num_upvals].value = value;
+	return (int64_t)env->num_upvals++;
 }
 
-static int64_t env_add_upval(struct Env *env, struct Scope *stack, const char *const name) {
+static int64_t env_add_upval(struct Env *env, const struct Scope *const stack, const size_t id) {
 	env->isclosure = true;
 
-	if (!env->parent && scope_contains(stack, name)) {
-		yasl_int value = get_index(scope_get(stack, name));
-		return env_add_upval_kv(env, name, value);
+	if (!env->parent && scope_contains(stack, id)) {
+		return env_add_upval_kv(env, id, get_index(scope_get(stack, id)));
 	}
 
 	YASL_ASSERT(env->parent, "Parent cannot be null.");
 
-	if (!env_contains_cur_only(env->parent, name) && !YASL_Table_contains_zstring_int(&env->parent->upval_indices, name)) {
-		env_add_upval(env->parent, stack, name);
+	if (!env_contains_cur_only(env->parent, id) && env_find_upval(env->parent, id) < 0) {
+		env_add_upval(env->parent, stack, id);
 	}
 
-	if (env_contains_cur_only(env->parent, name)) {
+	if (env_contains_cur_only(env->parent, id)) {
 		env->parent->usedinclosure = true;
-		yasl_int value = get_index(scope_get(env->parent->scope, name));
-		return env_add_upval_kv(env, name, value);
+		return env_add_upval_kv(env, id, get_index(scope_get(&env->parent->scope, id)));
 	}
 
-	const struct YASL_Object res = YASL_Table_search_zstring_int(&env->parent->upval_indices, name);
-	if (obj_isint(&res)) {
-		yasl_int value = obj_getint(&res);
-		return env_add_upval_kv(env, name, value < 0 ? value : ~value);;
+	const int64_t index = env_find_upval(env->parent, id);
+	if (index >= 0) {
+		return env_add_upval_kv(env, id, ~index);
 	}
 
 	YASL_UNREACHED();
 	return 0;
 }
 
-int64_t env_resolve_upval_index(struct Env *const env, struct Scope *stack, const char *const name) {
-	const struct YASL_Object res = YASL_Table_search_zstring_int(&env->upval_indices, name);
+int64_t env_resolve_upval_index(struct Env *const env, const struct Scope *const stack, const size_t id) {
+	const int64_t index = env_find_upval(env, id);
 
-	if (obj_isint(&res)) {
-		return res.value.ival;
+	if (index >= 0) {
+		return index;
 	}
 
-	return env_add_upval(env, stack, name);
+	return env_add_upval(env, stack, id);
 }
 
 // Assumes that the upval in question is already in the upvals for env.
-int64_t env_resolve_upval_value(struct Env *const env, const char *const name) {
-	struct YASL_Object value = YASL_Table_search_zstring_int(&env->upval_values, name);
+int64_t env_resolve_upval_value(const struct Env *const env, const size_t id) {
+	const int64_t index = env_find_upval(env, id);
 
-	YASL_ASSERT(value.type == Y_INT, "Value must be found in upvals for env.");
+	YASL_ASSERT(index >= 0, "Value must be found in upvals for env.");
 
-	return obj_getint(&value);
+	return env->upvals[index].value;
 }
 
-int64_t scope_get(const struct Scope *const scope, const char *const name) {
-	struct YASL_Object value = YASL_Table_search_zstring_int(&scope->vars, name);
-	if (value.type == Y_END && scope->parent == NULL) {
-		YASL_ASSERT(false, "Lookup should not fail.");
+int64_t scope_get(const struct Scope *const scope, const size_t id) {
+	const int64_t pos = scope_find(scope, id);
+	YASL_ASSERT(pos >= 0, "Lookup should not fail.");
+	return scope->vars[pos].index;
+}
+
+int64_t scope_decl_var_with_index(struct Scope *const scope, const size_t id, const int64_t index) {
+	if (2 * (scope->lookup_count + 1) > scope->lookup_size) {
+		scope_resize_lookup(scope);
+	}
+	if (scope->count >= scope->size) {
+		scope->size = scope->size ? scope->size * 2 : 8;
+		scope->vars = (struct Binding *)realloc(scope->vars, scope->size * sizeof(struct Binding));
 	}
-	if (value.type == Y_END) return scope_get(scope->parent, name);
-	return value.value.ival;
+
+	struct ScopeSlot *slot = scope_find_slot(scope, id);
+	if (slot->key == 0) {
+		slot->key = id + 1;
+		slot->pos = -1;
+		scope->lookup_count++;
+	}
+
+	struct Binding *binding = scope->vars + scope->count;
+	binding->id = id;
+	binding->index = index;
+	binding->shadowed = slot->pos;
+	binding->inline_fn = NULL;
+	slot->pos = (int64_t)scope->count++;
+	return index;
 }
 
-int64_t scope_decl_var(struct Scope *const scope, const char *const name) {
-	YASL_Table_insert_zstring_int(&scope->vars, name, scope_len(scope));
-	return scope_len(scope);
+int64_t scope_decl_var(struct Scope *const scope, const size_t id) {
+	return scope_decl_var_with_index(scope, id, (int64_t)scope->count);
 }
 
-static struct YASL_Table *get_closest_scope_with_var(struct Scope *const scope, const char *const name) {
-	return YASL_Table_contains_zstring_int(&scope->vars, name) ? &scope->vars : get_closest_scope_with_var(scope->parent, name);
+void scope_make_const(struct Scope *const scope, const size_t id) {
+	const int64_t pos = scope_find(scope, id);
+	YASL_ASSERT(pos >= 0, "Lookup should not fail.");
+	scope->vars[pos].index = ~scope->vars[pos].index;
 }
 
-void scope_make_const(struct Scope *const scope, const char *const name) {
-	struct YASL_Table *ht = get_closest_scope_with_var(scope, name);
-	YASL_Table_insert_zstring_int(ht, name, ~YASL_Table_search_zstring_int(ht, name).value.ival);
+void scope_set_inline(struct Scope *const scope, const size_t id, const void *fn) {
+	const int64_t pos = scope_find(scope, id);
+	YASL_ASSERT(pos >= 0, "Lookup should not fail.");
+	scope->vars[pos].inline_fn = fn;
+}
+
+const void *scope_get_inline(const struct Scope *const scope, const size_t id) {
+	const int64_t pos = scope_find(scope, id);
+	return pos >= 0 ? scope->vars[pos].inline_fn : NULL;
+}
+
+void scope_clear_inline(struct Scope *const scope) {
+	for (size_t i = 0; i < scope->count; i++) {
+		scope->vars[i].inline_fn = NULL;
+	}
 }
@@ -1,39 +1,87 @@
 #ifndef YASL_ENV_H_
 #define YASL_ENV_H_
 
-#include "data-structures/YASL_Table.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
 
+#define NEW_SCOPE() ((struct Scope) {\
+	.vars = NULL,\
+	.count = 0,\
+	.size = 0,\
+	.starts = NULL,\
+	.depth = 0,\
+	.starts_size = 0,\
+	.lookup = NULL,\
+	.lookup_size = 0,\
+	.lookup_count = 0,\
+})
+
+struct Binding {
+	size_t id;                // interned name, see "names.h"
+	int64_t index;            // where the variable lives, bitwise negated if it is const
+	int64_t shadowed;         // position of the binding this one hides, or -1
+	const void *inline_fn;    // const fn that calls through this binding can be inlined to, if any
+};
+
+struct ScopeSlot {
+	size_t key;               // id + 1, 0 for an empty slot
+	int64_t pos;              // position of the innermost binding for id, or -1 if id is not bound
+};
+
+/*
+ * All the variables of one frame (a fn, the top level of a file, or the globals), stored flat with the innermost last.
+ * Nested blocks push the number of bindings onto `starts` and pop back down to it when they are left. A variable's
+ * position in `vars` is also its stack slot.
+ */
 struct Scope {
-	struct Scope *parent;
-	struct YASL_Table vars;
+	struct Binding *vars;
+	size_t count;
+	size_t size;
+	size_t *starts;
+	size_t depth;
+	size_t starts_size;
+	struct ScopeSlot *lookup; // open addressed, id -> position
+	size_t lookup_size;
+	size_t lookup_count;
+};
+
+struct Upval {
+	size_t id;
+	int64_t value;            // What index to look at in the above scope
 };
 
 struct Env {
 	struct Env *parent;
-	struct Scope *scope;
-	struct YASL_Table upval_indices;  // Which order to store the upvalues in the closure
-	struct YASL_Table upval_values;   // What index to look at in the above scope
+	struct Scope scope;
+	struct Upval *upvals;     // upvalues, in the order they are stored in the closure
+	size_t num_upvals;
+	size_t upvals_size;
 	bool isclosure;
 	bool usedinclosure;
 };
 
-struct Scope *scope_new(struct Scope *const scope);
-void scope_del(struct Scope *const scope);
-void scope_del_cur_only(struct Scope *const scope);
+void scope_cleanup(struct Scope *const scope);
+void scope_enter(struct Scope *const scope);
+size_t scope_exit(struct Scope *const scope);
 
 size_t scope_num_vars_cur_only(const struct Scope *const scope);
 size_t scope_len(const struct Scope *const scope);
-bool scope_contains_cur_only(const struct Scope *const scope, const char *const name);
-bool scope_contains(const struct Scope *const scope, const char *const name);
-int64_t scope_get(const struct Scope *const scope, const char *const name);
-int64_t scope_decl_var(struct Scope *const scope, const char *const name);
-void scope_make_const(struct Scope *const scope, const char *const name);
-
-bool env_contains(const struct Env *env, const char *const name);
-bool env_contains_cur_only(const struct Env *const env, const char *const name);
+bool scope_contains_cur_only(const struct Scope *const scope, const size_t id);
+bool scope_contains(const struct Scope *const scope, const size_t id);
+int64_t scope_get(const struct Scope *const scope, const size_t id);
+int64_t scope_decl_var(struct Scope *const scope, const size_t id);
+int64_t scope_decl_var_with_index(struct Scope *const scope, const size_t id, const int64_t index);
+void scope_make_const(struct Scope *const scope, const size_t id);
+void scope_set_inline(struct Scope *const scope, const size_t id, const void *fn);
+const void *scope_get_inline(const struct Scope *const scope, const size_t id);
+void scope_clear_inline(struct Scope *const scope);
+
+bool env_contains(const struct Env *env, const size_t id);
+bool env_contains_cur_only(const struct Env *const env, const size_t id);
 struct Env *env_new(struct Env *const env);
-int64_t env_resolve_upval_index(struct Env *const env, struct Scope *stack, const char *const name);
-int64_t env_resolve_upval_value(struct Env *const env, const char *const name);
+int64_t env_resolve_upval_index(struct Env *const env, const struct Scope *const stack, const size_t id);
+int64_t env_resolve_upval_value(const struct Env *const env, const size_t id);
 void env_del(struct Env *const env);
 
 #endif
@@ -81,6 +81,10 @@ int lex_getchar(struct Lexer *const lex) {
 	return lex->c = (char)lxgetc(lex->file);
 }
 
+static inline void lex_skip(struct Lexer *const lex, const size_t n) {
+	lex->file->pos += n;
+}
+
 static bool lex_eatwhitespace(struct Lexer *const lex) {
 	while (!lxeof(lex->file) && iswhitespace(lex->c)) {
 		if (lex->c == '\n') {
@@ -89,6 +93,8 @@ static bool lex_eatwhitespace(struct Lexer *const lex) {
 				lex->type = T_SEMI;
 				return true;
 			}
+		} else {
+			lex_skip(lex, lxspan_while(lex->file, ' ', '\t'));
 		}
 		lex_getchar(lex);
 	}
@@ -96,7 +102,10 @@ static bool lex_eatwhitespace(struct Lexer *const lex) {
 }
 
 static bool lex_eatinlinecomments(struct Lexer *const lex) {
-	if ('#' == lex->c) while (!lxeof(lex->file) && lex_getchar(lex) != '\n') ;
+	if ('#' == lex->c) {
+		lex_skip(lex, lxspan_until(lex->file, '\n', '\n', '\n', '\n'));
+		lex_getchar(lex);
+	}
 	return false;
 }
 
@@ -115,13 +124,17 @@ static bool lex_eatcommentsandwhitespace(struct Lexer * lex) {
 			if (lex->c == '*') {
 				int addsemi = 0;
 				lex->c = ' ';
-				int c1 = lxgetc(lex->file);
-				int c2 = lxgetc(lex->file);
-				while (!lxeof(lex->file) && (c1 != '*' || c2 != '/')) {
-					if (c1 == '\n' || c2 == '\n') addsemi = 1;
-					if (c1 == '\n') lex->line++;
-					c1 = c2;
-					c2 = lxgetc(lex->file);
+				while (true) {
+					lex_skip(lex, lxspan_until(lex->file, '*', '\n', '\n', '\n'));
+					const int c1 = lxgetc(lex->file);
+					if (lxeof(lex->file)) break;
+					if (c1 == '\n') {
+						addsemi = 1;
+						lex->line++;
+						continue;
+					}
+					if (lxgetc(lex->file) == '/') break;
+					if (!lxeof(lex->file)) lxseek(lex->file, -1, SEEK_CUR);
 				}
 				if (lxeof(lex->file)) {
 					lex_print_err_syntax(lex,  "Unclosed block comment in line %" PRI_SIZET ".\n", lex->line);
@@ -291,13 +304,13 @@ static bool lex_eatnumber(struct Lexer *const lex) {
 }
 
 static void lex_eatid_fill(struct Lexer *const lex) {
-    long cur;
-	do {
-		lex_val_append(lex, lex->c);
-		cur = lxtell(lex->file);
-		lex_getchar(lex);
-	} while (!lxeof(lex->file) && isyaslid(lex->c));
-    if (!lxeof(lex->file)) lxseek(lex->file, cur, SEEK_SET);
+	// lex->c has already been consumed, so the identifier starts one byte back.
+	const unsigned char *const start = lex->file->buf + lex->file->pos - 1;
+	const unsigned char *const end = lex->file->buf + lex->file->len;
+	const unsigned char *curr = start + 1;
+	while (curr < end && isyaslid(*curr)) curr++;
+	YASL_ByteBuffer_extend(&lex->buffer, start, (size_t)(curr - start));
+	lex_skip(lex, (size_t)(curr - start) - 1);
 }
 static bool lex_eatid(struct Lexer *const lex) {
 	if (isyaslidstart(lex->c)) {                           // identifiers and keywords
@@ -380,6 +393,13 @@ error:
 	return true;
 }
 
+// Copies a run of plain string characters straight from the input, stopping before the next character that needs a closer look.
+static void lex_eatstring_run(struct Lexer *const lex, const int delim, const int placeholder) {
+	const size_t len = lxspan_until(lex->file, delim, ESCAPE_CHAR, '\n', placeholder);
+	YASL_ByteBuffer_extend(&lex->buffer, lex->file->buf + lex->file->pos, len);
+	lex_skip(lex, len);
+}
+
 static bool lex_eatstring_nextchar(struct Lexer *const lex, char delim) {
 	if (lex->c == ESCAPE_CHAR) {
 		lex_getchar(lex);
@@ -401,6 +421,7 @@ static bool lex_eatinterpstring_fill(struct Lexer *const lex) {
 		}
 
 		if (lex_eatstring_nextchar(lex, INTERP_STR_DELIM)) return true;
+		lex_eatstring_run(lex, INTERP_STR_DELIM, INTERP_STR_PLACEHOLDER);
 
 		lex_getchar(lex);
 	}
@@ -450,6 +471,7 @@ static bool lex_eatstring(struct Lexer *const lex) {
 			}
 
 			if (lex_eatstring_nextchar(lex, STR_DELIM)) return true;
+			lex_eatstring_run(lex, STR_DELIM, STR_DELIM);
 
 			lex_getchar(lex);
 		}
@@ -475,6 +497,7 @@ static bool lex_eatrawstring(struct Lexer *const lex) {
 		while (lex->c != RAW_STR_DELIM && !lxeof(lex->file)) {
 			if (lex->c == '\n') lex->line++;
 			lex_val_append(lex, lex->c);
+			lex_eatstring_run(lex, RAW_STR_DELIM, RAW_STR_DELIM);
 			lex_getchar(lex);
 		}
 
@@ -1,130 +1,151 @@
 #include "lexinput.h"
 
-#include "data-structures/YASL_ByteBuffer.h"
-
-#undef getc
-
-struct LEXINPUT {
-  FILE *fp;
-  YASL_ByteBuffer *bb;
-  int pos;
-  int iseof;
-  int (*getc)(struct LEXINPUT *const lp);
-  int (*tell)(struct LEXINPUT *const lp);
-  int (*seek)(struct LEXINPUT *const lp, int w, int cmd);
-  int (*close)(struct LEXINPUT *const lp);
-  int (*eof)(struct LEXINPUT *const lp);
-};
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define YASL_LEXINPUT_SSE2
+#include <emmintrin.h>
+#endif
 
 int lxgetc(struct LEXINPUT *const lp) {
-	int ch = lp->getc(lp);
-	return ch;
+	if (lp->pos >= lp->len) {
+		lp->iseof = 1;
+		return -1;
+	}
+	return lp->buf[lp->pos++];
 }
 
 int lxtell(struct LEXINPUT *const lp) {
-	int d = lp->tell(lp);
-	return d;
+	return (int) lp->pos;
 }
 
 int lxseek(struct LEXINPUT *const lp, const int w, const int cmd) {
-	int r = lp->seek(lp, w, cmd);
-	return r;
+	if (cmd == SEEK_SET) {
+		lp->pos = w;
+	} else if (cmd == SEEK_CUR) {
+		lp->pos += w;
+	} else if (cmd == SEEK_END) {
+		lp->pos = lp->len + w;
+	}
+	if (lp->pos < lp->len) lp->iseof = 0;
+	return 0;
 }
 
 int lxclose(struct LEXINPUT *const lp) {
-	return lp->close(lp);
-}
-
-int lxeof(struct LEXINPUT *const lp) {
-	return lp->eof(lp);
-}
-
-static  int lexinput_file_getc(struct LEXINPUT *const lp) {
-	return fgetc(lp->fp);
-}
-
-static  int lexinput_file_tell(struct LEXINPUT *const lp) {
-	return ftell(lp->fp);
-}
-
-static  int lexinput_file_seek(struct LEXINPUT *const lp, int w, int cmd) {
-	return fseek(lp->fp, w, cmd);
-}
-
-static  int lexinput_file_eof(struct LEXINPUT *const lp) {
-	return feof(lp->fp);
-}
-
-static  int lexinput_file_close(struct LEXINPUT *const lp) {
-	fclose(lp->fp);
-	lp->fp = 0;
+	free(lp->buf);
 	free(lp);
 	return 0;
 }
 
-struct LEXINPUT *lexinput_new_file(FILE *const fp) {
-	struct LEXINPUT *lp = (struct LEXINPUT *)malloc(sizeof(struct LEXINPUT));
-	lp->fp = fp;
-	lp->getc = lexinput_file_getc;
-	lp->tell = lexinput_file_tell;
-	lp->seek = lexinput_file_seek;
-	lp->close = lexinput_file_close;
-	lp->eof = lexinput_file_eof;
-	return lp;
-}
-
-#include "data-structures/YASL_ByteBuffer.h"
-
-static int lexinput_bb_eof(struct LEXINPUT *const lp);
-static  int lexinput_bb_getc(struct LEXINPUT *const lp) {
-	if (lp->pos >= (signed) lp->bb->count) {
-		lp->iseof = 1;
-		return -1;
+int lxeof(struct LEXINPUT *const lp) {
+	if (lp->pos >= lp->len) {
+		return lp->iseof;
 	}
-	return lp->bb->items[lp->pos++];
+	return 0;
 }
 
-static  int lexinput_bb_tell(struct LEXINPUT *const lp) {
-	return lp->pos;
+/*
+ * Whole-word helpers for scanning 8 bytes at a time when SSE2 isn't available.
+ */
+#define SWAR_ONES  0x0101010101010101ULL
+#define SWAR_LOWS  0x7F7F7F7F7F7F7F7FULL
+#define SWAR_HIGHS 0x8080808080808080ULL
+
+// Sets the high bit of exactly those bytes of x that are zero.
+static inline uint64_t swar_zero_bytes(const uint64_t x) {
+	return ~(((x & SWAR_LOWS) + SWAR_LOWS) | x | SWAR_LOWS);
+}
+
+static inline uint64_t swar_eq(const uint64_t x, const int c) {
+	return swar_zero_bytes(x ^ ((unsigned char) c * SWAR_ONES));
+}
+
+size_t lxspan_until(const struct LEXINPUT *const lp, const int a, const int b, const int c, const int d) {
+	const unsigned char *const p = lp->buf + lp->pos;
+	const size_t n = lp->pos < lp->len ? lp->len - lp->pos : 0;
+	size_t i = 0;
+#ifdef YASL_LEXINPUT_SSE2
+	const __m128i va = _mm_set1_epi8((char) a);
+	const __m128i vb = _mm_set1_epi8((char) b);
+	const __m128i vc = _mm_set1_epi8((char) c);
+	const __m128i vd = _mm_set1_epi8((char) d);
+	for (; i + 16 <= n; i += 16) {
+		const __m128i v = _mm_loadu_si128((const __m128i *) (p + i));
+		const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+						  _mm_or_si128(_mm_cmpeq_epi8(v, vc), _mm_cmpeq_epi8(v, vd)));
+		if (_mm_movemask_epi8(hits)) break;
+	}
+#else
+	for (; i + 8 <= n; i += 8) {
+		uint64_t w;
+		memcpy(&w, p + i, sizeof(w));
+		if (swar_eq(w, a) | swar_eq(w, b) | swar_eq(w, c) | swar_eq(w, d)) break;
+	}
+#endif
+	while (i < n && p[i] != a && p[i] != b && p[i] != c && p[i] != d) i++;
+	return i;
+}
+
+size_t lxspan_while(const struct LEXINPUT *const lp, const int a, const int b) {
+	const unsigned char *const p = lp->buf + lp->pos;
+	const size_t n = lp->pos < lp->len ? lp->len - lp->pos : 0;
+	size_t i = 0;
+#ifdef YASL_LEXINPUT_SSE2
+	const __m128i va = _mm_set1_epi8((char) a);
+	const __m128i vb = _mm_set1_epi8((char) b);
+	for (; i + 16 <= n; i += 16) {
+		const __m128i v = _mm_loadu_si128((const __m128i *) (p + i));
+		const __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb));
+		if (_mm_movemask_epi8(hits) != 0xFFFF) break;
+	}
+#else
+	for (; i + 8 <= n; i += 8) {
+		uint64_t w;
+		memcpy(&w, p + i, sizeof(w));
+		if ((swar_eq(w, a) | swar_eq(w, b)) != SWAR_HIGHS) break;
+	}
+#endif
+	while (i < n && (p[i] == a || p[i] == b)) i++;
+	return i;
 }
 
-static  int lexinput_bb_seek(struct LEXINPUT *const lp, int w, int cmd) {
-	if (cmd == 0) {
-		lp->pos = w;
-	} else if (cmd == 1) {
-		lp->pos += w;
-	} else if (cmd == 2) {
-		lp->pos = lp->bb->count = w;
+struct LEXINPUT *lexinput_new_file(FILE *const fp) {
+	size_t size = 4096;
+	const long start = ftell(fp);
+	if (start >= 0 && !fseek(fp, 0, SEEK_END)) {
+		const long end = ftell(fp);
+		if (end >= start) size = (size_t)(end - start) + 1;
+		fseek(fp, start, SEEK_SET);
 	}
-	if (lp->pos < (signed) lp->bb->count) lp->iseof = 0;
-	return 0;
-}
 
-static  int lexinput_bb_eof(struct LEXINPUT *const lp) {
-	if (lp->pos >= (signed) lp->bb->count) {
-		return lp->iseof;
+	size_t len = 0;
+	unsigned char *buf = (unsigned char *)malloc(size);
+	size_t read;
+	while ((read = fread(buf + len, 1, size - len, fp)) > 0) {
+		len += read;
+		if (len == size) {
+			size *= 2;
+			buf = (unsigned char *)realloc(buf, size);
+		}
 	}
-	return 0;
-}
+	fclose(fp);
 
-static  int lexinput_bb_close(struct LEXINPUT *const lp) {
-	YASL_ByteBuffer_del(lp->bb);
-	lp->bb = 0;
-	free(lp);
-	return 0;
+	struct LEXINPUT *lp = (struct LEXINPUT *)malloc(sizeof(struct LEXINPUT));
+	lp->buf = buf;
+	lp->len = len;
+	lp->pos = 0;
+	lp->iseof = 0;
+	return lp;
 }
 
 struct LEXINPUT *lexinput_new_bb(const char *const buf, const size_t len) {
 	struct LEXINPUT *lp = (struct LEXINPUT *) malloc(sizeof(struct LEXINPUT));
-	lp->bb = YASL_ByteBuffer_new(8);
-	YASL_ByteBuffer_extend(lp->bb, (unsigned char *) buf, len);
-	lp->getc = lexinput_bb_getc;
-	lp->tell = lexinput_bb_tell;
-	lp->seek = lexinput_bb_seek;
-	lp->close = lexinput_bb_close;
-	lp->eof = lexinput_bb_eof;
-	lp->iseof = 0;
+	lp->buf = (unsigned char *)malloc(len ? len : 1);
+	if (len) memcpy(lp->buf, buf, len);
+	lp->len = len;
 	lp->pos = 0;
+	lp->iseof = 0;
 	return lp;
 }
@@ -3,7 +3,17 @@
 
 #include <stdio.h>
 
-struct LEXINPUT;
+/*
+ * Source text is always held in one contiguous buffer, so that the lexer can scan it with plain pointer bumps instead
+ * of going through stdio for every character. Files are read in with a single bulk read when the input is created.
+ */
+struct LEXINPUT {
+	unsigned char *buf;   // OWN
+	size_t len;
+	size_t pos;
+	int iseof;
+};
+
 struct LEXINPUT *lexinput_new_file(FILE *const lp);
 struct LEXINPUT *lexinput_new_bb(const char *const buf, const size_t len);
 int lxgetc(struct LEXINPUT *const lp);
@@ -12,4 +22,15 @@ int lxseek(struct LEXINPUT *const lp, const int w, const int cmd);
 int lxclose(struct LEXINPUT *const lp);
 int lxeof(struct LEXINPUT *const lp);
 
+/*
+ * Number of bytes from the current position up to (but not including) the first one equal to any of a, b, c or d.
+ * Pass the same stop byte more than once if fewer are needed.
+ */
+size_t lxspan_until(const struct LEXINPUT *const lp, const int a, const int b, const int c, const int d);
+
+/*
+ * Number of bytes from the current position that are all equal to either a or b.
+ */
+size_t lxspan_while(const struct LEXINPUT *const lp, const int a, const int b);
+
 #endif
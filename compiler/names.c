@@ -0,0 +1,74 @@
+#include "names.h"
+
+#include <string.h>
+
+#include "debug.h"
+
+static size_t names_hash(const char *const name, const size_t len) {
+	size_t hash = 2166136261u;
+	for (size_t i = 0; i < len; i++) {
+		hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static size_t *names_find_bucket(const struct Names *const names, const char *const name, const size_t len) {
+	const size_t mask = names->num_buckets - 1;
+	size_t i = names_hash(name, len) & mask;
+	while (names->buckets[i] != 0) {
+		const size_t id = names->buckets[i] - 1;
+		if (names->lens[id] == len && !memcmp(names->names[id], name, len)) {
+			break;
+		}
+		i = (i + 1) & mask;
+	}
+	return names->buckets + i;
+}
+
+static void names_resize(struct Names *const names) {
+	free(names->buckets);
+	names->num_buckets = names->num_buckets ? names->num_buckets * 2 : 64;
+	names->buckets = (size_t *)calloc(names->num_buckets, sizeof(size_t));
+	for (size_t id = 0; id < names->count; id++) {
+		*names_find_bucket(names, names->names[id], names->lens[id]) = id + 1;
+	}
+}
+
+size_t names_intern(struct Names *const names, const char *const name, const size_t len) {
+	if (2 * (names->count + 1) > names->num_buckets) {
+		names_resize(names);
+	}
+
+	size_t *bucket = names_find_bucket(names, name, len);
+	if (*bucket != 0) {
+		return *bucket - 1;
+	}
+
+	if (names->count >= names->size) {
+		names->size = names->size ? names->size * 2 : 32;
+		names->names = (char **)realloc(names->names, names->size * sizeof(char *));
+		names->lens = (size_t *)realloc(names->lens, names->size * sizeof(size_t));
+	}
+
+	char *copy = (char *)malloc(len + 1);
+	memcpy(copy, name, len);
+	copy[len] = '\0';
+	names->names[names->count] = copy;
+	names->lens[names->count] = len;
+	*bucket = ++names->count;
+	return names->count - 1;
+}
+
+const char *names_get(const struct Names *const names, const size_t id) {
+	YASL_ASSERT(id < names->count, "Name must have been interned.");
+	return names->names[id];
+}
+
+void names_cleanup(struct Names *const names) {
+	for (size_t i = 0; i < names->count; i++) {
+		free(names->names[i]);
+	}
+	free(names->names);
+	free(names->lens);
+	free(names->buckets);
+}
@@ -0,0 +1,32 @@
+#ifndef YASL_NAMES_H_
+#define YASL_NAMES_H_
+
+#include <stdlib.h>
+
+#define NEW_NAMES() ((struct Names) {\
+	.names = NULL,\
+	.lens = NULL,\
+	.count = 0,\
+	.size = 0,\
+	.buckets = NULL,\
+	.num_buckets = 0,\
+})
+
+/*
+ * Interns identifiers, so that the compiler can refer to every name by a small integer id instead of a string.
+ * Ids are handed out densely, starting from 0.
+ */
+struct Names {
+	char **names;          // id -> name, OWN
+	size_t *lens;          // id -> length of name
+	size_t count;
+	size_t size;
+	size_t *buckets;       // open addressed, holds id + 1, 0 for an empty bucket
+	size_t num_buckets;
+};
+
+size_t names_intern(struct Names *const names, const char *const name, const size_t len);
+const char *names_get(const struct Names *const names, const size_t id);
+void names_cleanup(struct Names *const names);
+
+#endif
@@ -61,38 +61,20 @@ YASL_FORMAT_CHECK static void parser_print_err(struct Parser *parser, const char
 
 #define parser_print_err_syntax(parser, format, ...) parser_print_err(parser, "SyntaxError: " format, __VA_ARGS__)
 
-void parser_register_node(struct Parser *parser, struct Node *node) {
-	if (!parser->head) {
-		parser->head = node;
-	} else {
-		parser->tail->next = node;
-	}
-	parser->tail = node;
+size_t parser_intern_name(struct Parser *parser, const char *const name, const size_t len) {
+	return names_intern(&parser->names, name, len);
 }
 
-void parser_unregister_node(struct Parser *parser, struct Node *node) {
-	if (!parser->head)
-		return;
+const char *parser_get_name(struct Parser *parser, const size_t id) {
+	return names_get(&parser->names, id);
+}
 
-	if (parser->head == node) {
-		parser->head = parser->head->next;
-		node->next = NULL;
-		return;
-	}
+void *parser_alloc(struct Parser *parser, const size_t size) {
+	return arena_alloc(&parser->arena, size);
+}
 
-	struct Node *prev = parser->head;
-	struct Node *curr = prev->next;
-	while (curr) {
-		if (curr == node) {
-			prev->next = curr->next;
-			node->next = NULL;
-			if (node == parser->tail)
-				parser->tail = prev;
-			break;
-		}
-		prev = curr;
-		curr = curr->next;
-	}
+char *parser_copy_str(struct Parser *parser, const char *const str, const size_t len) {
+	return arena_strndup(&parser->arena, str, len);
 }
 
 int peof(const struct Parser *const parser) {
@@ -121,8 +103,17 @@ static inline enum Token curtok(const struct Parser *const parser) {
 }
 
 void parser_cleanup(struct Parser *const parser) {
-	node_del(parser->head);
+	arena_cleanup(&parser->arena);
 	lex_cleanup(&parser->lex);
+	names_cleanup(&parser->names);
+}
+
+/*
+ * Frees every node parsed so far in one go. Nodes are not freed individually, so this must only be called once
+ * nothing refers to them any more.
+ */
+void parser_release_nodes(struct Parser *const parser) {
+	arena_reset(&parser->arena);
 }
 
 static YASL_NORETURN void handle_error(struct Parser *const parser) {
@@ -157,12 +148,18 @@ enum Token eattok(struct Parser *const parser, const enum Token token) {
 	return token;
 }
 
+/*
+ * Returns the interned copy of the name, which lives as long as the parser.
+ */
 static char *eatname(struct Parser *const parser) {
 	char *tmp = lex_val_get(&parser->lex);
+	const size_t len = parser->lex.buffer.count;
 	eattok(parser, T_ID);
 	if (parser->status)
 		handle_error(parser);
-	return tmp;
+	const size_t id = parser_intern_name(parser, tmp, len);
+	free(tmp);
+	return (char *)parser_get_name(parser, id);
 }
 
 bool matcheattok(struct Parser *const parser, const enum Token token) {
@@ -598,7 +595,6 @@ static struct Node *parse_primitivepattern(struct Parser *const parser) {
 			parser_print_err_syntax(parser, "Invalid pattern: %s (line %" PRI_SIZET ").\n", name, line);
 			handle_error(parser);
 		}
-		free(name);
 		return n;
 	}
 	default:
@@ -1091,6 +1087,8 @@ static struct Node *parse_boolean(struct Parser *const parser) {
 static struct Node *parse_string(struct Parser *const parser) {
 	YASL_PARSE_DEBUG_LOG("%s\n", "Parsing str");
 	struct Node *cur_node = new_String(parser, lex_val_get(&parser->lex), parser->lex.buffer.count, parserline(parser));
+	lex_val_free(&parser->lex);
+	lex_val_setnull(&parser->lex);
 
 	// interpolated strings
 	while (parser->lex.mode == L_INTERP) {
@@ -1111,6 +1109,8 @@ static struct Node *parse_string(struct Parser *const parser) {
 			handle_error(parser);
 		};
 		struct Node *str = new_String(parser, lex_val_get(&parser->lex), parser->lex.buffer.count, parserline(parser));
+		lex_val_free(&parser->lex);
+		lex_val_setnull(&parser->lex);
 		cur_node = new_BinOp(parser, T_TILDE, cur_node, str, parserline(parser));
 	}
 
@@ -2,7 +2,9 @@
 #define YASL_PARSER_H_
 
 #include <setjmp.h>
+#include "arena.h"
 #include "lexer.h"
+#include "names.h"
 #include "yapp.h"
 #include "ast.h"
 
@@ -16,22 +18,23 @@
 #define NEW_PARSER(fp)\
 ((struct Parser) {\
 	.lex = NEW_LEXER(fp),\
+	.names = NEW_NAMES(),\
+	.arena = NEW_ARENA(),\
 	.status = YASL_SUCCESS,\
-	.head = NULL,\
-	.tail = NULL,\
 })
 
 struct Parser {
 	struct Lexer lex; /* OWN */
+	struct Names names; /* OWN */
+	struct Arena arena; /* OWN, holds the AST */
 	int status;
-	struct Node *head;
-	struct Node *tail;
 	jmp_buf env;
 };
 
 int peof(const struct Parser *const parser);
 size_t parserline(const struct Parser *const parser);
 void parser_cleanup(struct Parser *const parser);
+void parser_release_nodes(struct Parser *const parser);
 enum Token eattok(struct Parser *const parser, const enum Token token);
 struct Node *parse(struct Parser *const parser);
 
@@ -0,0 +1,361 @@
+#include "YASL_Array.h"
+
+#include <string.h>
+
+#include "debug.h"
+#include "interpreter/alloc.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define YASL_ARRAY_SSE2
+#include <emmintrin.h>
+#endif
+
+const char *const INTARRAY_NAME = "collections.intarray";
+const char *const FLOATARRAY_NAME = "collections.floatarray";
+const char *const BYTEARRAY_NAME = "collections.bytearray";
+
+size_t YASL_Array_itemsize(const enum YASL_ArrayKind kind) {
+	switch (kind) {
+	case ARRAY_INT:
+		return sizeof(yasl_int);
+	case ARRAY_FLOAT:
+		return sizeof(yasl_float);
+	case ARRAY_BYTE:
+	default:
+		return 1;
+	}
+}
+
+struct YASL_Array *YASL_Array_new_sized(const enum YASL_ArrayKind kind, const size_t base_size) {
+	struct YASL_Array *array = (struct YASL_Array *)mem_alloc(Y_USERDATA, sizeof(struct YASL_Array));
+	array->kind = kind;
+	array->size = base_size ? base_size : ARRAY_BASESIZE;
+	array->count = 0;
+	array->items.data = mem_alloc(Y_USERDATA, array->size * YASL_Array_itemsize(kind));
+	return array;
+}
+
+void YASL_Array_del(void *array) {
+	if (!array) return;
+	mem_free(((struct YASL_Array *)array)->items.data);
+	mem_free(array);
+}
+
+void YASL_Array_reserve(struct YASL_Array *const array, const size_t size) {
+	if (size <= array->size) return;
+	size_t new_size = array->size * 2;
+	while (new_size < size) new_size *= 2;
+	array->items.data = mem_realloc(Y_USERDATA, array->items.data, new_size * YASL_Array_itemsize(array->kind));
+	array->size = new_size;
+}
+
+struct YASL_Array *YASL_Array_slice(const struct YASL_Array *const array, const size_t start, const size_t end) {
+	const size_t len = start < end ? end - start : 0;
+	const size_t itemsize = YASL_Array_itemsize(array->kind);
+	struct YASL_Array *slice = YASL_Array_new_sized(array->kind, len);
+	memcpy(slice->items.data, (const unsigned char *)array->items.data + start * itemsize, len * itemsize);
+	slice->count = len;
+	return slice;
+}
+
+/*
+ * ints. Arithmetic wraps around on overflow, so it is done on unsigned values.
+ */
+yasl_int YASL_ints_sum(const yasl_int *const a, const size_t n) {
+	size_t i = 0;
+	uint64_t total = 0;
+#ifdef YASL_ARRAY_SSE2
+	__m128i acc0 = _mm_setzero_si128();
+	__m128i acc1 = _mm_setzero_si128();
+	for (; i + 4 <= n; i += 4) {
+		acc0 = _mm_add_epi64(acc0, _mm_loadu_si128((const __m128i *)(a + i)));
+		acc1 = _mm_add_epi64(acc1, _mm_loadu_si128((const __m128i *)(a + i + 2)));
+	}
+	uint64_t lanes[2];
+	_mm_storeu_si128((__m128i *)lanes, _mm_add_epi64(acc0, acc1));
+	total = lanes[0] + lanes[1];
+#endif
+	for (; i < n; i++) {
+		total += (uint64_t)a[i];
+	}
+	return (yasl_int)total;
+}
+
+yasl_int YASL_ints_dot(const yasl_int *const a, const yasl_int *const b, const size_t n) {
+	uint64_t acc[4] = { 0, 0, 0, 0 };
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		acc[0] += (uint64_t)a[i] * (uint64_t)b[i];
+		acc[1] += (uint64_t)a[i + 1] * (uint64_t)b[i + 1];
+		acc[2] += (uint64_t)a[i + 2] * (uint64_t)b[i + 2];
+		acc[3] += (uint64_t)a[i + 3] * (uint64_t)b[i + 3];
+	}
+	for (; i < n; i++) {
+		acc[0] += (uint64_t)a[i] * (uint64_t)b[i];
+	}
+	return (yasl_int)(acc[0] + acc[1] + acc[2] + acc[3]);
+}
+
+#define INTS_REDUCE(name, better) \
+yasl_int YASL_ints_##name(const yasl_int *const a, const size_t n) {\
+	YASL_ASSERT(n > 0, "Cannot reduce an empty array.");\
+	yasl_int acc[4] = { a[0], a[0], a[0], a[0] };\
+	size_t i = 0;\
+	for (; i + 4 <= n; i += 4) {\
+		if (a[i] better acc[0]) acc[0] = a[i];\
+		if (a[i + 1] better acc[1]) acc[1] = a[i + 1];\
+		if (a[i + 2] better acc[2]) acc[2] = a[i + 2];\
+		if (a[i + 3] better acc[3]) acc[3] = a[i + 3];\
+	}\
+	for (; i < n; i++) {\
+		if (a[i] better acc[0]) acc[0] = a[i];\
+	}\
+	for (i = 1; i < 4; i++) {\
+		if (acc[i] better acc[0]) acc[0] = acc[i];\
+	}\
+	return acc[0];\
+}
+
+INTS_REDUCE(min, <)
+INTS_REDUCE(max, >)
+
+void YASL_ints_add(yasl_int *const dest, const yasl_int *const src, const size_t n) {
+	size_t i = 0;
+#ifdef YASL_ARRAY_SSE2
+	for (; i + 2 <= n; i += 2) {
+		const __m128i sum = _mm_add_epi64(_mm_loadu_si128((const __m128i *)(dest + i)),
+						  _mm_loadu_si128((const __m128i *)(src + i)));
+		_mm_storeu_si128((__m128i *)(dest + i), sum);
+	}
+#endif
+	for (; i < n; i++) {
+		dest[i] = (yasl_int)((uint64_t)dest[i] + (uint64_t)src[i]);
+	}
+}
+
+void YASL_ints_scale(yasl_int *const a, const yasl_int k, const size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		a[i] = (yasl_int)((uint64_t)a[i] * (uint64_t)k);
+	}
+}
+
+/*
+ * floats. Sums are accumulated in four interleaved lanes, which is what the SSE2 versions do with two registers.
+ */
+yasl_float YASL_floats_sum(const yasl_float *const a, const size_t n) {
+	size_t i = 0;
+	yasl_float total = 0.0;
+#ifdef YASL_ARRAY_SSE2
+	if (n >= 4) {
+		__m128d acc01 = _mm_setzero_pd();
+		__m128d acc23 = _mm_setzero_pd();
+		for (; i + 4 <= n; i += 4) {
+			acc01 = _mm_add_pd(acc01, _mm_loadu_pd(a + i));
+			acc23 = _mm_add_pd(acc23, _mm_loadu_pd(a + i + 2));
+		}
+		double lanes[2];
+		_mm_storeu_pd(lanes, _mm_add_pd(acc01, acc23));
+		total = lanes[0] + lanes[1];
+	}
+#else
+	if (n >= 4) {
+		yasl_float acc[4] = { 0.0, 0.0, 0.0, 0.0 };
+		for (; i + 4 <= n; i += 4) {
+			acc[0] += a[i];
+			acc[1] += a[i + 1];
+			acc[2] += a[i + 2];
+			acc[3] += a[i + 3];
+		}
+		total = (acc[0] + acc[2]) + (acc[1] + acc[3]);
+	}
+#endif
+	for (; i < n; i++) {
+		total += a[i];
+	}
+	return total;
+}
+
+yasl_float YASL_floats_dot(const yasl_float *const a, const yasl_float *const b, const size_t n) {
+	size_t i = 0;
+	yasl_float total = 0.0;
+#ifdef YASL_ARRAY_SSE2
+	if (n >= 4) {
+		__m128d acc01 = _mm_setzero_pd();
+		__m128d acc23 = _mm_setzero_pd();
+		for (; i + 4 <= n; i += 4) {
+			acc01 = _mm_add_pd(acc01, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+			acc23 = _mm_add_pd(acc23, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+		}
+		double lanes[2];
+		_mm_storeu_pd(lanes, _mm_add_pd(acc01, acc23));
+		total = lanes[0] + lanes[1];
+	}
+#else
+	if (n >= 4) {
+		yasl_float acc[4] = { 0.0, 0.0, 0.0, 0.0 };
+		for (; i + 4 <= n; i += 4) {
+			acc[0] += a[i] * b[i];
+			acc[1] += a[i + 1] * b[i + 1];
+			acc[2] += a[i + 2] * b[i + 2];
+			acc[3] += a[i + 3] * b[i + 3];
+		}
+		total = (acc[0] + acc[2]) + (acc[1] + acc[3]);
+	}
+#endif
+	for (; i < n; i++) {
+		total += a[i] * b[i];
+	}
+	return total;
+}
+
+/*
+ * Matches the semantics of minpd/maxpd: the second operand is returned if either is NaN.
+ */
+#define FLOAT_MIN(x, y) ((x) < (y) ? (x) : (y))
+#define FLOAT_MAX(x, y) ((x) > (y) ? (x) : (y))
+
+#ifdef YASL_ARRAY_SSE2
+#define FLOATS_REDUCE(name, SCALAR, VECTOR) \
+yasl_float YASL_floats_##name(const yasl_float *const a, const size_t n) {\
+	YASL_ASSERT(n > 0, "Cannot reduce an empty array.");\
+	size_t i = 0;\
+	yasl_float result = a[0];\
+	if (n >= 4) {\
+		__m128d acc01 = _mm_loadu_pd(a);\
+		__m128d acc23 = _mm_loadu_pd(a + 2);\
+		for (i = 4; i + 4 <= n; i += 4) {\
+			acc01 = VECTOR(acc01, _mm_loadu_pd(a + i));\
+			acc23 = VECTOR(acc23, _mm_loadu_pd(a + i + 2));\
+		}\
+		double lanes[2];\
+		_mm_storeu_pd(lanes, VECTOR(acc01, acc23));\
+		result = SCALAR(lanes[0], lanes[1]);\
+	}\
+	for (; i < n; i++) {\
+		result = SCALAR(result, a[i]);\
+	}\
+	return result;\
+}
+
+FLOATS_REDUCE(min, FLOAT_MIN, _mm_min_pd)
+FLOATS_REDUCE(max, FLOAT_MAX, _mm_max_pd)
+#else
+#define FLOATS_REDUCE(name, SCALAR) \
+yasl_float YASL_floats_##name(const yasl_float *const a, const size_t n) {\
+	YASL_ASSERT(n > 0, "Cannot reduce an empty array.");\
+	size_t i = 0;\
+	yasl_float result = a[0];\
+	if (n >= 4) {\
+		yasl_float acc[4] = { a[0], a[1], a[2], a[3] };\
+		for (i = 4; i + 4 <= n; i += 4) {\
+			acc[0] = SCALAR(acc[0], a[i]);\
+			acc[1] = SCALAR(acc[1], a[i + 1]);\
+			acc[2] = SCALAR(acc[2], a[i + 2]);\
+			acc[3] = SCALAR(acc[3], a[i + 3]);\
+		}\
+		result = SCALAR(SCALAR(acc[0], acc[2]), SCALAR(acc[1], acc[3]));\
+	}\
+	for (; i < n; i++) {\
+		result = SCALAR(result, a[i]);\
+	}\
+	return result;\
+}
+
+FLOATS_REDUCE(min, FLOAT_MIN)
+FLOATS_REDUCE(max, FLOAT_MAX)
+#endif
+
+void YASL_floats_add(yasl_float *const dest, const yasl_float *const src, const size_t n) {
+	size_t i = 0;
+#ifdef YASL_ARRAY_SSE2
+	for (; i + 2 <= n; i += 2) {
+		_mm_storeu_pd(dest + i, _mm_add_pd(_mm_loadu_pd(dest + i), _mm_loadu_pd(src + i)));
+	}
+#endif
+	for (; i < n; i++) {
+		dest[i] += src[i];
+	}
+}
+
+void YASL_floats_scale(yasl_float *const a, const yasl_float k, const size_t n) {
+	size_t i = 0;
+#ifdef YASL_ARRAY_SSE2
+	const __m128d factor = _mm_set1_pd(k);
+	for (; i + 2 <= n; i += 2) {
+		_mm_storeu_pd(a + i, _mm_mul_pd(_mm_loadu_pd(a + i), factor));
+	}
+#endif
+	for (; i < n; i++) {
+		a[i] *= k;
+	}
+}
+
+/*
+ * bytes
+ */
+yasl_int YASL_bytes_sum(const unsigned char *const a, const size_t n) {
+	size_t i = 0;
+	uint64_t total = 0;
+#ifdef YASL_ARRAY_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	__m128i acc = _mm_setzero_si128();
+	for (; i + 16 <= n; i += 16) {
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(a + i)), zero));
+	}
+	uint64_t lanes[2];
+	_mm_storeu_si128((__m128i *)lanes, acc);
+	total = lanes[0] + lanes[1];
+#endif
+	for (; i < n; i++) {
+		total += a[i];
+	}
+	return (yasl_int)total;
+}
+
+yasl_int YASL_bytes_dot(const unsigned char *const a, const unsigned char *const b, const size_t n) {
+	uint64_t total = 0;
+	for (size_t i = 0; i < n; i++) {
+		total += (uint64_t)a[i] * b[i];
+	}
+	return (yasl_int)total;
+}
+
+#ifdef YASL_ARRAY_SSE2
+#define BYTES_REDUCE(name, better, VECTOR) \
+unsigned char YASL_bytes_##name(const unsigned char *const a, const size_t n) {\
+	YASL_ASSERT(n > 0, "Cannot reduce an empty array.");\
+	unsigned char result = a[0];\
+	size_t i = 0;\
+	if (n >= 16) {\
+		__m128i acc = _mm_loadu_si128((const __m128i *)a);\
+		for (i = 16; i + 16 <= n; i += 16) {\
+			acc = VECTOR(acc, _mm_loadu_si128((const __m128i *)(a + i)));\
+		}\
+		unsigned char lanes[16];\
+		_mm_storeu_si128((__m128i *)lanes, acc);\
+		for (size_t j = 0; j < 16; j++) {\
+			if (lanes[j] better result) result = lanes[j];\
+		}\
+	}\
+	for (; i < n; i++) {\
+		if (a[i] better result) result = a[i];\
+	}\
+	return result;\
+}
+
+BYTES_REDUCE(min, <, _mm_min_epu8)
+BYTES_REDUCE(max, >, _mm_max_epu8)
+#else
+#define BYTES_REDUCE(name, better) \
+unsigned char YASL_bytes_##name(const unsigned char *const a, const size_t n) {\
+	YASL_ASSERT(n > 0, "Cannot reduce an empty array.");\
+	unsigned char result = a[0];\
+	for (size_t i = 1; i < n; i++) {\
+		if (a[i] better result) result = a[i];\
+	}\
+	return result;\
+}
+
+BYTES_REDUCE(min, <)
+BYTES_REDUCE(max, >)
+#endif
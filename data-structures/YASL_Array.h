@@ -0,0 +1,65 @@
+#ifndef YASL_YASL_ARRAY_H_
+#define YASL_YASL_ARRAY_H_
+
+#include <stdlib.h>
+
+#include "yasl_conf.h"
+
+#define ARRAY_BASESIZE 8
+
+enum YASL_ArrayKind {
+	ARRAY_INT,
+	ARRAY_FLOAT,
+	ARRAY_BYTE
+};
+
+// Userdata tags, which are also the names of the metatables, for each kind of array.
+extern const char *const INTARRAY_NAME;
+extern const char *const FLOATARRAY_NAME;
+extern const char *const BYTEARRAY_NAME;
+
+/*
+ * Dynamically sized array of unboxed ints, floats or bytes.
+ */
+struct YASL_Array {
+	enum YASL_ArrayKind kind;
+	size_t size;
+	size_t count;
+	union {
+		void *data;
+		yasl_int *ints;
+		yasl_float *floats;
+		unsigned char *bytes;
+	} items;
+};
+
+struct YASL_Array *YASL_Array_new_sized(const enum YASL_ArrayKind kind, const size_t base_size);
+void YASL_Array_del(void *array);
+size_t YASL_Array_itemsize(const enum YASL_ArrayKind kind);
+void YASL_Array_reserve(struct YASL_Array *const array, const size_t size);
+struct YASL_Array *YASL_Array_slice(const struct YASL_Array *const array, const size_t start, const size_t end);
+
+/*
+ * Bulk operations over contiguous items. These use SSE2 where it is available; the portable versions accumulate in
+ * the same order, so results are identical either way.
+ */
+yasl_int YASL_ints_sum(const yasl_int *const a, const size_t n);
+yasl_int YASL_ints_dot(const yasl_int *const a, const yasl_int *const b, const size_t n);
+yasl_int YASL_ints_min(const yasl_int *const a, const size_t n);
+yasl_int YASL_ints_max(const yasl_int *const a, const size_t n);
+void YASL_ints_add(yasl_int *const dest, const yasl_int *const src, const size_t n);
+void YASL_ints_scale(yasl_int *const a, const yasl_int k, const size_t n);
+
+yasl_float YASL_floats_sum(const yasl_float *const a, const size_t n);
+yasl_float YASL_floats_dot(const yasl_float *const a, const yasl_float *const b, const size_t n);
+yasl_float YASL_floats_min(const yasl_float *const a, const size_t n);
+yasl_float YASL_floats_max(const yasl_float *const a, const size_t n);
+void YASL_floats_add(yasl_float *const dest, const yasl_float *const src, const size_t n);
+void YASL_floats_scale(yasl_float *const a, const yasl_float k, const size_t n);
+
+yasl_int YASL_bytes_sum(const unsigned char *const a, const size_t n);
+yasl_int YASL_bytes_dot(const unsigned char *const a, const unsigned char *const b, const size_t n);
+unsigned char YASL_bytes_min(const unsigned char *const a, const size_t n);
+unsigned char YASL_bytes_max(const unsigned char *const a, const size_t n);
+
+#endif
@@ -0,0 +1,473 @@
+#include "YASL_BTree.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "data-structures/YASL_String.h"
+#include "interpreter/alloc.h"
+#include "interpreter/refcount.h"
+
+static struct YASL_BTreeNode *node_new(const bool leaf) {
+	struct YASL_BTreeNode *node = (struct YASL_BTreeNode *)mem_alloc(Y_USERDATA, sizeof(struct YASL_BTreeNode));
+	node->count = 0;
+	node->leaf = leaf;
+	return node;
+}
+
+static void node_del(struct YASL_BTreeNode *const node) {
+	for (size_t i = 0; i < node->count; i++) {
+		dec_ref(node->keys + i);
+		dec_ref(node->vals + i);
+	}
+	if (!node->leaf) {
+		for (size_t i = 0; i <= node->count; i++) {
+			node_del(node->children[i]);
+		}
+	}
+	mem_free(node);
+}
+
+struct YASL_BTree *YASL_BTree_new(void) {
+	struct YASL_BTree *tree = (struct YASL_BTree *)mem_alloc(Y_USERDATA, sizeof(struct YASL_BTree));
+	tree->kind = BTREE_EMPTY;
+	tree->count = 0;
+	tree->version = 0;
+	tree->root = node_new(true);
+	return tree;
+}
+
+void YASL_BTree_del(void *ptr) {
+	struct YASL_BTree *tree = (struct YASL_BTree *)ptr;
+	if (!tree) return;
+	node_del(tree->root);
+	mem_free(tree);
+}
+
+void YASL_BTree_clear(struct YASL_BTree *const tree) {
+	struct YASL_BTreeNode *const root = tree->root;
+	tree->root = node_new(true);
+	node_del(root);
+	tree->kind = BTREE_EMPTY;
+	tree->count = 0;
+	tree->version++;
+}
+
+bool YASL_BTree_checkkey(struct YASL_BTree *const tree, const struct YASL_Object *const key) {
+	if (!YASL_BTree_cancompare(tree, key)) {
+		return false;
+	}
+	tree->kind = obj_isstr(key) ? BTREE_STR : BTREE_NUM;
+	return true;
+}
+
+bool YASL_BTree_cancompare(const struct YASL_BTree *const tree, const struct YASL_Object *const key) {
+	switch (key->type) {
+	case Y_INT:
+		return tree->kind != BTREE_STR;
+	case Y_FLOAT:
+		// NaN is unordered, so it would break the tree's invariants.
+		return tree->kind != BTREE_STR && !isnan(obj_getfloat(key));
+	case Y_STR:
+		return tree->kind == BTREE_EMPTY || tree->kind == BTREE_STR;
+	default:
+		return false;
+	}
+}
+
+int YASL_BTree_cmp(const struct YASL_Object *const a, const struct YASL_Object *const b) {
+	if (obj_isstr(a)) {
+		const int64_t cmp = YASL_String_cmp(obj_getstr(a), obj_getstr(b));
+		return (cmp > 0) - (cmp < 0);
+	}
+	if (obj_isint(a) && obj_isint(b)) {
+		const yasl_int l = obj_getint(a), r = obj_getint(b);
+		return (l > r) - (l < r);
+	}
+	const yasl_float l = obj_getnum(a), r = obj_getnum(b);
+	return (l > r) - (l < r);
+}
+
+/*
+ * Index of the first key in node that is >= key, or > key if strict.
+ */
+static size_t node_lower_bound(const struct YASL_BTreeNode *const node, const struct YASL_Object *const key,
+			       const bool strict) {
+	size_t lo = 0, hi = node->count;
+	while (lo < hi) {
+		const size_t mid = lo + (hi - lo) / 2;
+		const int cmp = YASL_BTree_cmp(node->keys + mid, key);
+		if (cmp < 0 || (strict && cmp == 0)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+static struct YASL_BTreeEntry entry_at(struct YASL_BTreeNode *const node, const size_t i) {
+	struct YASL_BTreeEntry entry = { node->keys + i, node->vals + i };
+	return entry;
+}
+
+static struct YASL_BTreeEntry entry_none(void) {
+	struct YASL_BTreeEntry entry = { NULL, NULL };
+	return entry;
+}
+
+/*
+ * Moves keys, values and (for internal nodes) children within or between nodes. Refcounts are left alone, since
+ * nothing is gained or lost.
+ */
+static void node_move(struct YASL_BTreeNode *const dest, const size_t to, struct YASL_BTreeNode *const src,
+		      const size_t from, const size_t n) {
+	memmove(dest->keys + to, src->keys + from, n * sizeof(struct YASL_Object));
+	memmove(dest->vals + to, src->vals + from, n * sizeof(struct YASL_Object));
+}
+
+static void node_move_children(struct YASL_BTreeNode *const dest, const size_t to, struct YASL_BTreeNode *const src,
+			       const size_t from, const size_t n) {
+	memmove(dest->children + to, src->children + from, n * sizeof(struct YASL_BTreeNode *));
+}
+
+/*
+ * Splits parent's full child i in two, moving its median key up into parent, which must not be full.
+ */
+static void node_split_child(struct YASL_BTreeNode *const parent, const size_t i) {
+	struct YASL_BTreeNode *const left = parent->children[i];
+	struct YASL_BTreeNode *const right = node_new(left->leaf);
+	node_move(right, 0, left, BTREE_T, BTREE_T - 1);
+	if (!left->leaf) {
+		node_move_children(right, 0, left, BTREE_T, BTREE_T);
+	}
+	right->count = BTREE_T - 1;
+	left->count = BTREE_T - 1;
+
+	node_move_children(parent, i + 2, parent, i + 1, parent->count - i);
+	parent->children[i + 1] = right;
+	node_move(parent, i + 1, parent, i, parent->count - i);
+	parent->keys[i] = left->keys[BTREE_T - 1];
+	parent->vals[i] = left->vals[BTREE_T - 1];
+	parent->count++;
+}
+
+static void node_setval(struct YASL_BTreeNode *const node, const size_t i, struct YASL_Object val) {
+	inc_ref(&val);
+	dec_ref(node->vals + i);
+	node->vals[i] = val;
+}
+
+/*
+ * Full nodes are split on the way down, so there is always room for the key once we reach a leaf.
+ */
+void YASL_BTree_insert(struct YASL_BTree *const tree, struct YASL_Object key, struct YASL_Object val) {
+	tree->version++;
+	if (tree->root->count == BTREE_MAXKEYS) {
+		struct YASL_BTreeNode *root = node_new(false);
+		root->children[0] = tree->root;
+		node_split_child(root, 0);
+		tree->root = root;
+	}
+
+	struct YASL_BTreeNode *node = tree->root;
+	for (;;) {
+		size_t i = node_lower_bound(node, &key, false);
+		if (i < node->count && YASL_BTree_cmp(node->keys + i, &key) == 0) {
+			node_setval(node, i, val);
+			return;
+		}
+		if (node->leaf) {
+			node_move(node, i + 1, node, i, node->count - i);
+			inc_ref(&key);
+			inc_ref(&val);
+			node->keys[i] = key;
+			node->vals[i] = val;
+			node->count++;
+			tree->count++;
+			return;
+		}
+		if (node->children[i]->count == BTREE_MAXKEYS) {
+			node_split_child(node, i);
+			const int cmp = YASL_BTree_cmp(&key, node->keys + i);
+			if (cmp == 0) {
+				node_setval(node, i, val);
+				return;
+			}
+			if (cmp > 0) i++;
+		}
+		node = node->children[i];
+	}
+}
+
+/*
+ * Merges parent's child i + 1 and the key between them into child i.
+ */
+static void node_merge_children(struct YASL_BTreeNode *const parent, const size_t i) {
+	struct YASL_BTreeNode *const left = parent->children[i];
+	struct YASL_BTreeNode *const right = parent->children[i + 1];
+	left->keys[left->count] = parent->keys[i];
+	left->vals[left->count] = parent->vals[i];
+	node_move(left, left->count + 1, right, 0, right->count);
+	if (!left->leaf) {
+		node_move_children(left, left->count + 1, right, 0, right->count + 1);
+	}
+	left->count += right->count + 1;
+
+	node_move(parent, i, parent, i + 1, parent->count - i - 1);
+	node_move_children(parent, i + 1, parent, i + 2, parent->count - i - 1);
+	parent->count--;
+	mem_free(right);
+}
+
+/*
+ * Makes sure parent's child i has at least BTREE_T keys, by borrowing from a sibling or merging with one. Returns the
+ * index of the child that now covers what child i did.
+ */
+static size_t node_fill_child(struct YASL_BTreeNode *const parent, const size_t i) {
+	struct YASL_BTreeNode *const child = parent->children[i];
+	if (i > 0 && parent->children[i - 1]->count >= BTREE_T) {
+		struct YASL_BTreeNode *const left = parent->children[i - 1];
+		node_move(child, 1, child, 0, child->count);
+		if (!child->leaf) {
+			node_move_children(child, 1, child, 0, child->count + 1);
+			child->children[0] = left->children[left->count];
+		}
+		child->keys[0] = parent->keys[i - 1];
+		child->vals[0] = parent->vals[i - 1];
+		child->count++;
+		left->count--;
+		parent->keys[i - 1] = left->keys[left->count];
+		parent->vals[i - 1] = left->vals[left->count];
+		return i;
+	}
+	if (i < parent->count && parent->children[i + 1]->count >= BTREE_T) {
+		struct YASL_BTreeNode *const right = parent->children[i + 1];
+		child->keys[child->count] = parent->keys[i];
+		child->vals[child->count] = parent->vals[i];
+		if (!child->leaf) {
+			child->children[child->count + 1] = right->children[0];
+			node_move_children(right, 0, right, 1, right->count);
+		}
+		child->count++;
+		parent->keys[i] = right->keys[0];
+		parent->vals[i] = right->vals[0];
+		node_move(right, 0, right, 1, right->count - 1);
+		right->count--;
+		return i;
+	}
+	if (i < parent->count) {
+		node_merge_children(parent, i);
+		return i;
+	}
+	node_merge_children(parent, i - 1);
+	return i - 1;
+}
+
+/*
+ * Removes key from the subtree under node, moving the tree's references to it and its value into *out. Every node we
+ * go down into has at least BTREE_T keys, so removing one never leaves it too small.
+ */
+static bool node_remove(struct YASL_BTreeNode *node, const struct YASL_Object *const key,
+			struct YASL_BTreeNode *const out, const size_t slot) {
+	for (;;) {
+		const size_t i = node_lower_bound(node, key, false);
+		const bool found = i < node->count && YASL_BTree_cmp(node->keys + i, key) == 0;
+		if (found && node->leaf) {
+			out->keys[slot] = node->keys[i];
+			out->vals[slot] = node->vals[i];
+			node_move(node, i, node, i + 1, node->count - i - 1);
+			node->count--;
+			return true;
+		}
+		if (found) {
+			struct YASL_BTreeNode *const left = node->children[i];
+			struct YASL_BTreeNode *const right = node->children[i + 1];
+			if (left->count >= BTREE_T || right->count >= BTREE_T) {
+				// Replace the key with its predecessor or successor, whichever child can spare one.
+				const bool pred = left->count >= BTREE_T;
+				struct YASL_BTreeNode *const child = pred ? left : right;
+				struct YASL_BTreeNode *leaf = child;
+				while (!leaf->leaf) {
+					leaf = leaf->children[pred ? leaf->count : 0];
+				}
+				const struct YASL_Object next = leaf->keys[pred ? leaf->count - 1 : 0];
+				out->keys[slot] = node->keys[i];
+				out->vals[slot] = node->vals[i];
+				return node_remove(child, &next, node, i);
+			}
+			node_merge_children(node, i);
+			node = left;
+			continue;
+		}
+		if (node->leaf) {
+			return false;
+		}
+		size_t c = i;
+		if (node->children[c]->count < BTREE_T) {
+			c = node_fill_child(node, c);
+		}
+		node = node->children[c];
+	}
+}
+
+bool YASL_BTree_rm(struct YASL_BTree *const tree, const struct YASL_Object *const key) {
+	if (tree->count == 0 || !YASL_BTree_cancompare(tree, key)) {
+		return false;
+	}
+	tree->version++;
+	struct YASL_BTreeNode removed;
+	const bool found = node_remove(tree->root, key, &removed, 0);
+	if (!tree->root->leaf && tree->root->count == 0) {
+		struct YASL_BTreeNode *const root = tree->root;
+		tree->root = root->children[0];
+		mem_free(root);
+	}
+	if (!found) {
+		return false;
+	}
+	dec_ref(removed.keys);
+	dec_ref(removed.vals);
+	if (--tree->count == 0) {
+		tree->kind = BTREE_EMPTY;
+	}
+	return true;
+}
+
+struct YASL_BTreeEntry YASL_BTree_search(const struct YASL_BTree *const tree, const struct YASL_Object *const key) {
+	if (tree->count == 0 || !YASL_BTree_cancompare(tree, key)) {
+		return entry_none();
+	}
+	struct YASL_BTreeNode *node = tree->root;
+	for (;;) {
+		const size_t i = node_lower_bound(node, key, false);
+		if (i < node->count && YASL_BTree_cmp(node->keys + i, key) == 0) {
+			return entry_at(node, i);
+		}
+		if (node->leaf) {
+			return entry_none();
+		}
+		node = node->children[i];
+	}
+}
+
+struct YASL_BTreeEntry YASL_BTree_floor(const struct YASL_BTree *const tree, const struct YASL_Object *const key,
+					const bool strict) {
+	struct YASL_BTreeEntry best = entry_none();
+	if (tree->count == 0 || !YASL_BTree_cancompare(tree, key)) {
+		return best;
+	}
+	struct YASL_BTreeNode *node = tree->root;
+	for (;;) {
+		// keys[i] is the first key that is too big, so keys[i - 1] is the best candidate so far.
+		const size_t i = node_lower_bound(node, key, !strict);
+		if (i > 0) {
+			best = entry_at(node, i - 1);
+		}
+		if (node->leaf) {
+			return best;
+		}
+		node = node->children[i];
+	}
+}
+
+struct YASL_BTreeEntry YASL_BTree_ceil(const struct YASL_BTree *const tree, const struct YASL_Object *const key,
+				       const bool strict) {
+	struct YASL_BTreeEntry best = entry_none();
+	if (tree->count == 0 || !YASL_BTree_cancompare(tree, key)) {
+		return best;
+	}
+	struct YASL_BTreeNode *node = tree->root;
+	for (;;) {
+		const size_t i = node_lower_bound(node, key, strict);
+		if (i < node->count) {
+			best = entry_at(node, i);
+		}
+		if (node->leaf) {
+			return best;
+		}
+		node = node->children[i];
+	}
+}
+
+struct YASL_BTreeEntry YASL_BTree_min(const struct YASL_BTree *const tree) {
+	if (tree->count == 0) {
+		return entry_none();
+	}
+	struct YASL_BTreeNode *node = tree->root;
+	while (!node->leaf) {
+		node = node->children[0];
+	}
+	return entry_at(node, 0);
+}
+
+struct YASL_BTreeEntry YASL_BTree_max(const struct YASL_BTree *const tree) {
+	if (tree->count == 0) {
+		return entry_none();
+	}
+	struct YASL_BTreeNode *node = tree->root;
+	while (!node->leaf) {
+		node = node->children[node->count];
+	}
+	return entry_at(node, node->count - 1);
+}
+
+/*
+ * If the cursor has run off the end of its node, climbs up to the next key. Leaves depth at -1 once there is none.
+ */
+static void cursor_settle(struct YASL_BTreeCursor *const cursor) {
+	while (cursor->depth >= 0 && cursor->idx[cursor->depth] >= cursor->nodes[cursor->depth]->count) {
+		cursor->depth--;
+	}
+}
+
+static void cursor_push(struct YASL_BTreeCursor *const cursor, struct YASL_BTreeNode *const node, const size_t i) {
+	cursor->depth++;
+	cursor->nodes[cursor->depth] = node;
+	cursor->idx[cursor->depth] = i;
+}
+
+void YASL_BTree_seek(const struct YASL_BTree *const tree, struct YASL_BTreeCursor *const cursor,
+		     const struct YASL_Object *const key, const bool strict) {
+	cursor->depth = -1;
+	if (tree->count == 0) {
+		return;
+	}
+	if (key && !YASL_BTree_cancompare(tree, key)) {
+		return;
+	}
+	struct YASL_BTreeNode *node = tree->root;
+	for (;;) {
+		const size_t i = key ? node_lower_bound(node, key, strict) : 0;
+		cursor_push(cursor, node, i);
+		if (node->leaf || (key && !strict && i < node->count &&
+				   YASL_BTree_cmp(node->keys + i, key) == 0)) {
+			break;
+		}
+		node = node->children[i];
+	}
+	cursor_settle(cursor);
+}
+
+struct YASL_BTreeEntry YASL_BTree_cursor_entry(const struct YASL_BTreeCursor *const cursor) {
+	if (cursor->depth < 0) {
+		return entry_none();
+	}
+	return entry_at(cursor->nodes[cursor->depth], cursor->idx[cursor->depth]);
+}
+
+void YASL_BTree_cursor_next(struct YASL_BTreeCursor *const cursor) {
+	if (cursor->depth < 0) {
+		return;
+	}
+	struct YASL_BTreeNode *node = cursor->nodes[cursor->depth];
+	const size_t i = ++cursor->idx[cursor->depth];
+	if (!node->leaf) {
+		node = node->children[i];
+		while (!node->leaf) {
+			cursor_push(cursor, node, 0);
+			node = node->children[0];
+		}
+		cursor_push(cursor, node, 0);
+	}
+	cursor_settle(cursor);
+}
@@ -0,0 +1,114 @@
+#ifndef YASL_YASL_BTREE_H_
+#define YASL_YASL_BTREE_H_
+
+#include <stdlib.h>
+
+#include "interpreter/YASL_Object.h"
+
+// Minimum degree. Every node but the root holds between BTREE_T - 1 and 2 * BTREE_T - 1 keys.
+#define BTREE_T 16
+#define BTREE_MAXKEYS (2 * BTREE_T - 1)
+// Enough for any tree that fits in memory, since each level multiplies the number of keys by at least BTREE_T.
+#define BTREE_MAXDEPTH 24
+
+/*
+ * What the keys in a tree are. Like collections.heap, a tree only orders numbers or strings.
+ */
+enum YASL_BTreeKind {
+	BTREE_EMPTY,
+	BTREE_NUM,
+	BTREE_STR
+};
+
+/*
+ * Keys and values are kept in separate arrays, so a search only touches the keys.
+ */
+struct YASL_BTreeNode {
+	size_t count;
+	bool leaf;
+	struct YASL_Object keys[BTREE_MAXKEYS];
+	struct YASL_Object vals[BTREE_MAXKEYS];
+	struct YASL_BTreeNode *children[BTREE_MAXKEYS + 1];
+};
+
+/*
+ * B-tree mapping keys to values, in key order. `version` changes whenever the tree's shape might have, so cursors can
+ * tell when they need to find their place again.
+ */
+struct YASL_BTree {
+	enum YASL_BTreeKind kind;
+	size_t count;
+	size_t version;
+	struct YASL_BTreeNode *root;
+};
+
+/*
+ * Pointers into a tree. Both are NULL if there is no such entry. They are only valid until the tree is next modified.
+ */
+struct YASL_BTreeEntry {
+	struct YASL_Object *key;
+	struct YASL_Object *val;
+};
+
+/*
+ * Position of an in-order walk over a tree. nodes[0] is the root; idx[i] is the child of nodes[i] we went down
+ * through, except at the top, where it is the index of the current key.
+ */
+struct YASL_BTreeCursor {
+	int depth;
+	struct YASL_BTreeNode *nodes[BTREE_MAXDEPTH];
+	size_t idx[BTREE_MAXDEPTH];
+};
+
+struct YASL_BTree *YASL_BTree_new(void);
+void YASL_BTree_del(void *tree);
+
+/*
+ * Returns false, leaving tree as it is, if key can't be compared with the keys already in tree.
+ */
+bool YASL_BTree_checkkey(struct YASL_BTree *const tree, const struct YASL_Object *const key);
+
+/*
+ * Like YASL_BTree_checkkey, but never changes what keys tree accepts. Lookups use this, so an incomparable key is
+ * simply not found.
+ */
+bool YASL_BTree_cancompare(const struct YASL_BTree *const tree, const struct YASL_Object *const key);
+
+/*
+ * Inserts key, or replaces its value if it is already in tree. key must have passed YASL_BTree_checkkey. The tree
+ * takes its own references to key and val.
+ */
+void YASL_BTree_insert(struct YASL_BTree *const tree, struct YASL_Object key, struct YASL_Object val);
+
+/*
+ * Returns false if key was not in tree.
+ */
+bool YASL_BTree_rm(struct YASL_BTree *const tree, const struct YASL_Object *const key);
+void YASL_BTree_clear(struct YASL_BTree *const tree);
+
+struct YASL_BTreeEntry YASL_BTree_search(const struct YASL_BTree *const tree, const struct YASL_Object *const key);
+
+/*
+ * The entry with the greatest key <= key (or < key, if strict), and the entry with the least key >= key (or > key).
+ */
+struct YASL_BTreeEntry YASL_BTree_floor(const struct YASL_BTree *const tree, const struct YASL_Object *const key,
+					bool strict);
+struct YASL_BTreeEntry YASL_BTree_ceil(const struct YASL_BTree *const tree, const struct YASL_Object *const key,
+				       bool strict);
+struct YASL_BTreeEntry YASL_BTree_min(const struct YASL_BTree *const tree);
+struct YASL_BTreeEntry YASL_BTree_max(const struct YASL_BTree *const tree);
+
+/*
+ * Puts cursor on the least key >= key (or > key, if strict). If key is NULL, puts it on the least key in tree.
+ */
+void YASL_BTree_seek(const struct YASL_BTree *const tree, struct YASL_BTreeCursor *const cursor,
+		     const struct YASL_Object *const key, bool strict);
+struct YASL_BTreeEntry YASL_BTree_cursor_entry(const struct YASL_BTreeCursor *const cursor);
+void YASL_BTree_cursor_next(struct YASL_BTreeCursor *const cursor);
+
+/*
+ * -1, 0 or 1 as a is less than, equal to or greater than b. a and b must both be numbers or both be strings.
+ */
+int YASL_BTree_cmp(const struct YASL_Object *const a, const struct YASL_Object *const b);
+
+#endif
@@ -0,0 +1,84 @@
+#include "YASL_Deque.h"
+
+#include <string.h>
+
+#include "interpreter/alloc.h"
+#include "interpreter/refcount.h"
+
+const char *const DEQUE_NAME = "collections.deque";
+
+struct YASL_Deque *YASL_Deque_new_sized(const size_t base_size, const size_t maxlen) {
+	struct YASL_Deque *deque = (struct YASL_Deque *)mem_alloc(Y_USERDATA, sizeof(struct YASL_Deque));
+	size_t size = DEQUE_BASESIZE;
+	while (size < base_size) size *= 2;
+	deque->size = size;
+	deque->head = 0;
+	deque->count = 0;
+	deque->maxlen = maxlen;
+	deque->items = (struct YASL_Object *)mem_alloc(Y_USERDATA, size * sizeof(struct YASL_Object));
+	return deque;
+}
+
+void YASL_Deque_del(void *ptr) {
+	struct YASL_Deque *deque = (struct YASL_Deque *)ptr;
+	if (!deque) return;
+	YASL_Deque_clear(deque);
+	mem_free(deque->items);
+	mem_free(deque);
+}
+
+/*
+ * Doubles the buffer, unwrapping the items so that they start at index 0.
+ */
+static void deque_resize_up(struct YASL_Deque *const deque) {
+	const size_t new_size = deque->size * 2;
+	struct YASL_Object *items = (struct YASL_Object *)mem_alloc(Y_USERDATA, new_size * sizeof(struct YASL_Object));
+	const size_t first = deque->size - deque->head < deque->count ? deque->size - deque->head : deque->count;
+	memcpy(items, deque->items + deque->head, first * sizeof(struct YASL_Object));
+	memcpy(items + first, deque->items, (deque->count - first) * sizeof(struct YASL_Object));
+	mem_free(deque->items);
+	deque->items = items;
+	deque->size = new_size;
+	deque->head = 0;
+}
+
+void YASL_Deque_push(struct YASL_Deque *const deque, struct YASL_Object value) {
+	inc_ref(&value);
+	if (deque->maxlen && deque->count == deque->maxlen) {
+		struct YASL_Object dropped = YASL_Deque_popleft(deque);
+		dec_ref(&dropped);
+	}
+	if (deque->count == deque->size) deque_resize_up(deque);
+	*YASL_Deque_at(deque, deque->count++) = value;
+}
+
+void YASL_Deque_pushleft(struct YASL_Deque *const deque, struct YASL_Object value) {
+	inc_ref(&value);
+	if (deque->maxlen && deque->count == deque->maxlen) {
+		struct YASL_Object dropped = YASL_Deque_pop(deque);
+		dec_ref(&dropped);
+	}
+	if (deque->count == deque->size) deque_resize_up(deque);
+	deque->head = (deque->head - 1) & (deque->size - 1);
+	deque->items[deque->head] = value;
+	deque->count++;
+}
+
+struct YASL_Object YASL_Deque_pop(struct YASL_Deque *const deque) {
+	return *YASL_Deque_at(deque, --deque->count);
+}
+
+struct YASL_Object YASL_Deque_popleft(struct YASL_Deque *const deque) {
+	struct YASL_Object value = deque->items[deque->head];
+	deque->head = (deque->head + 1) & (deque->size - 1);
+	deque->count--;
+	return value;
+}
+
+void YASL_Deque_clear(struct YASL_Deque *const deque) {
+	for (size_t i = 0; i < deque->count; i++) {
+		dec_ref(YASL_Deque_at(deque, i));
+	}
+	deque->head = 0;
+	deque->count = 0;
+}
@@ -0,0 +1,43 @@
+#ifndef YASL_YASL_DEQUE_H_
+#define YASL_YASL_DEQUE_H_
+
+#include <stdlib.h>
+
+#include "interpreter/YASL_Object.h"
+
+#define DEQUE_BASESIZE 8
+
+// Userdata tag, which is also the name of the metatable, for deques.
+extern const char *const DEQUE_NAME;
+
+/*
+ * Ring buffer of YASL_Object. Items are stored at items[(head + i) & (size - 1)], so size is always a power of 2. If
+ * maxlen is nonzero, pushing onto a full deque drops an item from the opposite end.
+ */
+struct YASL_Deque {
+	size_t size;
+	size_t head;
+	size_t count;
+	size_t maxlen;
+	struct YASL_Object *items;
+};
+
+struct YASL_Deque *YASL_Deque_new_sized(const size_t base_size, const size_t maxlen);
+void YASL_Deque_del(void *deque);
+
+static inline struct YASL_Object *YASL_Deque_at(const struct YASL_Deque *const deque, const size_t i) {
+	return deque->items + ((deque->head + i) & (deque->size - 1));
+}
+
+void YASL_Deque_push(struct YASL_Deque *const deque, struct YASL_Object value);
+void YASL_Deque_pushleft(struct YASL_Deque *const deque, struct YASL_Object value);
+
+/*
+ * These remove and return an item. The deque's reference to it is handed to the caller. The deque must be nonempty.
+ */
+struct YASL_Object YASL_Deque_pop(struct YASL_Deque *const deque);
+struct YASL_Object YASL_Deque_popleft(struct YASL_Deque *const deque);
+
+void YASL_Deque_clear(struct YASL_Deque *const deque);
+
+#endif
@@ -0,0 +1,135 @@
+#include "YASL_Heap.h"
+
+#include "data-structures/YASL_String.h"
+#include "interpreter/alloc.h"
+#include "interpreter/refcount.h"
+
+const char *const HEAP_NAME = "collections.heap";
+
+struct YASL_Heap *YASL_Heap_new_sized(const size_t base_size) {
+	struct YASL_Heap *heap = (struct YASL_Heap *)mem_alloc(Y_USERDATA, sizeof(struct YASL_Heap));
+	heap->kind = HEAP_EMPTY;
+	heap->keyfn = YASL_UNDEF();
+	heap->size = base_size ? base_size : HEAP_BASESIZE;
+	heap->count = 0;
+	heap->entries = (struct YASL_HeapEntry *)mem_alloc(Y_USERDATA, heap->size * sizeof(struct YASL_HeapEntry));
+	return heap;
+}
+
+void YASL_Heap_del(void *ptr) {
+	struct YASL_Heap *heap = (struct YASL_Heap *)ptr;
+	if (!heap) return;
+	YASL_Heap_clear(heap);
+	dec_ref(&heap->keyfn);
+	mem_free(heap->entries);
+	mem_free(heap);
+}
+
+bool YASL_Heap_checkkey(struct YASL_Heap *const heap, const struct YASL_Object *const key) {
+	switch (key->type) {
+	case Y_INT:
+		if (heap->kind == HEAP_EMPTY) heap->kind = HEAP_INT;
+		return heap->kind != HEAP_STR;
+	case Y_FLOAT:
+		if (heap->kind == HEAP_EMPTY || heap->kind == HEAP_INT) heap->kind = HEAP_NUM;
+		return heap->kind != HEAP_STR;
+	case Y_STR:
+		if (heap->kind == HEAP_EMPTY) heap->kind = HEAP_STR;
+		return heap->kind == HEAP_STR;
+	default:
+		return false;
+	}
+}
+
+static inline bool entry_less(const enum YASL_HeapKind kind, const struct YASL_HeapEntry *const a,
+			      const struct YASL_HeapEntry *const b) {
+	switch (kind) {
+	case HEAP_INT:
+		return obj_getint(&a->key) < obj_getint(&b->key);
+	case HEAP_STR:
+		return YASL_String_cmp(obj_getstr(&a->key), obj_getstr(&b->key)) < 0;
+	default:
+		if (obj_isint(&a->key) && obj_isint(&b->key)) {
+			return obj_getint(&a->key) < obj_getint(&b->key);
+		}
+		return obj_getnum(&a->key) < obj_getnum(&b->key);
+	}
+}
+
+/*
+ * Both sifts move a hole rather than swapping, so each level costs one copy.
+ */
+static void sift_up(struct YASL_Heap *const heap, size_t i, const struct YASL_HeapEntry entry) {
+	struct YASL_HeapEntry *const entries = heap->entries;
+	while (i > 0) {
+		const size_t parent = (i - 1) / 2;
+		if (!entry_less(heap->kind, &entry, entries + parent)) break;
+		entries[i] = entries[parent];
+		i = parent;
+	}
+	entries[i] = entry;
+}
+
+static void sift_down(struct YASL_Heap *const heap, size_t i, const struct YASL_HeapEntry entry) {
+	struct YASL_HeapEntry *const entries = heap->entries;
+	const size_t n = heap->count;
+	while (2 * i + 1 < n) {
+		size_t child = 2 * i + 1;
+		if (child + 1 < n && entry_less(heap->kind, entries + child + 1, entries + child)) child++;
+		if (!entry_less(heap->kind, entries + child, &entry)) break;
+		entries[i] = entries[child];
+		i = child;
+	}
+	entries[i] = entry;
+}
+
+void YASL_Heap_reserve(struct YASL_Heap *const heap, const size_t size) {
+	if (size <= heap->size) return;
+	size_t new_size = heap->size * 2;
+	while (new_size < size) new_size *= 2;
+	heap->entries = (struct YASL_HeapEntry *)mem_realloc(Y_USERDATA, heap->entries, new_size * sizeof(struct YASL_HeapEntry));
+	heap->size = new_size;
+}
+
+void YASL_Heap_append(struct YASL_Heap *const heap, struct YASL_HeapEntry entry) {
+	inc_ref(&entry.key);
+	inc_ref(&entry.item);
+	YASL_Heap_reserve(heap, heap->count + 1);
+	heap->entries[heap->count++] = entry;
+}
+
+void YASL_Heap_push(struct YASL_Heap *const heap, struct YASL_HeapEntry entry) {
+	YASL_Heap_append(heap, entry);
+	sift_up(heap, heap->count - 1, entry);
+}
+
+void YASL_Heap_heapify(struct YASL_Heap *const heap) {
+	for (size_t i = heap->count / 2; i-- > 0;) {
+		sift_down(heap, i, heap->entries[i]);
+	}
+}
+
+struct YASL_HeapEntry YASL_Heap_pop(struct YASL_Heap *const heap) {
+	const struct YASL_HeapEntry top = heap->entries[0];
+	if (--heap->count > 0) {
+		sift_down(heap, 0, heap->entries[heap->count]);
+	}
+	return top;
+}
+
+struct YASL_HeapEntry YASL_Heap_replace(struct YASL_Heap *const heap, struct YASL_HeapEntry entry) {
+	const struct YASL_HeapEntry top = heap->entries[0];
+	inc_ref(&entry.key);
+	inc_ref(&entry.item);
+	sift_down(heap, 0, entry);
+	return top;
+}
+
+void YASL_Heap_clear(struct YASL_Heap *const heap) {
+	for (size_t i = 0; i < heap->count; i++) {
+		dec_ref(&heap->entries[i].key);
+		dec_ref(&heap->entries[i].item);
+	}
+	heap->count = 0;
+	heap->kind = HEAP_EMPTY;
+}
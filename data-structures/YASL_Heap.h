@@ -0,0 +1,74 @@
+#ifndef YASL_YASL_HEAP_H_
+#define YASL_YASL_HEAP_H_
+
+#include <stdlib.h>
+
+#include "interpreter/YASL_Object.h"
+
+#define HEAP_BASESIZE 8
+
+// Userdata tag, which is also the name of the metatable, for heaps.
+extern const char *const HEAP_NAME;
+
+/*
+ * What the keys in a heap are. Like list.sort, a heap only orders numbers or strings, and picks the cheapest
+ * comparison that works for every key it has seen.
+ */
+enum YASL_HeapKind {
+	HEAP_EMPTY,
+	HEAP_INT,
+	HEAP_NUM,
+	HEAP_STR
+};
+
+struct YASL_HeapEntry {
+	struct YASL_Object key;
+	struct YASL_Object item;
+};
+
+/*
+ * Binary min-heap of items, ordered by their keys.
+ */
+struct YASL_Heap {
+	enum YASL_HeapKind kind;
+	struct YASL_Object keyfn;  // computes each item's key, or undef if items are their own keys
+	size_t size;
+	size_t count;
+	struct YASL_HeapEntry *entries;
+};
+
+struct YASL_Heap *YASL_Heap_new_sized(const size_t base_size);
+void YASL_Heap_del(void *heap);
+
+/*
+ * Returns false, leaving heap as it is, if key can't be compared with the keys already in heap.
+ */
+bool YASL_Heap_checkkey(struct YASL_Heap *const heap, const struct YASL_Object *const key);
+
+void YASL_Heap_reserve(struct YASL_Heap *const heap, const size_t size);
+
+/*
+ * The heap takes its own references to entry's key and item.
+ */
+void YASL_Heap_push(struct YASL_Heap *const heap, const struct YASL_HeapEntry entry);
+
+/*
+ * Adds entry without restoring the heap order. Call YASL_Heap_heapify once done.
+ */
+void YASL_Heap_append(struct YASL_Heap *const heap, const struct YASL_HeapEntry entry);
+void YASL_Heap_heapify(struct YASL_Heap *const heap);
+
+/*
+ * Removes the smallest entry. The heap's references to its key and item are handed to the caller. The heap must be
+ * nonempty.
+ */
+struct YASL_HeapEntry YASL_Heap_pop(struct YASL_Heap *const heap);
+
+/*
+ * Pops the smallest entry and pushes entry in its place, with a single sift.
+ */
+struct YASL_HeapEntry YASL_Heap_replace(struct YASL_Heap *const heap, const struct YASL_HeapEntry entry);
+
+void YASL_Heap_clear(struct YASL_Heap *const heap);
+
+#endif
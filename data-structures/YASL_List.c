@@ -1,6 +1,7 @@
 #include "YASL_List.h"
 
 #include "interpreter/YASL_Object.h"
+#include "interpreter/alloc.h"
 #include "data-structures/YASL_Table.h"
 
 #include <string.h>
@@ -8,15 +9,16 @@
 const char *const LIST_NAME = "list";
 
 struct YASL_List *YASL_List_new_sized(const size_t base_size) {
-	struct YASL_List *list = (struct YASL_List *)malloc(sizeof(struct YASL_List));
+	struct YASL_List *list = (struct YASL_List *)mem_alloc(Y_LIST, sizeof(struct YASL_List));
 	list->size = base_size;
 	list->count = 0;
-	list->items = (struct YASL_Object *)malloc(sizeof(struct YASL_Object) * list->size);
+	list->items = (struct YASL_Object *)mem_alloc(Y_LIST, sizeof(struct YASL_Object) * list->size);
+	list->storage = NULL;
 	return list;
 }
 
 struct RC_UserData* rcls_new_sized(const size_t base_size) {
-	struct RC_UserData *ls = (struct RC_UserData *)malloc(sizeof(struct RC_UserData));
+	struct RC_UserData *ls = (struct RC_UserData *)mem_alloc(Y_LIST, sizeof(struct RC_UserData));
 
 	ls->data = YASL_List_new_sized(base_size);
 	ls->rc = NEW_RC();
@@ -30,10 +32,87 @@ struct RC_UserData* rcls_new(void) {
 	return rcls_new_sized(LIST_BASESIZE);
 }
 
+static void storage_release(struct YASL_ListStorage *const storage) {
+	if (--storage->refs > 0) {
+		return;
+	}
+	for (size_t i = 0; i < storage->count; i++) dec_ref(storage->items + i);
+	mem_free(storage->items);
+	mem_free(storage);
+}
+
+/*
+ * Creates a list of the items of ls in [start, end) without copying them. Both lists share ls's items until either
+ * of them is modified.
+ */
+struct RC_UserData *rcls_slice(struct YASL_List *const ls, const size_t start, const size_t end) {
+	if (!ls->storage) {
+		ls->storage = (struct YASL_ListStorage *)mem_alloc(Y_LIST, sizeof(struct YASL_ListStorage));
+		ls->storage->refs = 1;
+		ls->storage->size = ls->size;
+		ls->storage->count = ls->count;
+		ls->storage->items = ls->items;
+	}
+
+	struct YASL_List *slice = (struct YASL_List *)mem_alloc(Y_LIST, sizeof(struct YASL_List));
+	slice->size = end - start;
+	slice->count = end - start;
+	slice->items = ls->items + start;
+	slice->storage = ls->storage;
+	slice->storage->refs++;
+
+	struct RC_UserData *ud = (struct RC_UserData *)mem_alloc(Y_LIST, sizeof(struct RC_UserData));
+	ud->data = slice;
+	ud->rc = NEW_RC();
+	ud->mt = NULL;
+	ud->destructor = YASL_List_del_data;
+	ud->tag = LIST_NAME;
+	return ud;
+}
+
+/*
+ * Gives ls its own copy of its items, if it is sharing them. This must be called before modifying a list.
+ */
+void YASL_List_unshare(struct YASL_List *const ls) {
+	struct YASL_ListStorage *storage = ls->storage;
+	if (!storage) {
+		return;
+	}
+
+	if (storage->refs == 1) {
+		ls->storage = NULL;
+		// ls is the last list using storage, so we can take it over.
+		const size_t start = (size_t)(ls->items - storage->items);
+		for (size_t i = 0; i < start; i++) dec_ref(storage->items + i);
+		for (size_t i = start + ls->count; i < storage->count; i++) dec_ref(storage->items + i);
+		memmove(storage->items, ls->items, ls->count * sizeof(struct YASL_Object));
+		ls->items = storage->items;
+		ls->size = storage->size;
+		mem_free(storage);
+		return;
+	}
+
+	// Allocate before changing ls, in case that raises a MemoryError.
+	const size_t size = ls->count > LIST_BASESIZE ? ls->count : LIST_BASESIZE;
+	struct YASL_Object *items = (struct YASL_Object *)mem_alloc(Y_LIST, size * sizeof(struct YASL_Object));
+	ls->storage = NULL;
+	memcpy(items, ls->items, ls->count * sizeof(struct YASL_Object));
+	ls->items = items;
+	ls->size = size;
+	for (size_t i = 0; i < ls->count; i++) inc_ref(ls->items + i);
+	storage_release(storage);
+}
+
 void YASL_List_del_data(void *ls) {
-	for (size_t i = 0; i < ((struct YASL_List *) ls)->count; i++) dec_ref(((struct YASL_List *) ls)->items + i);
-	free(((struct YASL_List *) ls)->items);
-	free(ls);
+	struct YASL_List *list = (struct YASL_List *)ls;
+	if (list->storage) {
+		storage_release(list->storage);
+		mem_free(list);
+		return;
+	}
+	for (size_t i = 0; i < list->count; i++) dec_ref(list->items + i);
+	mem_free(list->items);
+	mem_free(list);
 }
 
 yasl_int YASL_List_length(const struct YASL_List *const ls) {
@@ -41,7 +120,7 @@ yasl_int YASL_List_length(const struct YASL_List *const ls) {
 }
 
 static void ls_resize(struct YASL_List *const ls, const size_t base_size) {
-	ls->items = (struct YASL_Object *)realloc(ls->items, base_size * sizeof(struct YASL_Object));
+	ls->items = (struct YASL_Object *)mem_realloc(Y_LIST, ls->items, base_size * sizeof(struct YASL_Object));
 	ls->size = base_size;
 }
 
@@ -50,13 +129,32 @@ static void ls_resize_up(struct YASL_List *const ls) {
 	ls_resize(ls, new_size);
 }
 
+void YASL_List_reserve(struct YASL_List *const ls, const size_t size) {
+	YASL_List_unshare(ls);
+	if (size <= ls->size) return;
+	size_t new_size = ls->size ? ls->size * 2 : 1;
+	while (new_size < size) new_size *= 2;
+	ls_resize(ls, new_size);
+}
+
+void YASL_List_extend(struct YASL_List *const ls, const struct YASL_List *const other) {
+	const size_t n = other->count;
+	YASL_List_reserve(ls, ls->count + n);
+	// other may be ls itself, so only look at its items once ls has been resized.
+	memcpy(ls->items + ls->count, other->items, n * sizeof(struct YASL_Object));
+	for (size_t i = ls->count; i < ls->count + n; i++) inc_ref(ls->items + i);
+	ls->count += n;
+}
+
 void YASL_List_append(struct YASL_List *const ls, struct YASL_Object value) {
+	YASL_List_unshare(ls);
 	if (ls->count >= ls->size) ls_resize_up(ls);
 	ls->items[ls->count++] = value;
 	inc_ref(&value);
 }
 
 void YASL_List_insert(struct YASL_List *const ls, size_t index, struct YASL_Object value) {
+	YASL_List_unshare(ls);
 	if (ls->count >= ls->size) ls_resize_up(ls);
 	memmove(ls->items + index + 1, ls->items + index, (ls->count - index) * sizeof(struct YASL_Object));
 	ls->items[index] = value;
@@ -65,6 +163,7 @@ void YASL_List_insert(struct YASL_List *const ls, size_t index, struct YASL_Obje
 }
 
 void YASL_reverse(struct YASL_List *const ls) {
+	YASL_List_unshare(ls);
 	for (size_t i = 0; i < ls->count / 2; i++) {
 		struct YASL_Object tmp = ls->items[i];
 		ls->items[i] = ls->items[ls->count - i - 1];
@@ -9,20 +9,44 @@
 
 #define FOR_LIST(i, name, list) struct YASL_Object name; for (size_t i = 0; i < (list)->count && (name = (list)->items[i], 1); i++)
 
+/*
+ * Storage shared between a list and slices of it. It holds one reference to each of its items, and each list sharing
+ * it sees a window of them. Lists copy their window out before they are modified (see YASL_List_unshare).
+ */
+struct YASL_ListStorage {
+	size_t refs;
+	size_t size;
+	size_t count;
+	struct YASL_Object *items;
+};
+
 struct YASL_List {
 	size_t size;
 	size_t count;
 	struct YASL_Object *items;
+	struct YASL_ListStorage *storage;  // NULL unless items are shared with another list
 };
 
 struct YASL_List *YASL_List_new_sized(const size_t base_size);
 void YASL_List_del_data(void *ls);
 yasl_int YASL_List_length(const struct YASL_List *const ls);
 void YASL_List_append(struct YASL_List *const ls, struct YASL_Object value);
+
+/*
+ * Makes room for at least size items, growing geometrically, so a run of appends only reallocates once.
+ */
+void YASL_List_reserve(struct YASL_List *const ls, const size_t size);
+
+/*
+ * Appends all items of other, which may be ls itself, with a single resize and copy.
+ */
+void YASL_List_extend(struct YASL_List *const ls, const struct YASL_List *const other);
 void YASL_List_insert(struct YASL_List *const ls, size_t index, struct YASL_Object value);
 void YASL_reverse(struct YASL_List *const ls);
+void YASL_List_unshare(struct YASL_List *const ls);
 
 struct RC_UserData *rcls_new(void);
 struct RC_UserData* rcls_new_sized(const size_t base_size);
+struct RC_UserData *rcls_slice(struct YASL_List *const ls, const size_t start, const size_t end);
 
 #endif
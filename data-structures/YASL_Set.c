@@ -1,61 +1,194 @@
 #include "YASL_Set.h"
 
+#include <string.h>
+
+#include "interpreter/alloc.h"
 #include "util/hash_function.h"
 #include "util/prime.h"
 
 #define SET_BASESIZE 30
+#define SET_NOTFOUND ((size_t)-1)
 
-static struct YASL_Set *set_new_sized(const size_t base_size) {
-	struct YASL_Set *set = (struct YASL_Set *)malloc(sizeof(struct YASL_Set));
+const char SET_NAME[] = "collections.set";
+
+/*
+ * Hash used for the whole lifetime of an item. Unlike get_hash, it does not depend on the table size, so it can be
+ * stored alongside the item and reused when the set grows, shrinks, or is copied.
+ */
+static size_t set_hash(const struct YASL_Object value) {
+	return hash_function(value, PRIME_A, SIZE_MAX);
+}
+
+/*
+ * The probe step is derived from a scrambled copy of the hash, so that small hashes (e.g. small ints) do not all
+ * degrade to linear probing. The size is always prime, so any step in [1, size) visits every slot.
+ */
+static size_t set_step(const size_t hash, const size_t size) {
+	uint64_t h = (uint64_t)hash;
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	return (size_t)(1 + h % (size - 1));
+}
+
+#define SET_START(h, size) ((h) % (size))
+#define SET_STEP(h, size) set_step((h), (size))
+
+/*
+ * Gives set new, empty storage. set is only changed once it has been allocated.
+ */
+static void set_alloc(struct YASL_Set *const set, const size_t base_size) {
+	const size_t size = next_prime(base_size);
+	struct YASL_Object *items = (struct YASL_Object *)mem_calloc(Y_USERDATA, size, sizeof(struct YASL_Object));
+	size_t *hashes = (size_t *)mem_alloc(Y_USERDATA, size * sizeof(size_t));
 	set->base_size = base_size;
-	set->size = next_prime(set->base_size);
+	set->size = size;
 	set->count = 0;
-	set->items = (struct YASL_Object *)calloc((size_t) set->size, sizeof(struct YASL_Object));
+	set->deleted = 0;
+	set->items = items;
+	set->hashes = hashes;
+}
+
+static struct YASL_Set *set_new_sized(const size_t base_size) {
+	struct YASL_Set *set = (struct YASL_Set *)mem_alloc(Y_USERDATA, sizeof(struct YASL_Set));
+	set_alloc(set, base_size);
 	return set;
 }
 
+static size_t set_base_for(const size_t count) {
+	const size_t base_size = count * 10 / 7 + 1;
+	return base_size < SET_BASESIZE ? SET_BASESIZE : base_size;
+}
+
 struct YASL_Set *YASL_Set_new(void) {
 	return set_new_sized(SET_BASESIZE);
 }
 
+struct YASL_Set *YASL_Set_new_sized(const size_t count) {
+	return set_new_sized(set_base_for(count));
+}
+
+struct YASL_Set *YASL_Set_copy(const struct YASL_Set *const set) {
+	struct YASL_Set *copy = (struct YASL_Set *)mem_alloc(Y_USERDATA, sizeof(struct YASL_Set));
+	*copy = *set;
+	copy->items = (struct YASL_Object *)mem_alloc(Y_USERDATA, set->size * sizeof(struct YASL_Object));
+	copy->hashes = (size_t *)mem_alloc(Y_USERDATA, set->size * sizeof(size_t));
+	memcpy(copy->items, set->items, set->size * sizeof(struct YASL_Object));
+	memcpy(copy->hashes, set->hashes, set->size * sizeof(size_t));
+	FOR_SET(i, item, copy) {
+		inc_ref(item);
+	}
+	return copy;
+}
+
 void YASL_Set_del(void *s) {
 	if (!s) return;
 	struct YASL_Set *set = (struct YASL_Set *)s;
 	FOR_SET(i, item, set) {
 		dec_ref(item);
 	}
-	free(set->items);
-	free(set);
+	mem_free(set->items);
+	mem_free(set->hashes);
+	mem_free(set);
 }
 
-static void set_resize(struct YASL_Set *const set, const size_t base_size) {
-	if (base_size < SET_BASESIZE) return;
-	struct YASL_Set *new_set = set_new_sized(base_size);
-	FOR_SET(i, item, set) {
-			YASL_Set_insert(new_set, *item);
+void YASL_Set_clear(struct YASL_Set *const set) {
+	struct YASL_Object *items = set->items;
+	size_t *hashes = set->hashes;
+	const size_t size = set->size;
+
+	set_alloc(set, SET_BASESIZE);
+	for (size_t i = 0; i < size; i++) {
+		if (items[i].type != Y_END && !obj_isundef(&items[i])) {
+			dec_ref(items + i);
+		}
 	}
-	set->base_size = new_set->base_size;
-	set->count = new_set->count;
 
-	const size_t tmp_size = set->size;
-	set->size = new_set->size;
-	new_set->size = tmp_size;
+	mem_free(items);
+	mem_free(hashes);
+}
 
-	struct YASL_Object *tmp_items = set->items;
-	set->items = new_set->items;
-	new_set->items = tmp_items;
+/*
+ * Stores an item known not to be in the set yet. No equality checks are needed, only a free slot.
+ */
+static void set_place(struct YASL_Set *const set, const struct YASL_Object value, const size_t hash) {
+	const size_t step = SET_STEP(hash, set->size);
+	size_t index = SET_START(hash, set->size);
+	while (!obj_isundef(&set->items[index])) {
+		if (set->items[index].type == Y_END) {
+			set->deleted--;
+			break;
+		}
+		index = (index + step) % set->size;
+	}
+	set->items[index] = value;
+	set->hashes[index] = hash;
+	set->count++;
+}
+
+static size_t set_find(const struct YASL_Set *const set, const struct YASL_Object *key, const size_t hash) {
+	const size_t step = SET_STEP(hash, set->size);
+	size_t index = SET_START(hash, set->size);
+	const struct YASL_Object *item = &set->items[index];
+	while (!obj_isundef(item)) {
+		if (item->type != Y_END && set->hashes[index] == hash && isequal(item, key)) {
+			return index;
+		}
+		index = (index + step) % set->size;
+		item = &set->items[index];
+	}
+	return SET_NOTFOUND;
+}
+
+static void set_resize(struct YASL_Set *const set, size_t base_size) {
+	if (base_size < SET_BASESIZE) base_size = SET_BASESIZE;
+	struct YASL_Object *items = set->items;
+	size_t *hashes = set->hashes;
+	const size_t size = set->size;
+
+	set_alloc(set, base_size);
+	for (size_t i = 0; i < size; i++) {
+		if (items[i].type != Y_END && !obj_isundef(&items[i])) {
+			set_place(set, items[i], hashes[i]);
+		}
+	}
 
-	YASL_Set_del(new_set);
+	mem_free(items);
+	mem_free(hashes);
 }
 
-static void set_resize_up(struct YASL_Set *set) {
-	const size_t new_size = set->base_size * 2;
-	set_resize(set, new_size);
+/*
+ * Makes sure `extra` more items fit without going over the load limit. Tombstones count towards the limit, since
+ * they lengthen probe sequences just as much as live items do.
+ */
+static void set_reserve(struct YASL_Set *const set, const size_t extra) {
+	if ((set->count + set->deleted + extra) * 100 / set->size <= 70) return;
+	if ((set->count + extra) * 100 / set->size > 35) {
+		size_t base_size = set->base_size * 2;
+		while ((set->count + extra) * 100 / base_size > 70) base_size *= 2;
+		set_resize(set, base_size);
+	} else {
+		set_resize(set, set->base_size);
+	}
 }
 
-static void set_resize_down(struct YASL_Set *set) {
-	const size_t new_size = set->base_size / 2;
-	set_resize(set, new_size);
+static void set_remove_at(struct YASL_Set *const set, const size_t index) {
+	dec_ref(&set->items[index]);
+	set->items[index] = YASL_END();
+	set->count--;
+	set->deleted++;
+}
+
+static void set_insert_hashed(struct YASL_Set *const set, struct YASL_Object value, const size_t hash) {
+	inc_ref(&value);
+	const size_t index = set_find(set, &value, hash);
+	if (index != SET_NOTFOUND) {
+		dec_ref(&set->items[index]);
+		set->items[index] = value;
+		return;
+	}
+	set_reserve(set, 1);
+	set_place(set, value, hash);
 }
 
 bool YASL_Set_insert(struct YASL_Set *const set, struct YASL_Object value) {
@@ -63,115 +196,155 @@ bool YASL_Set_insert(struct YASL_Set *const set, struct YASL_Object value) {
 		return false;
 	}
 
-	const size_t load = set->count * 100 / set->size;
-	if (load > 70) set_resize_up(set);
-	size_t index = get_hash(value, set->size, 0);
-	inc_ref(&value);
-	struct YASL_Object curr_item = set->items[index];
-	size_t i = 1;
-	while (!obj_isundef(&curr_item)) {
-		if (curr_item.type != Y_END) {
-			if ((isequal(&curr_item, &value))) {
-				dec_ref(&curr_item);
-				set->items[index] = value;
-				return true;
-			}
-		}
-		index = get_hash(value, set->size, i++);
-		curr_item = set->items[index];
-	}
-	set->items[index] = value;
-	set->count++;
+	set_insert_hashed(set, value, set_hash(value));
 	return true;
 }
 
 bool YASL_Set_search(const struct YASL_Set *const set, const struct YASL_Object key) {
-	size_t index = get_hash(key, set->size, 0);
-	struct YASL_Object item = set->items[index];
-	size_t i = 1;
-	while (!obj_isundef(&item)) {
-		if ((isequal(&item, &key))) {
-			return true;
-		}
-		index = get_hash(key, set->size, i++);
-		item = set->items[index];
+	if (!ishashable(&key)) {
+		return false;
 	}
-	return false;
+	return set_find(set, &key, set_hash(key)) != SET_NOTFOUND;
 }
 
 void YASL_Set_rm(struct YASL_Set *const set, struct YASL_Object key) {
 	if (!ishashable(&key)) {
 		return;
 	}
-	const size_t load = set->count * 100 / set->size;
-	if (load < 10) set_resize_down(set);
-	size_t index = get_hash(key, set->size, 0);
-	struct YASL_Object item = set->items[index];
-	size_t i = 1;
-	while (!obj_isundef(&item)) {
-		if (item.type != Y_END) {
-			if ((isequal(&item, &key))) {
-				dec_ref(&item);
-				set->items[index] = YASL_END();
-			}
-		}
-		index = get_hash(key, set->size, i++);
-		item = set->items[index];
+	const size_t index = set_find(set, &key, set_hash(key));
+	if (index == SET_NOTFOUND) {
+		return;
+	}
+	set_remove_at(set, index);
+	if (set->count * 100 / set->size < 10 && set->base_size > SET_BASESIZE) {
+		set_resize(set, set->base_size / 2);
 	}
-	set->count--;
 }
 
 struct YASL_Set *YASL_Set_union(const struct YASL_Set *const left, const struct YASL_Set *const right) {
-	struct YASL_Set *tmp = YASL_Set_new();
-	FOR_SET(i, iteml, left) {
-			YASL_Set_insert(tmp, *iteml);
+	const struct YASL_Set *big = left->count >= right->count ? left : right;
+	const struct YASL_Set *small = big == left ? right : left;
+	struct YASL_Set *tmp = YASL_Set_new_sized(big->count + small->count);
+	FOR_SET(i, itemb, big) {
+		inc_ref(itemb);
+		set_place(tmp, *itemb, big->hashes[i]);
 	}
-	FOR_SET(i, itemr, right) {
-			YASL_Set_insert(tmp, *itemr);
+	FOR_SET(i, items, small) {
+		if (set_find(tmp, items, small->hashes[i]) == SET_NOTFOUND) {
+			inc_ref(items);
+			set_place(tmp, *items, small->hashes[i]);
+		}
 	}
 	return tmp;
 }
 
 struct YASL_Set *YASL_Set_intersection(const struct YASL_Set *const left, const struct YASL_Set *const right) {
-	struct YASL_Set *tmp = YASL_Set_new();
-	FOR_SET(i, iteml, left) {
-		bool cond = YASL_Set_search(right, *iteml);
-		if (cond) {
-			YASL_Set_insert(tmp, *iteml);
+	const struct YASL_Set *small = left->count <= right->count ? left : right;
+	const struct YASL_Set *big = small == left ? right : left;
+	struct YASL_Set *tmp = YASL_Set_new_sized(small->count);
+	FOR_SET(i, item, small) {
+		if (set_find(big, item, small->hashes[i]) != SET_NOTFOUND) {
+			inc_ref(item);
+			set_place(tmp, *item, small->hashes[i]);
 		}
 	}
 	return tmp;
 }
 
 struct YASL_Set *YASL_Set_symmetric_difference(const struct YASL_Set *const left, const struct YASL_Set *const right) {
-	struct YASL_Set *tmp = YASL_Set_new();
+	struct YASL_Set *tmp = YASL_Set_new_sized(left->count + right->count);
 	FOR_SET(i, iteml, left) {
-		bool cond = YASL_Set_search(right, *iteml);
-		if (!cond) {
-			YASL_Set_insert(tmp, *iteml);
+		if (set_find(right, iteml, left->hashes[i]) == SET_NOTFOUND) {
+			inc_ref(iteml);
+			set_place(tmp, *iteml, left->hashes[i]);
 		}
 	}
 	FOR_SET(i, itemr, right) {
-		bool cond = YASL_Set_search(left, *itemr);
-		if (!cond) {
-			YASL_Set_insert(tmp, *itemr);
+		if (set_find(left, itemr, right->hashes[i]) == SET_NOTFOUND) {
+			inc_ref(itemr);
+			set_place(tmp, *itemr, right->hashes[i]);
 		}
 	}
-
 	return tmp;
 }
 
 struct YASL_Set *YASL_Set_difference(const struct YASL_Set *const left, const struct YASL_Set *const right) {
-	struct YASL_Set *tmp = YASL_Set_new();
+	if (right->count < left->count) {
+		struct YASL_Set *tmp = YASL_Set_copy(left);
+		YASL_Set_difference_update(tmp, right);
+		return tmp;
+	}
+	struct YASL_Set *tmp = YASL_Set_new_sized(left->count);
 	FOR_SET(i, iteml, left) {
-		bool cond = YASL_Set_search(right, *iteml);
-		if (!cond) {
-			YASL_Set_insert(tmp, *iteml);
+		if (set_find(right, iteml, left->hashes[i]) == SET_NOTFOUND) {
+			inc_ref(iteml);
+			set_place(tmp, *iteml, left->hashes[i]);
 		}
 	}
 	return tmp;
 }
 
+void YASL_Set_update(struct YASL_Set *const left, const struct YASL_Set *const right) {
+	if (left == right) return;
+	set_reserve(left, right->count);
+	FOR_SET(i, item, right) {
+		set_insert_hashed(left, *item, right->hashes[i]);
+	}
+}
+
+void YASL_Set_intersection_update(struct YASL_Set *const left, const struct YASL_Set *const right) {
+	if (left == right) return;
+	FOR_SET(i, item, left) {
+		if (set_find(right, item, left->hashes[i]) == SET_NOTFOUND) {
+			set_remove_at(left, i);
+		}
+	}
+}
+
+void YASL_Set_difference_update(struct YASL_Set *const left, const struct YASL_Set *const right) {
+	if (left == right) {
+		YASL_Set_clear(left);
+		return;
+	}
+	if (right->count < left->count) {
+		FOR_SET(i, itemr, right) {
+			const size_t index = set_find(left, itemr, right->hashes[i]);
+			if (index != SET_NOTFOUND) {
+				set_remove_at(left, index);
+			}
+		}
+	} else {
+		FOR_SET(i, iteml, left) {
+			if (set_find(right, iteml, left->hashes[i]) != SET_NOTFOUND) {
+				set_remove_at(left, i);
+			}
+		}
+	}
+}
+
+bool YASL_Set_issubset(const struct YASL_Set *const left, const struct YASL_Set *const right) {
+	if (left->count > right->count) {
+		return false;
+	}
+	FOR_SET(i, item, left) {
+		if (set_find(right, item, left->hashes[i]) == SET_NOTFOUND) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool YASL_Set_isdisjoint(const struct YASL_Set *const left, const struct YASL_Set *const right) {
+	const struct YASL_Set *small = left->count <= right->count ? left : right;
+	const struct YASL_Set *big = small == left ? right : left;
+	FOR_SET(i, item, small) {
+		if (set_find(big, item, small->hashes[i]) != SET_NOTFOUND) {
+			return false;
+		}
+	}
+	return true;
+}
+
 size_t YASL_Set_length(const struct YASL_Set *const set) {
 	return set->count;
 }
@@ -3,18 +3,31 @@
 
 #include "interpreter/YASL_Object.h"
 
+// Userdata tag, which is also the name of the metatable, for sets.
+extern const char SET_NAME[];
+
 #define FOR_SET(i, item, table) struct YASL_Object *item; for (size_t i = 0; i < (table)->size; i++) \
                                                   if (item = &table->items[i], item->type != Y_END && !obj_isundef(item))
 
+/*
+ * Open-addressed hash set. `hashes` runs parallel to `items` and caches the full (size-independent) hash of each
+ * occupied slot, so probes can skip most equality checks and resizing never has to rehash.
+ */
 struct YASL_Set {
 	size_t size;
 	size_t base_size;
 	size_t count;
+	size_t deleted;
 	struct YASL_Object *items;
+	size_t *hashes;
 };
 
 struct YASL_Set *YASL_Set_new(void);
+// A set with room for at least `count` items before it has to resize.
+struct YASL_Set *YASL_Set_new_sized(const size_t count);
+struct YASL_Set *YASL_Set_copy(const struct YASL_Set *const set);
 void YASL_Set_del(void *s);
+void YASL_Set_clear(struct YASL_Set *const set);
 bool YASL_Set_insert(struct YASL_Set *const set, struct YASL_Object value) /* YASL_WARN_UNUSED */;
 bool YASL_Set_search(const struct YASL_Set *const set, const struct YASL_Object key);
 void YASL_Set_rm(struct YASL_Set *const set, struct YASL_Object key);
@@ -23,6 +36,16 @@ struct YASL_Set *YASL_Set_union(const struct YASL_Set *const left, const struct
 struct YASL_Set *YASL_Set_intersection(const struct YASL_Set *const left, const struct YASL_Set *const right);
 struct YASL_Set *YASL_Set_symmetric_difference(const struct YASL_Set *const left, const struct YASL_Set *const right);
 struct YASL_Set *YASL_Set_difference(const struct YASL_Set *const left, const struct YASL_Set *const right);
+
+/*
+ * In-place variants of the above; `left` is modified, `right` is left untouched. `right` may alias `left`.
+ */
+void YASL_Set_update(struct YASL_Set *const left, const struct YASL_Set *const right);
+void YASL_Set_intersection_update(struct YASL_Set *const left, const struct YASL_Set *const right);
+void YASL_Set_difference_update(struct YASL_Set *const left, const struct YASL_Set *const right);
+
+bool YASL_Set_issubset(const struct YASL_Set *const left, const struct YASL_Set *const right);
+bool YASL_Set_isdisjoint(const struct YASL_Set *const left, const struct YASL_Set *const right);
 size_t YASL_Set_length(const struct YASL_Set *const set);
 
 #endif
@@ -9,6 +9,7 @@
 #include "debug.h"
 #include "YASL_List.h"
 #include "interpreter/YASL_Object.h"
+#include "interpreter/alloc.h"
 #include "data-structures/YASL_ByteBuffer.h"
 
 #define iswhitespace(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\v' || (c) == '\r')
@@ -43,9 +44,11 @@ char *copy_char_buffer(const size_t size, const char *const ptr) {
 
 struct YASL_String *YASL_String_new_substring(const size_t start, const size_t end,
 					      const struct YASL_String *const string) {
-	struct YASL_String *str = (struct YASL_String *) malloc(sizeof(struct YASL_String));
+	struct YASL_String *str = (struct YASL_String *) mem_alloc(Y_STR, sizeof(struct YASL_String));
 	str->on_heap = string->on_heap;
+	str->external = false;
 	if (str->on_heap) {
+		mem_charge(str, end - start);
 		str->str = (char *)malloc(end - start);
 		memcpy(str->str, string->str + start, end - start);
 		str->start = 0;
@@ -60,36 +63,62 @@ struct YASL_String *YASL_String_new_substring(const size_t start, const size_t e
 }
 
 struct YASL_String *YASL_String_new_sized(const size_t base_size, const char *const ptr) {
-	struct YASL_String *str = (struct YASL_String *) malloc(sizeof(struct YASL_String));
+	struct YASL_String *str = (struct YASL_String *) mem_alloc(Y_STR, sizeof(struct YASL_String));
 	str->start = 0;
 	str->end = base_size;
 	str->str = (char *) ptr;
 	str->on_heap = false;
+	str->external = false;
 	str->rc = NEW_RC();
 	return str;
 }
 
 struct YASL_String* YASL_String_new_sized_heap(const size_t start, const size_t end, const char *const mem) {
-	struct YASL_String *str = (struct YASL_String *) malloc(sizeof(struct YASL_String));
+	struct YASL_String *str = (struct YASL_String *) mem_alloc(Y_STR, sizeof(struct YASL_String));
+	mem_charge(str, end);
 	str->start = start;
 	str->end = end;
 	str->str = (char *) mem;
 	str->on_heap = true;
+	str->external = false;
+	str->rc = NEW_RC();
+	return str;
+}
+
+/*
+ * The chars aren't charged to the current allocator, since they were never on its heap.
+ */
+struct YASL_String *YASL_String_new_external(const size_t len, const char *const ptr, void (*release)(void *),
+					     void *const data) {
+	struct YASL_ExternalString *ext = (struct YASL_ExternalString *) mem_alloc(Y_STR, sizeof(struct YASL_ExternalString));
+	ext->release = release;
+	ext->data = data;
+	struct YASL_String *str = &ext->string;
+	str->start = 0;
+	str->end = len;
+	str->str = (char *) ptr;
+	str->on_heap = true;
+	str->external = true;
 	str->rc = NEW_RC();
 	return str;
 }
 
 void str_del_data(struct YASL_String *const str) {
-	if (str->on_heap) free((void *) str->str);
+	if (str->external) {
+		struct YASL_ExternalString *ext = (struct YASL_ExternalString *) str;
+		if (ext->release) ext->release(ext->data);
+	} else if (str->on_heap) {
+		free((void *) str->str);
+	}
 }
 
 void str_del_rc(struct YASL_String *const str) {
-	free(str);
+	mem_free(str);
 }
 
 void str_del(struct YASL_String *const str) {
-	if (str->on_heap) free((void *) str->str);
-	free(str);
+	str_del_data(str);
+	mem_free(str);
 }
 
 
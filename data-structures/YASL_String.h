@@ -13,6 +13,17 @@ struct YASL_String {
 	size_t start;
 	size_t end;
 	bool on_heap;
+	bool external;     // whether this is a struct YASL_ExternalString
+};
+
+/*
+ * A string whose chars belong to the embedder. They are treated like chars on the heap, except that release is called
+ * with data instead of freeing them.
+ */
+struct YASL_ExternalString {
+	struct YASL_String string;  // NOTE: MUST BE THE FIRST MEMBER OF THIS STRUCT. DO NOT REARRANGE.
+	void (*release)(void *);
+	void *data;
 };
 
 size_t YASL_String_len(const struct YASL_String *const str);
@@ -23,6 +34,8 @@ struct YASL_String* YASL_String_new_sized(const size_t base_size, const char *co
 struct YASL_String *YASL_String_new_substring(const size_t start, const size_t end,
 					      const struct YASL_String *const string);
 struct YASL_String* YASL_String_new_sized_heap(const size_t start, const size_t end, const char *const mem);
+struct YASL_String *YASL_String_new_external(const size_t len, const char *const ptr, void (*release)(void *),
+					     void *const data);
 void str_del_data(struct YASL_String *const str);
 void str_del_rc(struct YASL_String *const str);
 void str_del(struct YASL_String *const str);
@@ -27,11 +27,11 @@ void del_item(struct YASL_Table_Item *const item) {
 }
 
 struct YASL_Table *table_new_sized(const size_t base_size) {
-	struct YASL_Table *table = (struct YASL_Table *)malloc(sizeof(struct YASL_Table));
+	struct YASL_Table *table = (struct YASL_Table *)mem_alloc(Y_TABLE, sizeof(struct YASL_Table));
 	table->base_size = base_size;
 	table->size = next_prime(table->base_size);
 	table->count = 0;
-	table->items = (struct YASL_Table_Item *)calloc((size_t) table->size, sizeof(struct YASL_Table_Item));
+	table->items = (struct YASL_Table_Item *)mem_calloc(Y_TABLE, (size_t) table->size, sizeof(struct YASL_Table_Item));
 	return table;
 }
 
@@ -42,11 +42,11 @@ struct YASL_Table *YASL_Table_new(void) {
 void YASL_Table_del(struct YASL_Table *const table) {
 	if (!table) return;
 	DEL_TABLE(table);
-	free(table);
+	mem_free(table);
 }
 
 struct RC_UserData *rcht_new_sized(const size_t base_size) {
-        struct RC_UserData *ht = (struct RC_UserData *)malloc(sizeof(struct RC_UserData));
+        struct RC_UserData *ht = (struct RC_UserData *)mem_alloc(Y_TABLE, sizeof(struct RC_UserData));
         ht->data = table_new_sized(base_size);
         ht->rc = NEW_RC();
         ht->tag = TABLE_NAME;
@@ -61,7 +61,7 @@ struct RC_UserData *rcht_new(void) {
 
 void rcht_del(struct RC_UserData *const hashtable) {
 	YASL_Table_del((struct YASL_Table *) hashtable->data);
-	free(hashtable);
+	mem_free(hashtable);
 }
 
 void rcht_del_data(void *hashtable) {
@@ -2,6 +2,7 @@
 #define YASL_YASL_TABLE_H_
 
 #include "interpreter/YASL_Object.h"
+#include "interpreter/alloc.h"
 #include "util/prime.h"
 #include "yasl_include.h"
 
@@ -15,14 +16,14 @@
 	.size = next_prime(TABLE_BASESIZE),\
 	.base_size = TABLE_BASESIZE,\
 	.count = 0,\
-	.items = (struct YASL_Table_Item *)calloc((size_t) next_prime(TABLE_BASESIZE), sizeof(struct YASL_Table_Item))\
+	.items = (struct YASL_Table_Item *)mem_calloc(Y_TABLE, (size_t) next_prime(TABLE_BASESIZE), sizeof(struct YASL_Table_Item))\
 })
 
 #define DEL_TABLE(table) do {\
         FOR_TABLE(i, item, table) {\
                 del_item(item);\
         }\
-        free((table)->items);\
+        mem_free((table)->items);\
 } while (0)
 
 
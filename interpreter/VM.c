@@ -6,14 +6,21 @@
 #include <stdarg.h>
 
 #include "interpreter/builtins.h"
+#include "interpreter/alloc.h"
 #include "data-structures/YASL_String.h"
 #include "data-structures/YASL_Table.h"
 #include "interpreter/refcount.h"
 
+#include "util/atomic.h"
+#include "util/clock.h"
 #include "util/varint.h"
 #include "interpreter/table_methods.h"
 #include "interpreter/list_methods.h"
+#include "interpreter/range_methods.h"
 #include "interpreter/str_methods.h"
+#include "interpreter/program.h"
+#include "interpreter/shared.h"
+#include "interpreter/clone.h"
 #include "yasl_state.h"
 #include "yasl_error.h"
 #include "yasl_include.h"
@@ -21,25 +28,7 @@
 #include "operator_names.h"
 #include "YASL_Object.h"
 #include "closure.h"
-
-static struct RC_UserData **builtins_htable_new(struct VM *const vm) {
-	struct RC_UserData **ht = (struct RC_UserData **) malloc(sizeof(struct RC_UserData *) * NUM_TYPES);
-	ht[Y_UNDEF] = ud_new(undef_builtins(vm), TABLE_NAME, NULL, rcht_del_data);
-	ht[Y_UNDEF]->rc.refs++;
-	ht[Y_FLOAT] = ud_new(float_builtins(vm), TABLE_NAME, NULL, rcht_del_data);
-	ht[Y_FLOAT]->rc.refs++;
-	ht[Y_INT] = ud_new(int_builtins(vm), TABLE_NAME, NULL, rcht_del_data);
-	ht[Y_INT]->rc.refs++;
-	ht[Y_BOOL] = ud_new(bool_builtins(vm), TABLE_NAME, NULL, rcht_del_data);
-	ht[Y_BOOL]->rc.refs++;
-	ht[Y_STR] = ud_new(str_builtins(vm), TABLE_NAME, NULL, rcht_del_data);
-	ht[Y_STR]->rc.refs++;
-	ht[Y_LIST] = ud_new(list_builtins(vm), TABLE_NAME, NULL, rcht_del_data);
-	ht[Y_LIST]->rc.refs++;
-	ht[Y_TABLE] = ud_new(table_builtins(vm), TABLE_NAME, NULL, rcht_del_data);
-	ht[Y_TABLE]->rc.refs++;
-	return ht;
-}
+#include "coroutine.h"
 
 void vm_init(struct VM *const vm,
 	     unsigned char *const code,    // pointer to bytecode
@@ -56,6 +45,8 @@ void vm_init(struct VM *const vm,
 		vm->headers[i] = NULL;
 	}
 	vm->metatables = YASL_Table_new();
+	vm->type_mts = NULL;
+	vm->type_mts_size = 0;
 	vm->headers[datasize - 1] = code;
 	vm->globals = YASL_Table_new();
 	vm->pc = code + pc;
@@ -63,66 +54,76 @@ void vm_init(struct VM *const vm,
 	vm->sp = -1;
 	vm->num_constants = 0;
 	vm->constants = NULL;
-	vm->stack = (struct YASL_Object *)calloc(sizeof(struct YASL_Object), STACK_SIZE);
-
-#define X(E, S, ...) vm->special_strings[E] = YASL_String_new_sized(strlen(S), S);
-#include "specialstrings.x"
-#undef X
-
-	vm->builtins_htable = builtins_htable_new(vm);
+	vm->program = NULL;
+	vm->frozen = NULL;
+	vm->stack = (struct YASL_Object *)mem_calloc(Y_UNDEF, STACK_SIZE, sizeof(struct YASL_Object));
+	vm->stack_size = STACK_SIZE;
+	vm->frames = (struct CallFrame *)mem_alloc(Y_UNDEF, sizeof(struct CallFrame) * NUM_FRAMES);
+	vm->frames_size = NUM_FRAMES;
+	vm->loopframes = (struct LoopFrame *)mem_alloc(Y_UNDEF, sizeof(struct LoopFrame) * NUM_LOOPFRAMES);
+	vm->co = NULL;
+	vm->depth = 0;
+	vm->trace_fp = -1;
+	vm->suspended = YASL_SUCCESS;
+	vm->interrupted = 0;
+	vm->hook = NULL;
+	vm->hook_data = NULL;
+	vm_setbudget(vm, 0, 0);
+
+	struct YASL_Shared *shared = shared_acquire();
+	vm->builtins_htable = shared->builtins_htable;
+	YASL_Table_insert_fast(vm->metatables, YASL_STR(YASL_String_new_sized(strlen(RANGE_NAME), RANGE_NAME)),
+			       YASL_TABLE(shared->range_mt));
 	vm->pending = NULL;
+	vm->alloc = mem_new(vm);
 }
 
 void vm_close_all(struct VM *const vm);
+static void vm_pop_loopframe(struct VM *const vm);
 
 void vm_cleanup(struct VM *const vm) {
 	// If we've exited early somehow, without closing over some upvalues, we need to do that first.
-	vm_close_all(vm);
+	vm->pending = upval_close_from(vm->pending, vm->stack);
 
 	// Exit out of all loops (in case we're exiting with an error).
 	while (vm->loopframe_num >= 0) {
-		vm_dec_ref(vm, &vm->loopframes[vm->loopframe_num].iterable);
-		vm->loopframe_num--;
+		vm_pop_loopframe(vm);
 	}
 
-	for (size_t i = 0; i < STACK_SIZE; i++) {
+	for (int i = 0; i < vm->stack_size; i++) {
  		vm_dec_ref(vm, vm->stack + i);
 	}
-	free(vm->stack);
+	mem_free(vm->stack);
+	mem_free(vm->frames);
+	mem_free(vm->loopframes);
 
 	for (int64_t i = 0; i < vm->num_constants; i++) {
 		vm_dec_ref(vm, vm->constants + i);
 	}
 	free(vm->constants);
 
+	YASL_Table_del(vm->globals);
+
+	vm_clear_type_mts(vm);
+	free(vm->type_mts);
+	YASL_Table_del(vm->metatables);
+
+	// Threads started from this state run its functions until they are joined, which may happen above.
 	for (size_t i = 0; i < vm->headers_size; i++) {
 		free(vm->headers[i]);
 	}
 	free(vm->headers);
 
-	YASL_Table_del(vm->globals);
-
-	YASL_Table_del(vm->metatables);
-
-	struct YASL_Object v;
-	v = YASL_TABLE(vm->builtins_htable[Y_UNDEF]);
-	vm_dec_ref(vm, &v);
-	v = YASL_TABLE(vm->builtins_htable[Y_FLOAT]);
-	vm_dec_ref(vm, &v);
-	v = YASL_TABLE(vm->builtins_htable[Y_INT]);
-	vm_dec_ref(vm, &v);
-	v = YASL_TABLE(vm->builtins_htable[Y_BOOL]);
-	vm_dec_ref(vm, &v);
-	v = YASL_TABLE(vm->builtins_htable[Y_STR]);
-	vm_dec_ref(vm, &v);
-	v = YASL_TABLE(vm->builtins_htable[Y_LIST]);
-	vm_dec_ref(vm, &v);
-	v = YASL_TABLE(vm->builtins_htable[Y_TABLE]);
-	vm_dec_ref(vm, &v);
-	free(vm->builtins_htable);
 
 	io_cleanup(&vm->out);
 	io_cleanup(&vm->err);
+
+	// Objects that are frozen, from the program or from the shared heap may have been used anywhere above, so they go
+	// last.
+	clone_release_frozen(vm);
+	program_dec_ref(vm->program);
+	shared_release();
+	mem_release(vm->alloc);
 }
 
 void *vm_alloc_cyclic(struct VM *vm, size_t size) {
@@ -157,20 +158,29 @@ static size_t vm_getcurrline(struct VM *vm) {
 	return i;
 }
 
-static void printline(struct VM *vm) {
-	size_t line =  vm_getcurrline(vm);
-
-	vm_print_err_wrapper(vm, " (line %" PRI_SIZET ")\n", line);
-
-	if (vm->fp >= 0 && vm->stack[vm->fp].type == Y_CFN) vm_exitframe(vm);
+static void printtrace(struct VM *vm) {
+	if (vm->fp > vm->trace_fp && vm->stack[vm->fp].type == Y_CFN) vm_exitframe(vm);
 
-	while (vm->fp >= 0) {
+	while (vm->fp > vm->trace_fp) {
 		vm_exitframe(vm);
 		size_t line = vm_getcurrline(vm);
 		vm_print_err_wrapper(vm, "In function call on line %" PRI_SIZET "\n", line);
 	}
 }
 
+static void printline(struct VM *vm) {
+	if (!vm->pc) {
+		vm_print_err_wrapper(vm, "\n");
+		return;
+	}
+
+	size_t line =  vm_getcurrline(vm);
+
+	vm_print_err_wrapper(vm, " (line %" PRI_SIZET ")\n", line);
+
+	printtrace(vm);
+}
+
 void vvm_print_err(struct VM *vm, const char *const fmt, va_list args) {
 	vm->err.print(&vm->err, fmt, args);
 	printline(vm);
@@ -200,8 +210,34 @@ void vm_dec_ref(struct VM *const vm, struct YASL_Object *val) {
 	dec_ref(val);
 }
 
+bool vm_growstack(struct VM *const vm, const int size) {
+	if (size <= vm->stack_size) {
+		return true;
+	}
+	if (size > STACK_SIZE) {
+		return false;
+	}
+	int new_size = vm->stack_size * 2;
+	while (new_size < size) new_size *= 2;
+	if (new_size > STACK_SIZE) new_size = STACK_SIZE;
+
+	// Open upvalues point into the stack, so they are moved along with it.
+	struct YASL_Object *const stack = (struct YASL_Object *)mem_alloc(Y_USERDATA, new_size * sizeof(struct YASL_Object));
+	memcpy(stack, vm->stack, vm->stack_size * sizeof(struct YASL_Object));
+	for (int i = vm->stack_size; i < new_size; i++) {
+		stack[i] = YASL_UNDEF();
+	}
+	for (struct Upvalue *upval = vm->pending; upval; upval = upval->next) {
+		upval->location = stack + (upval->location - vm->stack);
+	}
+	mem_free(vm->stack);
+	vm->stack = stack;
+	vm->stack_size = new_size;
+	return true;
+}
+
 void vm_push(struct VM *const vm, const struct YASL_Object val) {
-	if (vm->sp + 1 >= STACK_SIZE) {
+	if (vm->sp + 1 >= vm->stack_size && !vm_growstack(vm, vm->sp + 2)) {
 		vm_print_err(vm, "StackOverflow.");
 		vm_throw_err(vm, YASL_STACK_OVERFLOW_ERROR);
 	}
@@ -268,7 +304,7 @@ struct YASL_Table *vm_poptable(struct VM *const vm) {
 }
 
 void vm_insert(struct VM *const vm, int index, struct YASL_Object val) {
-	if (vm->sp + 1 >= STACK_SIZE) {
+	if (vm->sp + 1 >= vm->stack_size && !vm_growstack(vm, vm->sp + 2)) {
 		vm_print_err(vm, "StackOverflow.");
 		vm_throw_err(vm, YASL_STACK_OVERFLOW_ERROR);
 	}
@@ -308,8 +344,36 @@ static yasl_int vm_read_int(struct VM *const vm) {
     return val;
 }
 
-static void vm_duptop(struct VM *const vm);
-static void vm_swaptop(struct VM *const vm);
+struct RC_UserData *vm_type_mt(struct VM *const vm, const int id, const char *const name) {
+	if (id < vm->type_mts_size && vm->type_mts[id]) {
+		return vm->type_mts[id];
+	}
+
+	struct YASL_Object mt = YASL_Table_search_zstring_int(vm->metatables, name);
+	if (!obj_istable(&mt)) {
+		return NULL;
+	}
+
+	if (id >= vm->type_mts_size) {
+		const int size = id < 8 ? 8 : 2 * id;
+		vm->type_mts = (struct RC_UserData **)realloc(vm->type_mts, size * sizeof(struct RC_UserData *));
+		memset(vm->type_mts + vm->type_mts_size, 0, (size - vm->type_mts_size) * sizeof(struct RC_UserData *));
+		vm->type_mts_size = size;
+	}
+	inc_ref(&mt);
+	return vm->type_mts[id] = YASL_GETUSERDATA(mt);
+}
+
+void vm_clear_type_mts(struct VM *const vm) {
+	for (int i = 0; i < vm->type_mts_size; i++) {
+		if (vm->type_mts[i]) {
+			struct YASL_Object v = YASL_TABLE(vm->type_mts[i]);
+			vm->type_mts[i] = NULL;
+			dec_ref(&v);
+		}
+	}
+}
+
 static int vm_lookup_method_helper(struct VM *vm, struct YASL_Object obj, struct YASL_Table *mt, struct YASL_Object index);
 static void vm_GET(struct VM *const vm);
 static void vm_INIT_CALL(struct VM *const vm, int expected_returns);
@@ -584,9 +648,19 @@ void vm_stringify_top(struct VM *const vm) {
 	}
 }
 
+/*
+ * The pending list holds a reference to each upvalue in it, so that an upvalue outlives any closures that drop it
+ * before it is closed.
+ */
+static struct Upvalue *vm_newupvalue(struct YASL_Object *const location) {
+	struct Upvalue *upval = upval_new(location);
+	upval->rc.refs++;
+	return upval;
+}
+
 static struct Upvalue *add_upvalue(struct VM *const vm, struct YASL_Object *const location) {
 	if (vm->pending == NULL) {
-		return (vm->pending = upval_new(location));
+		return (vm->pending = vm_newupvalue(location));
 	}
 
 	struct Upvalue *prev = NULL;
@@ -601,14 +675,14 @@ static struct Upvalue *add_upvalue(struct VM *const vm, struct YASL_Object *cons
 			return curr;
 		}
 		if (curr->location < location) {
-			struct Upvalue *upval = upval_new(location);
+			struct Upvalue *upval = vm_newupvalue(location);
 			upval->next = curr->next;
 			curr->next = upval;
 			return upval;
 		}
-		return (curr->next = upval_new(location));
+		return (curr->next = vm_newupvalue(location));
 	}
-	return (prev->next = upval_new(location));
+	return (prev->next = vm_newupvalue(location));
 }
 
 static void vm_CCONST(struct VM *const vm) {
@@ -617,7 +691,7 @@ static void vm_CCONST(struct VM *const vm) {
 	vm->pc += len;
 
 	const size_t num_upvalues = NCODE(vm);
-	struct Closure *closure = (struct Closure *)malloc(sizeof(struct Closure) + num_upvalues*sizeof(struct Upvalue *));
+	struct Closure *closure = (struct Closure *)mem_alloc(Y_CLOSURE, sizeof(struct Closure) + num_upvalues*sizeof(struct Upvalue *));
 	closure->f = start;
 	closure->num_upvalues = num_upvalues;
 	closure->rc = NEW_RC();
@@ -672,13 +746,12 @@ static void vm_SLICE_list(struct VM *const vm) {
 	vm_pop(vm);
 	vm_pop(vm);
 
+	if (start > len) start = len;
+	if (end < start) end = start;
+
 	struct YASL_List *list = vm_poplist(vm);
-	struct RC_UserData *new_ls = rcls_new();
+	struct RC_UserData *new_ls = rcls_slice(list, (size_t)start, (size_t)end);
 	ud_setmt(new_ls, vm->builtins_htable[Y_LIST]);
-
-	for (yasl_int i = start; i <end; ++i) {
-		YASL_List_append((struct YASL_List *) new_ls->data, list->items[i]);
-	}
 	vm_push(vm, YASL_LIST(new_ls));
 }
 
@@ -730,10 +803,13 @@ static void vm_SLICE(struct VM *const vm) {
 	} else if (vm_isstr(vm, vm->sp - 2)) {
 		vm_SLICE_str(vm);
 	} else {
-		vm_pop(vm);
-		vm_pop(vm);
-		vm_print_err_type(vm,  "slicing is not defined for objects of type %s.", obj_typename(vm_pop_p(vm)));
-		vm_throw_err(vm, YASL_TYPE_ERROR);
+		struct YASL_Object obj = vm_peek(vm, vm->sp - 2);
+
+		vm_push(vm, obj);
+		vm_lookup_method_throwing(vm, "__slice", "slicing is not defined for objects of type %s.", obj_typename(&obj));
+		vm_shifttopdown(vm, 3);
+		vm_INIT_CALL_offset(vm, vm->sp - 3, 1);
+		vm_CALL(vm);
 	}
 }
 
@@ -878,8 +954,137 @@ static void vm_LIT8(struct VM *const vm) {
 	vm_push(vm, vm->constants[addr]);
 }
 
+/*
+ * Returns obj's method called name, or undef if it has none. Unlike vm_lookup_method_throwing, this only looks in
+ * obj's metatable.
+ */
+struct YASL_Object vm_find_method(struct VM *const vm, struct YASL_Object obj, const char *const name) {
+	struct YASL_Table *mt = get_mt(vm, obj);
+	if (!mt) {
+		return YASL_UNDEF();
+	}
+	struct YASL_Object key = YASL_STR(YASL_String_new_sized(strlen(name), name));
+	struct YASL_Object method = YASL_Table_search(mt, key);
+	str_del(obj_getstr(&key));
+	return method.type == Y_END ? YASL_UNDEF() : method;
+}
+
+static struct LoopFrame *vm_push_loopframe(struct VM *const vm, const struct YASL_Object iterable, const struct YASL_Object next) {
+	vm->loopframe_num++;
+	struct LoopFrame *frame = &vm->loopframes[vm->loopframe_num];
+	frame->iter = 0;
+	frame->step = 0;
+	frame->left = 0;
+	frame->iterable = iterable;
+	frame->next = next;
+	return frame;
+}
+
+static void vm_setrange(struct LoopFrame *const frame, const struct YASL_Range *const range) {
+	frame->iter = range->start;
+	frame->step = range->step;
+	frame->left = range_len(range);
+}
+
+/*
+ * Starts a loop over the top of the stack. Ranges are iterated without going through their methods. Userdata, and
+ * tables whose metatable defines __iter, are first replaced by the result of calling __iter. If that result has a
+ * __next method, the loop pulls its items from __next, which must return true and the next item, or false once there
+ * are no items left. Otherwise, lists, tables and strings are iterated directly.
+ */
+static void vm_INITFOR(struct VM *const vm) {
+	if (vm_isuserdata(vm) && YASL_GETUSERDATA(vm_peek(vm))->tag == RANGE_NAME) {
+		inc_ref(&vm_peek(vm));
+		struct LoopFrame *frame = vm_push_loopframe(vm, vm_peek(vm), YASL_UNDEF());
+		vm_setrange(frame, (struct YASL_Range *)YASL_GETUSERDATA(vm_pop(vm))->data);
+		return;
+	}
+
+	if (vm_isuserdata(vm) || vm_istable(vm)) {
+		struct YASL_Object iter = vm_find_method(vm, vm_peek(vm), "__iter");
+		if (!obj_isundef(&iter)) {
+			vm_push(vm, iter);
+			vm_swaptop(vm);
+			vm_INIT_CALL_offset(vm, vm->sp - 1, 1);
+			vm_CALL_now(vm);
+		}
+	}
+
+	struct YASL_Object next = YASL_UNDEF();
+	if (vm_isuserdata(vm) || vm_istable(vm)) {
+		next = vm_find_method(vm, vm_peek(vm), "__next");
+	}
+	if (vm_isuserdata(vm) && obj_isundef(&next)) {
+		vm_print_err_type(vm, "object of type %s is not iterable.", vm_peektypename(vm));
+		vm_throw_err(vm, YASL_TYPE_ERROR);
+	}
+
+	inc_ref(&vm_peek(vm));
+	inc_ref(&next);
+	vm_push_loopframe(vm, vm_pop(vm), next);
+}
+
+/*
+ * Starts a loop over callee(args...), where the top argc items of the stack are the args and the one below them is
+ * callee. If callee is the builtin range, we read its args directly instead of creating a range object.
+ */
+static void vm_INITRANGE(struct VM *const vm) {
+	const int argc = NCODE(vm);
+	struct YASL_Object *callee = vm_peek_p(vm, vm->sp - argc);
+	if (obj_iscfn(callee) && YASL_GETCFN(*callee)->value == &range_new) {
+		struct YASL_Range range;
+		int error = range_parse(vm, callee + 1, argc, &range);
+		if (error) {
+			vm_throw_err(vm, error);
+		}
+		vm->sp -= argc + 1;
+		vm_setrange(vm_push_loopframe(vm, YASL_UNDEF(), YASL_UNDEF()), &range);
+		return;
+	}
+
+	vm_INIT_CALL_offset(vm, vm->sp - argc, 1);
+	vm_CALL_now(vm);
+	vm_INITFOR(vm);
+}
+
+static void vm_pop_loopframe(struct VM *const vm) {
+	vm_dec_ref(vm, &vm->loopframes[vm->loopframe_num].iterable);
+	vm_dec_ref(vm, &vm->loopframes[vm->loopframe_num].next);
+	vm->loopframe_num--;
+}
+
+static void vm_ITER_1_next(struct VM *const vm, struct LoopFrame *const frame) {
+	vm_push(vm, frame->next);
+	vm_INIT_CALL_offset(vm, vm->sp, 2);
+	vm_push(vm, frame->iterable);
+	vm_CALL_now(vm);
+
+	if (!vm_isbool(vm, vm->sp - 1)) {
+		vm_print_err_type(vm, "__next expected to return bool, got %s.", vm_peektypename(vm, vm->sp - 1));
+		vm_throw_err(vm, YASL_TYPE_ERROR);
+	}
+	if (vm_peekbool(vm, vm->sp - 1)) {
+		vm_swaptop(vm);
+	} else {
+		vm_pop(vm);
+		vm_pop(vm);
+		vm_pushbool(vm, false);
+	}
+}
+
 static void vm_ITER_1(struct VM *const vm) {
 	struct LoopFrame *frame = &vm->loopframes[vm->loopframe_num];
+	if (frame->step) {
+		if (frame->left == 0) {
+			vm_pushbool(vm, false);
+		} else {
+			vm_pushint(vm, frame->iter);
+			frame->iter = (yasl_int)((uint64_t)frame->iter + (uint64_t)frame->step);
+			frame->left--;
+			vm_pushbool(vm, true);
+		}
+		return;
+	}
 	switch (frame->iterable.type) {
 	case Y_LIST: {
 		struct YASL_List *list = YASL_GETLIST(frame->iterable);
@@ -891,7 +1096,14 @@ static void vm_ITER_1(struct VM *const vm) {
 		}
 		return;
 	}
+	case Y_USERDATA:
+		vm_ITER_1_next(vm, frame);
+		return;
 	case Y_TABLE: {
+		if (!obj_isundef(&frame->next)) {
+			vm_ITER_1_next(vm, frame);
+			return;
+		}
 		struct YASL_Table *table = YASL_GETTABLE(frame->iterable);
 		while (table->size > (size_t) frame->iter &&
 		       (table->items[frame->iter].key.type == Y_END || table->items[frame->iter].key.type == Y_UNDEF)) {
@@ -923,6 +1135,38 @@ static void vm_ITER_1(struct VM *const vm) {
 	}
 }
 
+/*
+ * Stores the next item of the current loop in the local given by the next byte, or branches by the next 8 bytes if
+ * there are none left. Range loops do this without touching the stack.
+ */
+static void vm_ITERRANGE(struct VM *const vm) {
+	struct LoopFrame *frame = &vm->loopframes[vm->loopframe_num];
+	const unsigned char offset = NCODE(vm);
+	const yasl_int jump = vm_read_int(vm);
+	struct YASL_Object *local = vm_peek_p(vm, vm->fp + offset + 1);
+
+	if (frame->step) {
+		if (frame->left == 0) {
+			vm->pc += jump;
+			return;
+		}
+		vm_dec_ref(vm, local);
+		*local = YASL_INT(frame->iter);
+		frame->iter = (yasl_int)((uint64_t)frame->iter + (uint64_t)frame->step);
+		frame->left--;
+		return;
+	}
+
+	vm_ITER_1(vm);
+	if (!vm_popbool(vm)) {
+		vm->pc += jump;
+		return;
+	}
+	vm_dec_ref(vm, local);
+	*local = vm_pop(vm);
+	inc_ref(local);
+}
+
 static bool vm_MATCH_subpattern(struct VM *const vm, struct YASL_Object *expr);
 static void vm_ff_subpatterns_multiple(struct VM *const vm, const size_t n);
 
@@ -1137,8 +1381,21 @@ static void vm_GLOAD_8(struct VM *const vm) {
 	YASL_ASSERT(vm_peek(vm).type != Y_END, "global not found");
 }
 
+/*
+ * Like the stack, a coroutine's frames grow as needed, up to as many as the main script has.
+ */
+static bool vm_growframes(struct VM *const vm) {
+	if (vm->frames_size >= NUM_FRAMES) {
+		return false;
+	}
+	const int size = vm->frames_size * 2 < NUM_FRAMES ? vm->frames_size * 2 : NUM_FRAMES;
+	vm->frames = (struct CallFrame *)mem_realloc(Y_USERDATA, vm->frames, size * sizeof(struct CallFrame));
+	vm->frames_size = size;
+	return true;
+}
+
 static void vm_enterframe_offset(struct VM *const vm, int offset, int num_returns) {
-	if (++vm->frame_num >= NUM_FRAMES) {
+	if (++vm->frame_num >= vm->frames_size && !vm_growframes(vm)) {
 		vm->frame_num--;
 		vm->status = YASL_STACK_OVERFLOW_ERROR;
 		vm_print_err(vm, "StackOverflow.");
@@ -1174,7 +1431,7 @@ static void vm_exitframe_multi(struct VM *const vm, int len) {
 	vm->fp = frame.prev_fp;
 	vm->next_fp = frame.curr_fp;
 	while (vm->loopframe_num > frame.lp) {
-		vm_dec_ref(vm, &vm->loopframes[vm->loopframe_num--].iterable);
+		vm_pop_loopframe(vm);
 	}
 
 	vm->frame_num--;
@@ -1188,7 +1445,7 @@ static void vm_exitframe(struct VM *const vm) {
 	vm->fp = frame.prev_fp;
 	vm->next_fp = frame.curr_fp;
 	while (vm->loopframe_num > frame.lp) {
-		vm_dec_ref(vm, &vm->loopframes[vm->loopframe_num--].iterable);
+		vm_pop_loopframe(vm);
 	}
 
 	vm->frame_num--;
@@ -1207,11 +1464,11 @@ static void vm_INIT_CALL(struct VM *const vm, int expected_returns) {
 	vm_INIT_CALL_offset(vm, vm->sp, expected_returns);
 }
 
-static void vm_duptop(struct VM *const vm) {
+void vm_duptop(struct VM *const vm) {
 	vm_push(vm, vm_peek(vm));
 }
 
-static void vm_swaptop(struct VM *const vm) {
+void vm_swaptop(struct VM *const vm) {
 	struct YASL_Object tmp = vm_peek(vm);
 	vm_peek(vm) = vm_peek(vm, vm->sp - 1);
 	vm_peek(vm, vm->sp - 1) = tmp;
@@ -1239,8 +1496,6 @@ static void vm_fill_args(struct VM *const vm, const int num_args) {
 }
 
 static inline void vm_CALL_native(struct VM *const vm, unsigned char *const code) {
-	vm->frames[vm->frame_num].pc = vm->pc;
-
 	vm_fill_args(vm, *code);
 
 	vm->pc =  code + 1;
@@ -1255,7 +1510,6 @@ static void vm_CALL_fn(struct VM *const vm) {
 }
 
 static void vm_CALL_cfn(struct VM *const vm) {
-	vm->frames[vm->frame_num].pc = vm->pc;
 	struct CFunction *f = vm_peekcfn(vm, vm->fp);
 	if (f->num_args < 0) {
 		yasl_int diff = vm->sp - vm->fp - ~f->num_args;
@@ -1270,8 +1524,7 @@ static void vm_CALL_cfn(struct VM *const vm) {
 	vm_exitframe_multi(vm, vm->sp - num_returns - vm->fp);
 }
 
-void vm_CALL(struct VM *const vm) {
-	vm->fp = vm->next_fp;
+static void vm_CALL_helper(struct VM *const vm) {
 	if (vm_isfn(vm, vm->fp)) {
 		vm_CALL_fn(vm);
 	} else if (vm_iscfn(vm, vm->fp)) {
@@ -1281,12 +1534,39 @@ void vm_CALL(struct VM *const vm) {
 	}
 }
 
+void vm_CALL(struct VM *const vm) {
+	vm->fp = vm->next_fp;
+	vm->frames[vm->frame_num].pc = vm->pc;
+	vm_CALL_helper(vm);
+}
+
+/*
+ * Tail call: the callee takes over the current frame, so it returns directly to our caller. The frame pushed by the
+ * preceding O_INIT_CALL/O_INIT_MC is dropped, and the callee and its args are moved down to our fp, replacing our
+ * locals. Upvalues pointing into our locals are closed first, since we can't know at compile time whether a closure
+ * over them was created.
+ */
+static void vm_TCALL(struct VM *const vm) {
+	const int callee = vm->next_fp;
+	vm->next_fp = vm->frames[vm->frame_num--].curr_fp;
+
+	vm_close_all(vm);
+	while (vm->loopframe_num > vm->frames[vm->frame_num].lp) {
+		vm_pop_loopframe(vm);
+	}
+
+	vm_rm_range(vm, vm->fp, callee);
+	vm_CALL_helper(vm);
+}
+
 void vm_CALL_now(struct VM *const vm) {
 	int fp = vm->fp;
+	vm->depth++;
 	vm_CALL(vm);
 	while (fp < vm->fp) {
 		vm_executenext(vm);
 	}
+	vm->depth--;
 }
 
 static void vm_RET(struct VM *const vm) {
@@ -1294,16 +1574,8 @@ static void vm_RET(struct VM *const vm) {
 	vm_exitframe_multi(vm, len);
 }
 
-static struct Upvalue *vm_close_all_helper(struct YASL_Object *const end, struct Upvalue *const curr) {
-	if (curr == NULL) return NULL;
-	if (curr->location < end) return curr;
-	inc_ref(curr->location);
-	upval_close(curr);
-	return (vm_close_all_helper(end, curr->next));
-}
-
 void vm_close_all(struct VM *const vm) {
-	vm->pending = vm_close_all_helper(vm->stack + vm->fp, vm->pending);
+	vm->pending = upval_close_from(vm->pending, vm->stack + vm->fp);
 }
 
 static void vm_ECHO(struct VM *const vm) {
@@ -1329,47 +1601,117 @@ static void vm_ECHO(struct VM *const vm) {
 }
 
 void vm_setupconstants(struct VM *const vm) {
-	vm->num_constants = ((int64_t *)vm->code)[2];
-	vm->constants = (struct YASL_Object *)malloc(sizeof(struct YASL_Object) * vm->num_constants);
-	unsigned char *tmp = vm->code + 3*sizeof(int64_t);
 	for (int64_t i = 0; i < vm->num_constants; i++) {
-		switch (*tmp++) {
-		case C_STR: {
-			int64_t len = *((int64_t *) tmp);
-			tmp += sizeof(int64_t);
-			char *str = (char *) malloc((size_t) len);
-			memcpy(str, tmp, (size_t) len);
-			vm->constants[i] = YASL_STR(YASL_String_new_sized_heap(0, (size_t) len, str));
-			inc_ref(vm->constants + i);
-			tmp += len;
-			break
-			;
+		vm_dec_ref(vm, vm->constants + i);
+	}
+	free(vm->constants);
+	vm->constants = NULL;
+	vm->num_constants = 0;
+	// Like a program's constants, these come from the bytecode rather than the script, so they aren't charged to it.
+	struct Allocator *const prev = mem_enter(NULL);
+	vm->constants = program_decode_constants(vm->code, &vm->num_constants);
+	mem_enter(prev);
+}
+
+static void vm_refill(struct VM *const vm) {
+	int64_t batch = YASL_POLL_INTERVAL;
+	if (vm->steps >= 0) {
+		if (vm->steps < batch) {
+			batch = vm->steps;
 		}
-		case C_INT_1: {
-			vm->constants[i] = YASL_INT((signed char)*tmp++);
-			break;
+		vm->steps -= batch;
+	}
+	vm->ticks = batch;
+}
+
+void vm_setbudget(struct VM *const vm, int64_t steps, int64_t ms) {
+	vm->steps = steps > 0 ? steps : -1;
+	vm->deadline = ms > 0 ? clock_ms() + ms : -1;
+	vm->preempting = false;
+	vm->overdue = 0;
+	vm_refill(vm);
+}
+
+void vm_pollsoon(struct VM *const vm) {
+	// The steps we skip are given back, so the budget comes out the same.
+	if (vm->ticks > 0 && vm->steps >= 0 && !vm->preempting) {
+		vm->steps += vm->ticks;
+	}
+	vm->ticks = 0;
+}
+
+/*
+ * Checks whether we should stop, every YASL_POLL_INTERVAL steps or when the step budget runs out. Running out of budget
+ * (or the hook asking for it) preempts the main script, which can be resumed later. That can only happen between
+ * instructions of the main script, with nothing from C on the stack. Inside a coroutine or a call from C, we check at
+ * every step whether we're back out, but only for YASL_POLL_INTERVAL steps; after that, the script is stopped with
+ * YASL_BUDGET_ERROR instead, since it might never come back out.
+ */
+static void vm_poll(struct VM *const vm) {
+	mem_checklimit(vm->alloc);
+
+	if (atomic_loadint(&vm->interrupted)) {
+		atomic_storeint(&vm->interrupted, 0);
+		vm_print_err(vm, "InterruptError: execution was interrupted.");
+		vm_throw_err(vm, YASL_INTERRUPT_ERROR);
+	}
+
+	if (!vm->preempting) {
+		if (vm->hook) {
+			const int status = vm->hook((struct YASL_State *)vm, vm->hook_data);
+			if (status == YASL_PREEMPTED) {
+				vm->preempting = true;
+			} else if (status != YASL_SUCCESS) {
+				vm_throw_err(vm, status);
+			}
 		}
-		case C_INT_8: {
-			int64_t v = *((int64_t *) tmp);
-			vm->constants[i] = YASL_INT(v);
-			tmp += sizeof(int64_t);
-			break;
+		if (vm->steps == 0) {
+			vm->preempting = true;
 		}
-		case C_FLOAT: {
-			yasl_float v = *((yasl_float *) tmp);
-			vm->constants[i] = YASL_FLOAT(v);
-			tmp += sizeof(yasl_float);
-			break;
+		if (vm->deadline >= 0 && clock_ms() >= vm->deadline) {
+			vm->preempting = true;
 		}
-		default:
-			break;
+	}
+
+	if (!vm->preempting) {
+		if (vm->ticks <= 0) {
+			vm_refill(vm);
+		}
+		return;
+	}
+
+	if (vm->co || vm->depth) {
+		if (vm->overdue++ >= YASL_POLL_INTERVAL) {
+			vm->preempting = false;
+			vm->overdue = 0;
+			vm_print_err(vm, "BudgetError: ran out of budget inside a %s.", vm->co ? "coroutine" : "call from C");
+			vm_throw_err(vm, YASL_BUDGET_ERROR);
 		}
+		vm->ticks = 1;
+		return;
+	}
+
+	vm->preempting = false;
+	vm->overdue = 0;
+	if (vm->ticks <= 0) {
+		vm_refill(vm);
+	}
+	vm->suspended = YASL_PREEMPTED;
+	vm_throw_err(vm, YASL_PREEMPTED);
+}
+
+/*
+ * Counts a step. Loops count one for each time they go around, and calls one each.
+ */
+static inline void vm_tick(struct VM *const vm) {
+	if (--vm->ticks <= 0) {
+		vm_poll(vm);
 	}
 }
 
 void vm_executenext(struct VM *const vm) {
 	unsigned char opcode = NCODE(vm);        // fetch
-	signed char offset;
+	unsigned char offset;
 	struct YASL_Object a, b;
 	yasl_int c;
 	YASL_VM_DEBUG_LOG("----------------"
@@ -1380,6 +1722,11 @@ void vm_executenext(struct VM *const vm) {
 		vm_close_all(vm);
 		vm_throw_err(vm, YASL_MODULE_SUCCESS);
 	case O_HALT:
+		// Nothing polls after the last step, so a script can't finish over its limit without this. The error is reported
+		// at the halt, rather than past the end of the code.
+		vm->pc--;
+		mem_checklimit(vm->alloc);
+		vm->pc++;
 		vm_throw_err(vm, YASL_SUCCESS);
 	case O_BCONST_F:
 	case O_BCONST_T:
@@ -1524,25 +1871,26 @@ void vm_executenext(struct VM *const vm) {
 		break;
 	}
 	case O_INITFOR:
-		inc_ref(&vm_peek(vm));
-		vm->loopframe_num++;
-		vm->loopframes[vm->loopframe_num].iter = 0;
-		vm->loopframes[vm->loopframe_num].iterable = vm_pop(vm);
+		vm_INITFOR(vm);
 		break;
 	case O_ENDFOR:
-		vm_dec_ref(vm, &vm->loopframes[vm->loopframe_num].iterable);
-		vm->loopframe_num--;
+		vm_pop_loopframe(vm);
 		break;
 	case O_ENDCOMP:
 		a = vm_pop(vm);
 		vm_pop(vm);
 		vm_push(vm, a);
-		vm_dec_ref(vm, &vm->loopframes[vm->loopframe_num].iterable);
-		vm->loopframe_num--;
+		vm_pop_loopframe(vm);
 		break;
 	case O_ITER_1:
 		vm_ITER_1(vm);
 		break;
+	case O_INITRANGE:
+		vm_INITRANGE(vm);
+		break;
+	case O_ITERRANGE:
+		vm_ITERRANGE(vm);
+		break;
 	case O_END:
 		vm_pushend(vm);
 		break;
@@ -1565,7 +1913,11 @@ void vm_executenext(struct VM *const vm) {
 		vm_MATCH_IF(vm);
 		break;
 	case O_BR_8:
-		vm->pc += vm_read_int(vm);
+		c = vm_read_int(vm);
+		vm->pc += c;
+		if (c < 0) {
+			vm_tick(vm);
+		}
 		break;
 	case O_BRF_8:
 		c = vm_read_int(vm);
@@ -1612,6 +1964,11 @@ void vm_executenext(struct VM *const vm) {
 		break;
 	case O_CALL:
 		vm_CALL(vm);
+		vm_tick(vm);
+		break;
+	case O_TCALL:
+		vm_TCALL(vm);
+		vm_tick(vm);
 		break;
 	case O_CRET:
 		vm_close_all(vm);
@@ -1640,7 +1997,12 @@ void vm_executenext(struct VM *const vm) {
 		vm->sp -= NCODE(vm);
 		break;
 	case O_INCSP:
-		vm->sp += NCODE(vm);
+		c = NCODE(vm);
+		if (vm->sp + c + 1 >= vm->stack_size && !vm_growstack(vm, (int)(vm->sp + c + 2))) {
+			vm_print_err(vm, "StackOverflow.");
+			vm_throw_err(vm, YASL_STACK_OVERFLOW_ERROR);
+		}
+		vm->sp += c;
 		break;
 	case O_ECHO:
 		vm_ECHO(vm);
@@ -1660,8 +2022,19 @@ void vm_executenext(struct VM *const vm) {
 	}
 }
 
+static void vm_enterrun(struct VM *const vm) {
+	vm->co = NULL;
+	vm->depth = 0;
+	vm->suspended = YASL_SUCCESS;
+	vm->preempting = false;
+	vm->overdue = 0;
+}
+
 int vm_run(struct VM *const vm) {
+	struct Allocator *const prev = mem_enter(vm->alloc);
+	vm_enterrun(vm);
 	if (setjmp(vm->buf)) {
+		mem_enter(prev);
 		return vm->status;
 	}
 
@@ -1671,3 +2044,259 @@ int vm_run(struct VM *const vm) {
 		vm_executenext(vm);
 	}
 }
+
+int vm_call_protected(struct VM *const vm, const int n) {
+	const int base = vm->sp - n;
+	const int depth = vm->depth++;
+	struct Allocator *const prev = mem_enter(vm->alloc);
+	if (setjmp(vm->buf)) {
+		vm->depth = depth;
+		mem_enter(prev);
+		return vm->status;
+	}
+
+	vm_INIT_CALL_offset(vm, base, -1);
+	vm_CALL_now(vm);
+	vm->depth = depth;
+	mem_enter(prev);
+	return YASL_SUCCESS;
+}
+
+int vm_call_direct(struct VM *const vm, const int n, const int num_returns) {
+	const int base = vm->sp - n;
+	const int fp = vm->fp;
+	const int next_fp = vm->next_fp;
+	const int frame_num = vm->frame_num;
+	const int loopframe_num = vm->loopframe_num;
+	const int depth = vm->depth;
+	const int trace_fp = vm->trace_fp;
+	unsigned char *const pc = vm->pc;
+	jmp_buf buf;
+	memcpy(buf, vm->buf, sizeof(jmp_buf));
+	struct Allocator *const prev = mem_enter(vm->alloc);
+	if (setjmp(vm->buf)) {
+		vm->pending = upval_close_from(vm->pending, vm->stack + base);
+		while (vm->loopframe_num > loopframe_num) {
+			vm_pop_loopframe(vm);
+		}
+		// Let go of whatever the call left on the stack, so that it isn't kept alive (and charged to the state)
+		// until something else happens to overwrite it.
+		for (int i = base; i < vm->stack_size; i++) {
+			vm_dec_ref(vm, vm->stack + i);
+			vm->stack[i] = YASL_UNDEF();
+		}
+		vm->sp = base - 1;
+		vm->fp = fp;
+		vm->next_fp = next_fp;
+		vm->frame_num = frame_num;
+		vm->depth = depth;
+		vm->trace_fp = trace_fp;
+		vm->pc = pc;
+		memcpy(vm->buf, buf, sizeof(jmp_buf));
+		mem_enter(prev);
+		return vm->status;
+	}
+
+	// Traces stop at the function called, since whoever called it catches the error.
+	vm->trace_fp = base;
+	if (vm->frame_num < 0) {
+		// Nothing is running, so errors in a C function called here have no line to report.
+		vm->pc = NULL;
+	}
+	vm_enterframe_offset(vm, base, num_returns);
+	vm_CALL_now(vm);
+	vm->trace_fp = trace_fp;
+	vm->pc = pc;
+	memcpy(vm->buf, buf, sizeof(jmp_buf));
+	mem_enter(prev);
+	return YASL_SUCCESS;
+}
+
+static void vm_swapcontext(struct VM *const vm, struct Coroutine *const co) {
+	const struct Coroutine tmp = *co;
+	co->stack = vm->stack;
+	co->stack_size = vm->stack_size;
+	co->frames = vm->frames;
+	co->frames_size = vm->frames_size;
+	co->frame_num = vm->frame_num;
+	co->loopframes = vm->loopframes;
+	co->loopframe_num = vm->loopframe_num;
+	co->pc = vm->pc;
+	co->sp = vm->sp;
+	co->fp = vm->fp;
+	co->next_fp = vm->next_fp;
+	co->pending = vm->pending;
+
+	vm->stack = tmp.stack;
+	vm->stack_size = tmp.stack_size;
+	vm->frames = tmp.frames;
+	vm->frames_size = tmp.frames_size;
+	vm->frame_num = tmp.frame_num;
+	vm->loopframes = tmp.loopframes;
+	vm->loopframe_num = tmp.loopframe_num;
+	vm->pc = tmp.pc;
+	vm->sp = tmp.sp;
+	vm->fp = tmp.fp;
+	vm->next_fp = tmp.next_fp;
+	vm->pending = tmp.pending;
+}
+
+/*
+ * A yield longjmps back here with status YASL_YIELD, leaving the coroutine inside the yield's frame, with the yielded
+ * values on top of its stack. The next resume finishes that frame, as if the yield had returned. Since only one C
+ * function can be skipped over like this, a coroutine can't yield from inside a call made from C (e.g. a sort
+ * comparator); vm->depth tells us when that's the case.
+ */
+int vm_resume_coroutine(struct VM *const vm, struct Coroutine *const co, const int n) {
+	const struct YASL_Object *const args = vm->stack + vm->sp - n + 1;
+	struct Coroutine *const prev = vm->co;
+	const int depth = vm->depth;
+	const int trace_fp = vm->trace_fp;
+	jmp_buf buf;
+	memcpy(buf, vm->buf, sizeof(jmp_buf));
+
+	const bool started = co->frame_num >= 0;
+	if (prev) {
+		prev->status = CO_NORMAL;
+	}
+	co->status = CO_RUNNING;
+	co->depth = depth + 1;
+	vm_swapcontext(vm, co);
+	vm->co = co;
+	vm->depth = depth + 1;
+	vm->trace_fp = -1;
+
+	if (setjmp(vm->buf)) {
+		const int status = vm->status;
+		const int num_results = status == YASL_YIELD ? vm->sp - vm->fp - 1 : 0;
+		vm_swapcontext(vm, co);
+		vm->co = prev;
+		vm->depth = depth;
+		vm->trace_fp = trace_fp;
+		memcpy(vm->buf, buf, sizeof(jmp_buf));
+		if (prev) {
+			prev->status = CO_RUNNING;
+		}
+
+		if (status != YASL_YIELD) {
+			co_release(co);
+			vm_print_err_wrapper(vm, "In coroutine resumed on line %" PRI_SIZET "\n", vm_getcurrline(vm));
+			printtrace(vm);
+			vm_throw_err(vm, status);
+		}
+
+		co->status = CO_SUSPENDED;
+		for (int i = co->sp - num_results + 1; i <= co->sp; i++) {
+			vm_push(vm, co->stack[i]);
+		}
+		return num_results;
+	}
+
+	for (int i = 0; i < n; i++) {
+		vm_push(vm, args[i]);
+	}
+
+	if (started) {
+		vm_exitframe_multi(vm, vm->sp - n - vm->fp);
+	} else {
+		vm->pc = co->pc;
+		vm_INIT_CALL_offset(vm, 0, -1);
+		vm_CALL(vm);
+	}
+
+	while (vm->fp >= 0) {
+		vm_executenext(vm);
+	}
+
+	const int num_results = vm->sp + 1;
+	vm_swapcontext(vm, co);
+	vm->co = prev;
+	vm->depth = depth;
+	vm->trace_fp = trace_fp;
+	memcpy(vm->buf, buf, sizeof(jmp_buf));
+	if (prev) {
+		prev->status = CO_RUNNING;
+	}
+	co->status = CO_DEAD;
+
+	for (int i = 0; i < num_results; i++) {
+		vm_push(vm, co->stack[i]);
+	}
+	co_release(co);
+	return num_results;
+}
+
+void vm_suspend(struct VM *const vm) {
+	vm->suspended = YASL_YIELD;
+	vm_throw_err(vm, YASL_YIELD);
+}
+
+int vm_resume(struct VM *const vm, const int n) {
+	const int suspended = vm->suspended;
+	if (suspended == YASL_SUCCESS) {
+		vm_print_err_wrapper(vm, "Error: cannot resume a state that is not suspended.\n");
+		return YASL_ERROR;
+	}
+
+	vm->suspended = YASL_SUCCESS;
+	struct Allocator *const prev = mem_enter(vm->alloc);
+	if (setjmp(vm->buf)) {
+		mem_enter(prev);
+		return vm->status;
+	}
+
+	if (suspended == YASL_YIELD) {
+		vm_exitframe_multi(vm, vm->sp - n - vm->fp);
+	} else {
+		vm->sp -= n;
+	}
+	while (true) {
+		vm_executenext(vm);
+	}
+}
+
+/*
+ * The constants are copied out of the program rather than decoded again, and the code stays owned by the program, so
+ * it is never put in vm->headers.
+ */
+static void vm_loadprogram(struct VM *const vm, struct YASL_Program *const program) {
+	program_inc_ref(program);
+	for (int64_t i = 0; i < vm->num_constants; i++) {
+		vm_dec_ref(vm, vm->constants + i);
+	}
+	free(vm->constants);
+
+	vm->program = program;
+	vm->num_constants = program->num_constants;
+	vm->constants = (struct YASL_Object *)malloc(sizeof(struct YASL_Object) * program->num_constants);
+	memcpy(vm->constants, program->constants, sizeof(struct YASL_Object) * program->num_constants);
+	for (int64_t i = 0; i < program->num_constants; i++) {
+		inc_ref(vm->constants + i);
+	}
+}
+
+int vm_run_program(struct VM *const vm, struct YASL_Program *const program) {
+	// Globals and closures from the first program may still point into it, so a state only ever runs one.
+	if (vm->program && vm->program != program) {
+		vm_print_err_wrapper(vm, "Error: cannot run a different program in the same state.\n");
+		return YASL_ERROR;
+	}
+
+	if (!vm->program) {
+		vm_loadprogram(vm, program);
+	}
+
+	vm->code = program->code;
+	vm->pc = program->code + ((int64_t *)program->code)[0];
+
+	struct Allocator *const prev = mem_enter(vm->alloc);
+	vm_enterrun(vm);
+	if (setjmp(vm->buf)) {
+		mem_enter(prev);
+		return vm->status;
+	}
+
+	while (true) {
+		vm_executenext(vm);
+	}
+}
@@ -8,14 +8,17 @@
 #include <setjmp.h>
 
 #include "IO.h"
+#include "alloc.h"
 #include "data-structures/YASL_Table.h"
 #include "data-structures/YASL_List.h"
 #include "opcode.h"
+#include "program.h"
 #include "yapp.h"
 #include "yasl_conf.h"
 
 
 #define NUM_FRAMES 1000
+#define NUM_LOOPFRAMES 16
 #define NUM_TYPES 13                                     // number of builtin types, each needs a vtable
 #define SCRATCH_SIZE 1024								// scratchspace size (needs tuning)
 
@@ -87,32 +90,53 @@ struct CallFrame {
 };
 
 struct LoopFrame {
-	int iter;
+	yasl_int iter;
+	yasl_int step;            // nonzero if we iterate over a range, in which case iter is the next item
+	uint64_t left;            // items left in the range
 	struct YASL_Object iterable;
+	struct YASL_Object next;  // iterable's __next method, or undef if we iterate iterable directly
 };
 
 struct VM {
 	struct IO out;
 	struct IO err;
 	struct YASL_Table *metatables;
+	struct RC_UserData **type_mts; // metatables of registered types, by id, see vm_type_mt
+	int type_mts_size;
 	struct YASL_Table *globals;   // variables, see "constant.c" for details on YASL_Object.
 	struct YASL_Object *stack;     // stack
-	struct CallFrame frames[NUM_FRAMES];
+	int stack_size;
+	struct CallFrame *frames;
+	int frames_size;
 	int frame_num;
-	struct LoopFrame loopframes[16];
+	struct LoopFrame *loopframes;
 	int loopframe_num;
 	struct YASL_Object *constants;
 	int64_t num_constants;
 	unsigned char *code;           // bytecode
+	struct YASL_Program *program;  // program being run, if any; owns code
 	unsigned char **headers;
 	size_t headers_size;
 	unsigned char *pc;                     // program counter
 	int sp;                        // stack pointer
 	int fp;                        // frame pointer
 	int next_fp;
-	struct YASL_String *special_strings[NUM_SPECIAL_STRINGS];
-	struct RC_UserData **builtins_htable;   // htable of builtin methods
+	struct RC_UserData **builtins_htable;   // htable of builtin methods, shared by all states
+	struct YASL_List *frozen;      // objects made immortal to share them with clones, see "clone.h"
 	struct Upvalue *pending;
+	struct Coroutine *co;          // coroutine being run, or NULL if we are running the main script
+	int depth;                     // how many calls from C into the interpreter loop we are inside of
+	int trace_fp;                  // fp at which error traces stop: -1, or that of a call made by vm_call_direct
+	int suspended;                 // YASL_YIELD or YASL_PREEMPTED if the main script is stopped, see vm_resume
+	int64_t ticks;                 // steps left until the next call to vm_poll
+	int64_t steps;                 // steps left in the budget once those are taken, or -1 for no limit
+	int64_t deadline;              // when the budget runs out, according to clock_ms, or -1 for never
+	int64_t overdue;               // steps taken since the budget ran out while we couldn't stop, see vm_poll
+	bool preempting;               // whether the budget ran out, but we haven't been able to stop yet
+	volatile int interrupted;
+	int (*hook)(struct YASL_State *, void *);
+	void *hook_data;
+	struct Allocator *alloc;       // what objects made while this state runs are charged to, see "alloc.h"
 	jmp_buf buf;
 	int status;
 	uint8_t scratch[SCRATCH_SIZE];
@@ -137,11 +161,23 @@ void vm_print_err(struct VM *vm, const char *const fmt, ...);
 YASL_NORETURN void vm_throw_err(struct VM *const vm, int error);
 
 void vm_get_metatable(struct VM *const vm);
+
+/*
+ * Finds the metatable registered under name for the type with the given id, or NULL if there is none. It is looked up
+ * by name once, and then remembered until vm_clear_type_mts is called, which must happen whenever metatables changes.
+ */
+struct RC_UserData *vm_type_mt(struct VM *const vm, const int id, const char *const name);
+void vm_clear_type_mts(struct VM *const vm);
+struct YASL_Object vm_find_method(struct VM *const vm, struct YASL_Object obj, const char *const name);
 void vm_stringify_top(struct VM *const vm);
 void vm_EQ(struct VM *const vm);
 
 void vm_INIT_CALL_offset(struct VM *const vm, int offset, int expected_returns);
 void vm_CALL(struct VM *const vm);
+void vm_CALL_now(struct VM *const vm);
+
+void vm_duptop(struct VM *const vm);
+void vm_swaptop(struct VM *const vm);
 
 void vm_dec_ref(struct VM *const vm, struct YASL_Object *val);
 
@@ -153,6 +189,11 @@ struct YASL_String *vm_popstr(struct VM *const vm);
 struct YASL_List *vm_poplist(struct VM *const vm);
 struct YASL_Table *vm_poptable(struct VM *const vm);
 
+/*
+ * Makes vm's stack hold at least size items. Only coroutines' stacks are ever smaller than STACK_SIZE, so they are the
+ * only ones that grow. Returns false if size is more than STACK_SIZE.
+ */
+bool vm_growstack(struct VM *const vm, const int size);
 void vm_push(struct VM *const vm, const struct YASL_Object val);
 void vm_pushend(struct VM *const vm);
 void vm_pushundef(struct VM *const vm);
@@ -166,4 +207,51 @@ void vm_pushbool(struct VM *const vm, bool b);
 
 int vm_run(struct VM *const vm);
 
+/*
+ * Calls the function below the top n values with them as its arguments, catching any error, for use when vm isn't
+ * already running. On success, the results replace the function and its arguments.
+ */
+int vm_call_protected(struct VM *const vm, const int n);
+
+/*
+ * Like vm_call_protected, for a function already known to be a fn, closure or cfn, leaving exactly num_returns results.
+ * If the call fails, the stack, frames and open upvalues are put back as they were, so this may also be used from C
+ * functions called while vm is running.
+ */
+int vm_call_direct(struct VM *const vm, const int n, const int num_returns);
+
+/*
+ * Limits how many more steps vm may take, and for how many more milliseconds it may run. Either may be 0 for no limit.
+ */
+void vm_setbudget(struct VM *const vm, int64_t steps, int64_t ms);
+
+/*
+ * Makes vm check whether it should stop at its next step, rather than waiting up to YASL_POLL_INTERVAL steps.
+ */
+void vm_pollsoon(struct VM *const vm);
+
+/*
+ * Runs co until it yields or returns. The top n values are passed to it: as the arguments to its function the first
+ * time, and as the results of the yield it stopped in after that. Whatever it yields or returns is pushed on top of
+ * them, and the number of such values is returned. Errors in co are raised again in the caller.
+ */
+int vm_resume_coroutine(struct VM *const vm, struct Coroutine *const co, const int n);
+
+/*
+ * Stops the main script in a yield, so that vm_run (or whatever was running it) returns YASL_YIELD with the yielded
+ * values on top of the stack. Must be called from a function the main script called, with vm->depth == 0.
+ */
+YASL_NORETURN void vm_suspend(struct VM *const vm);
+
+/*
+ * Continues the main script after vm_suspend, with the top n values as the results of its yield, or after it was
+ * preempted, in which case n should be 0.
+ */
+int vm_resume(struct VM *const vm, const int n);
+
+/*
+ * Runs program from its entry point. vm keeps a reference to program until it runs a different one or is cleaned up.
+ */
+int vm_run_program(struct VM *const vm, struct YASL_Program *const program);
+
 #endif
@@ -6,6 +6,7 @@
 
 #include "debug.h"
 #include "data-structures/YASL_Table.h"
+#include "interpreter/alloc.h"
 #include "interpreter/userdata.h"
 #include "interpreter/refcount.h"
 #include "yasl.h"
@@ -28,7 +29,7 @@ static const char *YASL_TYPE_NAMES[] = {
 };
 
 struct CFunction *new_cfn(YASL_cfn value, int num_args) {
-	struct CFunction *fn = (struct CFunction *) malloc(sizeof(struct CFunction));
+	struct CFunction *fn = (struct CFunction *) mem_alloc(Y_CFN, sizeof(struct CFunction));
 	fn->value = value;
 	fn->num_args = num_args;
 	fn->rc = NEW_RC();
@@ -40,7 +41,7 @@ void cfn_del_data(struct CFunction *cfn) {
 }
 
 void cfn_del_rc(struct CFunction *cfn) {
-	free(cfn);
+	mem_free(cfn);
 }
 
 struct YASL_Object *YASL_Table(void) {
@@ -0,0 +1,190 @@
+#include "alloc.h"
+
+#include <string.h>
+
+#include "VM.h"
+#include "yasl_error.h"
+#include "yasl_include.h"
+
+#if defined _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+/*
+ * Two words, so the memory after it is aligned the same as anything from malloc.
+ */
+struct MemHeader {
+	struct MemCounter *counter;  // NULL if the memory isn't charged to any allocator
+	size_t size;                 // bytes charged, including the header itself
+};
+
+#define mem_header(ptr) ((struct MemHeader *)(ptr) - 1)
+
+static THREAD_LOCAL struct Allocator *current = NULL;
+
+struct Allocator *mem_new(struct VM *const vm) {
+	struct Allocator *a = (struct Allocator *)calloc(1, sizeof(struct Allocator));
+	a->vm = vm;
+	for (int i = 0; i < MEM_NUM_TYPES; i++) {
+		a->types[i].owner = a;
+	}
+	return a;
+}
+
+void mem_release(struct Allocator *const a) {
+	a->vm = NULL;
+	if (a->total == 0) {
+		free(a);
+	}
+}
+
+struct Allocator *mem_enter(struct Allocator *const a) {
+	struct Allocator *const prev = current;
+	current = a;
+	if (a) {
+		a->failing = false;
+	}
+	return prev;
+}
+
+static void mem_add(struct MemCounter *const counter, const size_t size) {
+	struct Allocator *const a = counter->owner;
+	counter->live += size;
+	if (counter->live > counter->peak) counter->peak = counter->live;
+	a->total += size;
+	if (a->total > a->peak) a->peak = a->total;
+}
+
+static void mem_sub(struct MemCounter *const counter, const size_t size) {
+	struct Allocator *const a = counter->owner;
+	counter->live -= size;
+	a->total -= size;
+	if (!a->vm && a->total == 0) {
+		free(a);
+	}
+}
+
+/*
+ * Once failing is set, the error message and anything else needed to unwind can be allocated past the limit.
+ */
+YASL_NORETURN static void mem_fail(struct Allocator *const a) {
+	a->failing = true;
+	if (a->limit) {
+		vm_print_err(a->vm, "MemoryError: memory limit of %" PRI_SIZET " bytes exceeded.", a->limit);
+	} else {
+		vm_print_err(a->vm, "MemoryError: out of memory.");
+	}
+	vm_throw_err(a->vm, YASL_MEMORY_ERROR);
+}
+
+static bool mem_over(const struct Allocator *const a, const size_t size) {
+	return a && a->limit && !a->failing && (size > a->limit || a->total > a->limit - size);
+}
+
+/*
+ * Going over the limit doesn't raise the MemoryError straight away, since whatever is being made at the time would
+ * leak. The state raises it at its next step instead, once everything it has made is on its stack (see
+ * mem_checklimit). Running out of memory still raises it at once, since there is nothing else to do.
+ */
+static void mem_check(struct Allocator *const a, const size_t size) {
+	if (mem_over(a, size)) {
+		vm_pollsoon(a->vm);
+	}
+}
+
+void *mem_alloc(const int type, const size_t size) {
+	struct Allocator *const a = current;
+	const size_t total = size + sizeof(struct MemHeader);
+	mem_check(a, total);
+	struct MemHeader *header = (struct MemHeader *)malloc(total);
+	if (!header) {
+		if (a && !a->failing) mem_fail(a);
+		return NULL;
+	}
+	header->counter = a ? a->types + type : NULL;
+	header->size = total;
+	if (header->counter) mem_add(header->counter, total);
+	return header + 1;
+}
+
+void *mem_calloc(const int type, const size_t num, const size_t size) {
+	void *ptr = mem_alloc(type, num * size);
+	if (ptr) memset(ptr, 0, num * size);
+	return ptr;
+}
+
+void *mem_realloc(const int type, void *const ptr, const size_t size) {
+	if (!ptr) {
+		return mem_alloc(type, size);
+	}
+
+	struct Allocator *const a = current;
+	struct MemHeader *header = mem_header(ptr);
+	struct MemCounter *const from = header->counter;
+	const size_t old = header->size;
+	const size_t total = size + sizeof(struct MemHeader);
+	if (from && from->owner == a) {
+		mem_check(a, total > old ? total - old : 0);
+	} else {
+		mem_check(a, total);
+	}
+
+	header = (struct MemHeader *)realloc(header, total);
+	if (!header) {
+		if (a && !a->failing) mem_fail(a);
+		return NULL;
+	}
+	if (from) mem_sub(from, old);
+	header->counter = a ? a->types + type : NULL;
+	header->size = total;
+	if (header->counter) mem_add(header->counter, total);
+	return header + 1;
+}
+
+void mem_free(void *const ptr) {
+	if (!ptr) {
+		return;
+	}
+	struct MemHeader *const header = mem_header(ptr);
+	if (header->counter) mem_sub(header->counter, header->size);
+	free(header);
+}
+
+void mem_charge(void *const ptr, const size_t size) {
+	struct MemHeader *const header = mem_header(ptr);
+	if (!header->counter) {
+		return;
+	}
+	struct Allocator *const a = header->counter->owner;
+	if (a == current) {
+		mem_check(a, size);
+	}
+	header->size += size;
+	mem_add(header->counter, size);
+}
+
+bool mem_hasroom(const size_t size) {
+	return !mem_over(current, size);
+}
+
+void mem_reserve(const size_t size) {
+	if (mem_over(current, size)) {
+		mem_fail(current);
+	}
+}
+
+void mem_checklimit(struct Allocator *const a) {
+	if (mem_over(a, 0)) {
+		mem_fail(a);
+	}
+}
+
+void mem_detach(void *const ptr) {
+	struct MemHeader *const header = mem_header(ptr);
+	if (header->counter) {
+		mem_sub(header->counter, header->size);
+		header->counter = NULL;
+	}
+}
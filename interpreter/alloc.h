@@ -0,0 +1,94 @@
+#ifndef YASL_ALLOC_H_
+#define YASL_ALLOC_H_
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "yasl_conf.h"
+#include "yasl_types.h"
+
+// One counter per type of object, indexed by enum YASL_Types. Y_UNDEF counts memory that belongs to no object.
+#define MEM_NUM_TYPES (Y_USERDATA + 1)
+
+struct VM;
+struct Allocator;
+
+struct MemCounter {
+	size_t live;
+	size_t peak;
+	struct Allocator *owner;
+};
+
+/*
+ * Keeps track of how much memory a state's objects use, and raises a MemoryError in the state once it goes over its
+ * limit. Objects are charged to the allocator of whichever state is running on the current thread when they are made
+ * (see mem_enter); objects made while no state is running aren't charged to any. An object remembers which allocator
+ * it was charged to, so it can be freed from anywhere on the same thread, even after its state is gone: the allocator
+ * then stays around until the last of them is.
+ */
+struct Allocator {
+	struct VM *vm;                  // state to raise MemoryError in, or NULL once it has been cleaned up
+	struct MemCounter types[MEM_NUM_TYPES];
+	size_t total;
+	size_t peak;
+	size_t limit;                   // most memory the state may use, or 0 for no limit
+	bool failing;                   // whether a MemoryError is being raised, in which case the limit is lifted
+};
+
+struct Allocator *mem_new(struct VM *const vm);
+
+/*
+ * Called when the state is cleaned up. Frees a, unless some objects charged to it are still around.
+ */
+void mem_release(struct Allocator *const a);
+
+/*
+ * Makes a the allocator new objects on this thread are charged to, and returns the one that was, so it can be put
+ * back. Pass NULL to stop charging objects to anything. Entering an allocator lifts any MemoryError being raised in it.
+ */
+struct Allocator *mem_enter(struct Allocator *const a);
+
+/*
+ * Like malloc, calloc, realloc and free, for memory that belongs to an object of the given type. Each has a small
+ * header in front of it, so memory from these must only ever be passed to these. If there is no memory left, a
+ * MemoryError is raised in the current allocator's state instead. Going over its limit doesn't stop them, but makes
+ * the state check it at its next step (see mem_checklimit), so callers can build objects in several steps.
+ *
+ * Memory that is reallocated is charged to the current allocator from then on, since whoever changes an object is the
+ * one using it.
+ */
+void *mem_alloc(const int type, const size_t size);
+void *mem_calloc(const int type, const size_t num, const size_t size);
+void *mem_realloc(const int type, void *const ptr, const size_t size);
+void mem_free(void *const ptr);
+
+/*
+ * Charges ptr, which must be from mem_alloc, for size more bytes of other memory it owns, such as the characters of a
+ * string. They are given back when ptr is freed.
+ */
+void mem_charge(void *const ptr, const size_t size);
+
+/*
+ * Whether size more bytes would fit in the current allocator's limit. Always true if it has none.
+ */
+bool mem_hasroom(const size_t size);
+
+/*
+ * Raises a MemoryError at once if size more bytes wouldn't fit in the current allocator's limit. Builtins that are
+ * about to make something as big as they are asked to call this first, since going over the limit while making it
+ * would only be caught afterwards (see mem_alloc).
+ */
+void mem_reserve(const size_t size);
+
+/*
+ * Raises a MemoryError in a's state if a is over its limit. Only called between steps, when everything the state has
+ * made is reachable from it.
+ */
+void mem_checklimit(struct Allocator *const a);
+
+/*
+ * Stops charging ptr to any allocator, for memory that is about to be shared with other threads.
+ */
+void mem_detach(void *const ptr);
+
+#endif
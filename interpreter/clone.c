@@ -0,0 +1,89 @@
+#include "clone.h"
+
+#include <string.h>
+
+#include "YASL_Object.h"
+#include "copy.h"
+#include "data-structures/YASL_List.h"
+#include "data-structures/YASL_Table.h"
+
+static struct RC *frozen_rc(struct YASL_Object v) {
+	return v.type == Y_STR ? &v.value.sval->rc : &v.value.cval->rc;
+}
+
+struct YASL_Object clone_freeze(struct VM *const vm, struct YASL_Object v) {
+	if (v.type != Y_STR && v.type != Y_CFN) {
+		return v;
+	}
+	struct RC *rc = frozen_rc(v);
+	// Immortal and thread-shared objects can already be used from any state.
+	if (rc_isshared(*rc)) {
+		return v;
+	}
+	if (!vm->frozen) {
+		vm->frozen = YASL_List_new_sized(LIST_BASESIZE);
+	}
+	YASL_List_append(vm->frozen, v);
+	rc->refs = RC_IMMORTAL;
+	return v;
+}
+
+void clone_release_frozen(struct VM *const vm) {
+	if (!vm->frozen) {
+		return;
+	}
+	// Frozen objects don't refer to anything, so the order they are freed in doesn't matter.
+	FOR_LIST(i, v, vm->frozen) {
+		frozen_rc(v)->refs = 1;
+	}
+	YASL_List_del_data(vm->frozen);
+	vm->frozen = NULL;
+}
+
+static const struct CopyRules clone_rules = { true, true, NULL, NULL, NULL };
+
+const char *clone_cannotclone(struct VM *const from) {
+	struct YASL_Table *seen = YASL_Table_new();
+	const char *bad = NULL;
+	FOR_TABLE(i, item, from->globals) {
+		if ((bad = copy_check(&clone_rules, item->key, seen)) || (bad = copy_check(&clone_rules, item->value, seen))) break;
+	}
+	if (!bad) {
+		FOR_TABLE(i, item, from->metatables) {
+			if ((bad = copy_check(&clone_rules, item->key, seen)) || (bad = copy_check(&clone_rules, item->value, seen))) break;
+		}
+	}
+	for (int64_t i = 0; i < from->num_constants && !bad; i++) {
+		bad = copy_check(&clone_rules, from->constants[i], seen);
+	}
+	YASL_Table_del(seen);
+	return bad;
+}
+
+static struct YASL_Table *clone_toplevel(struct Copier *const c, const struct YASL_Table *const from) {
+	struct YASL_Table *to = YASL_Table_new();
+	FOR_TABLE(i, item, from) {
+		YASL_Table_insert_fast(to, copier_copy(c, item->key), copier_copy(c, item->value));
+	}
+	return to;
+}
+
+void clone_vm(struct VM *const vm, struct VM *const from) {
+	struct Copier c;
+	copier_init(&c, &clone_rules, from, false);
+
+	YASL_Table_del(vm->globals);
+	vm->globals = clone_toplevel(&c, from->globals);
+	vm_clear_type_mts(vm);
+	YASL_Table_del(vm->metatables);
+	vm->metatables = clone_toplevel(&c, from->metatables);
+
+	vm->num_constants = from->num_constants;
+	vm->constants = (struct YASL_Object *)malloc(sizeof(struct YASL_Object) * vm->num_constants);
+	for (int64_t i = 0; i < vm->num_constants; i++) {
+		vm->constants[i] = copier_copy(&c, from->constants[i]);
+		inc_ref(vm->constants + i);
+	}
+
+	copier_finish(&c, vm);
+}
@@ -0,0 +1,32 @@
+#ifndef YASL_CLONE_H_
+#define YASL_CLONE_H_
+
+#include "VM.h"
+
+/*
+ * Returns the type name of something reachable from the globals, metatables or constants of from that clone_vm can't
+ * copy, or NULL if from can be cloned. Only sets, deques, heaps, typed arrays and userdata without a destructor can be
+ * cloned, out of all the userdata.
+ */
+const char *clone_cannotclone(struct VM *const from);
+
+/*
+ * Replaces the globals and metatables of vm with copies of those of from, which must pass clone_cannotclone. Tables,
+ * lists, closures with their upvalues and the collections' userdata are copied, keeping any aliasing and cycles between
+ * them, so that vm can change them without from seeing it (see copy.h). Strings and C functions are shared, after being
+ * frozen in from (see clone_freeze).
+ */
+void clone_vm(struct VM *const vm, struct VM *const from);
+
+/*
+ * Makes v immortal, so other VMs can share it, and records it in vm, which frees it when it is cleaned up. Objects that
+ * are already immortal, and anything but strings and C functions, are left alone.
+ */
+struct YASL_Object clone_freeze(struct VM *const vm, struct YASL_Object v);
+
+/*
+ * Frees everything frozen by clone_freeze. Only called once nothing in vm can refer to them any more.
+ */
+void clone_release_frozen(struct VM *const vm);
+
+#endif
@@ -1,16 +1,13 @@
 #include "closure.h"
 
+#include "alloc.h"
+
 void closure_del_data(struct Closure *closure) {
 	for (size_t i = 0; i < closure->num_upvalues; i++) {
-		struct Upvalue *upval = closure->upvalues[i];
-		upval->rc.refs--;
-		if (upval->rc.refs == 0) {
-			dec_ref(upval->location);
-			free(upval);
-		}
+		upval_dec_ref(closure->upvalues[i]);
 	}
 }
 
 void closure_del_rc(struct Closure *closure) {
-	free(closure);
+	mem_free(closure);
 }
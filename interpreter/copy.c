@@ -0,0 +1,336 @@
+#include "copy.h"
+
+#include <string.h>
+
+#include "YASL_Object.h"
+#include "alloc.h"
+#include "clone.h"
+#include "closure.h"
+#include "upvalue.h"
+#include "data-structures/YASL_Array.h"
+#include "data-structures/YASL_Deque.h"
+#include "data-structures/YASL_Heap.h"
+#include "data-structures/YASL_List.h"
+#include "data-structures/YASL_Set.h"
+#include "data-structures/YASL_Table.h"
+
+static bool copy_isarray(const struct RC_UserData *const ud) {
+	return ud->tag == INTARRAY_NAME || ud->tag == FLOATARRAY_NAME || ud->tag == BYTEARRAY_NAME;
+}
+
+static bool copy_isowned(const struct RC_UserData *const ud) {
+	return ud->tag == SET_NAME || ud->tag == DEQUE_NAME || ud->tag == HEAP_NAME || copy_isarray(ud);
+}
+
+/*
+ * The collections' userdata are copied. Clones may also have userdata that don't own their data, like io.stdout, in
+ * which case their copies point at the same data.
+ */
+static bool copy_cancopy(const struct CopyRules *const rules, const struct RC_UserData *const ud) {
+	return copy_isowned(ud) || (rules->shared_tag && ud->tag == rules->shared_tag) ||
+	       (rules->freeze && !ud->destructor && !ud_isinline(ud));
+}
+
+const char *copy_check(const struct CopyRules *const rules, struct YASL_Object v, struct YASL_Table *const seen) {
+	switch (v.type) {
+	case Y_FN:
+		return rules->fns ? NULL : obj_typename(&v);
+	case Y_CLOSURE:
+		if (!rules->fns) return obj_typename(&v);
+		break;
+	case Y_LIST:
+	case Y_TABLE:
+	case Y_USERDATA:
+		if (rc_isimmortal(v.value.uval->rc)) {
+			return NULL;
+		}
+		if (v.type == Y_USERDATA && !copy_cancopy(rules, v.value.uval)) {
+			return obj_typename(&v);
+		}
+		break;
+	default:
+		return NULL;
+	}
+
+	// Userdata and closures are all pointers, so any of them will do here.
+	if (YASL_Table_search(seen, YASL_USERPTR(v.value.uval)).type != Y_END) {
+		return NULL;
+	}
+	YASL_Table_insert_fast(seen, YASL_USERPTR(v.value.uval), YASL_BOOL(true));
+
+	const char *bad = NULL;
+	if (v.type == Y_CLOSURE) {
+		for (size_t i = 0; i < v.value.lval->num_upvalues; i++) {
+			if ((bad = copy_check(rules, upval_get(v.value.lval->upvalues[i]), seen))) return bad;
+		}
+		return NULL;
+	}
+
+	struct RC_UserData *const ud = v.value.uval;
+	if (rules->freeze && ud->mt && (bad = copy_check(rules, YASL_TABLE(ud->mt), seen))) {
+		return bad;
+	}
+	// Sets and arrays only hold values that don't need checking.
+	if (v.type == Y_LIST) {
+		FOR_LIST(i, item, (struct YASL_List *)ud->data) {
+			if ((bad = copy_check(rules, item, seen))) return bad;
+		}
+	} else if (v.type == Y_TABLE) {
+		FOR_TABLE(i, item, (struct YASL_Table *)ud->data) {
+			if ((bad = copy_check(rules, item->key, seen)) || (bad = copy_check(rules, item->value, seen))) return bad;
+		}
+	} else if (ud->tag == DEQUE_NAME) {
+		const struct YASL_Deque *const deque = (struct YASL_Deque *)ud->data;
+		for (size_t i = 0; i < deque->count; i++) {
+			if ((bad = copy_check(rules, *YASL_Deque_at(deque, i), seen))) return bad;
+		}
+	} else if (ud->tag == HEAP_NAME) {
+		const struct YASL_Heap *const heap = (struct YASL_Heap *)ud->data;
+		if ((bad = copy_check(rules, heap->keyfn, seen))) return bad;
+		for (size_t i = 0; i < heap->count; i++) {
+			if ((bad = copy_check(rules, heap->entries[i].key, seen)) ||
+			    (bad = copy_check(rules, heap->entries[i].item, seen))) return bad;
+		}
+	}
+	return NULL;
+}
+
+const char *copy_checkn(const struct CopyRules *const rules, const struct YASL_Object *const values, const size_t n) {
+	struct YASL_Table *seen = YASL_Table_new();
+	const char *bad = NULL;
+	for (size_t i = 0; i < n && !bad; i++) {
+		bad = copy_check(rules, values[i], seen);
+	}
+	YASL_Table_del(seen);
+	return bad;
+}
+
+void copier_init(struct Copier *const c, const struct CopyRules *const rules, struct VM *const from, bool detached) {
+	c->rules = rules;
+	c->from = from;
+	c->detached = detached;
+	c->prev = detached ? mem_enter(NULL) : NULL;
+	c->copies = YASL_Table_new();
+	c->fixups = NULL;
+}
+
+/*
+ * Strings whose chars aren't on the heap point into bytecode, which may be freed before the receiver is done with
+ * them, and the embedder may expect external strings to be released on its own thread, so those are copied. Others
+ * are shared outright.
+ */
+static struct YASL_String *share_str(struct YASL_String *const str) {
+	if (rc_isshared(str->rc)) {
+		return str;
+	}
+	if (!str->on_heap || str->external) {
+		const size_t len = YASL_String_len(str);
+		return YASL_String_new_sized_heap(0, len, copy_char_buffer(len, YASL_String_chars(str)));
+	}
+	mem_detach(str);
+	str->rc.refs += RC_SHARED;
+	return str;
+}
+
+static void copier_remember(struct Copier *const c, void *const original, void *const copy) {
+	YASL_Table_insert_fast(c->copies, YASL_USERPTR(original), YASL_USERPTR(copy));
+}
+
+/*
+ * Clones get copies of the metatables. Otherwise, the builtin method tables are the same for every state, so only
+ * they are kept as metatables; the collections' userdata are given the receiver's instead (see copy_fixups_apply).
+ */
+static void copier_copymt(struct Copier *const c, struct RC_UserData *const ud, struct RC_UserData *const copy) {
+	if (!ud->mt) {
+		return;
+	}
+	if (c->rules->freeze) {
+		ud_setmt(copy, copier_copy(c, YASL_TABLE(ud->mt)).value.uval);
+	} else if (rc_isimmortal(ud->mt->rc)) {
+		ud_setmt(copy, ud->mt);
+	}
+}
+
+static struct RC_UserData *copier_copylist(struct Copier *const c, struct RC_UserData *const ud) {
+	const struct YASL_List *const from = (struct YASL_List *)ud->data;
+	struct RC_UserData *copy = rcls_new_sized(from->count ? from->count : LIST_BASESIZE);
+	copier_remember(c, ud, copy);
+	copier_copymt(c, ud, copy);
+
+	struct YASL_List *const to = (struct YASL_List *)copy->data;
+	FOR_LIST(i, item, from) {
+		YASL_List_append(to, copier_copy(c, item));
+	}
+	return copy;
+}
+
+static struct RC_UserData *copier_copytable(struct Copier *const c, struct RC_UserData *const ud) {
+	const struct YASL_Table *const from = (struct YASL_Table *)ud->data;
+	struct RC_UserData *copy = rcht_new_sized(from->base_size);
+	copier_remember(c, ud, copy);
+	copier_copymt(c, ud, copy);
+
+	struct YASL_Table *const to = (struct YASL_Table *)copy->data;
+	FOR_TABLE(i, item, from) {
+		YASL_Table_insert_fast(to, copier_copy(c, item->key), copier_copy(c, item->value));
+	}
+	return copy;
+}
+
+/*
+ * ud must pass copy_check.
+ */
+static struct RC_UserData *copier_copyuserdata(struct Copier *const c, struct RC_UserData *const ud) {
+	struct RC_UserData *copy;
+	if (ud->tag == SET_NAME) {
+		// Copies of userdata don't hash the same as the originals, so the items are inserted again.
+		struct YASL_Set *const from = (struct YASL_Set *)ud->data;
+		struct YASL_Set *set = YASL_Set_new_sized(from->count);
+		copy = ud_new(set, SET_NAME, NULL, YASL_Set_del);
+		copier_remember(c, ud, copy);
+		FOR_SET(i, item, from) {
+			YASL_Set_insert(set, copier_copy(c, *item));
+		}
+	} else if (ud->tag == DEQUE_NAME) {
+		const struct YASL_Deque *const from = (struct YASL_Deque *)ud->data;
+		struct YASL_Deque *deque = YASL_Deque_new_sized(from->count, from->maxlen);
+		copy = ud_new(deque, DEQUE_NAME, NULL, YASL_Deque_del);
+		copier_remember(c, ud, copy);
+		for (size_t i = 0; i < from->count; i++) {
+			YASL_Deque_push(deque, copier_copy(c, *YASL_Deque_at(from, i)));
+		}
+	} else if (ud->tag == HEAP_NAME) {
+		// Entries are copied in the same order, so the copy is already a heap.
+		const struct YASL_Heap *const from = (struct YASL_Heap *)ud->data;
+		struct YASL_Heap *heap = YASL_Heap_new_sized(from->count);
+		copy = ud_new(heap, HEAP_NAME, NULL, YASL_Heap_del);
+		copier_remember(c, ud, copy);
+		heap->kind = from->kind;
+		heap->keyfn = copier_copy(c, from->keyfn);
+		inc_ref(&heap->keyfn);
+		for (size_t i = 0; i < from->count; i++) {
+			struct YASL_HeapEntry entry = { copier_copy(c, from->entries[i].key),
+							copier_copy(c, from->entries[i].item) };
+			YASL_Heap_append(heap, entry);
+		}
+	} else if (copy_isarray(ud)) {
+		const struct YASL_Array *const array = (struct YASL_Array *)ud->data;
+		copy = ud_new(YASL_Array_slice(array, 0, array->count), ud->tag, NULL, YASL_Array_del);
+		copier_remember(c, ud, copy);
+	} else if (c->rules->shared_tag && ud->tag == c->rules->shared_tag) {
+		copy = ud_new(c->rules->share(ud->data), ud->tag, NULL, c->rules->unshare);
+		copier_remember(c, ud, copy);
+	} else {
+		copy = ud_new(ud->data, ud->tag, NULL, NULL);
+		copier_remember(c, ud, copy);
+	}
+
+	if (c->rules->freeze) {
+		copier_copymt(c, ud, copy);
+	} else {
+		if (!c->fixups) {
+			c->fixups = YASL_List_new_sized(LIST_BASESIZE);
+		}
+		YASL_List_append(c->fixups, YASL_USERPTR(copy));
+	}
+	return copy;
+}
+
+/*
+ * The copy's upvalues are all closed, holding copies of what the originals held. Closures that shared an upvalue share
+ * its copy.
+ */
+static struct Closure *copier_copyclosure(struct Copier *const c, struct Closure *const closure) {
+	const size_t n = closure->num_upvalues;
+	struct Closure *copy = (struct Closure *)mem_alloc(Y_CLOSURE, sizeof(struct Closure) + n * sizeof(struct Upvalue *));
+	copy->rc = NEW_RC();
+	copy->f = closure->f;
+	copy->num_upvalues = n;
+	copier_remember(c, closure, copy);
+
+	for (size_t i = 0; i < n; i++) {
+		struct Upvalue *const upval = closure->upvalues[i];
+		struct YASL_Object found = YASL_Table_search(c->copies, YASL_USERPTR(upval));
+		struct Upvalue *upcopy;
+		if (found.type != Y_END) {
+			upcopy = (struct Upvalue *)YASL_GETUSERPTR(found);
+		} else {
+			upcopy = upval_new(NULL);
+			copier_remember(c, upval, upcopy);
+			upcopy->closed = copier_copy(c, upval_get(upval));
+			inc_ref(&upcopy->closed);
+			upcopy->location = &upcopy->closed;
+		}
+		upcopy->rc.refs++;
+		copy->upvalues[i] = upcopy;
+	}
+	return copy;
+}
+
+struct YASL_Object copier_copy(struct Copier *const c, struct YASL_Object v) {
+	switch (v.type) {
+	case Y_STR:
+		return c->rules->freeze ? clone_freeze(c->from, v) : YASL_STR(share_str(v.value.sval));
+	case Y_CFN:
+		return c->rules->freeze ? clone_freeze(c->from, v) : YASL_CFN(v.value.cval->value, v.value.cval->num_args);
+	case Y_LIST:
+	case Y_TABLE:
+	case Y_USERDATA: {
+		// The shared builtin tables stay shared.
+		if (rc_isimmortal(v.value.uval->rc)) {
+			return v;
+		}
+		struct YASL_Object copy = YASL_Table_search(c->copies, YASL_USERPTR(v.value.uval));
+		if (copy.type != Y_END) {
+			v.value.uval = (struct RC_UserData *)YASL_GETUSERPTR(copy);
+		} else if (v.type == Y_LIST) {
+			v.value.uval = copier_copylist(c, v.value.uval);
+		} else if (v.type == Y_TABLE) {
+			v.value.uval = copier_copytable(c, v.value.uval);
+		} else {
+			v.value.uval = copier_copyuserdata(c, v.value.uval);
+		}
+		return v;
+	}
+	case Y_CLOSURE: {
+		if (!c->rules->fns) {
+			return YASL_UNDEF();
+		}
+		struct YASL_Object copy = YASL_Table_search(c->copies, YASL_USERPTR(v.value.lval));
+		v.value.lval = copy.type != Y_END ? (struct Closure *)YASL_GETUSERPTR(copy) : copier_copyclosure(c, v.value.lval);
+		return v;
+	}
+	case Y_FN:
+		return c->rules->fns ? v : YASL_UNDEF();
+	default:
+		return v;
+	}
+}
+
+void copy_fixups_apply(struct VM *const vm, struct YASL_List *const fixups) {
+	if (!fixups) {
+		return;
+	}
+	FOR_LIST(i, item, fixups) {
+		struct RC_UserData *ud = (struct RC_UserData *)YASL_GETUSERPTR(item);
+		struct YASL_String *name = YASL_String_new_sized(strlen(ud->tag), ud->tag);
+		struct YASL_Object mt = YASL_Table_search(vm->metatables, YASL_STR(name));
+		str_del(name);
+		if (mt.type != Y_END) {
+			ud_setmt(ud, YASL_GETUSERDATA(mt));
+		}
+	}
+	YASL_List_del_data(fixups);
+}
+
+struct YASL_List *copier_finish(struct Copier *const c, struct VM *const vm) {
+	YASL_Table_del(c->copies);
+	if (c->detached) {
+		mem_enter(c->prev);
+	}
+	if (!vm) {
+		return c->fixups;
+	}
+	copy_fixups_apply(vm, c->fixups);
+	return NULL;
+}
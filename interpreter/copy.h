@@ -0,0 +1,68 @@
+#ifndef YASL_COPY_H_
+#define YASL_COPY_H_
+
+#include "VM.h"
+
+/*
+ * Deep copies of values, for moving them from one state to another: into a clone of the state (see clone.h), or into a
+ * state on another thread (see the thread library). Tables, lists, closures with their upvalues, and the collections'
+ * userdata are copied, keeping any aliasing and cycles between them.
+ */
+
+/*
+ * What may be copied, and how.
+ */
+struct CopyRules {
+	// Whether strings and C functions are frozen in the state they come from, and metatables copied, for a clone of
+	// that state. Otherwise strings are shared between threads (see share_str), and copies are given the metatables of
+	// the state they end up in.
+	bool freeze;
+	bool fns;                     // whether functions and closures may be copied
+	const char *shared_tag;       // tag of userdata whose data is shared by their copies rather than copied, or NULL
+	void *(*share)(void *data);   // called with a shared userdata's data for each copy of it
+	void (*unshare)(void *data);  // destructor for the copies of shared userdata
+};
+
+/*
+ * Returns the type name of the first value reachable from v that can't be copied under rules, or NULL if there isn't
+ * one. seen holds what has already been checked, as userptrs.
+ */
+const char *copy_check(const struct CopyRules *const rules, struct YASL_Object v, struct YASL_Table *const seen);
+
+/*
+ * Checks n values at once, as copy_check does.
+ */
+const char *copy_checkn(const struct CopyRules *const rules, const struct YASL_Object *const values, const size_t n);
+
+/*
+ * Copies values out of one state for another. Everything copied must have passed copy_check under the same rules.
+ */
+struct Copier {
+	const struct CopyRules *rules;
+	struct VM *from;            // when freezing, the state the values come from
+	bool detached;              // whether the copies leave this thread, see copier_init
+	struct Allocator *prev;
+	struct YASL_Table *copies;  // original list, table, userdata, closure or upvalue -> its copy, both as userptrs
+	struct YASL_List *fixups;   // userptrs to copied userdata that need the receiver's metatable
+};
+
+/*
+ * Copies that will be used and freed on another thread are detached: they aren't charged to the state running on this
+ * one. Copies into the running state are charged to it as usual. from is only needed when rules freeze.
+ */
+void copier_init(struct Copier *const c, const struct CopyRules *const rules, struct VM *const from, bool detached);
+
+struct YASL_Object copier_copy(struct Copier *const c, struct YASL_Object v);
+
+/*
+ * Finishes copying into vm. Pass NULL if the copies are not going straight into a state; the fixups are then
+ * returned, and must be applied with copy_fixups_apply once they are.
+ */
+struct YASL_List *copier_finish(struct Copier *const c, struct VM *const vm);
+
+/*
+ * Gives the copied userdata their metatables from vm, which is the state they were copied into, and frees fixups.
+ */
+void copy_fixups_apply(struct VM *const vm, struct YASL_List *const fixups);
+
+#endif
@@ -0,0 +1,55 @@
+#include "coroutine.h"
+
+#include "alloc.h"
+#include "upvalue.h"
+
+struct Coroutine *co_new(const struct YASL_Object fn) {
+	struct Coroutine *co = (struct Coroutine *)mem_alloc(Y_USERDATA, sizeof(struct Coroutine));
+	co->status = CO_SUSPENDED;
+	co->depth = 0;
+	co->stack = (struct YASL_Object *)mem_calloc(Y_USERDATA, CO_STACK_SIZE, sizeof(struct YASL_Object));
+	co->stack_size = CO_STACK_SIZE;
+	co->frames = (struct CallFrame *)mem_alloc(Y_USERDATA, sizeof(struct CallFrame) * CO_NUM_FRAMES);
+	co->frames_size = CO_NUM_FRAMES;
+	co->frame_num = -1;
+	co->loopframes = (struct LoopFrame *)mem_alloc(Y_USERDATA, sizeof(struct LoopFrame) * NUM_LOOPFRAMES);
+	co->loopframe_num = -1;
+	co->pc = NULL;
+	co->sp = 0;
+	co->fp = -1;
+	co->next_fp = -1;
+	co->pending = NULL;
+
+	co->stack[0] = fn;
+	inc_ref(co->stack);
+	return co;
+}
+
+void co_release(struct Coroutine *const co) {
+	if (co->stack == NULL) return;
+
+	co->pending = upval_close_from(co->pending, co->stack);
+
+	while (co->loopframe_num >= 0) {
+		dec_ref(&co->loopframes[co->loopframe_num].iterable);
+		dec_ref(&co->loopframes[co->loopframe_num].next);
+		co->loopframe_num--;
+	}
+
+	for (int i = 0; i < co->stack_size; i++) {
+		dec_ref(co->stack + i);
+	}
+	mem_free(co->stack);
+	mem_free(co->frames);
+	mem_free(co->loopframes);
+	co->stack = NULL;
+	co->frames = NULL;
+	co->loopframes = NULL;
+	co->sp = -1;
+	co->status = CO_DEAD;
+}
+
+void co_del(void *co) {
+	co_release((struct Coroutine *)co);
+	mem_free(co);
+}
@@ -0,0 +1,47 @@
+#ifndef YASL_COROUTINE_H_
+#define YASL_COROUTINE_H_
+
+#include "VM.h"
+
+enum CoroutineStatus {
+	CO_SUSPENDED,  // not started yet, or stopped in a yield
+	CO_RUNNING,
+	CO_NORMAL,     // running, but waiting on a coroutine it resumed
+	CO_DEAD        // returned, or stopped by an error
+};
+
+/*
+ * A coroutine has its own stack and frames, which start small and grow as needed (see vm_growstack).
+ * vm_resume_coroutine swaps them with the VM's, so while a coroutine runs, these fields hold the context of whoever
+ * resumed it instead.
+ */
+struct Coroutine {
+	enum CoroutineStatus status;
+	int depth;                     // vm->depth while the coroutine runs; it can only yield from there
+	struct YASL_Object *stack;
+	int stack_size;
+	struct CallFrame *frames;
+	int frames_size;
+	int frame_num;
+	struct LoopFrame *loopframes;
+	int loopframe_num;
+	unsigned char *pc;
+	int sp;
+	int fp;
+	int next_fp;
+	struct Upvalue *pending;
+};
+
+/*
+ * Makes a suspended coroutine that will call fn when first resumed.
+ */
+struct Coroutine *co_new(const struct YASL_Object fn);
+
+/*
+ * Closes over anything the coroutine's closures captured from its stack, and frees its stack and frames. The
+ * coroutine is dead afterwards. Must not be called while it is running.
+ */
+void co_release(struct Coroutine *const co);
+void co_del(void *co);
+
+#endif
@@ -3,8 +3,11 @@
 #include "yasl.h"
 #include "yasl_aux.h"
 #include "data-structures/YASL_List.h"
+#include "interpreter/alloc.h"
+#include "interpreter/userdata.h"
 #include "yasl_error.h"
 #include "yasl_state.h"
+#include "util/sort.h"
 
 static struct YASL_List *YASLX_checknlist(struct YASL_State *S, const char *name, unsigned pos) {
 	if (!YASL_isnlist(S, pos)) {
@@ -54,6 +57,7 @@ int list___set(struct YASL_State *S) {
 
 	if (index < 0) index += ls->count;
 
+	YASL_List_unshare(ls);
 	inc_ref(&value);
 	dec_ref(ls->items + index);
 	ls->items[index] = value;
@@ -62,12 +66,9 @@ int list___set(struct YASL_State *S) {
 
 int list_copy(struct YASL_State *S) {
 	struct YASL_List *ls = YASLX_checknlist(S, "list.copy", 0);
-	struct RC_UserData *new_ls = rcls_new_sized(ls->size);
+	struct RC_UserData *new_ls = rcls_new_sized(ls->count);
 	ud_setmt(new_ls, S->vm.builtins_htable[Y_LIST]);
-	struct YASL_List *new_list = (struct YASL_List *) new_ls->data;
-	FOR_LIST(i, elmt, ls) {
-		YASL_List_append(new_list, elmt);
-	}
+	YASL_List_extend((struct YASL_List *) new_ls->data, ls);
 
 	vm_pushlist((struct VM *) S, new_ls);
 	return 1;
@@ -101,16 +102,21 @@ int list_pushv(struct YASL_State *S) {
 }
 */
 
+int list_extend(struct YASL_State *S) {
+	struct YASL_List *other = YASLX_checknlist(S, "list.extend", 1);
+	struct YASL_List *ls = YASLX_checknlist(S, "list.extend", 0);
+
+	YASL_List_extend(ls, other);
+	YASL_pop(S);
+	return 1;
+}
+
 static struct RC_UserData *list_concat(struct YASL_State *S, struct YASL_List *a, struct YASL_List *b) {
 	size_t size = a->count + b->count;
 	struct RC_UserData *ptr = rcls_new_sized(size);
 	ud_setmt(ptr, (&S->vm)->builtins_htable[Y_LIST]);
-	for (size_t i = 0; i < a->count; i++) {
-		YASL_List_append((struct YASL_List *) ptr->data, (a)->items[i]);
-	}
-	for (size_t i = 0; i < (b)->count; i++) {
-		YASL_List_append((struct YASL_List *) ptr->data, (b)->items[i]);
-	}
+	YASL_List_extend((struct YASL_List *) ptr->data, a);
+	YASL_List_extend((struct YASL_List *) ptr->data, b);
 
 	return ptr;
 }
@@ -152,6 +158,7 @@ int list_pop(struct YASL_State *S) {
 		vm_print_err_value((struct VM *)S, "%s expected nonempty list as arg 0.", "list.pop");
 		YASL_throw_err(S, YASL_VALUE_ERROR);
 	}
+	YASL_List_unshare(ls);
 	vm_push((struct VM *) S, ls->items[--ls->count]);
 	return 1;
 }
@@ -171,6 +178,7 @@ int list_remove(struct YASL_State *S) {
 		vm_push(&S->vm, name);
 		vm_EQ(&S->vm);
 		if (YASL_popbool(S)) {
+			YASL_List_unshare(ls);
 			dec_ref(&name);
 			size_t remaining = ls->count - i;
 			memmove(ls->items + i, ls->items + i + 1, remaining * sizeof(struct YASL_Object));
@@ -272,10 +280,11 @@ int list_tostr(struct YASL_State *S) {
 
 int list_clear(struct YASL_State *S) {
 	struct YASL_List *list = YASLX_checknlist(S, "list.clear", 0);
+	YASL_List_unshare(list);
 	FOR_LIST(i, obj, list) vm_dec_ref(&S->vm, &obj);
 	list->count = 0;
 	list->size = LIST_BASESIZE;
-	list->items = (struct YASL_Object *) realloc(list->items, sizeof(struct YASL_Object) * list->size);
+	list->items = (struct YASL_Object *) mem_realloc(Y_LIST, list->items, sizeof(struct YASL_Object) * list->size);
 
 	return 0;
 }
@@ -367,103 +376,374 @@ int list_count(struct YASL_State *S) {
 	return 1;
 }
 
-static const int SORT_TYPE_EMPTY = 0;
-static const int SORT_TYPE_STR = -1;
-static const int SORT_TYPE_NUM = 1;
-void sort(struct YASL_Object *list, const size_t len) {
-	// Base cases
-	struct YASL_Object tmpObj;
-	if (len < 2) return;
-	if (len == 2) {
-		if (yasl_object_cmp(list[0], list[1]) > 0) {
-			tmpObj = list[0];
-			list[0] = list[1];
-			list[1] = tmpObj;
+/*
+ * Turns a possibly negative index into an offset into ls, throwing if it is out of range.
+ */
+static size_t list_checkindex(struct YASL_State *S, struct YASL_List *ls, yasl_int index) {
+	if (index < -(yasl_int) ls->count || index >= (yasl_int) ls->count) {
+		vm_print_err_value(&S->vm, "unable to index list of length %" PRI_SIZET " with index %" PRId64 ".", ls->count, index);
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+	return (size_t)(index < 0 ? index + (yasl_int) ls->count : index);
+}
+
+/*
+ * list.index(x, [start]) returns the index of the first item equal to x at or after start, or undef if there is none.
+ */
+int list_index(struct YASL_State *S) {
+	struct YASL_List *ls = YASLX_checknlist(S, "list.index", 0);
+	struct YASL_Object needle = vm_peek(&S->vm, S->vm.fp + 2);
+	yasl_int start = 0;
+	if (!YASL_isnundef(S, 2)) {
+		start = YASLX_checknint(S, "list.index", 2);
+		if (start < 0) start += (yasl_int) ls->count;
+		if (start < 0) start = 0;
+	}
+
+	for (size_t i = (size_t) start; i < ls->count; i++) {
+		if (isequal(ls->items + i, &needle)) {
+			YASL_pushint(S, (yasl_int) i);
+			return 1;
 		}
-		return;
 	}
 
-	// YASL_Set sorting bounds
-	size_t left = 0;
-	size_t right = len - 1;
+	YASL_pushundef(S);
+	return 1;
+}
 
-	// Determine random midpoint to use (good average case)
-	const size_t randIndex = rand() % len;
-	const struct YASL_Object mid = list[randIndex];
+/*
+ * list.resize(n, [fill]) truncates ls to n items, or pads it out to n items with fill.
+ */
+int list_resize(struct YASL_State *S) {
+	struct YASL_List *ls = YASLX_checknlist(S, "list.resize", 0);
+	yasl_int n = YASLX_checknint(S, "list.resize", 1);
+	struct YASL_Object fill = vm_peek(&S->vm, S->vm.fp + 3);
+	if (n < 0) {
+		vm_print_err_value(&S->vm, "%s expected nonnegative length, got %" PRId64 ".", "list.resize", n);
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
 
-	// Determine exact number of items less than mid (mid's index)
-	// Furthermore, ensure list is not homogenous to avoid infinite loops
-	size_t ltCount = 0;
-	int seenDifferent = 0;
-	for (size_t i = 0; i < len; i++) {
-		if (yasl_object_cmp(list[i], mid) < 0) ltCount++;
-		if (seenDifferent == 0 && yasl_object_cmp(list[0], list[i]) != 0) seenDifferent = 1;
+	const size_t count = (size_t) n;
+	if (count > ls->count) {
+		const size_t more = count - ls->count;
+		mem_reserve(more > SIZE_MAX / sizeof(struct YASL_Object) ? SIZE_MAX : more * sizeof(struct YASL_Object));
+	}
+	YASL_List_reserve(ls, count);
+	for (size_t i = count; i < ls->count; i++) dec_ref(ls->items + i);
+	for (size_t i = ls->count; i < count; i++) {
+		ls->items[i] = fill;
+		inc_ref(&fill);
 	}
-	if (seenDifferent == 0) return;
+	ls->count = count;
 
-	// Ensure all items are on the correct side of mid
-	while (left < right) {
-		while (yasl_object_cmp(list[left], mid) < 0) left++;
-		while (yasl_object_cmp(list[right], mid) >= 0) {
-			if (right == 0) break;
-			right--;
-		}
+	YASL_pop(S);
+	YASL_pop(S);
+	return 1;
+}
 
-		int cmp = yasl_object_cmp(list[left], list[right]);
-		if (cmp > 0 && left < right) {
-			tmpObj = list[right];
-			list[right] = list[left];
-			list[left++] = tmpObj;
-			if (right == 0) break;
-			right--;
-		} else if (cmp == 0) {
-			left++;
-			if (right == 0) break;
-			right--;
-		}
+int list_fill(struct YASL_State *S) {
+	struct YASL_List *ls = YASLX_checknlist(S, "list.fill", 0);
+	struct YASL_Object fill = vm_pop(&S->vm);
+
+	YASL_List_unshare(ls);
+	for (size_t i = 0; i < ls->count; i++) {
+		inc_ref(&fill);
+		dec_ref(ls->items + i);
+		ls->items[i] = fill;
+	}
+	return 1;
+}
+
+/*
+ * list.rotate(k) moves every item k places to the right, wrapping around. Negative k rotates to the left. The items
+ * are only moved, so no refcounts change.
+ */
+int list_rotate(struct YASL_State *S) {
+	struct YASL_List *ls = YASLX_checknlist(S, "list.rotate", 0);
+	yasl_int k = YASLX_checknint(S, "list.rotate", 1);
+	YASL_pop(S);
+
+	const size_t n = ls->count;
+	if (n == 0) return 1;
+	k %= (yasl_int) n;
+	if (k < 0) k += (yasl_int) n;
+	if (k == 0) return 1;
+
+	YASL_List_unshare(ls);
+	struct YASL_Object *items = ls->items;
+	const size_t right = (size_t) k;  // items that wrap from the back to the front
+	if (right <= n - right) {
+		struct YASL_Object *tmp = (struct YASL_Object *) mem_alloc(Y_LIST, right * sizeof(struct YASL_Object));
+		memcpy(tmp, items + n - right, right * sizeof(struct YASL_Object));
+		memmove(items + right, items, (n - right) * sizeof(struct YASL_Object));
+		memcpy(items, tmp, right * sizeof(struct YASL_Object));
+		mem_free(tmp);
+	} else {
+		const size_t left = n - right;
+		struct YASL_Object *tmp = (struct YASL_Object *) mem_alloc(Y_LIST, left * sizeof(struct YASL_Object));
+		memcpy(tmp, items, left * sizeof(struct YASL_Object));
+		memmove(items, items + left, right * sizeof(struct YASL_Object));
+		memcpy(items + right, tmp, left * sizeof(struct YASL_Object));
+		mem_free(tmp);
 	}
+	return 1;
+}
+
+int list_swap(struct YASL_State *S) {
+	struct YASL_List *ls = YASLX_checknlist(S, "list.swap", 0);
+	yasl_int i = YASLX_checknint(S, "list.swap", 1);
+	yasl_int j = YASLX_checknint(S, "list.swap", 2);
+	const size_t a = list_checkindex(S, ls, i);
+	const size_t b = list_checkindex(S, ls, j);
 
-	// Let sort() finish that for us...
-	sort(list, ltCount);
-	sort(&list[ltCount], len - ltCount);
+	YASL_List_unshare(ls);
+	struct YASL_Object tmp = ls->items[a];
+	ls->items[a] = ls->items[b];
+	ls->items[b] = tmp;
+
+	YASL_pop(S);
+	YASL_pop(S);
+	return 1;
 }
 
-// TODO: clean this up
+#define SORT_LESS(ctx, a, b) ((a) < (b))
+#define SORT_NUM_LESS(ctx, a, b) (obj_getnum(&(a)) < obj_getnum(&(b)))
+#define SORT_STR_LESS(ctx, a, b) (YASL_String_cmp(obj_getstr(&(a)), obj_getstr(&(b))) < 0)
+
+DEFINE_SORT(sort_ints, yasl_int, void *, SORT_LESS)
+DEFINE_SORT(sort_floats, yasl_float, void *, SORT_LESS)
+DEFINE_SORT(sort_nums, struct YASL_Object, void *, SORT_NUM_LESS)
+DEFINE_SORT(sort_strs, struct YASL_Object, void *, SORT_STR_LESS)
+
+enum SortType {
+	SORT_TYPE_EMPTY,
+	SORT_TYPE_INT,
+	SORT_TYPE_FLOAT,
+	SORT_TYPE_NUM,
+	SORT_TYPE_STR,
+	SORT_TYPE_ERR
+};
+
+/*
+ * Narrows type to the most specific kernel that can sort everything seen so far, including obj.
+ */
+static enum SortType sort_type_add(const enum SortType type, const struct YASL_Object *const obj) {
+	switch (obj->type) {
+	case Y_INT:
+		if (type == SORT_TYPE_EMPTY || type == SORT_TYPE_INT) return SORT_TYPE_INT;
+		if (type == SORT_TYPE_FLOAT || type == SORT_TYPE_NUM) return SORT_TYPE_NUM;
+		return SORT_TYPE_ERR;
+	case Y_FLOAT:
+		if (type == SORT_TYPE_EMPTY || type == SORT_TYPE_FLOAT) return SORT_TYPE_FLOAT;
+		if (type == SORT_TYPE_INT || type == SORT_TYPE_NUM) return SORT_TYPE_NUM;
+		return SORT_TYPE_ERR;
+	case Y_STR:
+		if (type == SORT_TYPE_EMPTY || type == SORT_TYPE_STR) return SORT_TYPE_STR;
+		return SORT_TYPE_ERR;
+	default:
+		return SORT_TYPE_ERR;
+	}
+}
+
+static void sort_items(struct YASL_Object *const items, const size_t n, const enum SortType type) {
+	switch (type) {
+	case SORT_TYPE_INT: {
+		yasl_int *vals = (yasl_int *)mem_alloc(Y_LIST, n * sizeof(yasl_int));
+		for (size_t i = 0; i < n; i++) vals[i] = obj_getint(items + i);
+		sort_ints(vals, n, NULL);
+		for (size_t i = 0; i < n; i++) items[i] = YASL_INT(vals[i]);
+		mem_free(vals);
+		break;
+	}
+	case SORT_TYPE_FLOAT: {
+		yasl_float *vals = (yasl_float *)mem_alloc(Y_LIST, n * sizeof(yasl_float));
+		for (size_t i = 0; i < n; i++) vals[i] = obj_getfloat(items + i);
+		sort_floats(vals, n, NULL);
+		for (size_t i = 0; i < n; i++) items[i] = YASL_FLOAT(vals[i]);
+		mem_free(vals);
+		break;
+	}
+	case SORT_TYPE_NUM:
+		sort_nums(items, n, NULL);
+		break;
+	case SORT_TYPE_STR:
+		sort_strs(items, n, NULL);
+		break;
+	default:
+		break;
+	}
+}
+
+struct SortPair {
+	struct YASL_Object key;
+	struct YASL_Object item;
+};
+
+#define SORT_PAIR_INT_LESS(ctx, a, b) (obj_getint(&(a).key) < obj_getint(&(b).key))
+#define SORT_PAIR_NUM_LESS(ctx, a, b) (obj_getnum(&(a).key) < obj_getnum(&(b).key))
+#define SORT_PAIR_STR_LESS(ctx, a, b) (YASL_String_cmp(obj_getstr(&(a).key), obj_getstr(&(b).key)) < 0)
+
+DEFINE_SORT(sort_pairs_int, struct SortPair, void *, SORT_PAIR_INT_LESS)
+DEFINE_SORT(sort_pairs_num, struct SortPair, void *, SORT_PAIR_NUM_LESS)
+DEFINE_SORT(sort_pairs_str, struct SortPair, void *, SORT_PAIR_STR_LESS)
+
+struct SortCmp {
+	struct VM *vm;
+	struct YASL_Object fn;
+};
+
+static bool sort_cmp_less(const struct SortCmp *const cmp, const struct YASL_Object a, const struct YASL_Object b) {
+	struct VM *vm = cmp->vm;
+	vm_push(vm, cmp->fn);
+	vm_INIT_CALL_offset(vm, vm->sp, 1);
+	vm_push(vm, a);
+	vm_push(vm, b);
+	vm_CALL_now(vm);
+	if (!vm_isnum(vm)) {
+		vm_print_err_type(vm, "%s expected comparison function to return a number, got %s.", "list.sort", vm_peektypename(vm));
+		vm_throw_err(vm, YASL_TYPE_ERROR);
+	}
+	const struct YASL_Object result = vm_pop(vm);
+	return obj_getnum(&result) < 0;
+}
+
+#define SORT_CMP_LESS(ctx, a, b) sort_cmp_less(ctx, a, b)
+
+DEFINE_SORT(sort_cmp, struct YASL_Object, const struct SortCmp *, SORT_CMP_LESS)
+
+static const char *const SORT_SCRATCH_NAME = "list.sort scratch";
+
+/*
+ * Pushes a list that holds a reference to every item and key while we sort, so that the key or comparison function
+ * can modify the list without freeing anything out from under us, followed by size bytes of scratch space. Both are
+ * owned by the stack, so they are freed even if the key or comparison function throws.
+ */
+static struct YASL_List *sort_push_scratch(struct YASL_State *S, const size_t num_refs, const size_t size,
+					   void **scratch) {
+	struct RC_UserData *refs = rcls_new_sized(num_refs);
+	vm_pushlist(&S->vm, refs);
+	struct RC_UserData *ud = ud_new_inline(size, SORT_SCRATCH_NAME, NULL, NULL);
+	vm_push(&S->vm, YASL_USERDATA(ud));
+	*scratch = ud->data;
+	return (struct YASL_List *)refs->data;
+}
+
+/*
+ * Puts sorted back into ls. The items are still referenced from the scratch list, so the order doesn't matter.
+ */
+static void sort_write_back(struct YASL_State *S, struct YASL_List *ls, const struct YASL_Object *const sorted,
+			    const size_t n) {
+	if (ls->count != n) {
+		vm_print_err_value(&S->vm, "%s: list was modified during sort.", "list.sort");
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+	YASL_List_unshare(ls);
+	for (size_t i = 0; i < n; i++) {
+		dec_ref(ls->items + i);
+		ls->items[i] = sorted[i];
+		inc_ref(ls->items + i);
+	}
+}
+
+static void sort_by_key(struct YASL_State *S, struct YASL_List *ls, struct YASL_Object key) {
+	struct VM *vm = &S->vm;
+	const size_t n = ls->count;
+	void *scratch;
+	struct YASL_List *refs = sort_push_scratch(S, 2 * n, (n + SORT_TMP_LEN(n)) * sizeof(struct SortPair), &scratch);
+	struct SortPair *pairs = (struct SortPair *)scratch;
+	size_t num_keys = 0;
+	for (; num_keys < n && num_keys < ls->count; num_keys++) {
+		pairs[num_keys].item = ls->items[num_keys];
+		YASL_List_append(refs, pairs[num_keys].item);
+		vm_push(vm, key);
+		vm_INIT_CALL_offset(vm, vm->sp, 1);
+		vm_push(vm, pairs[num_keys].item);
+		vm_CALL_now(vm);
+		pairs[num_keys].key = vm_pop(vm);
+		YASL_List_append(refs, pairs[num_keys].key);
+	}
+
+	if (num_keys != n) {
+		vm_print_err_value(&S->vm, "%s: list was modified during sort.", "list.sort");
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+
+	enum SortType type = SORT_TYPE_EMPTY;
+	for (size_t i = 0; i < num_keys; i++) {
+		type = sort_type_add(type, &pairs[i].key);
+	}
+	if (type == SORT_TYPE_ERR) {
+		vm_print_err_value(&S->vm, "%s expected keys to be all numbers or all strings.", "list.sort");
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+
+	struct SortPair *const tmp = pairs + n;
+	if (type == SORT_TYPE_INT) {
+		sort_pairs_int_with(pairs, n, tmp, NULL);
+	} else if (type == SORT_TYPE_STR) {
+		sort_pairs_str_with(pairs, n, tmp, NULL);
+	} else if (type != SORT_TYPE_EMPTY) {
+		sort_pairs_num_with(pairs, n, tmp, NULL);
+	}
+
+	// The items can be packed into the front of pairs, since sorted[i] only overwrites pairs that have been read.
+	struct YASL_Object *sorted = (struct YASL_Object *)scratch;
+	for (size_t i = 0; i < n; i++) {
+		sorted[i] = pairs[i].item;
+	}
+	sort_write_back(S, ls, sorted, n);
+}
+
+static void sort_by_cmp(struct YASL_State *S, struct YASL_List *ls, struct YASL_Object fn) {
+	const size_t n = ls->count;
+	void *scratch;
+	struct YASL_List *refs = sort_push_scratch(S, n, (n + SORT_TMP_LEN(n)) * sizeof(struct YASL_Object), &scratch);
+	YASL_List_extend(refs, ls);
+	struct YASL_Object *sorted = (struct YASL_Object *)scratch;
+	memcpy(sorted, ls->items, n * sizeof(struct YASL_Object));
+
+	const struct SortCmp cmp = { &S->vm, fn };
+	sort_cmp_with(sorted, n, sorted + n, &cmp);
+	sort_write_back(S, ls, sorted, n);
+}
+
+/*
+ * list.sort([key], [cmp])
+ * Sorts the list in place. The sort is stable. Without arguments, the list must hold all numbers or all strings.
+ * key is called once per item, and the items are ordered by the results. cmp is called with two items and must
+ * return a negative number if the first should come before the second.
+ */
 int list_sort(struct YASL_State *S) {
-	struct YASL_List *list = YASLX_checknlist(S, "list.sort", 0);
-	int type = SORT_TYPE_EMPTY;
-
-	int err = 0;
-	for (size_t i = 0; i < list->count; i++) {
-		switch (list->items[i].type) {
-		case Y_STR:
-			if (type == SORT_TYPE_EMPTY) {
-				type = SORT_TYPE_STR;
-			} else if (type == SORT_TYPE_NUM) {
-				err = -1;
-			}
-			break;
-		case Y_INT:
-		case Y_FLOAT:
-			if (type == SORT_TYPE_EMPTY) {
-				type = SORT_TYPE_NUM;
-			} else if (type == SORT_TYPE_STR) {
-				err = -1;
-			}
-			break;
-		default: err = -1;
-		}
+	struct YASL_Object cmp = vm_peek(&S->vm);
+	struct YASL_Object key = vm_peek(&S->vm, S->vm.sp - 1);
+	struct YASL_List *ls = YASLX_checknlist(S, "list.sort", 0);
 
-		if (err != 0) {
-			vm_print_err_value((struct VM *)S, "%s expected a list of all numbers or all strings.", "list.sort");
-			YASL_throw_err(S, YASL_VALUE_ERROR);
-		}
+	if (!obj_isundef(&key) && !obj_isundef(&cmp)) {
+		vm_print_err_value((struct VM *)S, "%s expected at most one of key and cmp.", "list.sort");
+		YASL_throw_err(S, YASL_VALUE_ERROR);
 	}
 
-	if (type != SORT_TYPE_EMPTY) {
-		sort(list->items, list->count);
+	if (!obj_isundef(&key)) {
+		sort_by_key(S, ls, key);
+		return 0;
+	}
+
+	if (!obj_isundef(&cmp)) {
+		sort_by_cmp(S, ls, cmp);
+		return 0;
+	}
+
+	enum SortType type = SORT_TYPE_EMPTY;
+	for (size_t i = 0; i < ls->count && type != SORT_TYPE_ERR; i++) {
+		type = sort_type_add(type, ls->items + i);
+	}
+	if (type == SORT_TYPE_ERR) {
+		vm_print_err_value((struct VM *)S, "%s expected a list of all numbers or all strings.", "list.sort");
+		YASL_throw_err(S, YASL_VALUE_ERROR);
 	}
 
+	YASL_List_unshare(ls);
+	sort_items(ls->items, ls->count, type);
 	return 0;
 }
 
@@ -39,4 +39,16 @@ int list_spread(struct YASL_State *S);
 
 int list_insert(struct YASL_State *S);
 
+int list_extend(struct YASL_State *S);
+
+int list_index(struct YASL_State *S);
+
+int list_resize(struct YASL_State *S);
+
+int list_fill(struct YASL_State *S);
+
+int list_rotate(struct YASL_State *S);
+
+int list_swap(struct YASL_State *S);
+
 #endif
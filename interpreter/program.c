@@ -0,0 +1,82 @@
+#include "program.h"
+
+#include <string.h>
+
+#include "alloc.h"
+#include "opcode.h"
+#include "refcount.h"
+#include "util/atomic.h"
+
+struct YASL_Object *program_decode_constants(const unsigned char *code, int64_t *num_constants) {
+	const int64_t num = ((const int64_t *)code)[2];
+	struct YASL_Object *constants = (struct YASL_Object *)malloc(sizeof(struct YASL_Object) * num);
+	const unsigned char *tmp = code + 3*sizeof(int64_t);
+	for (int64_t i = 0; i < num; i++) {
+		switch (*tmp++) {
+		case C_STR: {
+			int64_t len = *((const int64_t *) tmp);
+			tmp += sizeof(int64_t);
+			char *str = (char *) malloc((size_t) len);
+			memcpy(str, tmp, (size_t) len);
+			constants[i] = YASL_STR(YASL_String_new_sized_heap(0, (size_t) len, str));
+			inc_ref(constants + i);
+			tmp += len;
+			break;
+		}
+		case C_INT_1: {
+			constants[i] = YASL_INT((signed char)*tmp++);
+			break;
+		}
+		case C_INT_8: {
+			int64_t v = *((const int64_t *) tmp);
+			constants[i] = YASL_INT(v);
+			tmp += sizeof(int64_t);
+			break;
+		}
+		case C_FLOAT: {
+			yasl_float v = *((const yasl_float *) tmp);
+			constants[i] = YASL_FLOAT(v);
+			tmp += sizeof(yasl_float);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+	*num_constants = num;
+	return constants;
+}
+
+struct YASL_Program *program_new(unsigned char *code) {
+	struct YASL_Program *program = (struct YASL_Program *)malloc(sizeof(struct YASL_Program));
+	program->refs = 1;
+	program->code = code;
+	// The constants may outlive the state compiling them, so they aren't charged to it.
+	struct Allocator *const prev = mem_enter(NULL);
+	program->constants = program_decode_constants(code, &program->num_constants);
+	mem_enter(prev);
+	for (int64_t i = 0; i < program->num_constants; i++) {
+		if (program->constants[i].type == Y_STR) {
+			program->constants[i].value.sval->rc.refs = RC_IMMORTAL;
+		}
+	}
+	return program;
+}
+
+void program_inc_ref(struct YASL_Program *program) {
+	atomic_inc(&program->refs);
+}
+
+void program_dec_ref(struct YASL_Program *program) {
+	if (!program || atomic_dec(&program->refs) > 0) {
+		return;
+	}
+	for (int64_t i = 0; i < program->num_constants; i++) {
+		if (program->constants[i].type == Y_STR) {
+			str_del(program->constants[i].value.sval);
+		}
+	}
+	free(program->constants);
+	free(program->code);
+	free(program);
+}
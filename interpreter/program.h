@@ -0,0 +1,30 @@
+#ifndef YASL_PROGRAM_H_
+#define YASL_PROGRAM_H_
+
+#include "YASL_Object.h"
+
+/*
+ * Compiled bytecode together with its decoded constants. A program never changes once it is built, and its constants
+ * are immortal, so any number of states can run it, on any threads; each state that runs it holds a reference to it,
+ * as does whoever compiled it.
+ */
+struct YASL_Program {
+	volatile size_t refs;
+	unsigned char *code;
+	int64_t num_constants;
+	struct YASL_Object *constants;
+};
+
+/*
+ * Decodes the constant pool at the start of code. The returned array holds one reference to each constant.
+ */
+struct YASL_Object *program_decode_constants(const unsigned char *code, int64_t *num_constants);
+
+/*
+ * Builds a program from code, which the program takes ownership of. The program starts with one reference.
+ */
+struct YASL_Program *program_new(unsigned char *code);
+void program_inc_ref(struct YASL_Program *program);
+void program_dec_ref(struct YASL_Program *program);
+
+#endif
@@ -0,0 +1,119 @@
+#include "range_methods.h"
+
+#include <inttypes.h>
+
+#include "yasl.h"
+#include "yasl_aux.h"
+#include "yasl_error.h"
+#include "yasl_state.h"
+#include "interpreter/alloc.h"
+
+const char *const RANGE_NAME = "range";
+
+int range_parse(struct VM *vm, const struct YASL_Object *args, int argc, struct YASL_Range *range) {
+	while (argc > 1 && obj_isundef(args + argc - 1)) {
+		argc--;
+	}
+	for (int i = 0; i < argc; i++) {
+		if (!obj_isint(args + i)) {
+			vm_print_err_bad_arg_type_name(vm, "range", i, "int", obj_typename(args + i));
+			return YASL_TYPE_ERROR;
+		}
+	}
+
+	range->start = 0;
+	range->step = 1;
+	if (argc == 1) {
+		range->stop = obj_getint(args);
+		return YASL_SUCCESS;
+	}
+	range->start = obj_getint(args);
+	range->stop = obj_getint(args + 1);
+	if (argc == 3) {
+		range->step = obj_getint(args + 2);
+	}
+	if (range->step == 0) {
+		vm_print_err_value(vm, "%s expected nonzero step.", "range");
+		return YASL_VALUE_ERROR;
+	}
+	return YASL_SUCCESS;
+}
+
+/*
+ * Number of items in range. This is done in unsigned arithmetic so that ranges spanning most of yasl_int don't overflow.
+ */
+uint64_t range_len(const struct YASL_Range *range) {
+	if (range->step > 0) {
+		return range->start < range->stop ?
+		       ((uint64_t)range->stop - (uint64_t)range->start - 1) / (uint64_t)range->step + 1 : 0;
+	}
+	return range->start > range->stop ?
+	       ((uint64_t)range->start - (uint64_t)range->stop - 1) / (0 - (uint64_t)range->step) + 1 : 0;
+}
+
+static struct YASL_Range *YASLX_checknrange(struct YASL_State *S, const char *name, unsigned pos) {
+	return (struct YASL_Range *)YASLX_checknuserdata(S, RANGE_NAME, name, pos);
+}
+
+int range_new(struct YASL_State *S) {
+	struct YASL_Range *range = (struct YASL_Range *)mem_alloc(Y_USERDATA, sizeof(struct YASL_Range));
+	int error = range_parse(&S->vm, S->vm.stack + S->vm.fp + 1, 3, range);
+	if (error) {
+		mem_free(range);
+		YASL_throw_err(S, error);
+	}
+
+	YASL_pushuserdata(S, range, RANGE_NAME, mem_free);
+	YASL_loadmt(S, RANGE_NAME);
+	YASL_setmt(S);
+	return 1;
+}
+
+int range___len(struct YASL_State *S) {
+	struct YASL_Range *range = YASLX_checknrange(S, "range.__len", 0);
+	YASL_pushint(S, (yasl_int)range_len(range));
+	return 1;
+}
+
+int range___get(struct YASL_State *S) {
+	yasl_int index = YASLX_checknint(S, "range.__get", 1);
+	struct YASL_Range *range = YASLX_checknrange(S, "range.__get", 0);
+	const yasl_int len = (yasl_int)range_len(range);
+
+	if (index < -len || index >= len) {
+		vm_print_err_value(&S->vm, "unable to index range of length %" PRId64 " with index %" PRId64 ".", len, index);
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+
+	if (index < 0) index += len;
+	YASL_pushint(S, (yasl_int)((uint64_t)range->start + (uint64_t)index * (uint64_t)range->step));
+	return 1;
+}
+
+/*
+ * Ranges are equal when they produce the same ints, so e.g. range(0) == range(5, 0) and range(1, 2) == range(1, 3, 5).
+ */
+int range___eq(struct YASL_State *S) {
+	struct YASL_Range *left = YASLX_checknrange(S, "range.__eq", 0);
+	if (!YASL_isnuserdata(S, RANGE_NAME, 1)) {
+		YASL_pushbool(S, false);
+		return 1;
+	}
+	struct YASL_Range *right = (struct YASL_Range *)YASL_peeknuserdata(S, 1);
+
+	const uint64_t len = range_len(left);
+	YASL_pushbool(S, len == range_len(right) &&
+			 (len == 0 || (left->start == right->start && (len == 1 || left->step == right->step))));
+	return 1;
+}
+
+int range_tostr(struct YASL_State *S) {
+	struct YASL_Range *range = YASLX_checknrange(S, "range.tostr", 0);
+	const char *fmt = "range(%" PRId64 ", %" PRId64 ", %" PRId64 ")";
+	int len = snprintf(NULL, 0, fmt, range->start, range->stop, range->step);
+	char *ptr = (char *)malloc(len + 1);
+	sprintf(ptr, fmt, range->start, range->stop, range->step);
+	YASL_pushlstr(S, ptr, len);
+	free(ptr);
+	return 1;
+}
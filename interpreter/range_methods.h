@@ -0,0 +1,40 @@
+#ifndef YASL_RANGE_METHODS_H_
+#define YASL_RANGE_METHODS_H_
+
+#include <stdint.h>
+
+#include "yasl_conf.h"
+
+struct YASL_State;
+struct YASL_Object;
+struct VM;
+
+extern const char *const RANGE_NAME;
+
+/*
+ * Lazy sequence of ints start, start + step, ... up to but not including stop.
+ */
+struct YASL_Range {
+	yasl_int start;
+	yasl_int stop;
+	yasl_int step;
+};
+
+/*
+ * Reads the args to range([start], stop, [step]) from args[0..argc), treating trailing undefs as omitted. Prints an
+ * error and returns the error code if they are not ints or step is 0, otherwise returns YASL_SUCCESS.
+ */
+int range_parse(struct VM *vm, const struct YASL_Object *args, int argc, struct YASL_Range *range);
+uint64_t range_len(const struct YASL_Range *range);
+
+int range_new(struct YASL_State *S);
+
+int range___len(struct YASL_State *S);
+
+int range___get(struct YASL_State *S);
+
+int range___eq(struct YASL_State *S);
+
+int range_tostr(struct YASL_State *S);
+
+#endif
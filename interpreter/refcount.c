@@ -10,18 +10,18 @@
 static void inc_strong_ref(struct YASL_Object *v) {
 	switch (v->type) {
 	case Y_STR:
-		v->value.sval->rc.refs++;
+		rc_inc(v->value.sval->rc);
 		break;
 	case Y_USERDATA:
 	case Y_LIST:
 	case Y_TABLE:
-		v->value.uval->rc.refs++;
+		rc_inc(v->value.uval->rc);
 		break;
 	case Y_CFN:
-		v->value.cval->rc.refs++;
+		rc_inc(v->value.cval->rc);
 		break;
 	case Y_CLOSURE:
-		v->value.lval->rc.refs++;
+		rc_inc(v->value.lval->rc);
 		break;
 	default:
 		/* do nothing */
@@ -48,7 +48,7 @@ void inc_ref(struct YASL_Object *v) {
 void dec_strong_ref(struct YASL_Object *v) {
 	switch (v->type) {
 	case Y_STR:
-		if (--(v->value.sval->rc.refs)) return;
+		if (!rc_dec(v->value.sval->rc)) return;
 		str_del_data(v->value.sval);
 		str_del_rc(v->value.sval);
 		v->type = Y_UNDEF;
@@ -56,19 +56,19 @@ void dec_strong_ref(struct YASL_Object *v) {
 	case Y_LIST:
 	case Y_USERDATA:
 	case Y_TABLE:
-		if (--(v->value.uval->rc.refs)) return;
+		if (!rc_dec(v->value.uval->rc)) return;
 		ud_del_data(v->value.uval);
 		ud_del_rc(v->value.uval);
 		v->type = Y_UNDEF;
 		break;
 	case Y_CFN:
-		if (--(v->value.cval->rc.refs)) return;
+		if (!rc_dec(v->value.cval->rc)) return;
 		cfn_del_data(v->value.cval);
 		cfn_del_rc(v->value.cval);
 		v->type = Y_UNDEF;
 		break;
 	case Y_CLOSURE:
-		if (--(v->value.lval->rc.refs)) return;
+		if (!rc_dec(v->value.lval->rc)) return;
 		closure_del_data(v->value.lval);
 		closure_del_rc(v->value.lval);
 		v->type = Y_UNDEF;
@@ -1,8 +1,11 @@
 #ifndef YASL_REFCOUNT_H_
 #define YASL_REFCOUNT_H_
 
+#include <stdint.h>
 #include <stdlib.h>
 
+#include "util/atomic.h"
+
 struct YASL_Object;
 
 struct RC {
@@ -11,4 +14,28 @@ struct RC {
 
 #define NEW_RC() ((struct RC) { 0 })
 
+/*
+ * Objects with this many references are immortal: their count is never changed and they are never freed by dec_ref.
+ * Since they are never written to, any number of states can share them, even from different threads. Whoever made
+ * them immortal is responsible for freeing them.
+ */
+#define RC_IMMORTAL SIZE_MAX
+#define rc_isimmortal(rc) (atomic_load(&(rc).refs) == RC_IMMORTAL)
+
+/*
+ * Objects with at least this many references are shared between threads, and the count above RC_SHARED is changed
+ * atomically. Only a state that owns an object outright may make it shared; the last thread to drop it frees it.
+ */
+#define RC_SHARED ((SIZE_MAX >> 1) + 1)
+#define rc_isshared(rc) (atomic_load(&(rc).refs) >= RC_SHARED)
+
+#define rc_inc(rc) do {\
+	if (!rc_isshared(rc)) (rc).refs++;\
+	else if (!rc_isimmortal(rc)) atomic_inc(&(rc).refs);\
+} while (0)
+
+// Drops a reference, and is true if that was the last one.
+#define rc_dec(rc) (!rc_isshared(rc) ? --(rc).refs == 0 :\
+	!rc_isimmortal(rc) && atomic_dec(&(rc).refs) == RC_SHARED)
+
 #endif
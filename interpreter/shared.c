@@ -0,0 +1,89 @@
+#include "shared.h"
+
+#include "alloc.h"
+#include "builtins.h"
+#include "refcount.h"
+#include "util/atomic.h"
+
+static struct YASL_Shared shared;
+static size_t shared_users = 0;
+static volatile int shared_lock = 0;
+
+static struct RC_UserData *shared_table_new(struct YASL_Table *table) {
+	struct RC_UserData *ud = ud_new(table, TABLE_NAME, NULL, rcht_del_data);
+	ud->rc.refs = RC_IMMORTAL;
+	FOR_TABLE(i, item, table) {
+		item->value.value.cval->rc.refs = RC_IMMORTAL;
+	}
+	return ud;
+}
+
+/*
+ * The methods in each table are only referenced by that table, so they can be made mortal again and freed with it.
+ */
+static void shared_table_del(struct RC_UserData *ud) {
+	FOR_TABLE(i, item, (struct YASL_Table *)ud->data) {
+		item->value.value.cval->rc.refs = 1;
+	}
+	ud->rc.refs = 1;
+	struct YASL_Object v = YASL_TABLE(ud);
+	dec_ref(&v);
+}
+
+/*
+ * The shared objects belong to no state in particular, so they aren't charged to whichever one happens to be running.
+ */
+static void shared_init(void) {
+	struct Allocator *const prev = mem_enter(NULL);
+#define X(E, S, ...) shared.special_strings[E] = YASL_String_new_sized(strlen(S), S);
+#include "specialstrings.x"
+#undef X
+
+	struct YASL_String **strings = shared.special_strings;
+	shared.builtins_htable[Y_UNDEF] = shared_table_new(undef_builtins(strings));
+	shared.builtins_htable[Y_FLOAT] = shared_table_new(float_builtins(strings));
+	shared.builtins_htable[Y_INT] = shared_table_new(int_builtins(strings));
+	shared.builtins_htable[Y_BOOL] = shared_table_new(bool_builtins(strings));
+	shared.builtins_htable[Y_STR] = shared_table_new(str_builtins(strings));
+	shared.builtins_htable[Y_LIST] = shared_table_new(list_builtins(strings));
+	shared.builtins_htable[Y_TABLE] = shared_table_new(table_builtins(strings));
+	shared.range_mt = shared_table_new(range_builtins(strings));
+
+	for (int i = 0; i < NUM_SPECIAL_STRINGS; i++) {
+		shared.special_strings[i]->rc.refs = RC_IMMORTAL;
+	}
+	mem_enter(prev);
+}
+
+static void shared_cleanup(void) {
+	for (int i = 0; i < NUM_TYPES; i++) {
+		if (shared.builtins_htable[i]) {
+			shared_table_del(shared.builtins_htable[i]);
+			shared.builtins_htable[i] = NULL;
+		}
+	}
+	shared_table_del(shared.range_mt);
+	shared.range_mt = NULL;
+
+	for (int i = 0; i < NUM_SPECIAL_STRINGS; i++) {
+		str_del(shared.special_strings[i]);
+		shared.special_strings[i] = NULL;
+	}
+}
+
+struct YASL_Shared *shared_acquire(void) {
+	spin_lock(&shared_lock);
+	if (shared_users++ == 0) {
+		shared_init();
+	}
+	spin_unlock(&shared_lock);
+	return &shared;
+}
+
+void shared_release(void) {
+	spin_lock(&shared_lock);
+	if (--shared_users == 0) {
+		shared_cleanup();
+	}
+	spin_unlock(&shared_lock);
+}
@@ -0,0 +1,23 @@
+#ifndef YASL_SHARED_H_
+#define YASL_SHARED_H_
+
+#include "VM.h"
+
+/*
+ * Objects that every state in the process uses as is: the special strings, and the builtin method tables made from
+ * them. They are built when the first state is made and freed along with the last one. In between, they are immortal
+ * and never modified, so states running on different threads can all use them without synchronising.
+ */
+struct YASL_Shared {
+	struct YASL_String *special_strings[NUM_SPECIAL_STRINGS];
+	struct RC_UserData *builtins_htable[NUM_TYPES];
+	struct RC_UserData *range_mt;
+};
+
+/*
+ * Each call to shared_acquire must be matched by a call to shared_release. Both are safe to call from any thread.
+ */
+struct YASL_Shared *shared_acquire(void);
+void shared_release(void);
+
+#endif
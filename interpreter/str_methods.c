@@ -5,6 +5,7 @@
 #include "yasl_include.h"
 #include "yasl_types.h"
 #include "yasl_state.h"
+#include "interpreter/alloc.h"
 
 static struct YASL_String *YASLX_checknstr(struct YASL_State *S, const char *name, unsigned pos) {
 	if (!YASL_isnstr(S, pos)) {
@@ -277,6 +278,8 @@ int str_repeat(struct YASL_State *S) {
 		YASL_throw_err(S, YASL_VALUE_ERROR);
 	}
 
+	const size_t len = YASL_String_len(string);
+	mem_reserve(len && (uint64_t)num > SIZE_MAX / len ? SIZE_MAX : len * (size_t)num);
 	vm_push((struct VM *) S, YASL_STR(YASL_String_rep_fast(string, num)));
 	return 1;
 }
@@ -2,6 +2,7 @@
 
 #include "yasl.h"
 #include "yasl_aux.h"
+#include "interpreter/alloc.h"
 #include "yasl_error.h"
 #include "yasl_state.h"
 
@@ -14,6 +15,16 @@ static struct YASL_Table *YASLX_checkntable(struct YASL_State *S, const char *na
 	return (struct YASL_Table *)YASL_peeknuserdata(S, pos);
 }
 
+/*
+ * The builtin method tables are shared by every state, so scripts may read them but not change them.
+ */
+static void table_checkmutable(struct YASL_State *S, const char *name) {
+	if (rc_isimmortal(YASL_GETUSERDATA(vm_peek((struct VM *)S))->rc)) {
+		vm_print_err_value(&S->vm, "%s cannot modify a builtin method table.", name);
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+}
+
 int table___len(struct YASL_State *S) {
 	struct YASL_Table *ht = YASLX_checkntable(S, "table.__len", 0);
 	YASL_pushint(S, YASL_Table_length(ht));
@@ -36,6 +47,7 @@ int table___set(struct YASL_State *S) {
 	struct YASL_Object val = vm_pop((struct VM *) S);
 	struct YASL_Object key = vm_pop((struct VM *) S);
 	struct YASL_Table *ht = YASLX_checkntable(S, "table.__set", 0);
+	table_checkmutable(S, "table.__set");
 	if (obj_isundef(&val)) {
 		YASL_Table_rm(ht, key);
 		return 1;
@@ -195,7 +207,7 @@ int table_tostr(struct YASL_State *S) {
 
 int table_keys(struct YASL_State *S) {
 	struct YASL_Table *ht = YASLX_checkntable(S, "table.keys", 0);
-	struct RC_UserData *ls = rcls_new();
+	struct RC_UserData *ls = rcls_new_sized(ht->count);
 	ud_setmt(ls, S->vm.builtins_htable[Y_LIST]);
 	FOR_TABLE(i, item, ht) {
 			YASL_List_append((struct YASL_List *) ls->data, (item->key));
@@ -207,7 +219,7 @@ int table_keys(struct YASL_State *S) {
 
 int table_values(struct YASL_State *S) {
 	struct YASL_Table *ht = YASLX_checkntable(S, "table.values", 0);
-	struct RC_UserData *ls = rcls_new();
+	struct RC_UserData *ls = rcls_new_sized(ht->count);
 	ud_setmt(ls, S->vm.builtins_htable[Y_LIST]);
 	FOR_TABLE(i, item, ht) {
 			YASL_List_append((struct YASL_List *) ls->data, (item->value));
@@ -222,6 +234,7 @@ int table_remove(struct YASL_State *S) {
 		YASLX_print_err_bad_arg_type(S, "table.remove", 0, "table", YASL_peektypename(S));
 		YASL_throw_err(S, YASL_TYPE_ERROR);
 	}
+	table_checkmutable(S, "table.remove");
 	struct YASL_Table *ht = YASL_GETTABLE(vm_peek((struct VM *) S));
 
 	YASL_Table_rm(ht, key);
@@ -245,16 +258,18 @@ int table_clear(struct YASL_State *S) {
 		YASLX_print_err_bad_arg_type(S, "table.clear", 0, "table", YASL_peektypename(S));
 		YASL_throw_err(S, YASL_TYPE_ERROR);
 	}
+	table_checkmutable(S, "table.clear");
 	struct YASL_Table *ht = YASL_GETTABLE(vm_peek((struct VM *) S));
 	inc_ref(&vm_peek((struct VM *) S));
 	FOR_TABLE(i, item, ht) {
 		del_item(item);
 	}
 
+	struct YASL_Table_Item *items = (struct YASL_Table_Item *) mem_calloc(Y_TABLE, TABLE_BASESIZE, sizeof(struct YASL_Table_Item));
 	ht->count = 0;
 	ht->size = TABLE_BASESIZE;
-	free(ht->items);
-	ht->items = (struct YASL_Table_Item *) calloc((size_t) ht->size, sizeof(struct YASL_Table_Item));
+	mem_free(ht->items);
+	ht->items = items;
 	vm_dec_ref(&S->vm, &vm_peek((struct VM *) S));
 	YASL_pop(S);
 
@@ -1,7 +1,9 @@
 #include "upvalue.h"
 
+#include "alloc.h"
+
 struct Upvalue *upval_new(struct YASL_Object *const location) {
-	struct Upvalue *upval = (struct Upvalue *)malloc(sizeof(struct Upvalue));
+	struct Upvalue *upval = (struct Upvalue *)mem_alloc(Y_CLOSURE, sizeof(struct Upvalue));
 	upval->rc = NEW_RC();
 	upval->location = location;
 	upval->next = NULL;
@@ -22,3 +24,21 @@ void upval_close(struct Upvalue *const upval) {
 	upval->location = &upval->closed;
 }
 
+void upval_dec_ref(struct Upvalue *const upval) {
+	if (--upval->rc.refs == 0) {
+		dec_ref(upval->location);
+		mem_free(upval);
+	}
+}
+
+struct Upvalue *upval_close_from(struct Upvalue *pending, const struct YASL_Object *const end) {
+	while (pending != NULL && pending->location >= end) {
+		struct Upvalue *const next = pending->next;
+		inc_ref(pending->location);
+		upval_close(pending);
+		upval_dec_ref(pending);
+		pending = next;
+	}
+	return pending;
+}
+
@@ -16,4 +16,16 @@ struct YASL_Object upval_get(const struct Upvalue *const upval);
 void upval_set(struct VM *const vm, struct Upvalue *const upval, const struct YASL_Object v);
 void upval_close(struct Upvalue *const upval);
 
+/*
+ * Frees upval, and the value it closed over, once nothing refers to it. An open upvalue is referred to by the pending
+ * list of the stack it points into, so only closed ones are ever freed.
+ */
+void upval_dec_ref(struct Upvalue *const upval);
+
+/*
+ * Closes the upvalues in pending, a list ordered from the highest location to the lowest, that point at or above end.
+ * Returns the rest of the list.
+ */
+struct Upvalue *upval_close_from(struct Upvalue *pending, const struct YASL_Object *const end);
+
 #endif
@@ -1,19 +1,41 @@
 #include "userdata.h"
 
+#include <string.h>
+
+#include "alloc.h"
 #include "interpreter/refcount.h"
 #include "YASL_Object.h"
 
 struct RC_UserData *ud_new(void *data, const char *tag, struct RC_UserData *mt, void (*destructor)(void *)) {
-	struct RC_UserData *ud = (struct RC_UserData *)malloc(sizeof(struct RC_UserData));
+	struct RC_UserData *ud = (struct RC_UserData *)mem_alloc(Y_USERDATA, sizeof(struct RC_UserData));
 	ud->tag = tag;
 	ud->rc = NEW_RC();
 	ud->mt = mt;
-	if (mt)	mt->rc.refs++;
+	if (mt) rc_inc(mt->rc);
 	ud->destructor = destructor;
 	ud->data = data;
 	return ud;
 }
 
+// Where inline data starts, rounded up so it is aligned the same as anything from malloc.
+#define UD_INLINE_OFFSET ((sizeof(struct RC_UserData) + 2 * sizeof(void *) - 1) & ~(2 * sizeof(void *) - 1))
+
+struct RC_UserData *ud_new_inline(size_t size, const char *tag, struct RC_UserData *mt, void (*destructor)(void *)) {
+	struct RC_UserData *ud = (struct RC_UserData *)mem_alloc(Y_USERDATA, UD_INLINE_OFFSET + size);
+	ud->tag = tag;
+	ud->rc = NEW_RC();
+	ud->mt = mt;
+	if (mt) rc_inc(mt->rc);
+	ud->destructor = destructor;
+	ud->data = (char *)ud + UD_INLINE_OFFSET;
+	memset(ud->data, 0, size);
+	return ud;
+}
+
+bool ud_isinline(const struct RC_UserData *ud) {
+	return ud->data == (const char *)ud + UD_INLINE_OFFSET;
+}
+
 void ud_del_data(struct RC_UserData *ud) {
 	if (ud->mt) {
 		struct YASL_Object v = YASL_TABLE(ud->mt);
@@ -23,16 +45,16 @@ void ud_del_data(struct RC_UserData *ud) {
 }
 
 void ud_del_rc(struct RC_UserData *ud) {
-	free(ud);
+	mem_free(ud);
 }
 
 void ud_del(struct RC_UserData *ud) {
-	ud->destructor(ud->data);
-	free(ud);
+	if (ud->destructor) ud->destructor(ud->data);
+	mem_free(ud);
 }
 
 void ud_setmt(struct RC_UserData *ud, struct RC_UserData *mt) {
-	if (mt) mt->rc.refs++;
+	if (mt) rc_inc(mt->rc);
 	if (ud->mt) {
 		struct YASL_Object v = YASL_TABLE(ud->mt);
 		dec_ref(&v);
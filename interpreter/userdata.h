@@ -1,6 +1,8 @@
 #ifndef YASL_USERDATA_H_
 #define YASL_USERDATA_H_
 
+#include <stdbool.h>
+
 #include "refcount.h"
 
 struct YASL_Table;
@@ -14,6 +16,13 @@ struct RC_UserData {
 };
 
 struct RC_UserData *ud_new(void *data, const char *tag, struct RC_UserData *mt, void (*destructor)(void *));
+
+/*
+ * Makes a userdata whose data is size zeroed bytes allocated along with it, so there is only the one allocation to
+ * make and free. The destructor is given the data, but must not free it.
+ */
+struct RC_UserData *ud_new_inline(size_t size, const char *tag, struct RC_UserData *mt, void (*destructor)(void *));
+bool ud_isinline(const struct RC_UserData *ud);
 void ud_del_data(struct RC_UserData *ud);
 void ud_del_rc(struct RC_UserData *ud);
 void ud_del(struct RC_UserData *ud);
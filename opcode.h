@@ -72,10 +72,13 @@ enum Opcode {
 	O_ENDCOMP = 0xD1, // end list / table comprehension
 	O_ENDFOR = 0xD2, // end for-loop in VM
 	O_ITER_1 = 0xD3, // iterate to next, 1 var
+	O_INITRANGE = 0xD4, // initialises for-loop over range(...) (takes next byte as number of args)
+	O_ITERRANGE = 0xD5, // store next item in local (next byte) or branch if done (next 8 bytes as jump length)
 
 	O_INIT_MC = 0xE7,
 	O_INIT_CALL = 0xE8, // set up function call
 	O_CALL = 0xE9, // function call
+	O_TCALL = 0xEA, // tail call, reusing the current frame
 	O_RET = 0xEC,  // return from function
 	O_CRET = 0xED, // return from closure.
 
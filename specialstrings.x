@@ -9,6 +9,8 @@ X(S_CLEAR, "clear")
 X(S_COPY, "copy")
 X(S_COUNT, "count")
 X(S_ENDSWITH, "endswith")
+X(S_EXTEND, "extend")
+X(S_FILL, "fill")
 X(S_ISAL, "isal")
 X(S_ISALNUM, "isalnum")
 X(S_ISNUM, "isnum")
@@ -16,6 +18,7 @@ X(S_ISSPACE, "isspace")
 X(S_JOIN, "join")
 X(S_SORT, "sort")
 X(S_INSERT, "insert")
+X(S_INDEX, "index")
 X(S_KEYS, "keys")
 X(S_LTRIM, "ltrim")
 X(S_POP, "pop")
@@ -23,12 +26,15 @@ X(S_PUSH, "push")
 X(S_REMOVE, "remove")
 X(S_REP, "rep")
 X(S_REPLACE, "replace")
+X(S_RESIZE, "resize")
 X(S_REVERSE, "reverse")
+X(S_ROTATE, "rotate")
 X(S_RTRIM, "rtrim")
 X(S_SEARCH, "search")
 X(S_SPLIT, "split")
 X(S_SPREAD, "spread")
 X(S_STARTSWITH, "startswith")
+X(S_SWAP, "swap")
 X(S_TOBOOL, "tobool")
 X(S_TOFLOAT, "tofloat")
 X(S_TOINT, "toint")
@@ -1,25 +1,37 @@
 #include "yasl-std-collections.h"
 
+#include "data-structures/YASL_Array.h"
+#include "data-structures/YASL_BTree.h"
+#include "data-structures/YASL_Deque.h"
+#include "data-structures/YASL_Heap.h"
 #include "data-structures/YASL_Set.h"
+#include "interpreter/alloc.h"
 #include "yasl_state.h"
 #include "yasl_aux.h"
 
 // what to prepend to method names in messages to user
 #define SET_PRE "collections.set"
 
-static const char *const SET_NAME = "collections.set";
+static const char *const SORTEDMAP_NAME = "collections.sortedmap";
+static const char *const SORTEDSET_NAME = "collections.sortedset";
+
+// A set's data is made by the YASL_Set functions, so sets are pushed with YASL_pushobjectptr rather than inline.
+static struct YASL_Type set_type = {
+	SET_NAME, 0, YASL_Set_del, 0
+};
 
 static struct YASL_Set *YASLX_checknset(struct YASL_State *S, const char *name, unsigned n) {
 	return (struct YASL_Set *)YASLX_checknuserdata(S, SET_NAME, name, n);
 }
 
 static int YASL_collections_set_fromlist(struct YASL_State *S) {
-	struct YASL_Set *set = YASL_Set_new();
-
 	YASL_duptop(S);
 	YASL_len(S);
 	yasl_int len = YASL_popint(S);
 
+	mem_reserve((size_t)len * sizeof(struct YASL_Object));
+	struct YASL_Set *set = YASL_Set_new_sized((size_t)len);
+
 	for (yasl_int i = 0; i < len; i++) {
 		YASL_listget(S, i);
 		if (!YASL_Set_insert(set, vm_peek((struct VM *) S))) {
@@ -31,9 +43,7 @@ static int YASL_collections_set_fromlist(struct YASL_State *S) {
 		YASL_pop(S);
 	}
 
-	YASL_pushuserdata(S, set, SET_NAME, YASL_Set_del);
-	YASL_loadmt(S, SET_NAME);
-	YASL_setmt(S);
+	YASL_pushobjectptr(S, &set_type, set);
 	return 1;
 }
 
@@ -43,7 +53,7 @@ static int YASL_collections_set_new(struct YASL_State *S) {
 		return YASL_collections_set_fromlist(S);
 	}
 
-	struct YASL_Set *set = YASL_Set_new();
+	struct YASL_Set *set = YASL_Set_new_sized((size_t)i);
 	while (i-- > 0) {
 		if (!YASL_Set_insert(set, vm_peek((struct VM *) S))) {
 			YASL_Set_del(set);
@@ -54,9 +64,7 @@ static int YASL_collections_set_new(struct YASL_State *S) {
 		YASL_pop(S);
 	}
 
-	YASL_pushuserdata(S, set, SET_NAME, YASL_Set_del);
-	YASL_loadmt(S, SET_NAME);
-	YASL_setmt(S);
+	YASL_pushobjectptr(S, &set_type, set);
 	return 1;
 }
 
@@ -156,9 +164,7 @@ static int YASL_collections_set_##name(struct YASL_State *S) {\
 \
 	struct YASL_Set *tmp = fn(left, right);\
 \
-	YASL_pushuserdata(S, tmp, SET_NAME, YASL_Set_del);\
-	YASL_loadmt(S, SET_NAME);\
-	YASL_setmt(S);\
+	YASL_pushobjectptr(S, &set_type, tmp);\
 	return 1;\
 }
 
@@ -172,19 +178,7 @@ static int YASL_collections_set___eq(struct YASL_State *S) {
 	struct YASL_Set *right = YASLX_checknset(S, SET_PRE ".__eq", 1);
 	struct YASL_Set *left = YASLX_checknset(S, SET_PRE ".__eq", 0);
 
-	if (YASL_Set_length(left) != YASL_Set_length(right)) {
-		YASL_pushbool(S, false);
-		return 1;
-	}
-
-	FOR_SET(i, item, left) {
-		if (!YASL_Set_search(right, *item)) {
-			YASL_pushbool(S, false);
-			return 1;
-		}
-	}
-
-	YASL_pushbool(S, true);
+	YASL_pushbool(S, YASL_Set_length(left) == YASL_Set_length(right) && YASL_Set_issubset(left, right));
 	return 1;
 }
 
@@ -192,14 +186,7 @@ static int YASL_collections_set___gt(struct YASL_State *S) {
 	struct YASL_Set *right = YASLX_checknset(S, SET_PRE ".__gt", 1);
 	struct YASL_Set *left = YASLX_checknset(S, SET_PRE ".__gt", 0);
 
-	FOR_SET(i, item, right) {
-		if (!YASL_Set_search(left, *item)) {
-			YASL_pushbool(S, false);
-			return 1;
-		}
-	}
-
-	YASL_pushbool(S, YASL_Set_length(left) > YASL_Set_length(right));
+	YASL_pushbool(S, YASL_Set_length(left) > YASL_Set_length(right) && YASL_Set_issubset(right, left));
 	return 1;
 }
 
@@ -207,14 +194,7 @@ static int YASL_collections_set___ge(struct YASL_State *S) {
 	struct YASL_Set *right = YASLX_checknset(S, SET_PRE ".__ge", 1);
 	struct YASL_Set *left = YASLX_checknset(S, SET_PRE ".__ge", 0);
 
-	FOR_SET(i, item, right) {
-		if (!YASL_Set_search(left, *item)) {
-			YASL_pushbool(S, false);
-			return 1;
-		}
-	}
-
-	YASL_pushbool(S, YASL_Set_length(left) >= YASL_Set_length(right));
+	YASL_pushbool(S, YASL_Set_issubset(right, left));
 	return 1;
 }
 
@@ -222,14 +202,7 @@ static int YASL_collections_set___lt(struct YASL_State *S) {
 	struct YASL_Set *right = YASLX_checknset(S, SET_PRE ".__lt", 1);
 	struct YASL_Set *left = YASLX_checknset(S, SET_PRE ".__lt", 0);
 
-	FOR_SET(i, item, left) {
-		if (!YASL_Set_search(right, *item)) {
-			YASL_pushbool(S, false);
-			return 1;
-		}
-	}
-
-	YASL_pushbool(S, YASL_Set_length(left) < YASL_Set_length(right));
+	YASL_pushbool(S, YASL_Set_length(left) < YASL_Set_length(right) && YASL_Set_issubset(left, right));
 	return 1;
 }
 
@@ -237,17 +210,36 @@ static int YASL_collections_set___le(struct YASL_State *S) {
 	struct YASL_Set *right = YASLX_checknset(S, SET_PRE ".__le", 1);
 	struct YASL_Set *left = YASLX_checknset(S, SET_PRE ".__le", 0);
 
-	FOR_SET(i, item, left) {
-		if (!YASL_Set_search(right, *item)) {
-			YASL_pushbool(S, false);
-			return 1;
-		}
-	}
-
-	YASL_pushbool(S, YASL_Set_length(left) <= YASL_Set_length(right));
+	YASL_pushbool(S, YASL_Set_issubset(left, right));
 	return 1;
 }
 
+#define YASL_COLLECTIONS_SET_PRED(name, fn) \
+static int YASL_collections_set_##name(struct YASL_State *S) {\
+	struct YASL_Set *right = YASLX_checknset(S, SET_PRE "." #name, 1);\
+	struct YASL_Set *left = YASLX_checknset(S, SET_PRE "." #name, 0);\
+\
+	YASL_pushbool(S, fn(left, right));\
+	return 1;\
+}
+
+YASL_COLLECTIONS_SET_PRED(issubset, YASL_Set_issubset)
+YASL_COLLECTIONS_SET_PRED(isdisjoint, YASL_Set_isdisjoint)
+
+#define YASL_COLLECTIONS_SET_INPLACE(name, fn) \
+static int YASL_collections_set_##name(struct YASL_State *S) {\
+	struct YASL_Set *right = YASLX_checknset(S, SET_PRE "." #name, 1);\
+	struct YASL_Set *left = YASLX_checknset(S, SET_PRE "." #name, 0);\
+\
+	fn(left, right);\
+	YASL_pop(S);\
+	return 1;\
+}
+
+YASL_COLLECTIONS_SET_INPLACE(update, YASL_Set_update)
+YASL_COLLECTIONS_SET_INPLACE(intersection_update, YASL_Set_intersection_update)
+YASL_COLLECTIONS_SET_INPLACE(difference_update, YASL_Set_difference_update)
+
 static int YASL_collections_set___len(struct YASL_State *S) {
 	struct YASL_Set *set = YASLX_checknset(S, SET_PRE ".__len", 0);
 
@@ -281,23 +273,16 @@ static int YASL_collections_set_remove(struct YASL_State *S) {
 static int YASL_collections_set_copy(struct YASL_State *S) {
 	struct YASL_Set *set = YASLX_checknset(S, SET_PRE ".copy", 0);
 
-	struct YASL_Set *tmp = YASL_Set_new();
-	FOR_SET(i, item, set) {
-		YASL_Set_insert(tmp, *item);
-	}
+	struct YASL_Set *tmp = YASL_Set_copy(set);
 
-	YASL_pushuserdata(S, tmp, SET_NAME, YASL_Set_del);
-	YASL_loadmt(S, SET_NAME);
-	YASL_setmt(S);
+	YASL_pushobjectptr(S, &set_type, tmp);
 	return 1;
 }
 
 static int YASL_collections_set_clear(struct YASL_State *S) {
 	struct YASL_Set *set = YASLX_checknset(S, SET_PRE ".clear", 0);
 
-	FOR_SET(i, item, set) {
-		YASL_Set_rm(set, *item);
-	}
+	YASL_Set_clear(set);
 	return 1;
 }
 
@@ -309,95 +294,1534 @@ static int YASL_collections_set___get(struct YASL_State *S) {
 	return 1;
 }
 
-int YASL_decllib_collections(struct YASL_State *S) {
+static const char *array_name(const enum YASL_ArrayKind kind) {
+	switch (kind) {
+	case ARRAY_INT:
+		return INTARRAY_NAME;
+	case ARRAY_FLOAT:
+		return FLOATARRAY_NAME;
+	case ARRAY_BYTE:
+	default:
+		return BYTEARRAY_NAME;
+	}
+}
+
+static struct YASL_Array *YASLX_checknarray(struct YASL_State *S, const char *name, unsigned n) {
+	if (!YASL_isnuserdata(S, INTARRAY_NAME, n) && !YASL_isnuserdata(S, FLOATARRAY_NAME, n) &&
+	    !YASL_isnuserdata(S, BYTEARRAY_NAME, n)) {
+		YASLX_print_err_bad_arg_type(S, name, n, "array", YASL_peekntypename(S, n));
+		YASL_throw_err(S, YASL_TYPE_ERROR);
+	}
+	return (struct YASL_Array *)YASL_peeknuserdata(S, n);
+}
+
+static struct YASL_Array *YASLX_checknarray_kind(struct YASL_State *S, const enum YASL_ArrayKind kind, const char *name, unsigned n) {
+	return (struct YASL_Array *)YASLX_checknuserdata(S, array_name(kind), name, n);
+}
+
+static void YASL_pusharray(struct YASL_State *S, struct YASL_Array *array) {
+	const char *name = array_name(array->kind);
+	YASL_pushuserdata(S, array, name, YASL_Array_del);
+	YASL_loadmt(S, name);
+	YASL_setmt(S);
+}
+
+/*
+ * Stores val at index i of array, converting it to the array's item type. i may be one past the end, but the array
+ * must already have room for it.
+ */
+static void array_store(struct YASL_State *S, struct YASL_Array *array, const size_t i, const struct YASL_Object *val,
+			const char *name) {
+	switch (array->kind) {
+	case ARRAY_INT:
+		if (!obj_isint(val)) {
+			vm_print_err_type(&S->vm, "%s expected int, got %s.", name, obj_typename(val));
+			YASL_throw_err(S, YASL_TYPE_ERROR);
+		}
+		array->items.ints[i] = obj_getint(val);
+		return;
+	case ARRAY_FLOAT:
+		if (!obj_isnum(val)) {
+			vm_print_err_type(&S->vm, "%s expected float, got %s.", name, obj_typename(val));
+			YASL_throw_err(S, YASL_TYPE_ERROR);
+		}
+		array->items.floats[i] = obj_getnum(val);
+		return;
+	case ARRAY_BYTE:
+		if (!obj_isint(val)) {
+			vm_print_err_type(&S->vm, "%s expected int, got %s.", name, obj_typename(val));
+			YASL_throw_err(S, YASL_TYPE_ERROR);
+		}
+		if (obj_getint(val) < 0 || obj_getint(val) > 255) {
+			vm_print_err_value(&S->vm, "%s expected int in range 0..255, got %" PRId64 ".", name, obj_getint(val));
+			YASL_throw_err(S, YASL_VALUE_ERROR);
+		}
+		array->items.bytes[i] = (unsigned char)obj_getint(val);
+		return;
+	}
+}
+
+static void array_push_item(struct YASL_State *S, struct YASL_Array *array, const size_t i) {
+	switch (array->kind) {
+	case ARRAY_INT:
+		YASL_pushint(S, array->items.ints[i]);
+		return;
+	case ARRAY_FLOAT:
+		YASL_pushfloat(S, array->items.floats[i]);
+		return;
+	case ARRAY_BYTE:
+		YASL_pushint(S, array->items.bytes[i]);
+		return;
+	}
+}
+
+static int YASL_collections_array_new(struct YASL_State *S, const enum YASL_ArrayKind kind) {
+	const char *name = array_name(kind);
+	yasl_int n = YASL_peekvargscount(S);
+	struct YASL_Array *array;
+	if (n == 1 && YASL_islist(S)) {
+		struct YASL_List *ls = vm_peeklist(&S->vm);
+		mem_reserve(ls->count * YASL_Array_itemsize(kind));
+		array = YASL_Array_new_sized(kind, ls->count);
+		YASL_pushuserdata(S, array, name, YASL_Array_del);
+		FOR_LIST(i, elmt, ls) {
+			array_store(S, array, i, &elmt, name);
+			array->count++;
+		}
+	} else {
+		array = YASL_Array_new_sized(kind, (size_t)n);
+		YASL_pushuserdata(S, array, name, YASL_Array_del);
+		for (yasl_int i = 0; i < n; i++) {
+			struct YASL_Object val = vm_peek(&S->vm, S->vm.sp - n + i);
+			array_store(S, array, (size_t)i, &val, name);
+			array->count++;
+		}
+	}
+	YASL_loadmt(S, name);
+	YASL_setmt(S);
+	return 1;
+}
+
+static int YASL_collections_intarray_new(struct YASL_State *S) {
+	return YASL_collections_array_new(S, ARRAY_INT);
+}
+
+static int YASL_collections_floatarray_new(struct YASL_State *S) {
+	return YASL_collections_array_new(S, ARRAY_FLOAT);
+}
+
+static int YASL_collections_bytearray_new(struct YASL_State *S) {
+	return YASL_collections_array_new(S, ARRAY_BYTE);
+}
+
+static int YASL_collections_array___len(struct YASL_State *S) {
+	struct YASL_Array *array = YASLX_checknarray(S, "array.__len", 0);
+	YASL_pushint(S, (yasl_int)array->count);
+	return 1;
+}
+
+static size_t array_checkindex(struct YASL_State *S, struct YASL_Array *array, yasl_int index) {
+	if (index < -(yasl_int)array->count || index >= (yasl_int)array->count) {
+		vm_print_err_value(&S->vm, "unable to index array of length %" PRI_SIZET " with index %" PRId64 ".",
+				   array->count, index);
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+	return (size_t)(index < 0 ? index + (yasl_int)array->count : index);
+}
+
+static int YASL_collections_array___get(struct YASL_State *S) {
+	struct YASL_Array *array = YASLX_checknarray(S, "array.__get", 0);
+	yasl_int index = YASLX_checknint(S, "array.__get", 1);
+	array_push_item(S, array, array_checkindex(S, array, index));
+	return 1;
+}
+
+static int YASL_collections_array___set(struct YASL_State *S) {
+	struct YASL_Array *array = YASLX_checknarray(S, "array.__set", 0);
+	yasl_int index = YASLX_checknint(S, "array.__set", 1);
+	struct YASL_Object val = vm_peek(&S->vm);
+	array_store(S, array, array_checkindex(S, array, index), &val, "array.__set");
+	return 1;
+}
+
+static int YASL_collections_array___slice(struct YASL_State *S) {
+	struct YASL_Array *array = YASLX_checknarray(S, "array.__slice", 0);
+	const yasl_int len = (yasl_int)array->count;
+	yasl_int start = YASL_isnundef(S, 1) ? 0 : YASLX_checknint(S, "array.__slice", 1);
+	yasl_int end = YASL_isnundef(S, 2) ? len : YASLX_checknint(S, "array.__slice", 2);
+	if (start < 0) start += len;
+	if (start < 0) start = 0;
+	if (end < 0) end += len;
+	if (end > len) end = len;
+	YASL_pusharray(S, YASL_Array_slice(array, (size_t)start, (size_t)(end > start ? end : start)));
+	return 1;
+}
+
+static int YASL_collections_array___eq(struct YASL_State *S) {
+	struct YASL_Array *left = YASLX_checknarray(S, "array.__eq", 0);
+	struct YASL_Array *right = YASLX_checknarray(S, "array.__eq", 1);
+	if (left->kind != right->kind || left->count != right->count) {
+		YASL_pushbool(S, false);
+		return 1;
+	}
+	if (left->kind == ARRAY_FLOAT) {
+		for (size_t i = 0; i < left->count; i++) {
+			if (left->items.floats[i] != right->items.floats[i]) {
+				YASL_pushbool(S, false);
+				return 1;
+			}
+		}
+		YASL_pushbool(S, true);
+		return 1;
+	}
+	YASL_pushbool(S, !memcmp(left->items.data, right->items.data, left->count * YASL_Array_itemsize(left->kind)));
+	return 1;
+}
+
+static int YASL_collections_array_push(struct YASL_State *S) {
+	struct YASL_Array *array = YASLX_checknarray(S, "array.push", 0);
+	struct YASL_Object val = vm_pop(&S->vm);
+	YASL_Array_reserve(array, array->count + 1);
+	array_store(S, array, array->count, &val, "array.push");
+	array->count++;
+	return 1;
+}
+
+static int YASL_collections_array_pop(struct YASL_State *S) {
+	struct YASL_Array *array = YASLX_checknarray(S, "array.pop", 0);
+	if (array->count == 0) {
+		vm_print_err_value(&S->vm, "%s expected nonempty array as arg 0.", "array.pop");
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+	array_push_item(S, array, --array->count);
+	return 1;
+}
+
+static int YASL_collections_array_copy(struct YASL_State *S) {
+	struct YASL_Array *array = YASLX_checknarray(S, "array.copy", 0);
+	YASL_pusharray(S, YASL_Array_slice(array, 0, array->count));
+	return 1;
+}
+
+static int YASL_collections_array_tolist(struct YASL_State *S) {
+	struct YASL_Array *array = YASLX_checknarray(S, "array.tolist", 0);
+	struct RC_UserData *list = rcls_new_sized(array->count);
+	ud_setmt(list, S->vm.builtins_htable[Y_LIST]);
+	struct YASL_List *ls = (struct YASL_List *)list->data;
+	for (size_t i = 0; i < array->count; i++) {
+		switch (array->kind) {
+		case ARRAY_INT:
+			YASL_List_append(ls, YASL_INT(array->items.ints[i]));
+			break;
+		case ARRAY_FLOAT:
+			YASL_List_append(ls, YASL_FLOAT(array->items.floats[i]));
+			break;
+		case ARRAY_BYTE:
+			YASL_List_append(ls, YASL_INT(array->items.bytes[i]));
+			break;
+		}
+	}
+	vm_pushlist(&S->vm, list);
+	return 1;
+}
+
+static int YASL_collections_array_tostr(struct YASL_State *S) {
+	struct YASL_Array *array = YASLX_checknarray(S, "array.tostr", 0);
+	const char *name = array_name(array->kind) + strlen("collections.");
+
+	size_t string_count = strlen(name);
+	size_t string_size = string_count + 8;
+	char *string = (char *)malloc(string_size);
+	memcpy(string, name, string_count);
+	string[string_count++] = '(';
+	for (size_t i = 0; i < array->count; i++) {
+		array_push_item(S, array, i);
+		vm_stringify_top(&S->vm);
+		struct YASL_String *str = vm_popstr(&S->vm);
+		while (string_count + YASL_String_len(str) + 2 >= string_size) {
+			string_size *= 2;
+			string = (char *)realloc(string, string_size);
+		}
+		memcpy(string + string_count, str->str + str->start, YASL_String_len(str));
+		string_count += YASL_String_len(str);
+		if (i + 1 < array->count) {
+			string[string_count++] = ',';
+			string[string_count++] = ' ';
+		}
+	}
+	string[string_count++] = ')';
+	vm_pushstr(&S->vm, YASL_String_new_sized_heap(0, string_count, string));
+	return 1;
+}
+
+static int YASL_collections_array_sum(struct YASL_State *S) {
+	struct YASL_Array *array = YASLX_checknarray(S, "array.sum", 0);
+	switch (array->kind) {
+	case ARRAY_INT:
+		YASL_pushint(S, YASL_ints_sum(array->items.ints, array->count));
+		break;
+	case ARRAY_FLOAT:
+		YASL_pushfloat(S, YASL_floats_sum(array->items.floats, array->count));
+		break;
+	case ARRAY_BYTE:
+		YASL_pushint(S, YASL_bytes_sum(array->items.bytes, array->count));
+		break;
+	}
+	return 1;
+}
+
+#define YASL_COLLECTIONS_ARRAY_REDUCE(name) \
+static int YASL_collections_array_##name(struct YASL_State *S) {\
+	struct YASL_Array *array = YASLX_checknarray(S, "array." #name, 0);\
+	if (array->count == 0) {\
+		vm_print_err_value(&S->vm, "%s expected nonempty array as arg 0.", "array." #name);\
+		YASL_throw_err(S, YASL_VALUE_ERROR);\
+	}\
+	switch (array->kind) {\
+	case ARRAY_INT:\
+		YASL_pushint(S, YASL_ints_##name(array->items.ints, array->count));\
+		break;\
+	case ARRAY_FLOAT:\
+		YASL_pushfloat(S, YASL_floats_##name(array->items.floats, array->count));\
+		break;\
+	case ARRAY_BYTE:\
+		YASL_pushint(S, YASL_bytes_##name(array->items.bytes, array->count));\
+		break;\
+	}\
+	return 1;\
+}
+
+YASL_COLLECTIONS_ARRAY_REDUCE(min)
+YASL_COLLECTIONS_ARRAY_REDUCE(max)
+
+static struct YASL_Array *array_checkpair(struct YASL_State *S, struct YASL_Array *left, const char *name) {
+	struct YASL_Array *right = YASLX_checknarray_kind(S, left->kind, name, 1);
+	if (left->count != right->count) {
+		vm_print_err_value(&S->vm, "%s expected arrays of equal length, got lengths %" PRI_SIZET " and %" PRI_SIZET ".",
+				   name, left->count, right->count);
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+	return right;
+}
+
+static int YASL_collections_array_dot(struct YASL_State *S) {
+	struct YASL_Array *left = YASLX_checknarray(S, "array.dot", 0);
+	struct YASL_Array *right = array_checkpair(S, left, "array.dot");
+	switch (left->kind) {
+	case ARRAY_INT:
+		YASL_pushint(S, YASL_ints_dot(left->items.ints, right->items.ints, left->count));
+		break;
+	case ARRAY_FLOAT:
+		YASL_pushfloat(S, YASL_floats_dot(left->items.floats, right->items.floats, left->count));
+		break;
+	case ARRAY_BYTE:
+		YASL_pushint(S, YASL_bytes_dot(left->items.bytes, right->items.bytes, left->count));
+		break;
+	}
+	return 1;
+}
+
+/*
+ * Adds other to the array elementwise, in place.
+ */
+static int YASL_collections_array_add(struct YASL_State *S) {
+	struct YASL_Array *left = YASLX_checknarray(S, "array.add", 0);
+	struct YASL_Array *right = array_checkpair(S, left, "array.add");
+	if (left->kind == ARRAY_INT) {
+		YASL_ints_add(left->items.ints, right->items.ints, left->count);
+	} else {
+		YASL_floats_add(left->items.floats, right->items.floats, left->count);
+	}
+	YASL_pop(S);
+	return 1;
+}
+
+/*
+ * Multiplies every item of the array by k, in place.
+ */
+static int YASL_collections_array_scale(struct YASL_State *S) {
+	struct YASL_Array *array = YASLX_checknarray(S, "array.scale", 0);
+	if (array->kind == ARRAY_INT) {
+		YASL_ints_scale(array->items.ints, YASLX_checknint(S, "array.scale", 1), array->count);
+	} else if (YASL_isnint(S, 1)) {
+		YASL_floats_scale(array->items.floats, (yasl_float)YASL_peeknint(S, 1), array->count);
+	} else {
+		YASL_floats_scale(array->items.floats, YASLX_checknfloat(S, "array.scale", 1), array->count);
+	}
+	YASL_pop(S);
+	return 1;
+}
+
+/*
+ * Walks the items of an array in order, boxing them one at a time. Items pushed while we walk are included.
+ */
+struct ArrayIterator {
+	struct YASL_Object array;  // kept alive for as long as we are
+	size_t i;
+};
+
+static void array_iterator_del(void *ptr) {
+	struct ArrayIterator *it = (struct ArrayIterator *)ptr;
+	dec_ref(&it->array);
+}
+
+static struct YASL_Type array_iterator_type = {
+	"collections.arrayiterator", sizeof(struct ArrayIterator), array_iterator_del, 0
+};
+
+static int YASL_collections_array___iter(struct YASL_State *S) {
+	YASLX_checknarray(S, "array.__iter", 0);
+	struct ArrayIterator *it = (struct ArrayIterator *)YASL_pushobject(S, &array_iterator_type);
+	it->array = vm_peek(&S->vm, S->vm.fp + 1);
+	inc_ref(&it->array);
+	return 1;
+}
+
+static int YASL_collections_arrayiterator___iter(struct YASL_State *S) {
+	YASLX_checknuserdata(S, array_iterator_type.name, "arrayiterator.__iter", 0);
+	return 1;
+}
+
+static int YASL_collections_arrayiterator___next(struct YASL_State *S) {
+	struct ArrayIterator *it = (struct ArrayIterator *)YASLX_checknuserdata(S, array_iterator_type.name,
+										 "arrayiterator.__next", 0);
+	struct YASL_Array *array = (struct YASL_Array *)YASL_GETUSERDATA(it->array)->data;
+	if (it->i >= array->count) {
+		YASL_pushbool(S, false);
+		return 1;
+	}
+	YASL_pushbool(S, true);
+	array_push_item(S, array, it->i++);
+	return 2;
+}
+
+static void YASL_collections_arrayiterator_registermt(struct YASL_State *S) {
 	YASL_pushtable(S);
-	YASL_registermt(S, SET_NAME);
+	YASL_registertype(S, &array_iterator_type);
 
-	YASL_loadmt(S, SET_NAME);
-	YASL_pushlit(S, "tostr");
-	YASL_pushcfunction(S, YASL_collections_set_tostr, 1);
+	YASL_loadmt(S, array_iterator_type.name);
+	YASL_pushlit(S, "__iter");
+	YASL_pushcfunction(S, YASL_collections_arrayiterator___iter, 1);
 	YASL_tableset(S);
 
-	YASL_pushlit(S, "tolist");
-	YASL_pushcfunction(S, YASL_collections_set_tolist, 1);
+	YASL_pushlit(S, "__next");
+	YASL_pushcfunction(S, YASL_collections_arrayiterator___next, 1);
 	YASL_tableset(S);
+	YASL_pop(S);
+}
 
-	YASL_pushlit(S, "__band");
-	YASL_pushcfunction(S, YASL_collections_set___band, 2);
-	YASL_tableset(S);
+/*
+ * The three array types share their methods, except that elementwise arithmetic is left out for bytes.
+ */
+static void YASL_collections_array_registermt(struct YASL_State *S, const char *name, bool arith) {
+	YASL_pushtable(S);
+	YASL_registermt(S, name);
 
-	YASL_pushlit(S, "__bor");
-	YASL_pushcfunction(S, YASL_collections_set___bor, 2);
+	YASL_loadmt(S, name);
+	YASL_pushlit(S, "__len");
+	YASL_pushcfunction(S, YASL_collections_array___len, 1);
 	YASL_tableset(S);
 
-	YASL_pushlit(S, "__bxor");
-	YASL_pushcfunction(S, YASL_collections_set___bxor, 2);
+	YASL_pushlit(S, "__get");
+	YASL_pushcfunction(S, YASL_collections_array___get, 2);
 	YASL_tableset(S);
 
-	YASL_pushlit(S, "__bandnot");
-	YASL_pushcfunction(S, YASL_collections_set___bandnot, 2);
+	YASL_pushlit(S, "__set");
+	YASL_pushcfunction(S, YASL_collections_array___set, 3);
 	YASL_tableset(S);
 
-	YASL_pushlit(S, "__len");
-	YASL_pushcfunction(S, YASL_collections_set___len, 1);
+	YASL_pushlit(S, "__slice");
+	YASL_pushcfunction(S, YASL_collections_array___slice, 3);
 	YASL_tableset(S);
 
 	YASL_pushlit(S, "__eq");
-	YASL_pushcfunction(S, YASL_collections_set___eq, 2);
+	YASL_pushcfunction(S, YASL_collections_array___eq, 2);
 	YASL_tableset(S);
 
-	YASL_pushlit(S, "__gt");
-	YASL_pushcfunction(S, YASL_collections_set___gt, 2);
+	YASL_pushlit(S, "push");
+	YASL_pushcfunction(S, YASL_collections_array_push, 2);
 	YASL_tableset(S);
 
-	YASL_pushlit(S, "__ge");
-	YASL_pushcfunction(S, YASL_collections_set___ge, 2);
+	YASL_pushlit(S, "pop");
+	YASL_pushcfunction(S, YASL_collections_array_pop, 1);
 	YASL_tableset(S);
 
-	YASL_pushlit(S, "__lt");
-	YASL_pushcfunction(S, YASL_collections_set___lt, 2);
+	YASL_pushlit(S, "copy");
+	YASL_pushcfunction(S, YASL_collections_array_copy, 1);
 	YASL_tableset(S);
 
-	YASL_pushlit(S, "__le");
-	YASL_pushcfunction(S, YASL_collections_set___le, 2);
+	YASL_pushlit(S, "__iter");
+	YASL_pushcfunction(S, YASL_collections_array___iter, 1);
 	YASL_tableset(S);
 
-	YASL_pushlit(S, "add");
-	YASL_pushcfunction(S, YASL_collections_set_add, 2);
+	YASL_pushlit(S, "tolist");
+	YASL_pushcfunction(S, YASL_collections_array_tolist, 1);
 	YASL_tableset(S);
 
-	YASL_pushlit(S, "remove");
-	YASL_pushcfunction(S, YASL_collections_set_remove, 2);
+	YASL_pushlit(S, "tostr");
+	YASL_pushcfunction(S, YASL_collections_array_tostr, 1);
 	YASL_tableset(S);
 
-	YASL_pushlit(S, "copy");
-	YASL_pushcfunction(S, YASL_collections_set_copy, 1);
+	YASL_pushlit(S, "sum");
+	YASL_pushcfunction(S, YASL_collections_array_sum, 1);
 	YASL_tableset(S);
 
-	YASL_pushlit(S, "clear");
-	YASL_pushcfunction(S, YASL_collections_set_clear, 1);
+	YASL_pushlit(S, "min");
+	YASL_pushcfunction(S, YASL_collections_array_min, 1);
 	YASL_tableset(S);
 
-	YASL_pushlit(S, "__get");
-	YASL_pushcfunction(S, YASL_collections_set___get, 2);
+	YASL_pushlit(S, "max");
+	YASL_pushcfunction(S, YASL_collections_array_max, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "dot");
+	YASL_pushcfunction(S, YASL_collections_array_dot, 2);
 	YASL_tableset(S);
+
+	if (arith) {
+		YASL_pushlit(S, "add");
+		YASL_pushcfunction(S, YASL_collections_array_add, 2);
+		YASL_tableset(S);
+
+		YASL_pushlit(S, "scale");
+		YASL_pushcfunction(S, YASL_collections_array_scale, 2);
+		YASL_tableset(S);
+	}
 	YASL_pop(S);
+}
 
+static struct YASL_Deque *YASLX_checkndeque(struct YASL_State *S, const char *name, unsigned n) {
+	return (struct YASL_Deque *)YASLX_checknuserdata(S, DEQUE_NAME, name, n);
+}
 
-	YASL_pushtable(S);
-	YASLX_initglobal(S, "collections");
+static void YASL_pushdeque(struct YASL_State *S, struct YASL_Deque *deque) {
+	YASL_pushuserdata(S, deque, DEQUE_NAME, YASL_Deque_del);
+	YASL_loadmt(S, DEQUE_NAME);
+	YASL_setmt(S);
+}
 
-	YASL_loadglobal(S, "collections");
-	YASL_pushlit(S, "set");
-	YASL_pushcfunction(S, YASL_collections_set_new, -1);
-	YASL_tableset(S);
+/*
+ * collections.deque([ls], [maxlen])
+ */
+static int YASL_collections_deque_new(struct YASL_State *S) {
+	size_t maxlen = 0;
+	if (!YASL_isnundef(S, 1)) {
+		yasl_int n = YASLX_checknint(S, "collections.deque", 1);
+		if (n <= 0) {
+			vm_print_err_value(&S->vm, "%s expected positive maxlen, got %" PRId64 ".", "collections.deque", n);
+			YASL_throw_err(S, YASL_VALUE_ERROR);
+		}
+		maxlen = (size_t)n;
+	}
 
-	YASL_pushlit(S, "list");
-	YASL_pushcfunction(S, YASL_collections_list_new, -1);
-	YASL_tableset(S);
+	struct YASL_List *ls = NULL;
+	if (!YASL_isnundef(S, 0)) {
+		if (!YASL_isnlist(S, 0)) {
+			YASLX_print_err_bad_arg_type(S, "collections.deque", 0, "list", YASL_peekntypename(S, 0));
+			YASL_throw_err(S, YASL_TYPE_ERROR);
+		}
+		ls = (struct YASL_List *)YASL_peeknuserdata(S, 0);
+	}
 
-	YASL_pushlit(S, "table");
-	YASL_pushcfunction(S, YASL_collections_table_new, -1);
+	mem_reserve(ls ? ls->count * sizeof(struct YASL_Object) : 0);
+	struct YASL_Deque *deque = YASL_Deque_new_sized(ls ? ls->count : 0, maxlen);
+	YASL_pushdeque(S, deque);
+	if (ls) {
+		FOR_LIST(i, elmt, ls) {
+			YASL_Deque_push(deque, elmt);
+		}
+	}
+	return 1;
+}
+
+static int YASL_collections_deque___len(struct YASL_State *S) {
+	struct YASL_Deque *deque = YASLX_checkndeque(S, "deque.__len", 0);
+	YASL_pushint(S, (yasl_int)deque->count);
+	return 1;
+}
+
+static size_t deque_checkindex(struct YASL_State *S, struct YASL_Deque *deque, yasl_int index) {
+	if (index < -(yasl_int)deque->count || index >= (yasl_int)deque->count) {
+		vm_print_err_value(&S->vm, "unable to index deque of length %" PRI_SIZET " with index %" PRId64 ".",
+				   deque->count, index);
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+	return (size_t)(index < 0 ? index + (yasl_int)deque->count : index);
+}
+
+static int YASL_collections_deque___get(struct YASL_State *S) {
+	struct YASL_Deque *deque = YASLX_checkndeque(S, "deque.__get", 0);
+	yasl_int index = YASLX_checknint(S, "deque.__get", 1);
+	vm_push(&S->vm, *YASL_Deque_at(deque, deque_checkindex(S, deque, index)));
+	return 1;
+}
+
+static int YASL_collections_deque___set(struct YASL_State *S) {
+	struct YASL_Deque *deque = YASLX_checkndeque(S, "deque.__set", 0);
+	yasl_int index = YASLX_checknint(S, "deque.__set", 1);
+	struct YASL_Object *item = YASL_Deque_at(deque, deque_checkindex(S, deque, index));
+	struct YASL_Object val = vm_peek(&S->vm);
+	inc_ref(&val);
+	dec_ref(item);
+	*item = val;
+	return 1;
+}
+
+static int YASL_collections_deque_push(struct YASL_State *S) {
+	struct YASL_Deque *deque = YASLX_checkndeque(S, "deque.push", 0);
+	YASL_Deque_push(deque, vm_peek(&S->vm));
+	YASL_pop(S);
+	return 1;
+}
+
+static int YASL_collections_deque_pushleft(struct YASL_State *S) {
+	struct YASL_Deque *deque = YASLX_checkndeque(S, "deque.pushleft", 0);
+	YASL_Deque_pushleft(deque, vm_peek(&S->vm));
+	YASL_pop(S);
+	return 1;
+}
+
+static void deque_checknonempty(struct YASL_State *S, struct YASL_Deque *deque, const char *name) {
+	if (deque->count == 0) {
+		vm_print_err_value(&S->vm, "%s expected nonempty deque as arg 0.", name);
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+}
+
+static int YASL_collections_deque_pop(struct YASL_State *S) {
+	struct YASL_Deque *deque = YASLX_checkndeque(S, "deque.pop", 0);
+	deque_checknonempty(S, deque, "deque.pop");
+	struct YASL_Object val = YASL_Deque_pop(deque);
+	vm_push(&S->vm, val);
+	dec_ref(&val);
+	return 1;
+}
+
+static int YASL_collections_deque_popleft(struct YASL_State *S) {
+	struct YASL_Deque *deque = YASLX_checkndeque(S, "deque.popleft", 0);
+	deque_checknonempty(S, deque, "deque.popleft");
+	struct YASL_Object val = YASL_Deque_popleft(deque);
+	vm_push(&S->vm, val);
+	dec_ref(&val);
+	return 1;
+}
+
+static int YASL_collections_deque_clear(struct YASL_State *S) {
+	struct YASL_Deque *deque = YASLX_checkndeque(S, "deque.clear", 0);
+	YASL_Deque_clear(deque);
+	return 1;
+}
+
+static int YASL_collections_deque_maxlen(struct YASL_State *S) {
+	struct YASL_Deque *deque = YASLX_checkndeque(S, "deque.maxlen", 0);
+	if (deque->maxlen) {
+		YASL_pushint(S, (yasl_int)deque->maxlen);
+	} else {
+		YASL_pushundef(S);
+	}
+	return 1;
+}
+
+static int YASL_collections_deque_copy(struct YASL_State *S) {
+	struct YASL_Deque *deque = YASLX_checkndeque(S, "deque.copy", 0);
+	struct YASL_Deque *copy = YASL_Deque_new_sized(deque->count, deque->maxlen);
+	YASL_pushdeque(S, copy);
+	for (size_t i = 0; i < deque->count; i++) {
+		YASL_Deque_push(copy, *YASL_Deque_at(deque, i));
+	}
+	return 1;
+}
+
+static int YASL_collections_deque_tolist(struct YASL_State *S) {
+	struct YASL_Deque *deque = YASLX_checkndeque(S, "deque.tolist", 0);
+	struct RC_UserData *list = rcls_new_sized(deque->count);
+	ud_setmt(list, S->vm.builtins_htable[Y_LIST]);
+	struct YASL_List *ls = (struct YASL_List *)list->data;
+	for (size_t i = 0; i < deque->count; i++) {
+		YASL_List_append(ls, *YASL_Deque_at(deque, i));
+	}
+	vm_pushlist(&S->vm, list);
+	return 1;
+}
+
+static int YASL_collections_deque_tostr(struct YASL_State *S) {
+	struct YASL_Deque *deque = YASLX_checkndeque(S, "deque.tostr", 0);
+
+	size_t string_count = strlen("deque(");
+	size_t string_size = string_count + 8;
+	char *string = (char *)malloc(string_size);
+	memcpy(string, "deque(", string_count);
+	for (size_t i = 0; i < deque->count; i++) {
+		vm_push(&S->vm, *YASL_Deque_at(deque, i));
+		vm_stringify_top(&S->vm);
+		struct YASL_String *str = vm_popstr(&S->vm);
+		while (string_count + YASL_String_len(str) + 2 >= string_size) {
+			string_size *= 2;
+			string = (char *)realloc(string, string_size);
+		}
+		memcpy(string + string_count, str->str + str->start, YASL_String_len(str));
+		string_count += YASL_String_len(str);
+		if (i + 1 < deque->count) {
+			string[string_count++] = ',';
+			string[string_count++] = ' ';
+		}
+	}
+	string[string_count++] = ')';
+	vm_pushstr(&S->vm, YASL_String_new_sized_heap(0, string_count, string));
+	return 1;
+}
+
+/*
+ * Walks the items of a deque from the front, by position, so the items are not copied first. Like a list, a deque
+ * that is changed while we walk it is walked by its new positions.
+ */
+struct DequeIterator {
+	struct YASL_Object deque;  // kept alive for as long as we are
+	size_t i;
+};
+
+static void deque_iterator_del(void *ptr) {
+	struct DequeIterator *it = (struct DequeIterator *)ptr;
+	dec_ref(&it->deque);
+}
+
+static struct YASL_Type deque_iterator_type = {
+	"collections.dequeiterator", sizeof(struct DequeIterator), deque_iterator_del, 0
+};
+
+static int YASL_collections_deque___iter(struct YASL_State *S) {
+	YASLX_checkndeque(S, "deque.__iter", 0);
+	struct DequeIterator *it = (struct DequeIterator *)YASL_pushobject(S, &deque_iterator_type);
+	it->deque = vm_peek(&S->vm, S->vm.fp + 1);
+	inc_ref(&it->deque);
+	return 1;
+}
+
+static int YASL_collections_dequeiterator___iter(struct YASL_State *S) {
+	YASLX_checknuserdata(S, deque_iterator_type.name, "dequeiterator.__iter", 0);
+	return 1;
+}
+
+static int YASL_collections_dequeiterator___next(struct YASL_State *S) {
+	struct DequeIterator *it = (struct DequeIterator *)YASLX_checknuserdata(S, deque_iterator_type.name,
+										 "dequeiterator.__next", 0);
+	struct YASL_Deque *deque = (struct YASL_Deque *)YASL_GETUSERDATA(it->deque)->data;
+	if (it->i >= deque->count) {
+		YASL_pushbool(S, false);
+		return 1;
+	}
+	YASL_pushbool(S, true);
+	vm_push(&S->vm, *YASL_Deque_at(deque, it->i++));
+	return 2;
+}
+
+static void YASL_collections_dequeiterator_registermt(struct YASL_State *S) {
+	YASL_pushtable(S);
+	YASL_registertype(S, &deque_iterator_type);
+
+	YASL_loadmt(S, deque_iterator_type.name);
+	YASL_pushlit(S, "__iter");
+	YASL_pushcfunction(S, YASL_collections_dequeiterator___iter, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__next");
+	YASL_pushcfunction(S, YASL_collections_dequeiterator___next, 1);
+	YASL_tableset(S);
+	YASL_pop(S);
+}
+
+static void YASL_collections_deque_registermt(struct YASL_State *S) {
+	YASL_pushtable(S);
+	YASL_registermt(S, DEQUE_NAME);
+
+	YASL_loadmt(S, DEQUE_NAME);
+	YASL_pushlit(S, "__len");
+	YASL_pushcfunction(S, YASL_collections_deque___len, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__get");
+	YASL_pushcfunction(S, YASL_collections_deque___get, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__set");
+	YASL_pushcfunction(S, YASL_collections_deque___set, 3);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "push");
+	YASL_pushcfunction(S, YASL_collections_deque_push, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "pushleft");
+	YASL_pushcfunction(S, YASL_collections_deque_pushleft, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "pop");
+	YASL_pushcfunction(S, YASL_collections_deque_pop, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "popleft");
+	YASL_pushcfunction(S, YASL_collections_deque_popleft, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "clear");
+	YASL_pushcfunction(S, YASL_collections_deque_clear, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "maxlen");
+	YASL_pushcfunction(S, YASL_collections_deque_maxlen, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "copy");
+	YASL_pushcfunction(S, YASL_collections_deque_copy, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__iter");
+	YASL_pushcfunction(S, YASL_collections_deque___iter, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "tolist");
+	YASL_pushcfunction(S, YASL_collections_deque_tolist, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "tostr");
+	YASL_pushcfunction(S, YASL_collections_deque_tostr, 1);
+	YASL_tableset(S);
+	YASL_pop(S);
+}
+
+static struct YASL_Heap *YASLX_checknheap(struct YASL_State *S, const char *name, unsigned n) {
+	return (struct YASL_Heap *)YASLX_checknuserdata(S, HEAP_NAME, name, n);
+}
+
+/*
+ * Makes an entry for the item on top of the stack, calling heap's key fn if it has one. The item stays on the stack,
+ * so it is kept alive while the key fn runs.
+ */
+static struct YASL_HeapEntry heap_entry_top(struct YASL_State *S, struct YASL_Heap *heap, const char *name) {
+	struct VM *vm = &S->vm;
+	struct YASL_HeapEntry entry = { vm_peek(vm), vm_peek(vm) };
+	if (!obj_isundef(&heap->keyfn)) {
+		vm_push(vm, heap->keyfn);
+		vm_INIT_CALL_offset(vm, vm->sp, 1);
+		vm_push(vm, entry.item);
+		vm_CALL_now(vm);
+		entry.key = vm_pop(vm);
+	}
+	if (!YASL_Heap_checkkey(heap, &entry.key)) {
+		vm_print_err_value(vm, "%s expected keys to be all numbers or all strings.", name);
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+	return entry;
+}
+
+/*
+ * Pushes the item of entry, and drops the references that were handed to us with it.
+ */
+static void heap_push_item(struct YASL_State *S, struct YASL_HeapEntry entry) {
+	vm_push(&S->vm, entry.item);
+	dec_ref(&entry.key);
+	dec_ref(&entry.item);
+}
+
+/*
+ * collections.heap([ls], [key])
+ */
+static int YASL_collections_heap_new(struct YASL_State *S) {
+	struct VM *vm = &S->vm;
+	struct YASL_List *ls = NULL;
+	if (!YASL_isnundef(S, 0)) {
+		if (!YASL_isnlist(S, 0)) {
+			YASLX_print_err_bad_arg_type(S, "collections.heap", 0, "list", YASL_peekntypename(S, 0));
+			YASL_throw_err(S, YASL_TYPE_ERROR);
+		}
+		ls = (struct YASL_List *)YASL_peeknuserdata(S, 0);
+	}
+
+	mem_reserve(ls ? ls->count * sizeof(struct YASL_HeapEntry) : 0);
+	struct YASL_Heap *heap = YASL_Heap_new_sized(ls ? ls->count : 0);
+	heap->keyfn = vm_peek(vm, vm->fp + 2);
+	inc_ref(&heap->keyfn);
+	YASL_pushuserdata(S, heap, HEAP_NAME, YASL_Heap_del);
+	YASL_loadmt(S, HEAP_NAME);
+	YASL_setmt(S);
+
+	// the key fn may change ls, so don't hold on to any of its items between calls.
+	for (size_t i = 0; ls && i < ls->count; i++) {
+		vm_push(vm, ls->items[i]);
+		YASL_Heap_append(heap, heap_entry_top(S, heap, "collections.heap"));
+		YASL_pop(S);
+	}
+	YASL_Heap_heapify(heap);
+	return 1;
+}
+
+static int YASL_collections_heap___len(struct YASL_State *S) {
+	struct YASL_Heap *heap = YASLX_checknheap(S, "heap.__len", 0);
+	YASL_pushint(S, (yasl_int)heap->count);
+	return 1;
+}
+
+static int YASL_collections_heap_push(struct YASL_State *S) {
+	struct YASL_Heap *heap = YASLX_checknheap(S, "heap.push", 0);
+	YASL_Heap_push(heap, heap_entry_top(S, heap, "heap.push"));
+	YASL_pop(S);
+	return 1;
+}
+
+static void heap_checknonempty(struct YASL_State *S, struct YASL_Heap *heap, const char *name) {
+	if (heap->count == 0) {
+		vm_print_err_value(&S->vm, "%s expected nonempty heap as arg 0.", name);
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+}
+
+static int YASL_collections_heap_pop(struct YASL_State *S) {
+	struct YASL_Heap *heap = YASLX_checknheap(S, "heap.pop", 0);
+	heap_checknonempty(S, heap, "heap.pop");
+	heap_push_item(S, YASL_Heap_pop(heap));
+	return 1;
+}
+
+static int YASL_collections_heap_peek(struct YASL_State *S) {
+	struct YASL_Heap *heap = YASLX_checknheap(S, "heap.peek", 0);
+	heap_checknonempty(S, heap, "heap.peek");
+	vm_push(&S->vm, heap->entries[0].item);
+	return 1;
+}
+
+/*
+ * Pops the smallest item and pushes x, which is cheaper than doing them separately.
+ */
+static int YASL_collections_heap_replace(struct YASL_State *S) {
+	struct YASL_Heap *heap = YASLX_checknheap(S, "heap.replace", 0);
+	heap_checknonempty(S, heap, "heap.replace");
+	struct YASL_HeapEntry entry = heap_entry_top(S, heap, "heap.replace");
+	heap_checknonempty(S, heap, "heap.replace");
+	heap_push_item(S, YASL_Heap_replace(heap, entry));
+	return 1;
+}
+
+static int YASL_collections_heap_clear(struct YASL_State *S) {
+	struct YASL_Heap *heap = YASLX_checknheap(S, "heap.clear", 0);
+	YASL_Heap_clear(heap);
+	return 1;
+}
+
+/*
+ * The items in heap order, i.e. the smallest comes first, but the rest are not sorted.
+ */
+static int YASL_collections_heap_tolist(struct YASL_State *S) {
+	struct YASL_Heap *heap = YASLX_checknheap(S, "heap.tolist", 0);
+	struct RC_UserData *list = rcls_new_sized(heap->count);
+	ud_setmt(list, S->vm.builtins_htable[Y_LIST]);
+	struct YASL_List *ls = (struct YASL_List *)list->data;
+	for (size_t i = 0; i < heap->count; i++) {
+		YASL_List_append(ls, heap->entries[i].item);
+	}
+	vm_pushlist(&S->vm, list);
+	return 1;
+}
+
+static void YASL_collections_heap_registermt(struct YASL_State *S) {
+	YASL_pushtable(S);
+	YASL_registermt(S, HEAP_NAME);
+
+	YASL_loadmt(S, HEAP_NAME);
+	YASL_pushlit(S, "__len");
+	YASL_pushcfunction(S, YASL_collections_heap___len, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "push");
+	YASL_pushcfunction(S, YASL_collections_heap_push, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "pop");
+	YASL_pushcfunction(S, YASL_collections_heap_pop, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "peek");
+	YASL_pushcfunction(S, YASL_collections_heap_peek, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "replace");
+	YASL_pushcfunction(S, YASL_collections_heap_replace, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "clear");
+	YASL_pushcfunction(S, YASL_collections_heap_clear, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "tolist");
+	YASL_pushcfunction(S, YASL_collections_heap_tolist, 1);
+	YASL_tableset(S);
+	YASL_pop(S);
+}
+
+static struct YASL_BTree *YASLX_checknsorted(struct YASL_State *S, const char *tag, const char *name, unsigned n) {
+	return (struct YASL_BTree *)YASLX_checknuserdata(S, tag, name, n);
+}
+
+static void YASL_pushsorted(struct YASL_State *S, struct YASL_BTree *tree, const char *tag) {
+	YASL_pushuserdata(S, tree, tag, YASL_BTree_del);
+	YASL_loadmt(S, tag);
+	YASL_setmt(S);
+}
+
+static void sorted_checkkey(struct YASL_State *S, struct YASL_BTree *tree, const struct YASL_Object *key,
+			    const char *name) {
+	if (!YASL_BTree_checkkey(tree, key)) {
+		vm_print_err_value(&S->vm, "%s expected keys to be all numbers or all strings.", name);
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+}
+
+static void sorted_pushkey(struct YASL_State *S, const struct YASL_BTreeEntry entry) {
+	if (entry.key) {
+		vm_push(&S->vm, *entry.key);
+	} else {
+		YASL_pushundef(S);
+	}
+}
+
+/*
+ * Walks the keys of a sortedmap or sortedset in order, optionally stopping before a given key. If the tree is changed
+ * mid-walk, the iterator finds its place again from the last key it returned.
+ */
+struct SortedIterator {
+	struct YASL_Object owner;  // the sortedmap or sortedset, kept alive for as long as we are
+	struct YASL_BTree *tree;
+	struct YASL_BTreeCursor cursor;
+	size_t version;
+	struct YASL_Object last;   // the last key returned, or where to start from
+	bool strict;               // whether to start after last rather than at it
+	struct YASL_Object stop;   // undef to run to the end
+};
+
+static void sorted_iterator_del(void *ptr) {
+	struct SortedIterator *it = (struct SortedIterator *)ptr;
+	dec_ref(&it->owner);
+	dec_ref(&it->last);
+	dec_ref(&it->stop);
+}
+
+static struct YASL_Type sorted_iterator_type = {
+	"collections.sortediterator", sizeof(struct SortedIterator), sorted_iterator_del, 0
+};
+
+static void sorted_iterator_seek(struct SortedIterator *it) {
+	YASL_BTree_seek(it->tree, &it->cursor, obj_isundef(&it->last) ? NULL : &it->last, it->strict);
+	it->version = it->tree->version;
+}
+
+/*
+ * Pushes an iterator over the keys of the tree at position 0 that are >= start and < stop. Either bound may be undef.
+ */
+static void sorted_pushiterator(struct YASL_State *S, struct YASL_BTree *tree, struct YASL_Object start,
+				struct YASL_Object stop) {
+	struct SortedIterator *it = (struct SortedIterator *)YASL_pushobject(S, &sorted_iterator_type);
+	it->owner = vm_peek(&S->vm, S->vm.fp + 1);
+	it->tree = tree;
+	it->last = start;
+	it->strict = false;
+	it->stop = stop;
+	inc_ref(&it->owner);
+	inc_ref(&it->last);
+	inc_ref(&it->stop);
+	sorted_iterator_seek(it);
+}
+
+static int YASL_collections_sortediterator___iter(struct YASL_State *S) {
+	YASLX_checknuserdata(S, sorted_iterator_type.name, "sortediterator.__iter", 0);
+	return 1;
+}
+
+static int YASL_collections_sortediterator___next(struct YASL_State *S) {
+	struct SortedIterator *it = (struct SortedIterator *)YASLX_checknuserdata(S, sorted_iterator_type.name,
+										   "sortediterator.__next", 0);
+	if (it->version != it->tree->version) {
+		sorted_iterator_seek(it);
+	}
+	struct YASL_BTreeEntry entry = YASL_BTree_cursor_entry(&it->cursor);
+	if (!entry.key || (!obj_isundef(&it->stop) && (!YASL_BTree_cancompare(it->tree, &it->stop) ||
+						       YASL_BTree_cmp(entry.key, &it->stop) >= 0))) {
+		YASL_pushbool(S, false);
+		return 1;
+	}
+
+	struct YASL_Object key = *entry.key;
+	inc_ref(&key);
+	dec_ref(&it->last);
+	it->last = key;
+	it->strict = true;
+	YASL_BTree_cursor_next(&it->cursor);
+
+	YASL_pushbool(S, true);
+	vm_push(&S->vm, key);
+	return 2;
+}
+
+static void sorted_checkbound(struct YASL_State *S, const char *name, unsigned n) {
+	if (!YASL_isnundef(S, n) && !YASL_isnint(S, n) && !YASL_isnfloat(S, n) && !YASL_isnstr(S, n)) {
+		YASLX_print_err_bad_arg_type(S, name, n, "int, float, str, or undef", YASL_peekntypename(S, n));
+		YASL_throw_err(S, YASL_TYPE_ERROR);
+	}
+}
+
+/*
+ * The methods below are shared by sortedmap and sortedset; only the tag they check for differs.
+ */
+static int sorted___len(struct YASL_State *S, const char *tag, const char *name) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, tag, name, 0);
+	YASL_pushint(S, (yasl_int)tree->count);
+	return 1;
+}
+
+static int sorted___iter(struct YASL_State *S, const char *tag, const char *name) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, tag, name, 0);
+	sorted_pushiterator(S, tree, YASL_UNDEF(), YASL_UNDEF());
+	return 1;
+}
+
+/*
+ * sortedmap.range([start], [stop]) iterates over the keys k with start <= k < stop.
+ */
+static int sorted_range(struct YASL_State *S, const char *tag, const char *name) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, tag, name, 0);
+	sorted_checkbound(S, name, 1);
+	sorted_checkbound(S, name, 2);
+	sorted_pushiterator(S, tree, vm_peek(&S->vm, S->vm.fp + 2), vm_peek(&S->vm, S->vm.fp + 3));
+	return 1;
+}
+
+static int sorted_floor(struct YASL_State *S, const char *tag, const char *name) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, tag, name, 0);
+	struct YASL_Object key = vm_peek(&S->vm, S->vm.fp + 2);
+	sorted_pushkey(S, YASL_BTree_floor(tree, &key, false));
+	return 1;
+}
+
+static int sorted_ceil(struct YASL_State *S, const char *tag, const char *name) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, tag, name, 0);
+	struct YASL_Object key = vm_peek(&S->vm, S->vm.fp + 2);
+	sorted_pushkey(S, YASL_BTree_ceil(tree, &key, false));
+	return 1;
+}
+
+static int sorted_first(struct YASL_State *S, const char *tag, const char *name) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, tag, name, 0);
+	sorted_pushkey(S, YASL_BTree_min(tree));
+	return 1;
+}
+
+static int sorted_last(struct YASL_State *S, const char *tag, const char *name) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, tag, name, 0);
+	sorted_pushkey(S, YASL_BTree_max(tree));
+	return 1;
+}
+
+static int sorted_remove(struct YASL_State *S, const char *tag, const char *name) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, tag, name, 0);
+	struct YASL_Object key = vm_peek(&S->vm, S->vm.fp + 2);
+	YASL_BTree_rm(tree, &key);
+	YASL_pop(S);
+	return 1;
+}
+
+static int sorted_clear(struct YASL_State *S, const char *tag, const char *name) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, tag, name, 0);
+	YASL_BTree_clear(tree);
+	return 1;
+}
+
+/*
+ * Pushes a list of the keys (or values) of tree, in key order.
+ */
+static void sorted_pushlist(struct YASL_State *S, struct YASL_BTree *tree, const bool vals) {
+	struct RC_UserData *list = rcls_new_sized(tree->count);
+	ud_setmt(list, S->vm.builtins_htable[Y_LIST]);
+	struct YASL_List *ls = (struct YASL_List *)list->data;
+	struct YASL_BTreeCursor cursor;
+	for (YASL_BTree_seek(tree, &cursor, NULL, false); cursor.depth >= 0; YASL_BTree_cursor_next(&cursor)) {
+		struct YASL_BTreeEntry entry = YASL_BTree_cursor_entry(&cursor);
+		YASL_List_append(ls, vals ? *entry.val : *entry.key);
+	}
+	vm_pushlist(&S->vm, list);
+}
+
+/*
+ * Stringifying an item may run a tostr method, which could change tree, so we find our place again after each one.
+ */
+static void sorted_tostr(struct YASL_State *S, struct YASL_BTree *tree, const char *prefix, const bool vals) {
+	size_t string_count = strlen(prefix);
+	size_t string_size = string_count + 8;
+	char *string = (char *)malloc(string_size);
+	memcpy(string, prefix, string_count);
+
+	struct YASL_BTreeCursor cursor;
+	YASL_BTree_seek(tree, &cursor, NULL, false);
+	bool first = true;
+	while (cursor.depth >= 0) {
+		struct YASL_BTreeEntry entry = YASL_BTree_cursor_entry(&cursor);
+		struct YASL_Object key = *entry.key;
+		vm_push(&S->vm, key);
+		const size_t n = vals ? 2 : 1;
+		if (vals) {
+			vm_push(&S->vm, *entry.val);
+		}
+		for (size_t i = n; i-- > 0;) {
+			vm_push(&S->vm, vm_peek(&S->vm, S->vm.sp - i));
+			vm_stringify_top(&S->vm);
+			struct YASL_String *str = vm_popstr(&S->vm);
+			while (string_count + YASL_String_len(str) + 4 >= string_size) {
+				string_size *= 2;
+				string = (char *)realloc(string, string_size);
+			}
+			if (i + 1 == n && !first) {
+				string[string_count++] = ',';
+				string[string_count++] = ' ';
+			}
+			memcpy(string + string_count, str->str + str->start, YASL_String_len(str));
+			string_count += YASL_String_len(str);
+			if (i > 0) {
+				string[string_count++] = ':';
+				string[string_count++] = ' ';
+			}
+		}
+		first = false;
+		YASL_BTree_seek(tree, &cursor, &vm_peek(&S->vm, S->vm.sp - (n - 1)), true);
+		S->vm.sp -= n;
+	}
+
+	string[string_count++] = ')';
+	vm_pushstr(&S->vm, YASL_String_new_sized_heap(0, string_count, string));
+}
+
+#define YASL_COLLECTIONS_SORTED_METHOD(kind, tag, method) \
+static int YASL_collections_##kind##_##method(struct YASL_State *S) {\
+	return sorted_##method(S, tag, #kind "." #method);\
+}
+
+#define YASL_COLLECTIONS_SORTED_METHODS(kind, tag) \
+YASL_COLLECTIONS_SORTED_METHOD(kind, tag, __len)\
+YASL_COLLECTIONS_SORTED_METHOD(kind, tag, __iter)\
+YASL_COLLECTIONS_SORTED_METHOD(kind, tag, range)\
+YASL_COLLECTIONS_SORTED_METHOD(kind, tag, floor)\
+YASL_COLLECTIONS_SORTED_METHOD(kind, tag, ceil)\
+YASL_COLLECTIONS_SORTED_METHOD(kind, tag, first)\
+YASL_COLLECTIONS_SORTED_METHOD(kind, tag, last)\
+YASL_COLLECTIONS_SORTED_METHOD(kind, tag, remove)\
+YASL_COLLECTIONS_SORTED_METHOD(kind, tag, clear)
+
+YASL_COLLECTIONS_SORTED_METHODS(sortedmap, SORTEDMAP_NAME)
+YASL_COLLECTIONS_SORTED_METHODS(sortedset, SORTEDSET_NAME)
+
+/*
+ * collections.sortedmap([table])
+ */
+static int YASL_collections_sortedmap_new(struct YASL_State *S) {
+	struct YASL_Table *table = NULL;
+	if (!YASL_isnundef(S, 0)) {
+		if (!YASL_isntable(S, 0)) {
+			YASLX_print_err_bad_arg_type(S, "collections.sortedmap", 0, "table", YASL_peekntypename(S, 0));
+			YASL_throw_err(S, YASL_TYPE_ERROR);
+		}
+		table = YASL_GETTABLE(vm_peek(&S->vm, S->vm.fp + 1));
+	}
+
+	struct YASL_BTree *tree = YASL_BTree_new();
+	YASL_pushsorted(S, tree, SORTEDMAP_NAME);
+	if (table) {
+		FOR_TABLE(i, item, table) {
+			sorted_checkkey(S, tree, &item->key, "collections.sortedmap");
+			YASL_BTree_insert(tree, item->key, item->value);
+		}
+	}
+	return 1;
+}
+
+/*
+ * collections.sortedset([list])
+ */
+static int YASL_collections_sortedset_new(struct YASL_State *S) {
+	struct YASL_List *ls = NULL;
+	if (!YASL_isnundef(S, 0)) {
+		if (!YASL_isnlist(S, 0)) {
+			YASLX_print_err_bad_arg_type(S, "collections.sortedset", 0, "list", YASL_peekntypename(S, 0));
+			YASL_throw_err(S, YASL_TYPE_ERROR);
+		}
+		ls = (struct YASL_List *)YASL_peeknuserdata(S, 0);
+	}
+
+	struct YASL_BTree *tree = YASL_BTree_new();
+	YASL_pushsorted(S, tree, SORTEDSET_NAME);
+	if (ls) {
+		FOR_LIST(i, elmt, ls) {
+			sorted_checkkey(S, tree, &elmt, "collections.sortedset");
+			YASL_BTree_insert(tree, elmt, YASL_UNDEF());
+		}
+	}
+	return 1;
+}
+
+static int YASL_collections_sortedmap___get(struct YASL_State *S) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, SORTEDMAP_NAME, "sortedmap.__get", 0);
+	struct YASL_Object key = vm_peek(&S->vm, S->vm.fp + 2);
+	struct YASL_BTreeEntry entry = YASL_BTree_search(tree, &key);
+	if (entry.val) {
+		vm_push(&S->vm, *entry.val);
+	} else {
+		YASL_pushundef(S);
+	}
+	return 1;
+}
+
+static int YASL_collections_sortedmap___set(struct YASL_State *S) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, SORTEDMAP_NAME, "sortedmap.__set", 0);
+	struct YASL_Object key = vm_peek(&S->vm, S->vm.fp + 2);
+	sorted_checkkey(S, tree, &key, "sortedmap.__set");
+	YASL_BTree_insert(tree, key, vm_peek(&S->vm, S->vm.fp + 3));
+	return 1;
+}
+
+static int YASL_collections_sortedmap_keys(struct YASL_State *S) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, SORTEDMAP_NAME, "sortedmap.keys", 0);
+	sorted_pushlist(S, tree, false);
+	return 1;
+}
+
+static int YASL_collections_sortedmap_values(struct YASL_State *S) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, SORTEDMAP_NAME, "sortedmap.values", 0);
+	sorted_pushlist(S, tree, true);
+	return 1;
+}
+
+static int YASL_collections_sortedmap_tostr(struct YASL_State *S) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, SORTEDMAP_NAME, "sortedmap.tostr", 0);
+	sorted_tostr(S, tree, "sortedmap(", true);
+	return 1;
+}
+
+static int YASL_collections_sortedset___get(struct YASL_State *S) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, SORTEDSET_NAME, "sortedset.__get", 0);
+	struct YASL_Object key = vm_peek(&S->vm, S->vm.fp + 2);
+	YASL_pushbool(S, YASL_BTree_search(tree, &key).key != NULL);
+	return 1;
+}
+
+static int YASL_collections_sortedset_add(struct YASL_State *S) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, SORTEDSET_NAME, "sortedset.add", 0);
+	struct YASL_Object key = vm_peek(&S->vm, S->vm.fp + 2);
+	sorted_checkkey(S, tree, &key, "sortedset.add");
+	YASL_BTree_insert(tree, key, YASL_UNDEF());
+	YASL_pop(S);
+	return 1;
+}
+
+static int YASL_collections_sortedset_tolist(struct YASL_State *S) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, SORTEDSET_NAME, "sortedset.tolist", 0);
+	sorted_pushlist(S, tree, false);
+	return 1;
+}
+
+static int YASL_collections_sortedset_tostr(struct YASL_State *S) {
+	struct YASL_BTree *tree = YASLX_checknsorted(S, SORTEDSET_NAME, "sortedset.tostr", 0);
+	sorted_tostr(S, tree, "sortedset(", false);
+	return 1;
+}
+
+static void sorted_registermethod(struct YASL_State *S, const char *name, YASL_cfn fn, int args) {
+	YASL_pushlit(S, name);
+	YASL_pushcfunction(S, fn, args);
+	YASL_tableset(S);
+}
+
+#define YASL_COLLECTIONS_SORTED_REGISTER(kind) \
+	sorted_registermethod(S, "__len", YASL_collections_##kind##___len, 1);\
+	sorted_registermethod(S, "__iter", YASL_collections_##kind##___iter, 1);\
+	sorted_registermethod(S, "range", YASL_collections_##kind##_range, 3);\
+	sorted_registermethod(S, "floor", YASL_collections_##kind##_floor, 2);\
+	sorted_registermethod(S, "ceil", YASL_collections_##kind##_ceil, 2);\
+	sorted_registermethod(S, "first", YASL_collections_##kind##_first, 1);\
+	sorted_registermethod(S, "last", YASL_collections_##kind##_last, 1);\
+	sorted_registermethod(S, "remove", YASL_collections_##kind##_remove, 2);\
+	sorted_registermethod(S, "clear", YASL_collections_##kind##_clear, 1);
+
+static void YASL_collections_sorted_registermt(struct YASL_State *S) {
+	YASL_pushtable(S);
+	YASL_registertype(S, &sorted_iterator_type);
+	YASL_loadmt(S, sorted_iterator_type.name);
+	sorted_registermethod(S, "__iter", YASL_collections_sortediterator___iter, 1);
+	sorted_registermethod(S, "__next", YASL_collections_sortediterator___next, 1);
+	YASL_pop(S);
+
+	YASL_pushtable(S);
+	YASL_registermt(S, SORTEDMAP_NAME);
+	YASL_loadmt(S, SORTEDMAP_NAME);
+	YASL_COLLECTIONS_SORTED_REGISTER(sortedmap)
+	sorted_registermethod(S, "__get", YASL_collections_sortedmap___get, 2);
+	sorted_registermethod(S, "__set", YASL_collections_sortedmap___set, 3);
+	sorted_registermethod(S, "keys", YASL_collections_sortedmap_keys, 1);
+	sorted_registermethod(S, "values", YASL_collections_sortedmap_values, 1);
+	sorted_registermethod(S, "tostr", YASL_collections_sortedmap_tostr, 1);
+	YASL_pop(S);
+
+	YASL_pushtable(S);
+	YASL_registermt(S, SORTEDSET_NAME);
+	YASL_loadmt(S, SORTEDSET_NAME);
+	YASL_COLLECTIONS_SORTED_REGISTER(sortedset)
+	sorted_registermethod(S, "__get", YASL_collections_sortedset___get, 2);
+	sorted_registermethod(S, "add", YASL_collections_sortedset_add, 2);
+	sorted_registermethod(S, "tolist", YASL_collections_sortedset_tolist, 1);
+	sorted_registermethod(S, "tostr", YASL_collections_sortedset_tostr, 1);
+	YASL_pop(S);
+}
+
+int YASL_decllib_collections(struct YASL_State *S) {
+	YASL_pushtable(S);
+	YASL_registertype(S, &set_type);
+
+	YASL_loadmt(S, SET_NAME);
+	YASL_pushlit(S, "tostr");
+	YASL_pushcfunction(S, YASL_collections_set_tostr, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "tolist");
+	YASL_pushcfunction(S, YASL_collections_set_tolist, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__band");
+	YASL_pushcfunction(S, YASL_collections_set___band, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__bor");
+	YASL_pushcfunction(S, YASL_collections_set___bor, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__bxor");
+	YASL_pushcfunction(S, YASL_collections_set___bxor, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__bandnot");
+	YASL_pushcfunction(S, YASL_collections_set___bandnot, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__len");
+	YASL_pushcfunction(S, YASL_collections_set___len, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__eq");
+	YASL_pushcfunction(S, YASL_collections_set___eq, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__gt");
+	YASL_pushcfunction(S, YASL_collections_set___gt, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__ge");
+	YASL_pushcfunction(S, YASL_collections_set___ge, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__lt");
+	YASL_pushcfunction(S, YASL_collections_set___lt, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__le");
+	YASL_pushcfunction(S, YASL_collections_set___le, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "add");
+	YASL_pushcfunction(S, YASL_collections_set_add, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "remove");
+	YASL_pushcfunction(S, YASL_collections_set_remove, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "copy");
+	YASL_pushcfunction(S, YASL_collections_set_copy, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "clear");
+	YASL_pushcfunction(S, YASL_collections_set_clear, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "update");
+	YASL_pushcfunction(S, YASL_collections_set_update, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "intersection_update");
+	YASL_pushcfunction(S, YASL_collections_set_intersection_update, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "difference_update");
+	YASL_pushcfunction(S, YASL_collections_set_difference_update, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "issubset");
+	YASL_pushcfunction(S, YASL_collections_set_issubset, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "isdisjoint");
+	YASL_pushcfunction(S, YASL_collections_set_isdisjoint, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__get");
+	YASL_pushcfunction(S, YASL_collections_set___get, 2);
+	YASL_tableset(S);
+	YASL_pop(S);
+
+	YASL_collections_arrayiterator_registermt(S);
+	YASL_collections_array_registermt(S, INTARRAY_NAME, true);
+	YASL_collections_array_registermt(S, FLOATARRAY_NAME, true);
+	YASL_collections_array_registermt(S, BYTEARRAY_NAME, false);
+	YASL_collections_dequeiterator_registermt(S);
+	YASL_collections_deque_registermt(S);
+	YASL_collections_heap_registermt(S);
+	YASL_collections_sorted_registermt(S);
+
+
+	YASL_pushtable(S);
+	YASLX_initglobal(S, "collections");
+
+	YASL_loadglobal(S, "collections");
+	YASL_pushlit(S, "set");
+	YASL_pushcfunction(S, YASL_collections_set_new, -1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "list");
+	YASL_pushcfunction(S, YASL_collections_list_new, -1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "table");
+	YASL_pushcfunction(S, YASL_collections_table_new, -1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "intarray");
+	YASL_pushcfunction(S, YASL_collections_intarray_new, -1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "floatarray");
+	YASL_pushcfunction(S, YASL_collections_floatarray_new, -1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "bytearray");
+	YASL_pushcfunction(S, YASL_collections_bytearray_new, -1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "deque");
+	YASL_pushcfunction(S, YASL_collections_deque_new, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "heap");
+	YASL_pushcfunction(S, YASL_collections_heap_new, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "sortedmap");
+	YASL_pushcfunction(S, YASL_collections_sortedmap_new, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "sortedset");
+	YASL_pushcfunction(S, YASL_collections_sortedset_new, 1);
 	YASL_tableset(S);
 	YASL_pop(S);
 
@@ -0,0 +1,145 @@
+#include "yasl-std-coroutine.h"
+
+#include "interpreter/coroutine.h"
+#include "yasl_aux.h"
+#include "yasl_state.h"
+
+static const char *const COROUTINE_NAME = "coroutine";
+
+static const char *const STATUS_NAMES[] = {
+	"suspended",
+	"running",
+	"normal",
+	"dead"
+};
+
+static struct Coroutine *YASLX_checkncoroutine(struct YASL_State *S, const char *name, unsigned n) {
+	return (struct Coroutine *)YASLX_checknuserdata(S, COROUTINE_NAME, name, n);
+}
+
+static void coroutine_checksuspended(struct YASL_State *S, struct Coroutine *const co, const char *const name) {
+	if (co->status != CO_SUSPENDED) {
+		vm_print_err_value(&S->vm, "%s expected a suspended coroutine, got a %s one.", name, STATUS_NAMES[co->status]);
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+}
+
+/*
+ * Makes a coroutine that calls fn when it is first resumed. Coroutines have stacks of their own, so that they can stop
+ * partway through fn and pick up from there later.
+ */
+static int YASL_coroutine_new(struct YASL_State *S) {
+	struct VM *const vm = &S->vm;
+	if (!vm_isfn(vm, vm->fp + 1) && !vm_iscfn(vm, vm->fp + 1) && !vm_isclosure(vm, vm->fp + 1)) {
+		YASLX_print_err_bad_arg_type(S, "coroutine.new", 0, "fn", YASL_peekntypename(S, 0));
+		YASL_throw_err(S, YASL_TYPE_ERROR);
+	}
+
+	struct Coroutine *co = co_new(vm_peek(vm, vm->fp + 1));
+	YASL_pushuserdata(S, co, COROUTINE_NAME, co_del);
+	YASL_loadmt(S, COROUTINE_NAME);
+	YASL_setmt(S);
+	return 1;
+}
+
+/*
+ * Stops the running coroutine, which makes the resume that ran it return the arguments. The next resume continues from
+ * here, and its arguments are returned from the yield. Outside of any coroutine, this suspends the whole script
+ * instead, returning control to the host (see YASL_resume).
+ */
+static int YASL_coroutine_yield(struct YASL_State *S) {
+	struct VM *const vm = &S->vm;
+	if (vm->co ? vm->depth != vm->co->depth : vm->depth != 0) {
+		vm_print_err_value(vm, "%s cannot be called from a function called from C.", "coroutine.yield");
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+
+	if (!vm->co) {
+		vm_suspend(vm);
+	}
+	vm_throw_err(vm, YASL_YIELD);
+}
+
+/*
+ * Runs the coroutine until it yields or returns, and returns whatever it yielded or returned. The remaining arguments
+ * are passed to its function the first time, and returned from the yield it stopped in after that.
+ */
+static int YASL_coroutine_coroutine_resume(struct YASL_State *S) {
+	struct Coroutine *co = YASLX_checkncoroutine(S, "coroutine.resume", 0);
+	coroutine_checksuspended(S, co, "coroutine.resume");
+	return vm_resume_coroutine(&S->vm, co, (int)YASL_peekvargscount(S));
+}
+
+/*
+ * One of 'suspended', 'running', 'normal' (running, but waiting on a coroutine it resumed) or 'dead'.
+ */
+static int YASL_coroutine_coroutine_status(struct YASL_State *S) {
+	struct Coroutine *co = YASLX_checkncoroutine(S, "coroutine.status", 0);
+	YASL_pushlit(S, STATUS_NAMES[co->status]);
+	return 1;
+}
+
+/*
+ * Lets a coroutine be used as a generator in a for loop. Each step resumes it without arguments, and takes the first
+ * value it yields; the loop stops once the coroutine returns.
+ */
+static int YASL_coroutine_coroutine___next(struct YASL_State *S) {
+	struct VM *const vm = &S->vm;
+	struct Coroutine *co = YASLX_checkncoroutine(S, "coroutine.__next", 0);
+	if (co->status == CO_DEAD) {
+		YASL_pushbool(S, false);
+		return 1;
+	}
+	coroutine_checksuspended(S, co, "coroutine.__next");
+
+	int n = vm_resume_coroutine(vm, co, 0);
+	if (co->status == CO_DEAD) {
+		YASL_pushbool(S, false);
+		return 1;
+	}
+
+	if (n == 0) {
+		vm_pushundef(vm);
+	}
+	while (n-- > 1) {
+		vm_pop(vm);
+	}
+	vm_pushbool(vm, true);
+	vm_swaptop(vm);
+	return 2;
+}
+
+int YASL_decllib_coroutine(struct YASL_State *S) {
+	YASL_pushtable(S);
+	YASL_registermt(S, COROUTINE_NAME);
+
+	YASL_loadmt(S, COROUTINE_NAME);
+	YASL_pushlit(S, "resume");
+	YASL_pushcfunction(S, YASL_coroutine_coroutine_resume, -2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "status");
+	YASL_pushcfunction(S, YASL_coroutine_coroutine_status, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__next");
+	YASL_pushcfunction(S, YASL_coroutine_coroutine___next, 1);
+	YASL_tableset(S);
+	YASL_pop(S);
+
+	YASL_declglobal(S, "coroutine");
+	YASL_pushtable(S);
+	YASL_setglobal(S, "coroutine");
+
+	YASL_loadglobal(S, "coroutine");
+	YASL_pushlit(S, "new");
+	YASL_pushcfunction(S, YASL_coroutine_new, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "yield");
+	YASL_pushcfunction(S, YASL_coroutine_yield, -1);
+	YASL_tableset(S);
+	YASL_pop(S);
+
+	return YASL_SUCCESS;
+}
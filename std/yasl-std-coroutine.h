@@ -0,0 +1,8 @@
+#ifndef YASL_YASL_STD_COROUTINE_H_
+#define YASL_YASL_STD_COROUTINE_H_
+
+#include "yasl.h"
+
+int YASL_decllib_coroutine(struct YASL_State *S);
+
+#endif
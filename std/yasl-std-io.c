@@ -6,6 +6,7 @@
 
 #include "data-structures/YASL_Table.h"
 #include "VM.h"
+#include "interpreter/alloc.h"
 #include "yasl_aux.h"
 
 // what to prepend to method names in messages to user
@@ -139,6 +140,7 @@ static int YASL_io_read(struct YASL_State *S) {
 		size_t fsize = ftell(f);
 		fseek(f, 0, SEEK_SET);
 
+		mem_reserve(fsize);
 		char *string = (char *) malloc(fsize);
 		int result = fread(string, fsize, 1, f);
 		(void) result;
@@ -156,6 +158,10 @@ static int YASL_io_read(struct YASL_State *S) {
 		while ( (c = fgetc(f)) != EOF && c != '\n') {
 			if (i == size) {
 				size *= 2;
+				if (!mem_hasroom(size)) {
+					free(string);
+					mem_reserve(size);
+				}
 				string = (char *)realloc(string, size);
 			}
 			string[i++] = (char) c;
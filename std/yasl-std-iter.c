@@ -0,0 +1,498 @@
+#include "yasl-std-iter.h"
+
+#include "yasl_state.h"
+#include "yasl_aux.h"
+#include "interpreter/range_methods.h"
+#include "interpreter/userdata.h"
+
+/*
+ * Lazy iterators. Each adapter holds the iterators it reads from and pulls one item from them at a time, so a
+ * pipeline of adapters never builds intermediate lists.
+ */
+
+static const char *const ITERATOR_NAME = "iter.iterator";
+
+enum IteratorKind {
+	ITER_LIST,
+	ITER_STR,
+	ITER_TABLE,
+	ITER_NEXT,       // object with a __next method
+	ITER_RANGE,
+	ITER_MAP,
+	ITER_FILTER,
+	ITER_TAKE,
+	ITER_ZIP,
+	ITER_ENUMERATE,
+	ITER_CHAIN
+};
+
+struct Iterator {
+	enum IteratorKind kind;
+	yasl_int i;
+	yasl_int stop;
+	yasl_int step;
+	struct YASL_Object obj;       // the list, str, table or iterator object, or the fn for map and filter
+	struct YASL_Object next;      // obj's __next method, for ITER_NEXT
+	size_t num_sources;
+	struct YASL_Object *sources;  // iterators we pull items from
+};
+
+static void iterator_del(void *ptr) {
+	struct Iterator *it = (struct Iterator *)ptr;
+	dec_ref(&it->obj);
+	dec_ref(&it->next);
+	for (size_t i = 0; i < it->num_sources; i++) {
+		dec_ref(it->sources + i);
+	}
+}
+
+/*
+ * Pushes a new iterator, with room for its sources allocated along with it.
+ */
+static struct Iterator *iterator_push(struct YASL_State *S, const enum IteratorKind kind, const size_t num_sources) {
+	const size_t size = sizeof(struct Iterator) + num_sources * sizeof(struct YASL_Object);
+	struct RC_UserData *ud = ud_new_inline(size, ITERATOR_NAME, NULL, iterator_del);
+	struct Iterator *it = (struct Iterator *)ud->data;
+	it->kind = kind;
+	it->i = 0;
+	it->stop = 0;
+	it->step = 1;
+	it->obj = YASL_UNDEF();
+	it->next = YASL_UNDEF();
+	it->num_sources = num_sources;
+	it->sources = num_sources ? (struct YASL_Object *)(it + 1) : NULL;
+	for (size_t i = 0; i < num_sources; i++) {
+		it->sources[i] = YASL_UNDEF();
+	}
+	vm_push(&S->vm, YASL_USERDATA(ud));
+	YASL_loadmt(S, ITERATOR_NAME);
+	YASL_setmt(S);
+	return it;
+}
+
+static void iterator_setobj(struct Iterator *it, struct YASL_Object obj) {
+	inc_ref(&obj);
+	dec_ref(&it->obj);
+	it->obj = obj;
+}
+
+static bool vm_isiterator(struct VM *vm) {
+	return vm_isuserdata(vm) && YASL_GETUSERDATA(vm_peek(vm))->tag == ITERATOR_NAME;
+}
+
+/*
+ * Replaces the top of the stack with an iterator over it. Iterators are left as they are.
+ */
+static void iter_from_top(struct YASL_State *S, const char *name) {
+	struct VM *vm = &S->vm;
+	if (vm_isiterator(vm)) {
+		return;
+	}
+
+	if (vm_isuserdata(vm) || vm_istable(vm)) {
+		struct YASL_Object iter = vm_find_method(vm, vm_peek(vm), "__iter");
+		if (!obj_isundef(&iter)) {
+			vm_push(vm, iter);
+			vm_swaptop(vm);
+			vm_INIT_CALL_offset(vm, vm->sp - 1, 1);
+			vm_CALL_now(vm);
+			if (vm_isiterator(vm)) {
+				return;
+			}
+		}
+	}
+
+	struct YASL_Object next = YASL_UNDEF();
+	if (vm_isuserdata(vm) || vm_istable(vm)) {
+		next = vm_find_method(vm, vm_peek(vm), "__next");
+	}
+
+	enum IteratorKind kind;
+	if (vm_isuserdata(vm) && YASL_GETUSERDATA(vm_peek(vm))->tag == RANGE_NAME) {
+		kind = ITER_RANGE;
+	} else if (!obj_isundef(&next)) {
+		kind = ITER_NEXT;
+	} else if (vm_islist(vm)) {
+		kind = ITER_LIST;
+	} else if (vm_isstr(vm)) {
+		kind = ITER_STR;
+	} else if (vm_istable(vm)) {
+		kind = ITER_TABLE;
+	} else {
+		vm_print_err_type(vm, "%s expected iterable, got %s.", name, vm_peektypename(vm));
+		YASL_throw_err(S, YASL_TYPE_ERROR);
+	}
+
+	struct YASL_Object obj = vm_peek(vm);
+	struct Iterator *it = iterator_push(S, kind, 0);
+	iterator_setobj(it, obj);
+	if (kind == ITER_RANGE) {
+		struct YASL_Range *range = (struct YASL_Range *)YASL_GETUSERDATA(obj)->data;
+		it->i = range->start;
+		it->stop = range->stop;
+		it->step = range->step;
+	} else if (kind == ITER_NEXT) {
+		it->next = next;
+		inc_ref(&it->next);
+	}
+	vm_swaptop(vm);
+	vm_pop(vm);
+}
+
+/*
+ * Stores iterators over the items of the stack from index start up as its sources, in order.
+ */
+static void iterator_setsources(struct YASL_State *S, struct Iterator *it, const int start, const char *name) {
+	struct VM *vm = &S->vm;
+	for (size_t i = 0; i < it->num_sources; i++) {
+		vm_push(vm, vm_peek(vm, start + (int)i));
+		iter_from_top(S, name);
+		it->sources[i] = vm_pop(vm);
+		inc_ref(it->sources + i);
+	}
+}
+
+static bool iter_advance(struct YASL_State *S, struct YASL_Object iterator);
+
+static bool iter_call_next(struct YASL_State *S, struct Iterator *it) {
+	struct VM *vm = &S->vm;
+	vm_push(vm, it->next);
+	vm_INIT_CALL_offset(vm, vm->sp, 2);
+	vm_push(vm, it->obj);
+	vm_CALL_now(vm);
+
+	if (!vm_isbool(vm, vm->sp - 1)) {
+		vm_print_err_type(vm, "__next expected to return bool, got %s.", vm_peektypename(vm, vm->sp - 1));
+		YASL_throw_err(S, YASL_TYPE_ERROR);
+	}
+	if (vm_peekbool(vm, vm->sp - 1)) {
+		vm_swaptop(vm);
+		vm_pop(vm);
+		return true;
+	}
+	vm_pop(vm);
+	vm_pop(vm);
+	return false;
+}
+
+/*
+ * Calls fn on the top of the stack, replacing it with the result.
+ */
+static void iter_call_fn(struct VM *vm, struct YASL_Object fn) {
+	vm_push(vm, fn);
+	vm_swaptop(vm);
+	vm_INIT_CALL_offset(vm, vm->sp - 1, 1);
+	vm_CALL_now(vm);
+}
+
+/*
+ * Pushes the next item of it and returns true, or returns false if there are none left.
+ */
+static bool iterator_advance(struct YASL_State *S, struct Iterator *it) {
+	struct VM *vm = &S->vm;
+	switch (it->kind) {
+	case ITER_LIST: {
+		struct YASL_List *list = YASL_GETLIST(it->obj);
+		if ((size_t)it->i >= list->count) {
+			return false;
+		}
+		vm_push(vm, list->items[it->i++]);
+		return true;
+	}
+	case ITER_STR: {
+		struct YASL_String *str = obj_getstr(&it->obj);
+		if ((size_t)it->i >= YASL_String_len(str)) {
+			return false;
+		}
+		const size_t i = (size_t)it->i++;
+		vm_pushstr(vm, YASL_String_new_substring(i, i + 1, str));
+		return true;
+	}
+	case ITER_TABLE: {
+		struct YASL_Table *table = YASL_GETTABLE(it->obj);
+		while ((size_t)it->i < table->size &&
+		       (table->items[it->i].key.type == Y_END || table->items[it->i].key.type == Y_UNDEF)) {
+			it->i++;
+		}
+		if ((size_t)it->i >= table->size) {
+			return false;
+		}
+		vm_push(vm, table->items[it->i++].key);
+		return true;
+	}
+	case ITER_NEXT:
+		return iter_call_next(S, it);
+	case ITER_RANGE:
+		if (it->step > 0 ? it->i >= it->stop : it->i <= it->stop) {
+			return false;
+		}
+		vm_pushint(vm, it->i);
+		it->i += it->step;
+		return true;
+	case ITER_MAP:
+		if (!iter_advance(S, it->sources[0])) {
+			return false;
+		}
+		iter_call_fn(vm, it->obj);
+		return true;
+	case ITER_FILTER:
+		while (iter_advance(S, it->sources[0])) {
+			vm_duptop(vm);
+			iter_call_fn(vm, it->obj);
+			struct YASL_Object keep = vm_pop(vm);
+			if (!isfalsey(&keep)) {
+				return true;
+			}
+			vm_pop(vm);
+		}
+		return false;
+	case ITER_TAKE:
+		if (it->i >= it->stop || !iter_advance(S, it->sources[0])) {
+			return false;
+		}
+		it->i++;
+		return true;
+	case ITER_ENUMERATE: {
+		if (!iter_advance(S, it->sources[0])) {
+			return false;
+		}
+		struct RC_UserData *pair = rcls_new_sized(2);
+		ud_setmt(pair, vm->builtins_htable[Y_LIST]);
+		YASL_List_append((struct YASL_List *)pair->data, YASL_INT(it->i++));
+		YASL_List_append((struct YASL_List *)pair->data, vm_pop(vm));
+		vm_pushlist(vm, pair);
+		return true;
+	}
+	case ITER_ZIP: {
+		if (it->num_sources == 0) {
+			return false;
+		}
+		for (size_t i = 0; i < it->num_sources; i++) {
+			if (!iter_advance(S, it->sources[i])) {
+				vm->sp -= (int)i;
+				return false;
+			}
+		}
+		struct RC_UserData *items = rcls_new_sized(it->num_sources);
+		ud_setmt(items, vm->builtins_htable[Y_LIST]);
+		for (size_t i = 0; i < it->num_sources; i++) {
+			YASL_List_append((struct YASL_List *)items->data, vm_peek(vm, vm->sp - (int)it->num_sources + 1 + (int)i));
+		}
+		vm->sp -= (int)it->num_sources;
+		vm_pushlist(vm, items);
+		return true;
+	}
+	case ITER_CHAIN:
+		for (; (size_t)it->i < it->num_sources; it->i++) {
+			if (iter_advance(S, it->sources[it->i])) {
+				return true;
+			}
+		}
+		return false;
+	}
+	return false;
+}
+
+static bool iter_advance(struct YASL_State *S, struct YASL_Object iterator) {
+	return iterator_advance(S, (struct Iterator *)YASL_GETUSERDATA(iterator)->data);
+}
+
+static struct Iterator *YASLX_checkniterator(struct YASL_State *S, const char *name, unsigned n) {
+	return (struct Iterator *)YASLX_checknuserdata(S, ITERATOR_NAME, name, n);
+}
+
+static int YASL_iter_iter(struct YASL_State *S) {
+	iter_from_top(S, "iter.iter");
+	return 1;
+}
+
+static int YASL_iter___iter(struct YASL_State *S) {
+	YASLX_checkniterator(S, "iter.__iter", 0);
+	return 1;
+}
+
+static int YASL_iter___next(struct YASL_State *S) {
+	struct Iterator *it = YASLX_checkniterator(S, "iter.__next", 0);
+	if (!iterator_advance(S, it)) {
+		YASL_pushbool(S, false);
+		return 1;
+	}
+	YASL_pushbool(S, true);
+	vm_swaptop(&S->vm);
+	return 2;
+}
+
+/*
+ * iter.range([start], stop, [step])
+ */
+static int YASL_iter_range(struct YASL_State *S) {
+	struct Iterator *it = iterator_push(S, ITER_RANGE, 0);
+	if (YASL_isnundef(S, 1)) {
+		it->stop = YASLX_checknint(S, "iter.range", 0);
+		return 1;
+	}
+	it->i = YASLX_checknint(S, "iter.range", 0);
+	it->stop = YASLX_checknint(S, "iter.range", 1);
+	if (!YASL_isnundef(S, 2)) {
+		it->step = YASLX_checknint(S, "iter.range", 2);
+	}
+	if (it->step == 0) {
+		vm_print_err_value(&S->vm, "%s expected nonzero step.", "iter.range");
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+	return 1;
+}
+
+/*
+ * Shared by the adapters with one source and an fn. The source is arg 0 and the fn arg 1.
+ */
+static int iter_adapt_fn(struct YASL_State *S, const enum IteratorKind kind, const char *name) {
+	struct VM *vm = &S->vm;
+	struct Iterator *it = iterator_push(S, kind, 1);
+	iterator_setobj(it, vm_peek(vm, vm->fp + 2));
+	iterator_setsources(S, it, vm->fp + 1, name);
+	return 1;
+}
+
+static int YASL_iter_map(struct YASL_State *S) {
+	return iter_adapt_fn(S, ITER_MAP, "iter.map");
+}
+
+static int YASL_iter_filter(struct YASL_State *S) {
+	return iter_adapt_fn(S, ITER_FILTER, "iter.filter");
+}
+
+static int YASL_iter_take(struct YASL_State *S) {
+	struct VM *vm = &S->vm;
+	yasl_int n = YASLX_checknint(S, "iter.take", 1);
+	struct Iterator *it = iterator_push(S, ITER_TAKE, 1);
+	it->stop = n;
+	iterator_setsources(S, it, vm->fp + 1, "iter.take");
+	return 1;
+}
+
+static int YASL_iter_enumerate(struct YASL_State *S) {
+	struct VM *vm = &S->vm;
+	struct Iterator *it = iterator_push(S, ITER_ENUMERATE, 1);
+	iterator_setsources(S, it, vm->fp + 1, "iter.enumerate");
+	return 1;
+}
+
+/*
+ * Shared by the variadic adapters, which read from all of their args.
+ */
+static int iter_adapt_all(struct YASL_State *S, const enum IteratorKind kind, const char *name) {
+	struct VM *vm = &S->vm;
+	yasl_int n = YASL_peekvargscount(S);
+	struct Iterator *it = iterator_push(S, kind, (size_t)n);
+	iterator_setsources(S, it, vm->sp - (int)n, name);
+	return 1;
+}
+
+static int YASL_iter_zip(struct YASL_State *S) {
+	return iter_adapt_all(S, ITER_ZIP, "iter.zip");
+}
+
+static int YASL_iter_chain(struct YASL_State *S) {
+	return iter_adapt_all(S, ITER_CHAIN, "iter.chain");
+}
+
+static int YASL_iter_tolist(struct YASL_State *S) {
+	struct VM *vm = &S->vm;
+	iter_from_top(S, "iter.tolist");
+	struct YASL_Object iterator = vm_peek(vm);
+	struct RC_UserData *list = rcls_new();
+	ud_setmt(list, vm->builtins_htable[Y_LIST]);
+	vm_pushlist(vm, list);
+	while (iter_advance(S, iterator)) {
+		YASL_List_append((struct YASL_List *)list->data, vm_pop(vm));
+	}
+	return 1;
+}
+
+int YASL_decllib_iter(struct YASL_State *S) {
+	YASL_pushtable(S);
+	YASL_registermt(S, ITERATOR_NAME);
+
+	YASL_loadmt(S, ITERATOR_NAME);
+	YASL_pushlit(S, "__iter");
+	YASL_pushcfunction(S, YASL_iter___iter, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__next");
+	YASL_pushcfunction(S, YASL_iter___next, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "map");
+	YASL_pushcfunction(S, YASL_iter_map, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "filter");
+	YASL_pushcfunction(S, YASL_iter_filter, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "take");
+	YASL_pushcfunction(S, YASL_iter_take, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "enumerate");
+	YASL_pushcfunction(S, YASL_iter_enumerate, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "zip");
+	YASL_pushcfunction(S, YASL_iter_zip, -1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "chain");
+	YASL_pushcfunction(S, YASL_iter_chain, -1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "tolist");
+	YASL_pushcfunction(S, YASL_iter_tolist, 1);
+	YASL_tableset(S);
+	YASL_pop(S);
+
+	YASL_declglobal(S, "iter");
+	YASL_pushtable(S);
+	YASL_setglobal(S, "iter");
+
+	YASL_loadglobal(S, "iter");
+	YASL_pushlit(S, "iter");
+	YASL_pushcfunction(S, YASL_iter_iter, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "range");
+	YASL_pushcfunction(S, YASL_iter_range, 3);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "map");
+	YASL_pushcfunction(S, YASL_iter_map, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "filter");
+	YASL_pushcfunction(S, YASL_iter_filter, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "take");
+	YASL_pushcfunction(S, YASL_iter_take, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "enumerate");
+	YASL_pushcfunction(S, YASL_iter_enumerate, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "zip");
+	YASL_pushcfunction(S, YASL_iter_zip, -1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "chain");
+	YASL_pushcfunction(S, YASL_iter_chain, -1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "tolist");
+	YASL_pushcfunction(S, YASL_iter_tolist, 1);
+	YASL_tableset(S);
+	YASL_pop(S);
+
+	return YASL_SUCCESS;
+}
@@ -0,0 +1,8 @@
+#ifndef YASL_YASL_STD_ITER_H_
+#define YASL_YASL_STD_ITER_H_
+
+#include "yasl.h"
+
+int YASL_decllib_iter(struct YASL_State *S);
+
+#endif
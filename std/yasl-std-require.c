@@ -58,6 +58,7 @@ int YASL_require(struct YASL_State *S) {
 	// Load Standard Libraries
 	YASLX_decllibs(Ss);
 
+	vm_clear_type_mts(&Ss->vm);
 	YASL_Table_del(Ss->vm.metatables);
 	Ss->vm.metatables = S->vm.metatables;
 
@@ -82,6 +83,9 @@ int YASL_require(struct YASL_State *S) {
 	}
 	S->vm.headers_size = new_headers_size;
 
+	// The module may have registered metatables in the table S shares with it.
+	vm_clear_type_mts(&S->vm);
+	vm_clear_type_mts(&Ss->vm);
 	Ss->vm.globals = NULL;
 	Ss->vm.metatables = NULL;
 
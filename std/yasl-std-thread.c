@@ -0,0 +1,747 @@
+#include "yasl-std-thread.h"
+
+#include "interpreter/alloc.h"
+#include "interpreter/closure.h"
+#include "interpreter/copy.h"
+#include "util/atomic.h"
+#include "util/thread.h"
+#include "yasl_aux.h"
+#include "yasl_state.h"
+
+static const char *const THREAD_NAME = "thread.thread";
+static const char CHANNEL_NAME[] = "thread.channel";
+
+/*
+ * Each thread runs in a state of its own, so nothing but strings and channels is ever shared between threads. Lists,
+ * tables and the collections' userdata are copied when they are sent (see copy.h); strings are not, but are switched
+ * over to atomic reference counts. Functions point into the bytecode of the state that defined them, so they can only be sent to threads that state
+ * starts, which it outlives. Closures are sent with copies of the variables they capture.
+ */
+
+struct Channel;
+static struct Channel *channel_inc_ref(struct Channel *channel);
+static void channel_dec_ref(void *channel);
+
+static void *channel_share(void *channel) {
+	return channel_inc_ref((struct Channel *)channel);
+}
+
+// Channels are shared by their copies, so that threads can talk over them.
+static const struct CopyRules send_rules = { false, false, CHANNEL_NAME, channel_share, channel_dec_ref };
+static const struct CopyRules send_fns_rules = { false, true, CHANNEL_NAME, channel_share, channel_dec_ref };
+
+static const struct CopyRules *thread_rules(bool fns) {
+	return fns ? &send_fns_rules : &send_rules;
+}
+
+/*
+ * A value copied out of one state and not yet received by another, so it belongs to no thread in particular.
+ */
+struct Message {
+	struct YASL_Object value;
+	struct YASL_List *fixups;
+};
+
+static void message_init(struct Message *const msg, struct YASL_Object v, bool fns) {
+	struct Copier c;
+	copier_init(&c, thread_rules(fns), NULL, true);
+	msg->value = copier_copy(&c, v);
+	inc_ref(&msg->value);
+	msg->fixups = copier_finish(&c, NULL);
+}
+
+/*
+ * Pushes the value onto vm's stack, leaving msg empty.
+ */
+static void message_receive(struct VM *const vm, struct Message *const msg) {
+	copy_fixups_apply(vm, msg->fixups);
+	msg->fixups = NULL;
+	vm_push(vm, msg->value);
+	dec_ref(&msg->value);
+	msg->value = YASL_UNDEF();
+}
+
+static void message_cleanup(struct Message *const msg) {
+	if (msg->fixups) YASL_List_del_data(msg->fixups);
+	msg->fixups = NULL;
+	dec_ref(&msg->value);
+	msg->value = YASL_UNDEF();
+}
+
+static void copy_checkn_throwing(struct YASL_State *S, const struct YASL_Object *const values, const size_t n,
+				 bool fns, const char *const name) {
+	const char *bad = copy_checkn(thread_rules(fns), values, n);
+	if (bad) {
+		vm_print_err_type(&S->vm, "%s cannot send values of type %s.", name, bad);
+		YASL_throw_err(S, YASL_TYPE_ERROR);
+	}
+}
+
+/*
+ * A queue of messages that any number of states, on any threads, may hold a reference to.
+ */
+struct Channel {
+	volatile size_t refs;
+	yasl_mutex lock;
+	yasl_cond nonempty;
+	yasl_cond nonfull;
+	bool closed;
+	size_t capacity;   // most messages held at once, or 0 for no limit
+	size_t head;
+	size_t count;
+	size_t size;
+	struct Message *queue;
+};
+
+static struct Channel *channel_new(const size_t capacity) {
+	struct Channel *channel = (struct Channel *)malloc(sizeof(struct Channel));
+	channel->refs = 1;
+	mutex_init(&channel->lock);
+	cond_init(&channel->nonempty);
+	cond_init(&channel->nonfull);
+	channel->closed = false;
+	channel->capacity = capacity;
+	channel->head = 0;
+	channel->count = 0;
+	channel->size = capacity ? capacity : LIST_BASESIZE;
+	channel->queue = (struct Message *)malloc(sizeof(struct Message) * channel->size);
+	return channel;
+}
+
+static struct Channel *channel_inc_ref(struct Channel *channel) {
+	atomic_inc(&channel->refs);
+	return channel;
+}
+
+static void channel_dec_ref(void *ptr) {
+	struct Channel *channel = (struct Channel *)ptr;
+	if (atomic_dec(&channel->refs) > 0) {
+		return;
+	}
+	for (size_t i = 0; i < channel->count; i++) {
+		message_cleanup(channel->queue + (channel->head + i) % channel->size);
+	}
+	free(channel->queue);
+	cond_destroy(&channel->nonfull);
+	cond_destroy(&channel->nonempty);
+	mutex_destroy(&channel->lock);
+	free(channel);
+}
+
+// Must hold channel->lock.
+static void channel_grow(struct Channel *channel) {
+	struct Message *queue = (struct Message *)malloc(sizeof(struct Message) * channel->size * 2);
+	for (size_t i = 0; i < channel->count; i++) {
+		queue[i] = channel->queue[(channel->head + i) % channel->size];
+	}
+	free(channel->queue);
+	channel->queue = queue;
+	channel->head = 0;
+	channel->size *= 2;
+}
+
+static struct Channel *YASLX_checknchannel(struct YASL_State *S, const char *name, unsigned n) {
+	return (struct Channel *)YASLX_checknuserdata(S, CHANNEL_NAME, name, n);
+}
+
+static void YASL_pushchannel(struct YASL_State *S, struct Channel *channel) {
+	YASL_pushuserdata(S, channel, CHANNEL_NAME, channel_dec_ref);
+	YASL_loadmt(S, CHANNEL_NAME);
+	YASL_setmt(S);
+}
+
+/*
+ * thread.channel([capacity])
+ */
+static int YASL_thread_channel(struct YASL_State *S) {
+	size_t capacity = 0;
+	if (!YASL_isundef(S)) {
+		yasl_int n = YASLX_checknint(S, "thread.channel", 0);
+		if (n <= 0) {
+			vm_print_err_value(&S->vm, "%s expected positive capacity, got %" PRId64 ".", "thread.channel", n);
+			YASL_throw_err(S, YASL_VALUE_ERROR);
+		}
+		capacity = (size_t)n;
+	}
+
+	YASL_pushchannel(S, channel_new(capacity));
+	return 1;
+}
+
+/*
+ * Blocks while the channel is full.
+ */
+static int YASL_thread_channel_send(struct YASL_State *S) {
+	struct Channel *channel = YASLX_checknchannel(S, "channel.send", 0);
+	copy_checkn_throwing(S, vm_peek_p(&S->vm), 1, false, "channel.send");
+
+	// The copy is made before taking the lock, so receivers aren't held up by it.
+	struct Message msg;
+	message_init(&msg, vm_peek(&S->vm), false);
+
+	mutex_lock(&channel->lock);
+	while (channel->capacity && channel->count >= channel->capacity && !channel->closed) {
+		cond_wait(&channel->nonfull, &channel->lock);
+	}
+	if (channel->closed) {
+		mutex_unlock(&channel->lock);
+		message_cleanup(&msg);
+		vm_print_err_value(&S->vm, "%s cannot send on a closed channel.", "channel.send");
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+	if (channel->count == channel->size) {
+		channel_grow(channel);
+	}
+	channel->queue[(channel->head + channel->count++) % channel->size] = msg;
+	cond_signal(&channel->nonempty);
+	mutex_unlock(&channel->lock);
+
+	YASL_pop(S);
+	return 1;
+}
+
+/*
+ * Blocks until there is a message, and returns undef once the channel is closed and empty.
+ */
+static int YASL_thread_channel_recv(struct YASL_State *S) {
+	struct Channel *channel = YASLX_checknchannel(S, "channel.recv", 0);
+
+	mutex_lock(&channel->lock);
+	while (!channel->count && !channel->closed) {
+		cond_wait(&channel->nonempty, &channel->lock);
+	}
+	if (!channel->count) {
+		mutex_unlock(&channel->lock);
+		YASL_pushundef(S);
+		return 1;
+	}
+	struct Message msg = channel->queue[channel->head];
+	channel->head = (channel->head + 1) % channel->size;
+	channel->count--;
+	cond_signal(&channel->nonfull);
+	mutex_unlock(&channel->lock);
+
+	message_receive(&S->vm, &msg);
+	return 1;
+}
+
+/*
+ * Messages already sent can still be received, but no more can be sent.
+ */
+static int YASL_thread_channel_close(struct YASL_State *S) {
+	struct Channel *channel = YASLX_checknchannel(S, "channel.close", 0);
+
+	mutex_lock(&channel->lock);
+	channel->closed = true;
+	cond_broadcast(&channel->nonempty);
+	cond_broadcast(&channel->nonfull);
+	mutex_unlock(&channel->lock);
+	return 0;
+}
+
+static int YASL_thread_channel___len(struct YASL_State *S) {
+	struct Channel *channel = YASLX_checknchannel(S, "channel.__len", 0);
+
+	mutex_lock(&channel->lock);
+	const size_t count = channel->count;
+	mutex_unlock(&channel->lock);
+
+	YASL_pushint(S, (yasl_int)count);
+	return 1;
+}
+
+/*
+ * Makes a state for running S's functions on another thread. It has the standard libraries and a copy of S's
+ * constants, and of whichever of S's other globals can be sent. It shares S's bytecode, so S must outlive it.
+ */
+static struct YASL_State *thread_newstate(struct YASL_State *S, struct Copier *const c) {
+	struct YASL_State *C = YASL_newstate_bb("", 0);
+	YASLX_decllibs(C);
+	YASL_setprinterr_tostr(C);
+
+	struct VM *const vm = &C->vm;
+	// Errors report lines in S's code, with the call that started the thread as the outermost one.
+	vm->code = S->vm.code;
+	vm->pc = S->vm.pc;
+
+	vm->num_constants = S->vm.num_constants;
+	vm->constants = (struct YASL_Object *)malloc(sizeof(struct YASL_Object) * vm->num_constants);
+	for (int64_t i = 0; i < vm->num_constants; i++) {
+		vm->constants[i] = copier_copy(c, S->vm.constants[i]);
+		inc_ref(vm->constants + i);
+	}
+
+	FOR_TABLE(i, item, S->vm.globals) {
+		if (YASL_Table_search(vm->globals, item->key).type != Y_END || copy_checkn(&send_fns_rules, &item->value, 1)) {
+			continue;
+		}
+		YASL_Table_insert_fast(vm->globals, copier_copy(c, item->key), copier_copy(c, item->value));
+	}
+
+	return C;
+}
+
+/*
+ * The error C stopped with, as printed to its error output. Must be freed.
+ */
+static char *thread_geterr(struct YASL_State *C) {
+	YASL_loadprinterr(C);
+	return YASL_popcstr(C);
+}
+
+/*
+ * Reports an error from a thread in S, as if it had happened in fn_name. Frees err.
+ */
+static YASL_NORETURN void thread_rethrow(struct YASL_State *S, char *err, int status, const char *const fn_name) {
+	YASL_print_err(S, "%sIn %s", err, fn_name);
+	free(err);
+	YASL_throw_err(S, status);
+}
+
+/*
+ * Copies the top n values of C's stack onto S's.
+ */
+static void thread_copyresults(struct YASL_State *S, struct YASL_State *C, const int n, bool fns) {
+	struct VM *const from = &C->vm;
+	struct Copier c;
+	copier_init(&c, thread_rules(fns), NULL, false);
+	for (int i = n - 1; i >= 0; i--) {
+		vm_push(&S->vm, copier_copy(&c, vm_peek(from, from->sp - i)));
+	}
+	copier_finish(&c, &S->vm);
+}
+
+struct Thread {
+	yasl_thread handle;
+	bool joined;
+	bool module;             // whether it runs a module, rather than one of its parent's functions
+	struct YASL_State *S;    // the state the thread runs in
+	struct RC_UserData *args;  // for modules, the arguments to call the export with
+	int base;                // where the function, and then its results, are on S's stack
+	int nargs;
+	int status;
+};
+
+static THREAD_RETURN thread_main(void *arg) {
+	struct Thread *t = (struct Thread *)arg;
+	struct VM *const vm = &t->S->vm;
+
+	if (t->module) {
+		t->status = YASL_execute(t->S);
+		if (t->status != YASL_MODULE_SUCCESS) {
+			t->base = vm->sp + 1;
+			if (t->status == YASL_SUCCESS) YASL_pushundef(t->S);
+			return THREAD_RESULT;
+		}
+		t->status = YASL_SUCCESS;
+		t->base = vm->sp;
+		if (!vm_isfn(vm) && !vm_iscfn(vm) && !vm_isclosure(vm)) {
+			return THREAD_RESULT;
+		}
+		FOR_LIST(i, arg, (struct YASL_List *)t->args->data) {
+			vm_push(vm, arg);
+		}
+	}
+
+	t->status = vm_call_protected(vm, t->nargs);
+	return THREAD_RESULT;
+}
+
+static void thread_del(void *ptr) {
+	struct Thread *t = (struct Thread *)ptr;
+	if (!t->joined) {
+		thread_join(t->handle);
+	}
+	if (t->args) {
+		struct YASL_Object args = YASL_LIST(t->args);
+		dec_ref(&args);
+	}
+	YASL_delstate(t->S);
+	free(t);
+}
+
+/*
+ * thread.spawn(fn, ...)
+ * thread.spawn(path, ...)
+ *
+ * Runs fn(...) on a new thread, in a state of its own. fn may use its module's globals and the variables it captures,
+ * but gets copies of them. A module given by path is run on a new thread instead, and whatever it exports is called
+ * with the arguments.
+ */
+static int YASL_thread_spawn(struct YASL_State *S) {
+	struct VM *const vm = &S->vm;
+	const int nargs = (int)YASL_peekvargscount(S);
+	const struct YASL_Object *const args = vm->stack + vm->sp - nargs + 1;
+	const struct YASL_Object f = vm_peek(vm, vm->fp + 1);
+
+	if (f.type != Y_STR && f.type != Y_FN && f.type != Y_CFN && f.type != Y_CLOSURE) {
+		YASLX_print_err_bad_arg_type(S, "thread.spawn", 0, "fn or str", YASL_peekntypename(S, 0));
+		YASL_throw_err(S, YASL_TYPE_ERROR);
+	}
+	const bool module = f.type == Y_STR;
+	if (!module) {
+		copy_checkn_throwing(S, &f, 1, true, "thread.spawn");
+	}
+	copy_checkn_throwing(S, args, nargs, !module, "thread.spawn");
+
+	struct YASL_State *C;
+	struct Copier c;
+	copier_init(&c, thread_rules(!module), NULL, true);
+	if (module) {
+		const size_t len = YASL_String_len(f.value.sval);
+		char *path = (char *)malloc(len + 1);
+		memcpy(path, YASL_String_chars(f.value.sval), len);
+		path[len] = '\0';
+		C = YASL_newstate(path);
+		if (!C) {
+			copier_finish(&c, NULL);
+			vm_print_err_value(vm, "%s could not open module %s.", "thread.spawn", path);
+			free(path);
+			YASL_throw_err(S, YASL_VALUE_ERROR);
+		}
+		free(path);
+		YASLX_decllibs(C);
+		YASL_setprinterr_tostr(C);
+	} else {
+		C = thread_newstate(S, &c);
+		vm_push(&C->vm, copier_copy(&c, f));
+	}
+
+	// A module's own code runs first, so its arguments are kept to one side until then.
+	struct RC_UserData *margs = NULL;
+	if (module) {
+		margs = rcls_new_sized(nargs ? nargs : LIST_BASESIZE);
+		rc_inc(margs->rc);
+	}
+	for (int i = 0; i < nargs; i++) {
+		if (module) {
+			YASL_List_append((struct YASL_List *)margs->data, copier_copy(&c, args[i]));
+		} else {
+			vm_push(&C->vm, copier_copy(&c, args[i]));
+		}
+	}
+	copier_finish(&c, &C->vm);
+
+	struct Thread *t = (struct Thread *)malloc(sizeof(struct Thread));
+	t->joined = false;
+	t->module = module;
+	t->S = C;
+	t->args = margs;
+	t->base = 0;
+	t->nargs = nargs;
+	t->status = YASL_SUCCESS;
+	if (!thread_start(&t->handle, thread_main, t)) {
+		t->joined = true;
+		thread_del(t);
+		vm_print_err(vm, "Error: %s could not start a thread.", "thread.spawn");
+		YASL_throw_err(S, YASL_ERROR);
+	}
+
+	YASL_pushuserdata(S, t, THREAD_NAME, thread_del);
+	YASL_loadmt(S, THREAD_NAME);
+	YASL_setmt(S);
+	return 1;
+}
+
+/*
+ * Waits for the thread to finish, and returns whatever its function returned. Errors in the thread are raised again
+ * here.
+ */
+static int YASL_thread_thread_join(struct YASL_State *S) {
+	struct Thread *t = (struct Thread *)YASLX_checknuserdata(S, THREAD_NAME, "thread.join", 0);
+	if (t->joined) {
+		vm_print_err_value(&S->vm, "%s expected a thread that has not been joined.", "thread.join");
+		YASL_throw_err(S, YASL_VALUE_ERROR);
+	}
+
+	thread_join(t->handle);
+	t->joined = true;
+
+	struct YASL_State *const C = t->S;
+	if (t->status != YASL_SUCCESS) {
+		thread_rethrow(S, thread_geterr(C), t->status, "thread.join");
+	}
+
+	const int n = C->vm.sp - t->base + 1;
+	copy_checkn_throwing(S, C->vm.stack + t->base, n, !t->module, "thread.join");
+	thread_copyresults(S, C, n, !t->module);
+	return n;
+}
+
+/*
+ * Splits the indices of the list among the workers. Each takes items from the front of its own range, and when that
+ * runs out, steals the back half of another's.
+ */
+struct Worker {
+	struct Pool *pool;
+	struct YASL_State *S;
+	yasl_thread handle;
+	volatile int lock;      // guards next and end, which other workers change when they steal
+	size_t next;
+	size_t end;
+	struct YASL_Object fn;
+	struct RC_UserData *results;  // list of the results this worker got, in order
+	struct YASL_List *indices;    // the index of each result, as ints
+	int status;
+};
+
+struct Pool {
+	struct Message *items;
+	struct Worker *workers;
+	size_t num_workers;
+	volatile size_t failed;
+};
+
+static bool worker_steal(struct Worker *const w, size_t *const index) {
+	struct Pool *const pool = w->pool;
+	const size_t self = (size_t)(w - pool->workers);
+	for (size_t k = 1; k < pool->num_workers; k++) {
+		struct Worker *victim = pool->workers + (self + k) % pool->num_workers;
+		spin_lock(&victim->lock);
+		const size_t left = victim->end - victim->next;
+		if (!left) {
+			spin_unlock(&victim->lock);
+			continue;
+		}
+		const size_t end = victim->end;
+		const size_t mid = end - (left + 1) / 2;
+		victim->end = mid;
+		spin_unlock(&victim->lock);
+
+		spin_lock(&w->lock);
+		w->next = mid + 1;
+		w->end = end;
+		spin_unlock(&w->lock);
+		*index = mid;
+		return true;
+	}
+	return false;
+}
+
+static bool worker_take(struct Worker *const w, size_t *const index) {
+	spin_lock(&w->lock);
+	if (w->next < w->end) {
+		*index = w->next++;
+		spin_unlock(&w->lock);
+		return true;
+	}
+	spin_unlock(&w->lock);
+	return worker_steal(w, index);
+}
+
+static THREAD_RETURN worker_main(void *arg) {
+	struct Worker *const w = (struct Worker *)arg;
+	struct VM *const vm = &w->S->vm;
+	size_t index;
+
+	while (!atomic_load(&w->pool->failed) && worker_take(w, &index)) {
+		const int base = vm->sp + 1;
+		vm_push(vm, w->fn);
+		message_receive(vm, w->pool->items + index);
+		w->status = vm_call_protected(vm, 1);
+		if (w->status != YASL_SUCCESS) {
+			atomic_inc(&w->pool->failed);
+			break;
+		}
+		YASL_List_append((struct YASL_List *)w->results->data, vm->sp >= base ? vm_peek(vm, base) : YASL_UNDEF());
+		YASL_List_append(w->indices, YASL_INT((yasl_int)index));
+		while (vm->sp >= base) {
+			vm_pop(vm);
+		}
+	}
+	return THREAD_RESULT;
+}
+
+static void pool_cleanup(struct Pool *const pool, const size_t n) {
+	for (size_t i = 0; i < pool->num_workers; i++) {
+		struct Worker *w = pool->workers + i;
+		struct YASL_Object results = YASL_LIST(w->results);
+		dec_ref(&results);
+		YASL_List_del_data(w->indices);
+		dec_ref(&w->fn);
+		YASL_delstate(w->S);
+	}
+	for (size_t i = 0; i < n; i++) {
+		message_cleanup(pool->items + i);
+	}
+	free(pool->items);
+	free(pool->workers);
+}
+
+/*
+ * thread.parallel_map(fn, ls, [n])
+ *
+ * Returns the list of fn(x) for each x in ls, calling fn on n threads (by default, one for each CPU).
+ */
+static int YASL_thread_parallel_map(struct YASL_State *S) {
+	struct VM *const vm = &S->vm;
+	size_t num_workers = thread_numcpus();
+	if (!YASL_isundef(S)) {
+		yasl_int n = YASLX_checknint(S, "thread.parallel_map", 2);
+		if (n <= 0) {
+			vm_print_err_value(vm, "%s expected positive number of threads, got %" PRId64 ".",
+					   "thread.parallel_map", n);
+			YASL_throw_err(S, YASL_VALUE_ERROR);
+		}
+		num_workers = (size_t)n;
+	}
+	if (!YASL_isnlist(S, 1)) {
+		YASLX_print_err_bad_arg_type(S, "thread.parallel_map", 1, "list", YASL_peekntypename(S, 1));
+		YASL_throw_err(S, YASL_TYPE_ERROR);
+	}
+	const struct YASL_Object f = vm_peek(vm, vm->fp + 1);
+	if (f.type != Y_FN && f.type != Y_CFN && f.type != Y_CLOSURE) {
+		YASLX_print_err_bad_arg_type(S, "thread.parallel_map", 0, "fn", YASL_peekntypename(S, 0));
+		YASL_throw_err(S, YASL_TYPE_ERROR);
+	}
+	copy_checkn_throwing(S, &f, 1, true, "thread.parallel_map");
+	const struct YASL_List *const ls = (struct YASL_List *)YASL_peeknuserdata(S, 1);
+	copy_checkn_throwing(S, ls->items, ls->count, true, "thread.parallel_map");
+
+	const size_t n = ls->count;
+	if (num_workers > n) num_workers = n;
+
+	struct Pool pool;
+	pool.items = (struct Message *)malloc(sizeof(struct Message) * (n ? n : 1));
+	for (size_t i = 0; i < n; i++) {
+		message_init(pool.items + i, ls->items[i], true);
+	}
+	pool.workers = (struct Worker *)malloc(sizeof(struct Worker) * (num_workers ? num_workers : 1));
+	pool.num_workers = num_workers;
+	pool.failed = 0;
+
+	for (size_t i = 0; i < num_workers; i++) {
+		struct Worker *w = pool.workers + i;
+		struct Copier c;
+		copier_init(&c, &send_fns_rules, NULL, true);
+		w->pool = &pool;
+		w->S = thread_newstate(S, &c);
+		w->fn = copier_copy(&c, f);
+		inc_ref(&w->fn);
+		// The worker fills these in on its own thread, so they are made along with the copies.
+		w->results = rcls_new();
+		rc_inc(w->results->rc);
+		w->indices = YASL_List_new_sized(LIST_BASESIZE);
+		copier_finish(&c, &w->S->vm);
+		w->lock = 0;
+		w->next = n * i / num_workers;
+		w->end = n * (i + 1) / num_workers;
+		w->status = YASL_SUCCESS;
+	}
+
+	size_t started = 0;
+	while (started < num_workers && thread_start(&pool.workers[started].handle, worker_main, pool.workers + started)) {
+		started++;
+	}
+	if (started < num_workers) {
+		pool.failed = 1;
+	}
+	for (size_t i = 0; i < started; i++) {
+		thread_join(pool.workers[i].handle);
+	}
+
+	for (size_t i = 0; i < num_workers; i++) {
+		struct Worker *w = pool.workers + i;
+		if (w->status != YASL_SUCCESS) {
+			const int status = w->status;
+			char *err = thread_geterr(w->S);
+			pool_cleanup(&pool, n);
+			thread_rethrow(S, err, status, "thread.parallel_map");
+		}
+	}
+	if (started < num_workers) {
+		pool_cleanup(&pool, n);
+		vm_print_err(vm, "Error: %s could not start a thread.", "thread.parallel_map");
+		YASL_throw_err(S, YASL_ERROR);
+	}
+
+	struct RC_UserData *result = rcls_new_sized(n ? n : LIST_BASESIZE);
+	ud_setmt(result, vm->builtins_htable[Y_LIST]);
+	vm_pushlist(vm, result);
+	struct YASL_List *const to = (struct YASL_List *)result->data;
+	for (size_t i = 0; i < n; i++) {
+		YASL_List_append(to, YASL_UNDEF());
+	}
+	for (size_t i = 0; i < num_workers; i++) {
+		struct Worker *w = pool.workers + i;
+		const struct YASL_List *const results = (struct YASL_List *)w->results->data;
+		const char *bad = copy_checkn(&send_fns_rules, results->items, results->count);
+		if (bad) {
+			pool_cleanup(&pool, n);
+			vm_print_err_type(vm, "%s cannot send values of type %s.", "thread.parallel_map", bad);
+			YASL_throw_err(S, YASL_TYPE_ERROR);
+		}
+		struct Copier c;
+		copier_init(&c, &send_fns_rules, NULL, false);
+		FOR_LIST(j, index, w->indices) {
+			struct YASL_Object *slot = to->items + obj_getint(&index);
+			*slot = copier_copy(&c, results->items[j]);
+			inc_ref(slot);
+		}
+		copier_finish(&c, vm);
+	}
+
+	pool_cleanup(&pool, n);
+	return 1;
+}
+
+static int YASL_thread_cpus(struct YASL_State *S) {
+	YASL_pushint(S, (yasl_int)thread_numcpus());
+	return 1;
+}
+
+int YASL_decllib_thread(struct YASL_State *S) {
+	YASL_pushtable(S);
+	YASL_registermt(S, THREAD_NAME);
+
+	YASL_loadmt(S, THREAD_NAME);
+	YASL_pushlit(S, "join");
+	YASL_pushcfunction(S, YASL_thread_thread_join, 1);
+	YASL_tableset(S);
+	YASL_pop(S);
+
+	YASL_pushtable(S);
+	YASL_registermt(S, CHANNEL_NAME);
+
+	YASL_loadmt(S, CHANNEL_NAME);
+	YASL_pushlit(S, "send");
+	YASL_pushcfunction(S, YASL_thread_channel_send, 2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "recv");
+	YASL_pushcfunction(S, YASL_thread_channel_recv, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "close");
+	YASL_pushcfunction(S, YASL_thread_channel_close, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "__len");
+	YASL_pushcfunction(S, YASL_thread_channel___len, 1);
+	YASL_tableset(S);
+	YASL_pop(S);
+
+	YASL_declglobal(S, "thread");
+	YASL_pushtable(S);
+	YASL_setglobal(S, "thread");
+
+	YASL_loadglobal(S, "thread");
+	YASL_pushlit(S, "spawn");
+	YASL_pushcfunction(S, YASL_thread_spawn, -2);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "channel");
+	YASL_pushcfunction(S, YASL_thread_channel, 1);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "parallel_map");
+	YASL_pushcfunction(S, YASL_thread_parallel_map, 3);
+	YASL_tableset(S);
+
+	YASL_pushlit(S, "cpus");
+	YASL_pushcfunction(S, YASL_thread_cpus, 0);
+	YASL_tableset(S);
+	YASL_pop(S);
+
+	return YASL_SUCCESS;
+}
@@ -0,0 +1,8 @@
+#ifndef YASL_YASL_STD_THREAD_H_
+#define YASL_YASL_STD_THREAD_H_
+
+#include "yasl.h"
+
+int YASL_decllib_thread(struct YASL_State *S);
+
+#endif
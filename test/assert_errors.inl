@@ -13,4 +13,6 @@ static const char *assert_errors[] = {
   "test/errors/assert/table.yasl",
   "test/errors/assert/undef.yasl",
   "test/errors/assert/while.yasl",
+  "test/errors/assert/thread_join.yasl",
+  "test/errors/assert/coroutine.yasl",
 };
@@ -142,6 +142,8 @@ static const char *inputs[] = {
   "test/inputs/fn/forward.yasl",
   "test/inputs/fn/functional.yasl",
   "test/inputs/fn/spread.yasl",
+  "test/inputs/fn/inline.yasl",
+  "test/inputs/fn/tailcall.yasl",
   "test/inputs/list/count.yasl",
   "test/inputs/list/join.yasl",
   "test/inputs/list/insert.yasl",
@@ -159,8 +161,10 @@ static const char *inputs[] = {
   "test/inputs/list/__len.yasl",
   "test/inputs/list/__eq.yasl",
   "test/inputs/list/sort.yasl",
+  "test/inputs/list/sort_key.yasl",
   "test/inputs/list/clear.yasl",
   "test/inputs/list/extend.yasl",
+  "test/inputs/list/extend_method.yasl",
   "test/inputs/list/__set.yasl",
   "test/inputs/list/search.yasl",
   "test/inputs/require/require.yasl",
@@ -173,6 +177,7 @@ static const char *inputs[] = {
   "test/inputs/collections/list.yasl",
   "test/inputs/collections/contains.yasl",
   "test/inputs/dead_code_elimination.yasl",
+  "test/inputs/max_locals.yasl",
   "test/inputs/match/guard/last_guard.yasl",
   "test/inputs/match/guard/basic_guard.yasl",
   "test/inputs/match/guard/list_guard.yasl",
@@ -202,4 +207,31 @@ static const char *inputs[] = {
   "test/inputs/match/list/list_let.yasl",
   "test/inputs/match/list/const_vlist.yasl",
   "test/inputs/match/float_smallint.yasl",
+  "test/inputs/collections/intarray.yasl",
+  "test/inputs/collections/array_iter.yasl",
+  "test/inputs/collections/floatarray.yasl",
+  "test/inputs/collections/bytearray.yasl",
+  "test/inputs/list/slice_shared.yasl",
+  "test/inputs/iter/adapters.yasl",
+  "test/inputs/iter/protocol.yasl",
+  "test/inputs/iter/zip_empty.yasl",
+  "test/inputs/range/loops.yasl",
+  "test/inputs/range/methods.yasl",
+  "test/inputs/collections/deque.yasl",
+  "test/inputs/collections/deque_iter.yasl",
+  "test/inputs/collections/heap.yasl",
+  "test/inputs/collections/set_update.yasl",
+  "test/inputs/collections/sorted.yasl",
+  "test/inputs/list/index.yasl",
+  "test/inputs/list/resize.yasl",
+  "test/inputs/list/fill.yasl",
+  "test/inputs/list/rotate.yasl",
+  "test/inputs/list/swap.yasl",
+  "test/inputs/thread/spawn.yasl",
+  "test/inputs/thread/channel.yasl",
+  "test/inputs/thread/parallel_map.yasl",
+  "test/inputs/coroutine/resume.yasl",
+  "test/inputs/coroutine/generator.yasl",
+  "test/inputs/coroutine/nested.yasl",
+  "test/inputs/coroutine/stack.yasl",
 };
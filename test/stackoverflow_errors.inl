@@ -1,4 +1,5 @@
 static const char *stackoverflow_errors[] = {
   "test/errors/stackoverflow/fib.yasl",
   "test/errors/stackoverflow/list_eq.yasl",
+  "test/errors/stackoverflow/coroutine.yasl",
 };
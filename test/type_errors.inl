@@ -97,6 +97,9 @@ static const char *type_errors[] = {
   "test/errors/type/list/reverse.yasl",
   "test/errors/type/list/search.yasl",
   "test/errors/type/list/sort.yasl",
+  "test/errors/type/list/sort2.yasl",
+  "test/errors/type/list/sort3.yasl",
+  "test/errors/type/list/sort4.yasl",
   "test/errors/type/list/tostr.yasl",
   "test/errors/type/math/abs.yasl",
   "test/errors/type/math/acos.yasl",
@@ -198,4 +201,20 @@ static const char *type_errors[] = {
   "test/errors/type/unary_operators/__pos.yasl",
   "test/errors/type/undef/tobool.yasl",
   "test/errors/type/undef/tostr.yasl",
+  "test/errors/type/collections/array/__slice.yasl",
+  "test/errors/type/collections/array/add.yasl",
+  "test/errors/type/collections/array/intarray.yasl",
+  "test/errors/type/collections/array/push.yasl",
+  "test/errors/type/iter/__next.yasl",
+  "test/errors/type/iter/map.yasl",
+  "test/errors/type/range/range.yasl",
+  "test/errors/type/collections/deque/deque.yasl",
+  "test/errors/type/collections/heap/heap.yasl",
+  "test/errors/type/collections/sorted/sortedset.yasl",
+  "test/errors/type/collections/sorted/range.yasl",
+  "test/errors/type/list/extend.yasl",
+  "test/errors/type/list/rotate.yasl",
+  "test/errors/type/thread/send_file.yasl",
+  "test/errors/type/thread/send_fn.yasl",
+  "test/errors/type/coroutine/new.yasl",
 };
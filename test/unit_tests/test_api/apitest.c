@@ -5,6 +5,13 @@
 #include "fntest.h"
 #include "tablenexttest.h"
 #include "listitertest.h"
+#include "programtest.h"
+#include "clonetest.h"
+#include "resumetest.h"
+#include "budgettest.h"
+#include "memtest.h"
+#include "bulktest.h"
+#include "objecttest.h"
 
 SETUP_YATS();
 
@@ -17,5 +24,12 @@ int apitest() {
 	RUN(pushtest);
 	RUN(listitertest);
 	RUN(tablenexttest);
+	RUN(programtest);
+	RUN(clonetest);
+	RUN(resumetest);
+	RUN(budgettest);
+	RUN(memtest);
+	RUN(bulktest);
+	RUN(objecttest);
 	return NUM_FAILED;
 }
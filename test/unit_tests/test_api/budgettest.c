@@ -0,0 +1,155 @@
+#include "yats.h"
+#include "yasl.h"
+#include "yasl_aux.h"
+#include "yasl_state.h"
+#include "teststate.h"
+
+SETUP_YATS();
+
+static void teststeps(void) {
+	const char *src = "let n = 0\nwhile n < 10000 {\n    n += 1\n}\necho n\n";
+	struct YASL_State *S = make_state(src);
+
+	YASL_setbudget(S, 1000, 0);
+	int status = YASL_execute(S);
+	int slices = 0;
+	while (status == YASL_PREEMPTED) {
+		slices++;
+		YASL_setbudget(S, 1000, 0);
+		status = YASL_resume(S, 0);
+	}
+	ASSERT_SUCCESS(status);
+	ASSERT_EQ(slices, 10);
+	ASSERT_OUT(S, "10000\n");
+	YASL_delstate(S);
+}
+
+static void testcalls(void) {
+	const char *src = "fn f(x) {\n    return x + 1\n}\nlet n = 0\nn = f(n)\nn = f(n)\nn = f(n)\necho n\n";
+	struct YASL_State *S = make_state(src);
+
+	YASL_setbudget(S, 1, 0);
+	int status = YASL_execute(S);
+	int slices = 0;
+	while (status == YASL_PREEMPTED) {
+		slices++;
+		YASL_setbudget(S, 1, 0);
+		status = YASL_resume(S, 0);
+	}
+	ASSERT_SUCCESS(status);
+	ASSERT_EQ(slices, 3);
+	ASSERT_OUT(S, "3\n");
+	YASL_delstate(S);
+}
+
+static void testms(void) {
+	struct YASL_State *S = make_state("while true {}\n");
+	YASL_setbudget(S, 0, 5);
+	ASSERT_EQ(YASL_execute(S), YASL_PREEMPTED);
+	YASL_setbudget(S, 0, 5);
+	ASSERT_EQ(YASL_resume(S, 0), YASL_PREEMPTED);
+	YASL_delstate(S);
+}
+
+// Preemption waits until the script is out of the coroutine.
+static void testcoroutine(void) {
+	const char *src =
+		"let co = coroutine.new(fn() {\n"
+		"    for let i = 0; i < 100; i += 1 {}\n"
+		"    coroutine.yield('inner')\n"
+		"})\n"
+		"echo co->resume()\n"
+		"echo 'outer'\n";
+	struct YASL_State *S = make_state(src);
+	YASL_setbudget(S, 10, 0);
+	ASSERT_EQ(YASL_execute(S), YASL_PREEMPTED);
+	ASSERT_OUT(S, "");
+	YASL_setbudget(S, 0, 0);
+	ASSERT_SUCCESS(YASL_resume(S, 0));
+	ASSERT_OUT(S, "inner\nouter\n");
+	YASL_delstate(S);
+}
+
+// A coroutine that never comes back out can't be preempted, so it is stopped with an error instead.
+static void testcoroutineloop(void) {
+	struct YASL_State *S = make_state("coroutine.new(fn() { while true {}; })->resume()\n");
+	YASL_setbudget(S, 0, 5);
+	ASSERT_EQ(YASL_execute(S), YASL_BUDGET_ERROR);
+
+	YASL_loadprinterr(S);
+	char *err = YASL_popcstr(S);
+	const char *expected =
+		"BudgetError: ran out of budget inside a coroutine. (line 1)\n"
+		"In function call on line 1\n"
+		"In coroutine resumed on line 1\n";
+	ASSERT_STR_EQ(err, expected, strlen(expected) + 1);
+	free(err);
+	YASL_delstate(S);
+}
+
+// The same goes for a function called from C, like a sort comparator.
+static void testcallback(void) {
+	struct YASL_State *S = make_state("[3, 1, 2]->sort(undef, fn(a, b) { while true {}; })\n");
+	YASL_setbudget(S, 1000, 0);
+	ASSERT_EQ(YASL_execute(S), YASL_BUDGET_ERROR);
+	YASL_delstate(S);
+
+	S = make_state("[3, 1, 2]->sort(undef, fn(a, b) { while true {}; })\n");
+	YASL_setbudget(S, 0, 5);
+	ASSERT_EQ(YASL_execute(S), YASL_BUDGET_ERROR);
+	YASL_delstate(S);
+}
+
+static int count_polls(struct YASL_State *S, void *data) {
+	int *polls = (int *)data;
+	if (++*polls == 3) {
+		YASL_interrupt(S);
+	}
+	return YASL_SUCCESS;
+}
+
+static void testinterrupt(void) {
+	struct YASL_State *S = make_state("let n = 0\nwhile true {\n    n += 1\n}\n");
+	int polls = 0;
+	YASL_sethook(S, count_polls, &polls);
+	ASSERT_EQ(YASL_execute(S), YASL_INTERRUPT_ERROR);
+	ASSERT_EQ(polls, 3);
+
+	YASL_loadprinterr(S);
+	char *err = YASL_popcstr(S);
+	const char *expected = "InterruptError: execution was interrupted. (line 1)\n";
+	ASSERT_STR_EQ(err, expected, strlen(expected) + 1);
+	free(err);
+	YASL_delstate(S);
+}
+
+static int stop_at_once(struct YASL_State *S, void *data) {
+	(void)S;
+	return *(int *)data;
+}
+
+static void testhook(void) {
+	int result = YASL_PREEMPTED;
+	struct YASL_State *S = make_state("while true {}\n");
+	YASL_sethook(S, stop_at_once, &result);
+	ASSERT_EQ(YASL_execute(S), YASL_PREEMPTED);
+
+	result = YASL_VALUE_ERROR;
+	ASSERT_EQ(YASL_resume(S, 0), YASL_VALUE_ERROR);
+
+	// Nothing to resume after an error.
+	ASSERT_EQ(YASL_resume(S, 0), YASL_ERROR);
+	YASL_delstate(S);
+}
+
+TEST(budgettest) {
+	teststeps();
+	testcalls();
+	testms();
+	testcoroutine();
+	testcoroutineloop();
+	testcallback();
+	testinterrupt();
+	testhook();
+	return NUM_FAILED;
+}
@@ -0,0 +1,111 @@
+#include "yats.h"
+#include "yasl.h"
+#include "yasl_aux.h"
+#include "yasl_state.h"
+#include "teststate.h"
+
+SETUP_YATS();
+
+static void testpushlists(void) {
+	struct YASL_State *S = make_state("echo ints\necho floats\necho strs\n");
+	const yasl_int ints[] = { 1, 2, 3 };
+	const yasl_float floats[] = { 0.5, 1.5 };
+	const char *const strs[] = { "a", "bcd", "e\0f" };
+	const size_t lens[] = { 1, 3, 3 };
+
+	YASL_pushintlist(S, ints, 3);
+	ASSERT_SUCCESS(YASL_declglobal(S, "ints"));
+	ASSERT_SUCCESS(YASL_setglobal(S, "ints"));
+	YASL_pushfloatlist(S, floats, 2);
+	ASSERT_SUCCESS(YASL_declglobal(S, "floats"));
+	ASSERT_SUCCESS(YASL_setglobal(S, "floats"));
+	YASL_pushstrlist(S, strs, lens, 2);
+	ASSERT_SUCCESS(YASL_declglobal(S, "strs"));
+	ASSERT_SUCCESS(YASL_setglobal(S, "strs"));
+
+	ASSERT_SUCCESS(YASL_execute(S));
+	ASSERT_OUT(S, "[1, 2, 3]\n[0.5, 1.5]\n[a, bcd]\n");
+	YASL_delstate(S);
+}
+
+static void testpeeklists(void) {
+	struct YASL_State *S = make_state("ints = [ 4, 5, 6, 'x' ]\nmixed = [ 1.5, true, 'hey', undef ]\n");
+	ASSERT_SUCCESS(YASL_declglobal(S, "ints"));
+	ASSERT_SUCCESS(YASL_declglobal(S, "mixed"));
+	ASSERT_SUCCESS(YASL_execute(S));
+
+	ASSERT_SUCCESS(YASL_loadglobal(S, "ints"));
+	yasl_int ints[4];
+	ASSERT_EQ(YASL_peeklistints(S, ints, 4), 3u);
+	ASSERT_EQ(ints[0], 4);
+	ASSERT_EQ(ints[2], 6);
+	ASSERT_EQ(YASL_peeklistints(S, ints, 2), 2u);
+	yasl_float floats[4];
+	ASSERT_EQ(YASL_peeklistfloats(S, floats, 4), 0u);
+	YASL_pop(S);
+
+	ASSERT_SUCCESS(YASL_loadglobal(S, "mixed"));
+	struct YASL_Value values[4];
+	ASSERT_EQ(YASL_peeklistvalues(S, values, 4), 4u);
+	ASSERT_EQ(values[0].type, Y_FLOAT);
+	ASSERT_EQ(values[0].value.dval, 1.5);
+	ASSERT_EQ(values[1].type, Y_BOOL);
+	ASSERT(values[1].value.bval);
+	ASSERT_EQ(values[2].type, Y_STR);
+	ASSERT_EQ(values[2].value.sval.len, 3u);
+	ASSERT_STR_EQ(values[2].value.sval.chars, "hey", 3);
+	ASSERT_EQ(values[3].type, Y_UNDEF);
+	YASL_pop(S);
+
+	YASL_pushint(S, 1);
+	ASSERT_EQ(YASL_peeklistvalues(S, values, 4), 0u);
+	YASL_pop(S);
+	YASL_delstate(S);
+}
+
+static void testpeektable(void) {
+	struct YASL_State *S = make_state("t = { 'a': 1, 'b': 2, 'c': 3 }\nt->remove('b')\n");
+	ASSERT_SUCCESS(YASL_declglobal(S, "t"));
+	ASSERT_SUCCESS(YASL_execute(S));
+	ASSERT_SUCCESS(YASL_loadglobal(S, "t"));
+
+	struct YASL_Value keys[4], values[4];
+	ASSERT_EQ(YASL_peektablevalues(S, keys, values, 4), 2u);
+	yasl_int sum = 0;
+	for (size_t i = 0; i < 2; i++) {
+		ASSERT_EQ(keys[i].type, Y_STR);
+		ASSERT_EQ(keys[i].value.sval.len, 1u);
+		ASSERT_EQ(values[i].type, Y_INT);
+		sum += values[i].value.ival;
+	}
+	ASSERT_EQ(sum, 4);
+	ASSERT_EQ(YASL_peektablevalues(S, keys, values, 1), 1u);
+	YASL_pop(S);
+	YASL_delstate(S);
+}
+
+static void count_release(void *data) {
+	(*(int *)data)++;
+}
+
+static void testextstr(void) {
+	struct YASL_State *S = make_state("echo s\necho s[1:4]\necho s->toupper()\n");
+	char buffer[] = "hello";
+	int releases = 0;
+	YASL_pushextstr(S, buffer, 5, count_release, &releases);
+	ASSERT_SUCCESS(YASL_declglobal(S, "s"));
+	ASSERT_SUCCESS(YASL_setglobal(S, "s"));
+	ASSERT_SUCCESS(YASL_execute(S));
+	ASSERT_OUT(S, "hello\nell\nHELLO\n");
+	ASSERT_EQ(releases, 0);
+	YASL_delstate(S);
+	ASSERT_EQ(releases, 1);
+}
+
+TEST(bulktest) {
+	testpushlists();
+	testpeeklists();
+	testpeektable();
+	testextstr();
+	return NUM_FAILED;
+}
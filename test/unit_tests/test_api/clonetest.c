@@ -0,0 +1,166 @@
+#include "yats.h"
+#include "yasl.h"
+#include "yasl_aux.h"
+#include "yasl_state.h"
+
+SETUP_YATS();
+
+static const char *const SETUP =
+	"config.name = 'template'\n"
+	"config.seen = []\n"
+	"config.twice = fn(x) {\n"
+	"    return x * 2\n"
+	"}\n";
+
+static const char *const REQUEST =
+	"config.seen->push(len config.seen)\n"
+	"config.name = 'clone'\n"
+	"echo config.twice(21)\n"
+	"echo config.seen\n"
+	"echo math.max(1, 2)\n";
+
+static struct YASL_State *make_template(void) {
+	struct YASL_State *T = YASL_newstate_bb(SETUP, strlen(SETUP));
+	YASLX_decllibs(T);
+	YASL_declglobal(T, "config");
+	YASL_pushtable(T);
+	YASL_setglobal(T, "config");
+	YASL_execute(T);
+	return T;
+}
+
+static char *run_request(struct YASL_State *C) {
+	YASL_resetstate_bb(C, REQUEST, strlen(REQUEST));
+	YASL_setprintout_tostr(C);
+	ASSERT_SUCCESS(YASL_execute(C));
+	YASL_loadprintout(C);
+	return YASL_popcstr(C);
+}
+
+static void testclone(void) {
+	struct YASL_State *T = make_template();
+	const char *expected = "42\n[0]\n2\n";
+
+	for (int i = 0; i < 3; i++) {
+		struct YASL_State *C = YASL_clonestate(T);
+		char *out = run_request(C);
+		ASSERT_EQ(strlen(out), strlen(expected));
+		ASSERT_STR_EQ(out, expected, strlen(expected));
+		free(out);
+		YASL_delstate(C);
+	}
+
+	// None of the clones' changes reached the template.
+	const char *check = "echo config.name ~ ' ' ~ (len config.seen)->tostr()\n";
+	YASL_resetstate_bb(T, check, strlen(check));
+	YASL_setprintout_tostr(T);
+	ASSERT_SUCCESS(YASL_execute(T));
+	YASL_loadprintout(T);
+	char *out = YASL_popcstr(T);
+	ASSERT_STR_EQ(out, "template 0\n", strlen("template 0\n") + 1);
+	free(out);
+	YASL_delstate(T);
+}
+
+static void testclonealiasing(void) {
+	const char *setup = "config.a = [1]\nconfig.b = config.a\nconfig.inner = { .list: config.a }\n";
+	struct YASL_State *T = YASL_newstate_bb(setup, strlen(setup));
+	YASL_declglobal(T, "config");
+	YASL_pushtable(T);
+	YASL_setglobal(T, "config");
+	ASSERT_SUCCESS(YASL_execute(T));
+
+	const char *request = "config.a->push(2)\necho config.b\necho config.inner.list\n";
+	struct YASL_State *C = YASL_clonestate(T);
+	YASL_resetstate_bb(C, request, strlen(request));
+	YASL_setprintout_tostr(C);
+	ASSERT_SUCCESS(YASL_execute(C));
+	YASL_loadprintout(C);
+	char *out = YASL_popcstr(C);
+	const char *expected = "[1, 2]\n[1, 2]\n";
+	ASSERT_STR_EQ(out, expected, strlen(expected) + 1);
+	free(out);
+
+	YASL_delstate(C);
+	YASL_delstate(T);
+}
+
+static void testclonecopiesuserdataandclosures(void) {
+	const char *setup =
+		"config.s = collections.set(1)\n"
+		"config.d = collections.deque([1])\n"
+		"config.h = collections.heap([3, 1])\n"
+		"config.a = collections.intarray(1)\n"
+		"let count = 0\n"
+		"config.bump = fn() {\n"
+		"    count += 1\n"
+		"    return count\n"
+		"}\n"
+		"config.peek = fn() {\n"
+		"    return count\n"
+		"}\n"
+		"config.bump()\n";
+	struct YASL_State *T = YASL_newstate_bb(setup, strlen(setup));
+	YASLX_decllibs(T);
+	YASL_declglobal(T, "config");
+	YASL_pushtable(T);
+	YASL_setglobal(T, "config");
+	ASSERT_SUCCESS(YASL_execute(T));
+
+	const char *request =
+		"config.s->add(2)\n"
+		"config.d->push(2)\n"
+		"config.h->push(0)\n"
+		"config.a[0] = 2\n"
+		"config.bump()\n"
+		"echo [len config.s, len config.d, config.h->peek(), config.a[0], config.peek()]\n";
+	for (int i = 0; i < 2; i++) {
+		struct YASL_State *C = YASL_clonestate(T);
+		ASSERT(C != NULL);
+		YASL_resetstate_bb(C, request, strlen(request));
+		YASL_setprintout_tostr(C);
+		ASSERT_SUCCESS(YASL_execute(C));
+		YASL_loadprintout(C);
+		char *out = YASL_popcstr(C);
+		// Closures that shared an upvalue still do.
+		const char *expected = "[2, 2, 0, 2, 2]\n";
+		ASSERT_STR_EQ(out, expected, strlen(expected) + 1);
+		free(out);
+		YASL_delstate(C);
+	}
+
+	// The template's functions can't be called once it is reset, so a fresh clone shows what the template holds.
+	const char *check = "echo [len config.s, len config.d, config.h->peek(), config.a[0], config.peek()]\n";
+	struct YASL_State *C = YASL_clonestate(T);
+	YASL_resetstate_bb(C, check, strlen(check));
+	YASL_setprintout_tostr(C);
+	ASSERT_SUCCESS(YASL_execute(C));
+	YASL_loadprintout(C);
+	char *out = YASL_popcstr(C);
+	const char *expected = "[1, 1, 1, 1, 1]\n";
+	ASSERT_STR_EQ(out, expected, strlen(expected) + 1);
+	free(out);
+	YASL_delstate(C);
+	YASL_delstate(T);
+}
+
+static void testclonerejectsuncopyable(void) {
+	const char *setup = "config.co = coroutine.new(fn() { })\n";
+	struct YASL_State *T = YASL_newstate_bb(setup, strlen(setup));
+	YASLX_decllibs(T);
+	YASL_declglobal(T, "config");
+	YASL_pushtable(T);
+	YASL_setglobal(T, "config");
+	ASSERT_SUCCESS(YASL_execute(T));
+
+	ASSERT(YASL_clonestate(T) == NULL);
+	YASL_delstate(T);
+}
+
+TEST(clonetest) {
+	testclone();
+	testclonealiasing();
+	testclonecopiesuserdataandclosures();
+	testclonerejectsuncopyable();
+	return NUM_FAILED;
+}
@@ -1,5 +1,6 @@
 #include "yats.h"
 #include "yasl.h"
+#include "yasl_aux.h"
 #include "yasl_state.h"
 
 SETUP_YATS();
@@ -25,7 +26,170 @@ static void testfncall(void) {
 	YASL_delstate(S);
 }
 
+static struct YASL_Value int_value(yasl_int i) {
+	struct YASL_Value v;
+	v.type = Y_INT;
+	v.value.ival = i;
+	return v;
+}
+
+static struct YASL_Function *load_function(struct YASL_State *S, const char *name) {
+	YASL_loadglobal(S, name);
+	return YASL_popfunction(S);
+}
+
+static void testhandles(void) {
+	const char *code =
+		"add = fn(a, b) { return a + b; }\n"
+		"greet = fn(name) { return 'hi ' ~ name; }\n"
+		"two = fn() { return 1, 2; }\n"
+		"bad = fn() { return 1 + 'a'; }\n"
+		"let n = 0\n"
+		"counter = fn() { n += 1; return n; }\n";
+	struct YASL_State *S = YASL_newstate_bb(code, strlen(code));
+	YASL_setprinterr_tostr(S);
+	const char *names[] = { "add", "greet", "two", "bad", "counter" };
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+		ASSERT_SUCCESS(YASL_declglobal(S, names[i]));
+	}
+	ASSERT_SUCCESS(YASL_execute(S));
+
+	struct YASL_Function *add = load_function(S, "add");
+	struct YASL_Value args[2], results[3];
+	for (yasl_int i = 0; i < 100; i++) {
+		args[0] = int_value(i);
+		args[1] = int_value(2 * i);
+		ASSERT_SUCCESS(YASL_callfunction(S, add, args, 2, results, 1));
+		ASSERT_EQ(results[0].type, Y_INT);
+		ASSERT_EQ(results[0].value.ival, 3 * i);
+	}
+
+	struct YASL_Function *greet = load_function(S, "greet");
+	args[0].type = Y_STR;
+	args[0].value.sval.chars = "you";
+	args[0].value.sval.len = 3;
+	ASSERT_SUCCESS(YASL_callfunction(S, greet, args, 1, results, 1));
+	ASSERT_EQ(results[0].type, Y_STR);
+	ASSERT_EQ(results[0].value.sval.len, 6u);
+	ASSERT_STR_EQ(results[0].value.sval.chars, "hi you", 6);
+
+	struct YASL_Function *two = load_function(S, "two");
+	ASSERT_SUCCESS(YASL_callfunction(S, two, NULL, 0, results, 3));
+	ASSERT_EQ(results[0].value.ival, 1);
+	ASSERT_EQ(results[1].value.ival, 2);
+	ASSERT_EQ(results[2].type, Y_UNDEF);
+
+	// Errors leave the stack as it was.
+	struct YASL_Function *bad = load_function(S, "bad");
+	YASL_pushint(S, 42);
+	ASSERT_EQ(YASL_callfunction(S, bad, NULL, 0, results, 1), YASL_TYPE_ERROR);
+	ASSERT_EQ(YASL_popint(S), 42);
+	YASL_loadprinterr(S);
+	char *err = YASL_popcstr(S);
+	const char *expected = "TypeError: + not supported for operands of types int and str. (line 4)\n";
+	ASSERT_STR_EQ(err, expected, strlen(expected) + 1);
+	free(err);
+
+	struct YASL_Function *counter = load_function(S, "counter");
+	for (yasl_int i = 1; i <= 3; i++) {
+		ASSERT_SUCCESS(YASL_callfunction(S, counter, NULL, 0, results, 1));
+		ASSERT_EQ(results[0].value.ival, i);
+	}
+
+	YASL_pushint(S, 1);
+	ASSERT_EQ(YASL_popfunction(S), NULL);
+
+	YASL_delfunction(add);
+	YASL_delfunction(greet);
+	YASL_delfunction(two);
+	YASL_delfunction(bad);
+	YASL_delfunction(counter);
+	YASL_delstate(S);
+}
+
+static int fail(struct YASL_State *S) {
+	YASL_print_err(S, "ValueError: nope.");
+	YASL_throw_err(S, YASL_VALUE_ERROR);
+}
+
+static void testcfnhandle(void) {
+	const char *code = "";
+	struct YASL_State *S = YASL_newstate_bb(code, strlen(code));
+	YASL_setprinterr_tostr(S);
+	ASSERT_SUCCESS(YASL_execute(S));
+
+	YASL_pushcfunction(S, TEST_FN, 2);
+	struct YASL_Function *add = YASL_popfunction(S);
+	struct YASL_Value args[2] = { int_value(2), int_value(5) }, result;
+	ASSERT_SUCCESS(YASL_callfunction(S, add, args, 2, &result, 1));
+	ASSERT_EQ(result.value.ival, 7);
+
+	YASL_pushcfunction(S, fail, 0);
+	struct YASL_Function *f = YASL_popfunction(S);
+	ASSERT_EQ(YASL_callfunction(S, f, NULL, 0, NULL, 0), YASL_VALUE_ERROR);
+	YASL_loadprinterr(S);
+	char *err = YASL_popcstr(S);
+	const char *expected = "ValueError: nope.\n";
+	ASSERT_STR_EQ(err, expected, strlen(expected) + 1);
+	free(err);
+
+	YASL_delfunction(add);
+	YASL_delfunction(f);
+	YASL_delstate(S);
+}
+
+static struct YASL_Function *callback;
+
+static int apply(struct YASL_State *S) {
+	struct YASL_Value arg = int_value(YASL_popint(S)), result;
+	if (!callback) {
+		YASL_loadglobal(S, "f");
+		callback = YASL_popfunction(S);
+	}
+	if (YASL_callfunction(S, callback, &arg, 1, &result, 1)) {
+		YASL_pushlit(S, "failed");
+	} else {
+		YASL_pushint(S, result.value.ival);
+	}
+	return 1;
+}
+
+// Calls made from a C function while a script runs, including ones that fail.
+static void testnestedhandles(void) {
+	const char *code =
+		"f = fn(x) {\n"
+		"    assert x >= 0\n"
+		"    return x * 10\n"
+		"}\n"
+		"for let i = 0; i < 2; i += 1 {\n"
+		"    echo apply(5)\n"
+		"    echo apply(-1)\n"
+		"}\n"
+		"echo 'done'\n";
+	struct YASL_State *S = YASL_newstate_bb(code, strlen(code));
+	YASL_setprintout_tostr(S);
+	YASL_setprinterr_tostr(S);
+	ASSERT_SUCCESS(YASL_declglobal(S, "f"));
+	ASSERT_SUCCESS(YASL_declglobal(S, "apply"));
+	YASL_pushcfunction(S, apply, 1);
+	ASSERT_SUCCESS(YASL_setglobal(S, "apply"));
+	ASSERT_SUCCESS(YASL_execute(S));
+
+	YASL_loadprintout(S);
+	char *out = YASL_popcstr(S);
+	const char *expected = "50\nfailed\n50\nfailed\ndone\n";
+	ASSERT_STR_EQ(out, expected, strlen(expected) + 1);
+	free(out);
+
+	YASL_delfunction(callback);
+	callback = NULL;
+	YASL_delstate(S);
+}
+
 TEST(fntest) {
 	testfncall();
+	testhandles();
+	testnestedhandles();
+	testcfnhandle();
 	return NUM_FAILED;
 }
@@ -0,0 +1,119 @@
+#include "yats.h"
+#include "yasl.h"
+#include "yasl_aux.h"
+#include "yasl_state.h"
+#include "teststate.h"
+
+SETUP_YATS();
+
+static void teststats(void) {
+	const char *src = "let ls = []\nfor let i = 0; i < 1000; i += 1 {\n    ls->push(i)\n}\n";
+	struct YASL_State *S = make_state(src);
+	const size_t before = YASL_memused(S, YASL_MEM_TOTAL);
+	ASSERT_EQ(YASL_memused(S, Y_LIST), 0u);
+
+	ASSERT_SUCCESS(YASL_execute(S));
+	ASSERT(YASL_memused(S, Y_LIST) > 1000 * sizeof(struct YASL_Object));
+	ASSERT(YASL_memused(S, YASL_MEM_TOTAL) >= before + YASL_memused(S, Y_LIST));
+	ASSERT(YASL_mempeak(S, Y_LIST) >= YASL_memused(S, Y_LIST));
+	ASSERT(YASL_mempeak(S, YASL_MEM_TOTAL) >= YASL_memused(S, YASL_MEM_TOTAL));
+	YASL_delstate(S);
+}
+
+static void testlimit(void) {
+	const char *src = "fn f() {\n    let ls = []\n    while true {\n        ls->push((len ls)->tostr())\n    }\n}\nf()\n";
+	struct YASL_State *S = make_state(src);
+	YASL_setmemlimit(S, 1 << 16);
+	ASSERT_EQ(YASL_execute(S), YASL_MEMORY_ERROR);
+	ASSERT(YASL_mempeak(S, Y_LIST) > 0);
+	ASSERT(YASL_mempeak(S, Y_STR) > 0);
+	ASSERT(YASL_mempeak(S, YASL_MEM_TOTAL) >= 1 << 16);
+
+	YASL_loadprinterr(S);
+	char *err = YASL_popcstr(S);
+	const char *expected = "MemoryError: memory limit of 65536 bytes exceeded. (line 4)\n";
+	ASSERT_STR_EQ(err, expected, strlen(expected));
+	free(err);
+
+	// The state can still be used once the error is over.
+	YASL_setmemlimit(S, 0);
+	YASL_pushlist(S);
+	YASL_pushint(S, 1);
+	ASSERT_SUCCESS(YASL_listpush(S));
+	ASSERT_EQ(YASL_peektype(S), Y_LIST);
+	YASL_pop(S);
+	YASL_delstate(S);
+}
+
+static void testlimitafterreset(void) {
+	const char *first = "let x = 'first'\n";
+	struct YASL_State *S = make_state(first);
+	ASSERT_SUCCESS(YASL_execute(S));
+
+	// The new constants come from the bytecode, so decoding them doesn't count towards the limit.
+	const char *second = "let y = 'second'\n";
+	YASL_setmemlimit(S, 1);
+	YASL_resetstate_bb(S, second, strlen(second));
+	ASSERT_SUCCESS(YASL_execute(S));
+	YASL_delstate(S);
+}
+
+static void testlimitrepeatedly(void) {
+	const char *src =
+		"fill = fn() {\n"
+		"    let ls = []\n"
+		"    let s = collections.set()\n"
+		"    let t = {}\n"
+		"    while true {\n"
+		"        const n = len ls\n"
+		"        ls->push({ .n: n, .s: n->tostr() ~ 'x' })\n"
+		"        s->add(n)\n"
+		"        t[n] = [n, n * 2] + [n]\n"
+		"        const co = coroutine.new(fn(x) { return coroutine.yield(x); })\n"
+		"        co->resume(n)\n"
+		"    }\n"
+		"}\n";
+	struct YASL_State *S = make_state(src);
+	ASSERT_SUCCESS(YASL_declglobal(S, "fill"));
+	ASSERT_SUCCESS(YASL_execute(S));
+	YASL_loadglobal(S, "fill");
+	struct YASL_Function *fill = YASL_popfunction(S);
+
+	// Each limit stops fill somewhere different, and whatever it had made by then is freed, so the state is left using
+	// what it did before. Each error message is added to the error output, which is charged to Y_UNDEF, so that is left
+	// out.
+	const size_t used = YASL_memused(S, YASL_MEM_TOTAL) - YASL_memused(S, Y_UNDEF);
+	for (size_t i = 0; i < 20; i++) {
+		YASL_setmemlimit(S, 16384 + i * 1031);
+		ASSERT_EQ(YASL_callfunction(S, fill, NULL, 0, NULL, 0), YASL_MEMORY_ERROR);
+		ASSERT_EQ(YASL_memused(S, YASL_MEM_TOTAL) - YASL_memused(S, Y_UNDEF), used);
+	}
+
+	YASL_setmemlimit(S, 0);
+	YASL_delfunction(fill);
+	YASL_delstate(S);
+}
+
+// Builtins asked to make something too big raise before they start on it, rather than going far over the limit.
+static void testreserve(void) {
+	const char *const srcs[] = {
+		"echo 'a'->rep(200000000)\n",
+		"echo [0]->resize(50000000)\n",
+	};
+	for (size_t i = 0; i < sizeof(srcs) / sizeof(srcs[0]); i++) {
+		struct YASL_State *S = make_state(srcs[i]);
+		YASL_setmemlimit(S, 1 << 20);
+		ASSERT_EQ(YASL_execute(S), YASL_MEMORY_ERROR);
+		ASSERT(YASL_mempeak(S, YASL_MEM_TOTAL) < 2 << 20);
+		YASL_delstate(S);
+	}
+}
+
+TEST(memtest) {
+	teststats();
+	testlimit();
+	testlimitafterreset();
+	testlimitrepeatedly();
+	testreserve();
+	return NUM_FAILED;
+}
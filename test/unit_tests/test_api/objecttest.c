@@ -0,0 +1,129 @@
+#include "yats.h"
+#include "yasl.h"
+#include "yasl_aux.h"
+#include "yasl_state.h"
+#include "teststate.h"
+
+SETUP_YATS();
+
+struct Point {
+	yasl_int x;
+	yasl_int y;
+};
+
+static int points_freed = 0;
+
+static void point_free(void *ptr) {
+	(void) ptr;
+	points_freed++;
+}
+
+static struct YASL_Type point_type = { "test.point", sizeof(struct Point), point_free, 0 };
+static struct YASL_Type other_type = { "test.other", sizeof(int), NULL, 0 };
+
+static int point_new(struct YASL_State *S) {
+	yasl_int y = YASL_popint(S);
+	yasl_int x = YASL_popint(S);
+	struct Point *p = (struct Point *)YASL_pushobject(S, &point_type);
+	p->x = x;
+	p->y = y;
+	return 1;
+}
+
+static int point_sum(struct YASL_State *S) {
+	struct Point *p = (struct Point *)YASL_peeknobject(S, &point_type, 0);
+	YASL_pushint(S, p->x + p->y);
+	return 1;
+}
+
+static int point_product(struct YASL_State *S) {
+	struct Point *p = (struct Point *)YASL_peeknobject(S, &point_type, 0);
+	YASL_pushint(S, p->x * p->y);
+	return 1;
+}
+
+static void register_point(struct YASL_State *S, YASL_cfn sum) {
+	YASL_pushtable(S);
+	YASL_pushlit(S, "sum");
+	YASL_pushcfunction(S, sum, 1);
+	YASL_tableset(S);
+	YASL_registertype(S, &point_type);
+}
+
+static struct YASL_State *make_point_state(const char *const src) {
+	struct YASL_State *S = make_state(src);
+	YASL_declglobal(S, "point");
+	YASL_pushcfunction(S, point_new, 2);
+	YASL_setglobal(S, "point");
+	return S;
+}
+
+static void testobjects(void) {
+	struct YASL_State *S = make_point_state("echo point(3, 4)->sum()\nlet ps = []\nfor let i = 0; i < 100; i += 1 {\n"
+					  "    ps->push(point(i, i))\n}\necho ps[99]->sum()\n");
+	register_point(S, point_sum);
+	ASSERT(point_type.id > 0);
+	points_freed = 0;
+	ASSERT_SUCCESS(YASL_execute(S));
+	ASSERT_OUT(S, "7\n198\n");
+	YASL_delstate(S);
+	ASSERT_EQ(points_freed, 101);
+
+	S = make_point_state("");
+	YASL_pushint(S, 5);
+	YASL_pushint(S, 6);
+	point_new(S);
+	struct Point *p = (struct Point *)YASL_peeknobject(S, &point_type, 0);
+	ASSERT(p != NULL);
+	ASSERT_EQ(p->x, 5);
+	ASSERT_EQ(p->y, 6);
+	ASSERT(YASL_isnuserdata(S, point_type.name, 0));
+	ASSERT(YASL_peeknobject(S, &other_type, 0) == NULL);
+	ASSERT_EQ(YASL_peeknuserdata(S, 0), p);
+
+	YASL_pushobject(S, &other_type);
+	ASSERT(other_type.id > 0 && other_type.id != point_type.id);
+	ASSERT_EQ(*(int *)YASL_peeknobject(S, &other_type, 1), 0);
+	YASL_pop(S);
+	YASL_pop(S);
+	YASL_delstate(S);
+	ASSERT_EQ(points_freed, 102);
+}
+
+static void testreregister(void) {
+	struct YASL_State *S = make_point_state("a = point(3, 4)\necho a->sum()\n");
+	YASL_declglobal(S, "a");
+	register_point(S, point_sum);
+	ASSERT_SUCCESS(YASL_execute(S));
+	ASSERT_OUT(S, "7\n");
+
+	// Objects made after a metatable is registered again get the new one, even though the old one was cached.
+	register_point(S, point_product);
+	const char *src = "echo point(3, 4)->sum()\necho a->sum()\n";
+	ASSERT_SUCCESS(YASL_resetstate_bb(S, src, strlen(src)));
+	ASSERT_SUCCESS(YASL_execute(S));
+	ASSERT_OUT(S, "7\n12\n7\n");
+	YASL_delstate(S);
+}
+
+static void testobjectptr(void) {
+	struct Point point = { 5, 6 };
+	struct YASL_State *S = make_point_state("echo a->sum()\n");
+	register_point(S, point_sum);
+	points_freed = 0;
+	YASL_declglobal(S, "a");
+	YASL_pushobjectptr(S, &point_type, &point);
+	ASSERT_EQ(YASL_peeknobject(S, &point_type, 0), &point);
+	YASL_setglobal(S, "a");
+	ASSERT_SUCCESS(YASL_execute(S));
+	ASSERT_OUT(S, "11\n");
+	YASL_delstate(S);
+	ASSERT_EQ(points_freed, 1);
+}
+
+TEST(objecttest) {
+	testobjects();
+	testreregister();
+	testobjectptr();
+	return NUM_FAILED;
+}
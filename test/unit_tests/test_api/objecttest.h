@@ -0,0 +1,4 @@
+#pragma once
+#include "yats.h"
+
+TEST(objecttest);
@@ -0,0 +1,121 @@
+#include "yats.h"
+#include "yasl.h"
+#include "yasl_state.h"
+
+SETUP_YATS();
+
+#define NUM_STATES 3
+
+static const char *const PROGRAM =
+	"fn sum(n) {\n"
+	"    let total = 0\n"
+	"    for i <- range(0, n, 1) {\n"
+	"        total += i\n"
+	"    }\n"
+	"    return total\n"
+	"}\n"
+	"echo 'sum: ' ~ sum(10)->tostr()\n";
+
+static const char *const EXPECTED = "sum: 45\n";
+
+static void testrunmany(void) {
+	struct YASL_State *C = YASL_newstate_bb(PROGRAM, strlen(PROGRAM));
+	struct YASL_Program *P = YASL_compileprogram(C);
+	ASSERT(P != NULL);
+	YASL_delstate(C);
+
+	struct YASL_State *states[NUM_STATES];
+	for (int i = 0; i < NUM_STATES; i++) {
+		states[i] = YASL_newstate_bb("", 0);
+		YASL_setprintout_tostr(states[i]);
+		ASSERT_SUCCESS(YASL_runprogram(states[i], P));
+	}
+
+	// The states keep the program alive on their own.
+	YASL_delprogram(P);
+
+	for (int i = 0; i < NUM_STATES; i++) {
+		YASL_loadprintout(states[i]);
+		char *out = YASL_popcstr(states[i]);
+		ASSERT_EQ(strlen(out), strlen(EXPECTED));
+		ASSERT_STR_EQ(out, EXPECTED, strlen(EXPECTED));
+		free(out);
+		YASL_delstate(states[i]);
+	}
+}
+
+static void testrunagain(void) {
+	struct YASL_State *C = YASL_newstate_bb(PROGRAM, strlen(PROGRAM));
+	struct YASL_Program *P = YASL_compileprogram(C);
+	ASSERT(P != NULL);
+
+	struct YASL_State *S = YASL_newstate_bb("", 0);
+	YASL_setprintout_tostr(S);
+	ASSERT_SUCCESS(YASL_runprogram(S, P));
+	ASSERT_SUCCESS(YASL_runprogram(S, P));
+	YASL_loadprintout(S);
+	char *out = YASL_popcstr(S);
+	ASSERT_EQ(strlen(out), 2 * strlen(EXPECTED));
+	ASSERT_STR_EQ(out, "sum: 45\nsum: 45\n", 2 * strlen(EXPECTED));
+	free(out);
+
+	YASL_delstate(S);
+	YASL_delprogram(P);
+	YASL_delstate(C);
+}
+
+static void testrunother(void) {
+	const char *other = "echo 'other'\n";
+	struct YASL_State *C = YASL_newstate_bb(PROGRAM, strlen(PROGRAM));
+	struct YASL_Program *P = YASL_compileprogram(C);
+	struct YASL_State *D = YASL_newstate_bb(other, strlen(other));
+	struct YASL_Program *Q = YASL_compileprogram(D);
+
+	struct YASL_State *S = YASL_newstate_bb("", 0);
+	YASL_setprintout_tostr(S);
+	YASL_setprinterr_tostr(S);
+	ASSERT_SUCCESS(YASL_runprogram(S, P));
+	ASSERT_EQ(YASL_runprogram(S, Q), YASL_ERROR);
+
+	YASL_delstate(S);
+	YASL_delprogram(P);
+	YASL_delprogram(Q);
+	YASL_delstate(C);
+	YASL_delstate(D);
+}
+
+static void testsharedbuiltins(void) {
+	struct YASL_State *S = YASL_newstate_bb("", 0);
+	struct YASL_State *T = YASL_newstate_bb("", 0);
+	ASSERT(S->vm.builtins_htable[Y_LIST] == T->vm.builtins_htable[Y_LIST]);
+	ASSERT(S->vm.builtins_htable[Y_STR] == T->vm.builtins_htable[Y_STR]);
+	YASL_delstate(S);
+
+	const char *code = "echo [3, 1, 2]->join(', ')\n";
+	struct YASL_State *U = YASL_newstate_bb(code, strlen(code));
+	YASL_setprintout_tostr(U);
+	ASSERT_SUCCESS(YASL_execute(U));
+	YASL_loadprintout(U);
+	char *out = YASL_popcstr(U);
+	ASSERT_STR_EQ(out, "3, 1, 2\n", strlen("3, 1, 2\n"));
+	free(out);
+	YASL_delstate(U);
+	YASL_delstate(T);
+}
+
+static void testcompileerror(void) {
+	const char *code = "echo (";
+	struct YASL_State *S = YASL_newstate_bb(code, strlen(code));
+	YASL_setprinterr_tostr(S);
+	ASSERT(YASL_compileprogram(S) == NULL);
+	YASL_delstate(S);
+}
+
+TEST(programtest) {
+	testrunmany();
+	testrunagain();
+	testrunother();
+	testsharedbuiltins();
+	testcompileerror();
+	return NUM_FAILED;
+}
@@ -0,0 +1,85 @@
+#include "yats.h"
+#include "yasl.h"
+#include "yasl_aux.h"
+#include "yasl_state.h"
+#include "teststate.h"
+
+SETUP_YATS();
+
+static const char *const SCRIPT =
+	"let total = 0\n"
+	"for let i = 0; i < 3; i += 1 {\n"
+	"    total += coroutine.yield('read', i)\n"
+	"}\n"
+	"echo total\n";
+
+// Pretends to be a host serving the script's reads.
+static int serve_read(struct YASL_State *S, const yasl_int scale) {
+	ASSERT_EQ(YASL_peekvargscount(S), 2);
+	const yasl_int i = YASL_popint(S);
+	char *request = YASL_popcstr(S);
+	ASSERT_STR_EQ(request, "read", strlen("read") + 1);
+	free(request);
+	YASL_pushint(S, i * scale);
+	return YASL_resume(S, 1);
+}
+
+static void testresume(void) {
+	struct YASL_State *S = make_state(SCRIPT);
+
+	int status = YASL_execute(S);
+	int yields = 0;
+	while (status == YASL_YIELD) {
+		yields++;
+		status = serve_read(S, 10);
+	}
+	ASSERT_SUCCESS(status);
+	ASSERT_EQ(yields, 3);
+
+	ASSERT_OUT(S, "30\n");
+
+	// Nothing is suspended any more.
+	ASSERT_EQ(YASL_resume(S, 0), YASL_ERROR);
+	YASL_delstate(S);
+}
+
+static void testinterleaved(void) {
+	enum { N = 50 };
+	struct YASL_State *states[N];
+	int status[N];
+	for (int i = 0; i < N; i++) {
+		states[i] = make_state(SCRIPT);
+		status[i] = YASL_execute(states[i]);
+		ASSERT_EQ(status[i], YASL_YIELD);
+	}
+
+	// Each state is resumed once per round, like an event loop would as their reads complete.
+	for (int round = 0; round < 3; round++) {
+		for (int i = 0; i < N; i++) {
+			status[i] = serve_read(states[i], i);
+		}
+	}
+
+	for (int i = 0; i < N; i++) {
+		ASSERT_SUCCESS(status[i]);
+		char expected[32];
+		sprintf(expected, "%d\n", 3 * i);
+		ASSERT_OUT(states[i], expected);
+		YASL_delstate(states[i]);
+	}
+}
+
+static void testabandoned(void) {
+	const char *src = "let x = [1, 2, 3]\nlet f = fn() { return x; }\ncoroutine.yield(f)\necho 'unreachable'\n";
+	struct YASL_State *S = make_state(src);
+	ASSERT_EQ(YASL_execute(S), YASL_YIELD);
+	// Deleting a suspended state frees everything it was holding on to.
+	YASL_delstate(S);
+}
+
+TEST(resumetest) {
+	testresume();
+	testinterleaved();
+	testabandoned();
+	return NUM_FAILED;
+}
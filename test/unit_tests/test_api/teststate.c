@@ -0,0 +1,18 @@
+#include "teststate.h"
+
+#include <string.h>
+
+#include "yasl_aux.h"
+
+struct YASL_State *make_state(const char *const src) {
+	struct YASL_State *S = YASL_newstate_bb(src, strlen(src));
+	YASLX_decllibs(S);
+	YASL_setprintout_tostr(S);
+	YASL_setprinterr_tostr(S);
+	return S;
+}
+
+char *get_out(struct YASL_State *S) {
+	YASL_loadprintout(S);
+	return YASL_popcstr(S);
+}
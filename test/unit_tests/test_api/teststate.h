@@ -0,0 +1,17 @@
+#pragma once
+
+#include "yats.h"
+#include "yasl.h"
+
+// Makes a state running src, with the standard libraries declared and its output and error output going to strings.
+struct YASL_State *make_state(const char *const src);
+
+// Everything S has printed so far. Must be freed.
+char *get_out(struct YASL_State *S);
+
+// A macro rather than a function, so that failures count against the test that called it.
+#define ASSERT_OUT(S, expected) do {\
+	char *out_ = get_out(S);\
+	ASSERT_STR_EQ(out_, expected, strlen(expected) + 1);\
+	free(out_);\
+} while(0)
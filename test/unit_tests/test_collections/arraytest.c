@@ -0,0 +1,81 @@
+#include "arraytest.h"
+#include "test/yats.h"
+#include "data-structures/YASL_Array.h"
+
+SETUP_YATS();
+
+static struct YASL_Array *make_ints(size_t n) {
+	struct YASL_Array *array = YASL_Array_new_sized(ARRAY_INT, n);
+	for (size_t i = 0; i < n; i++) {
+		array->items.ints[i] = (yasl_int)(i * 7 % 11) - 5;
+	}
+	array->count = n;
+	return array;
+}
+
+static void testintkernels(void) {
+	for (size_t n = 1; n < 20; n++) {
+		struct YASL_Array *array = make_ints(n);
+		yasl_int sum = 0, dot = 0, min = array->items.ints[0], max = array->items.ints[0];
+		for (size_t i = 0; i < n; i++) {
+			yasl_int v = array->items.ints[i];
+			sum += v;
+			dot += v * v;
+			if (v < min) min = v;
+			if (v > max) max = v;
+		}
+		ASSERT_EQ(YASL_ints_sum(array->items.ints, n), sum);
+		ASSERT_EQ(YASL_ints_dot(array->items.ints, array->items.ints, n), dot);
+		ASSERT_EQ(YASL_ints_min(array->items.ints, n), min);
+		ASSERT_EQ(YASL_ints_max(array->items.ints, n), max);
+
+		YASL_ints_add(array->items.ints, array->items.ints, n);
+		YASL_ints_scale(array->items.ints, 3, n);
+		ASSERT_EQ(YASL_ints_sum(array->items.ints, n), sum * 6);
+		YASL_Array_del(array);
+	}
+}
+
+static void testfloatkernels(void) {
+	yasl_float a[9] = { 0.5, -2.0, 4.25, 1.0, -8.0, 3.5, 2.0, 0.0, 7.75 };
+	yasl_float b[9] = { 2.0, 2.0, 2.0, 2.0, 2.0, 2.0, 2.0, 2.0, 2.0 };
+	ASSERT_EQ(YASL_floats_sum(a, 0), 0.0);
+	ASSERT_EQ(YASL_floats_sum(a, 3), 2.75);
+	ASSERT_EQ(YASL_floats_sum(a, 9), 9.0);
+	ASSERT_EQ(YASL_floats_dot(a, b, 9), 18.0);
+	ASSERT_EQ(YASL_floats_min(a, 9), -8.0);
+	ASSERT_EQ(YASL_floats_max(a, 9), 7.75);
+	ASSERT_EQ(YASL_floats_max(a, 2), 0.5);
+
+	YASL_floats_add(b, a, 9);
+	ASSERT_EQ(b[8], 9.75);
+	YASL_floats_scale(b, 0.5, 9);
+	ASSERT_EQ(b[4], -3.0);
+}
+
+static void testbytekernels(void) {
+	struct YASL_Array *array = YASL_Array_new_sized(ARRAY_BYTE, 1);
+	for (size_t i = 0; i < 100; i++) {
+		YASL_Array_reserve(array, array->count + 1);
+		array->items.bytes[array->count++] = (unsigned char)(255 - i);
+	}
+	ASSERT_EQ(YASL_bytes_sum(array->items.bytes, array->count), 20550);
+	ASSERT_EQ(YASL_bytes_dot(array->items.bytes, array->items.bytes, 2), 255 * 255 + 254 * 254);
+	ASSERT_EQ(YASL_bytes_min(array->items.bytes, array->count), 156);
+	ASSERT_EQ(YASL_bytes_max(array->items.bytes, array->count), 255);
+
+	struct YASL_Array *slice = YASL_Array_slice(array, 90, 100);
+	ASSERT_EQ(slice->count, 10);
+	ASSERT_EQ(YASL_bytes_min(slice->items.bytes, slice->count), 156);
+	ASSERT_EQ(YASL_bytes_max(slice->items.bytes, slice->count), 165);
+	YASL_Array_del(slice);
+	YASL_Array_del(array);
+}
+
+TEST(arraytest) {
+	testintkernels();
+	testfloatkernels();
+	testbytekernels();
+
+	return NUM_FAILED;
+}
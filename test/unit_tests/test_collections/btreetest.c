@@ -0,0 +1,141 @@
+#include "btreetest.h"
+#include "test/yats.h"
+#include "data-structures/YASL_BTree.h"
+
+SETUP_YATS();
+
+#define BTREE_TEST_N 2000
+
+/*
+ * Checks that the keys are in order and that every node but the root has enough keys. Returns the subtree's height,
+ * or -1 if its leaves are not all at the same depth.
+ */
+static int check_node(const struct YASL_BTreeNode *node, bool root, yasl_int *prev, size_t *count) {
+	if (!root && (node->count < BTREE_T - 1 || node->count > BTREE_MAXKEYS)) return -1;
+	int height = 0;
+	for (size_t i = 0; i <= node->count; i++) {
+		if (!node->leaf) {
+			const int h = check_node(node->children[i], false, prev, count);
+			if (h < 0 || (i > 0 && h != height)) return -1;
+			height = h;
+		}
+		if (i < node->count) {
+			if (obj_getint(node->keys + i) <= *prev) return -1;
+			*prev = obj_getint(node->keys + i);
+			(*count)++;
+		}
+	}
+	return height + 1;
+}
+
+static bool check_tree(const struct YASL_BTree *tree) {
+	yasl_int prev = -1;
+	size_t count = 0;
+	return check_node(tree->root, true, &prev, &count) > 0 && count == tree->count;
+}
+
+static void testinsertremove(void) {
+	struct YASL_BTree *tree = YASL_BTree_new();
+	bool present[BTREE_TEST_N] = { false };
+	size_t count = 0;
+	for (yasl_int i = 0; i < 4 * BTREE_TEST_N; i++) {
+		const yasl_int k = (i * 7919) % BTREE_TEST_N;
+		struct YASL_Object key = YASL_INT(k);
+		if (i % 3 == 2) {
+			ASSERT_EQ(YASL_BTree_rm(tree, &key), present[k]);
+			count -= present[k];
+			present[k] = false;
+		} else {
+			ASSERT(YASL_BTree_checkkey(tree, &key));
+			YASL_BTree_insert(tree, key, YASL_INT(k * 2));
+			count += !present[k];
+			present[k] = true;
+		}
+	}
+	ASSERT_EQ(tree->count, count);
+	ASSERT(check_tree(tree));
+
+	for (yasl_int k = 0; k < BTREE_TEST_N; k++) {
+		struct YASL_Object key = YASL_INT(k);
+		struct YASL_BTreeEntry entry = YASL_BTree_search(tree, &key);
+		ASSERT_EQ(entry.key != NULL, present[k]);
+		if (entry.key) {
+			ASSERT_EQ(obj_getint(entry.val), k * 2);
+		}
+	}
+
+	for (yasl_int k = 0; k < BTREE_TEST_N; k += 2) {
+		struct YASL_Object key = YASL_INT(k);
+		YASL_BTree_rm(tree, &key);
+		present[k] = false;
+	}
+	ASSERT(check_tree(tree));
+
+	struct YASL_BTreeCursor cursor;
+	yasl_int expected = 0;
+	for (YASL_BTree_seek(tree, &cursor, NULL, false); cursor.depth >= 0; YASL_BTree_cursor_next(&cursor)) {
+		while (!present[expected]) expected++;
+		ASSERT_EQ(obj_getint(YASL_BTree_cursor_entry(&cursor).key), expected);
+		expected++;
+	}
+	while (expected < BTREE_TEST_N && !present[expected]) expected++;
+	ASSERT_EQ(expected, BTREE_TEST_N);
+
+	YASL_BTree_del(tree);
+}
+
+static void testfloorceil(void) {
+	struct YASL_BTree *tree = YASL_BTree_new();
+	for (yasl_int i = 0; i < BTREE_TEST_N; i++) {
+		struct YASL_Object key = YASL_INT(i * 10);
+		YASL_BTree_checkkey(tree, &key);
+		YASL_BTree_insert(tree, key, YASL_UNDEF());
+	}
+
+	struct YASL_Object key = YASL_FLOAT(55.5);
+	ASSERT_EQ(obj_getint(YASL_BTree_floor(tree, &key, false).key), 50);
+	ASSERT_EQ(obj_getint(YASL_BTree_ceil(tree, &key, false).key), 60);
+	key = YASL_INT(60);
+	ASSERT_EQ(obj_getint(YASL_BTree_floor(tree, &key, false).key), 60);
+	ASSERT_EQ(obj_getint(YASL_BTree_floor(tree, &key, true).key), 50);
+	ASSERT_EQ(obj_getint(YASL_BTree_ceil(tree, &key, true).key), 70);
+	key = YASL_INT(-1);
+	ASSERT(YASL_BTree_floor(tree, &key, false).key == NULL);
+	key = YASL_INT(BTREE_TEST_N * 10);
+	ASSERT(YASL_BTree_ceil(tree, &key, false).key == NULL);
+	ASSERT_EQ(obj_getint(YASL_BTree_min(tree).key), 0);
+	ASSERT_EQ(obj_getint(YASL_BTree_max(tree).key), (BTREE_TEST_N - 1) * 10);
+
+	struct YASL_BTreeCursor cursor;
+	key = YASL_INT(12345);
+	YASL_BTree_seek(tree, &cursor, &key, false);
+	ASSERT_EQ(obj_getint(YASL_BTree_cursor_entry(&cursor).key), 12350);
+	YASL_BTree_cursor_next(&cursor);
+	ASSERT_EQ(obj_getint(YASL_BTree_cursor_entry(&cursor).key), 12360);
+
+	YASL_BTree_del(tree);
+}
+
+static void testkinds(void) {
+	struct YASL_BTree *tree = YASL_BTree_new();
+	struct YASL_Object i = YASL_INT(1);
+	struct YASL_Object f = YASL_FLOAT(0.5);
+	struct YASL_Object b = YASL_BOOL(true);
+	ASSERT(YASL_BTree_checkkey(tree, &i));
+	ASSERT(YASL_BTree_checkkey(tree, &f));
+	ASSERT(!YASL_BTree_checkkey(tree, &b));
+	ASSERT_EQ(tree->kind, BTREE_NUM);
+	YASL_BTree_insert(tree, i, YASL_UNDEF());
+	YASL_BTree_insert(tree, f, YASL_UNDEF());
+	ASSERT_EQ(obj_getfloat(YASL_BTree_min(tree).key), 0.5);
+	YASL_BTree_clear(tree);
+	ASSERT_EQ(tree->kind, BTREE_EMPTY);
+	YASL_BTree_del(tree);
+}
+
+TEST(btreetest) {
+	testinsertremove();
+	testfloorceil();
+	testkinds();
+	return NUM_FAILED;
+}
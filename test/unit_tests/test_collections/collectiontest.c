@@ -1,3 +1,7 @@
+#include "arraytest.h"
+#include "btreetest.h"
+#include "dequetest.h"
+#include "heaptest.h"
 #include "settest.h"
 #include "test/yats.h"
 
@@ -9,5 +13,9 @@ SETUP_YATS();
 
 int collectiontest() {
 	RUN(settest);
+	RUN(arraytest);
+	RUN(dequetest);
+	RUN(heaptest);
+	RUN(btreetest);
 	return NUM_FAILED;
 }
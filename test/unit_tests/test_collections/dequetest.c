@@ -0,0 +1,47 @@
+#include "dequetest.h"
+#include "test/yats.h"
+#include "data-structures/YASL_Deque.h"
+
+SETUP_YATS();
+
+static void testwraparound(void) {
+	struct YASL_Deque *deque = YASL_Deque_new_sized(0, 0);
+	for (yasl_int i = 0; i < 6; i++) {
+		YASL_Deque_push(deque, YASL_INT(i));
+	}
+	for (yasl_int i = 0; i < 4; i++) {
+		struct YASL_Object val = YASL_Deque_popleft(deque);
+		ASSERT_EQ(obj_getint(&val), i);
+	}
+	// the next pushes wrap around the end of the buffer, then force it to grow.
+	for (yasl_int i = 6; i < 20; i++) {
+		YASL_Deque_push(deque, YASL_INT(i));
+	}
+	YASL_Deque_pushleft(deque, YASL_INT(3));
+	ASSERT_EQ(deque->count, 17);
+	for (size_t i = 0; i < deque->count; i++) {
+		ASSERT_EQ(obj_getint(YASL_Deque_at(deque, i)), (yasl_int)i + 3);
+	}
+	YASL_Deque_del(deque);
+}
+
+static void testmaxlen(void) {
+	struct YASL_Deque *deque = YASL_Deque_new_sized(0, 3);
+	for (yasl_int i = 0; i < 10; i++) {
+		YASL_Deque_push(deque, YASL_INT(i));
+	}
+	ASSERT_EQ(deque->count, 3);
+	ASSERT_EQ(obj_getint(YASL_Deque_at(deque, 0)), 7);
+	YASL_Deque_pushleft(deque, YASL_INT(-1));
+	ASSERT_EQ(deque->count, 3);
+	ASSERT_EQ(obj_getint(YASL_Deque_at(deque, 0)), -1);
+	ASSERT_EQ(obj_getint(YASL_Deque_at(deque, 2)), 8);
+	YASL_Deque_del(deque);
+}
+
+TEST(dequetest) {
+	testwraparound();
+	testmaxlen();
+
+	return NUM_FAILED;
+}
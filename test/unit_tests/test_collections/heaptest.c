@@ -0,0 +1,54 @@
+#include "heaptest.h"
+#include "test/yats.h"
+#include "data-structures/YASL_Heap.h"
+
+SETUP_YATS();
+
+static struct YASL_HeapEntry int_entry(yasl_int n) {
+	struct YASL_HeapEntry entry = { YASL_INT(n), YASL_INT(n) };
+	return entry;
+}
+
+static void testheapify(void) {
+	struct YASL_Heap *heap = YASL_Heap_new_sized(0);
+	for (yasl_int i = 0; i < 50; i++) {
+		struct YASL_HeapEntry entry = int_entry(i * 37 % 50);
+		ASSERT(YASL_Heap_checkkey(heap, &entry.key));
+		YASL_Heap_append(heap, entry);
+	}
+	YASL_Heap_heapify(heap);
+	ASSERT_EQ(heap->kind, HEAP_INT);
+	for (yasl_int i = 0; i < 50; i++) {
+		struct YASL_HeapEntry entry = YASL_Heap_pop(heap);
+		ASSERT_EQ(obj_getint(&entry.key), i);
+	}
+	ASSERT_EQ(heap->count, 0);
+	YASL_Heap_del(heap);
+}
+
+static void testmixednumbers(void) {
+	struct YASL_Heap *heap = YASL_Heap_new_sized(0);
+	struct YASL_HeapEntry a = int_entry(3), b = { YASL_FLOAT(2.5), YASL_FLOAT(2.5) }, c = int_entry(1);
+	struct YASL_Object str = YASL_STR(NULL);
+	ASSERT(YASL_Heap_checkkey(heap, &a.key));
+	YASL_Heap_push(heap, a);
+	ASSERT(YASL_Heap_checkkey(heap, &b.key));
+	YASL_Heap_push(heap, b);
+	ASSERT(!YASL_Heap_checkkey(heap, &str));
+	ASSERT_EQ(heap->kind, HEAP_NUM);
+
+	struct YASL_HeapEntry top = YASL_Heap_replace(heap, c);
+	ASSERT_EQ(obj_getfloat(&top.key), 2.5);
+	top = YASL_Heap_pop(heap);
+	ASSERT_EQ(obj_getint(&top.key), 1);
+	top = YASL_Heap_pop(heap);
+	ASSERT_EQ(obj_getint(&top.key), 3);
+	YASL_Heap_del(heap);
+}
+
+TEST(heaptest) {
+	testheapify();
+	testmixednumbers();
+
+	return NUM_FAILED;
+}
@@ -134,6 +134,56 @@ static void testremoveset(void) {
 	YASL_Set_del(set);
 }
 
+static void testremovemissingset(void) {
+	struct YASL_Set *set = YASL_Set_new();
+	YASL_Set_insert(set, YASL_INT(1));
+	YASL_Set_rm(set, YASL_INT(2));
+	ASSERT_EQ(YASL_Set_length(set), 1);
+
+	YASL_Set_del(set);
+}
+
+static void testlargeset(void) {
+	struct YASL_Set *left = YASL_Set_new();
+	struct YASL_Set *right = YASL_Set_new_sized(1000);
+	for (yasl_int i = 0; i < 1000; i++) {
+		YASL_Set_insert(left, YASL_INT(i));
+		YASL_Set_insert(right, YASL_INT(i * 2));
+	}
+	for (yasl_int i = 0; i < 1000; i += 2) {
+		YASL_Set_rm(left, YASL_INT(i));
+	}
+	ASSERT_EQ(YASL_Set_length(left), 500);
+	ASSERT_EQ((YASL_Set_search(left, YASL_INT(999))), true);
+	ASSERT_EQ((YASL_Set_search(left, YASL_INT(998))), false);
+
+	struct YASL_Set *set = YASL_Set_union(left, right);
+	ASSERT_EQ(YASL_Set_length(set), 1500);
+	YASL_Set_del(set);
+
+	set = YASL_Set_intersection(left, right);
+	ASSERT_EQ(YASL_Set_length(set), 0);
+	ASSERT_EQ(YASL_Set_isdisjoint(left, right), true);
+	YASL_Set_del(set);
+
+	set = YASL_Set_copy(right);
+	YASL_Set_difference_update(set, left);
+	ASSERT_EQ(YASL_Set_length(set), 1000);
+	YASL_Set_update(set, left);
+	ASSERT_EQ(YASL_Set_length(set), 1500);
+	ASSERT_EQ(YASL_Set_issubset(left, set), true);
+	ASSERT_EQ(YASL_Set_issubset(set, left), false);
+	YASL_Set_intersection_update(set, left);
+	ASSERT_EQ(YASL_Set_length(set), 500);
+	ASSERT_EQ(YASL_Set_issubset(set, left), true);
+	YASL_Set_difference_update(set, set);
+	ASSERT_EQ(YASL_Set_length(set), 0);
+
+	YASL_Set_del(left);
+	YASL_Set_del(right);
+	YASL_Set_del(set);
+}
+
 TEST(settest) {
 	testsearchset();
 	testunionset();
@@ -141,5 +191,7 @@ TEST(settest) {
 	testsymmetricdifferenceset();
 	testdifferenceset();
 	testremoveset();
+	testremovemissingset();
+	testlargeset();
 	return NUM_FAILED;
 }
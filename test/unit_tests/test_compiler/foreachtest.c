@@ -90,8 +90,37 @@ static void test_break() {
 	ASSERT_GEN_BC_EQ(expected, "for i <- [0, 1, 2, 3, 4, 5] { if i == 5 { break; }; echo i; };");
 }
 
+static void test_range() {
+	unsigned char expected[] = {
+		0x1A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x4E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		C_INT_1, 3,
+		O_NCONST,
+		O_LLOAD, 0x00,
+		O_LIT, 0x00,
+		O_INITRANGE, 0x01,
+		O_END,
+		O_BR_8,
+		0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		O_BRF_8,
+		0x17, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		O_ITERRANGE, 0x01,
+		0x0D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		O_LLOAD, 0x01,
+		O_ECHO, 0x02,
+		O_BR_8,
+		0xE9, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+		O_ENDFOR,
+		O_POP,
+		O_HALT
+	};
+	ASSERT_GEN_BC_EQ(expected, "let range = undef; for i <- range(3) { echo i; };");
+}
+
 TEST(foreachtest) {
 	test_continue();
 	test_break();
+	test_range();
 	return NUM_FAILED;
 }
@@ -26,7 +26,55 @@ static void test_simple() {
 
 }
 
+static void test_inline() {
+	unsigned char expected[] = {
+		0x1A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x37, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		C_INT_1, 0x03,
+		O_FCONST,
+		0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // len
+		0x01,	// number of parameters
+		O_LLOAD, 0x00,
+		O_LLOAD, 0x00,
+		O_MUL,
+		O_RET, 0x01,
+		O_NCONST,
+		O_RET, 0x01,
+		O_POP,
+		O_LIT, 0x00,	// sq(3) is inlined
+		O_LIT, 0x00,
+		O_MUL,
+		O_ECHO, 0x01,
+		O_HALT,
+	};
+
+	ASSERT_GEN_BC_EQ(expected, "const fn sq(x) { return x * x; }; echo sq(3);");
+}
+
+static void test_tailcall() {
+	unsigned char expected[] = {
+		0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x2C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		O_FCONST,
+		0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // len
+		0x01,	// number of parameters
+		O_LLOAD, 0x00,
+		O_INIT_CALL, 0xFF,
+		O_TCALL,
+		O_NCONST,
+		O_RET, 0x01,
+		O_POP,
+		O_HALT,
+	};
+
+	ASSERT_GEN_BC_EQ(expected, "fn f(g) { return g(); };");
+}
+
 TEST(functiontest) {
 	test_simple();
+	test_inline();
+	test_tailcall();
 	return NUM_FAILED;
 }
@@ -1,9 +1,13 @@
 #include "env.h"
+#include "names.h"
 #include "yats.h"
 
 SETUP_YATS();
 
-#define ENTER_SCOPE(env) do { (env)->scope = scope_new((env)->scope); } while(0)
+#define ENTER_SCOPE(env) scope_enter(&(env)->scope)
+#define ID(name) names_intern(&names, name, strlen(name))
+
+static struct Names names;
 
 /*
 fn f(a) {
@@ -21,17 +25,18 @@ echo add1(6)
 echo add2(3)
  */
 static void test_two(void) {
+	struct Scope stack = NEW_SCOPE();
 	struct Env *outer = env_new(NULL);
 	struct Env *inner = env_new(outer);
 
 	ENTER_SCOPE(outer);
 	ENTER_SCOPE(inner);
 
-	scope_decl_var(outer->scope, "a");
-	scope_decl_var(outer->scope, "g");
-	scope_decl_var(inner->scope, "b");
+	scope_decl_var(&outer->scope, ID("a"));
+	scope_decl_var(&outer->scope, ID("g"));
+	scope_decl_var(&inner->scope, ID("b"));
 
-	int64_t a = env_resolve_upval_index(inner, NULL, "a");
+	int64_t a = env_resolve_upval_index(inner, &stack, ID("a"));
 	ASSERT_EQ(a, 0);
 
 	env_del(inner);
@@ -53,20 +58,21 @@ echo tmp(1)
 echo tmp(3)
  */
 static void test_multi(void) {
+	struct Scope stack = NEW_SCOPE();
 	struct Env *outer = env_new(NULL);
 	struct Env *inner = env_new(outer);
 
 	ENTER_SCOPE(outer);
 	ENTER_SCOPE(inner);
 
-	scope_decl_var(outer->scope, "x");
-	scope_decl_var(outer->scope, "a");
-	scope_decl_var(outer->scope, "b");
-	scope_decl_var(outer->scope, "g");
-	scope_decl_var(inner->scope, "y");
+	scope_decl_var(&outer->scope, ID("x"));
+	scope_decl_var(&outer->scope, ID("a"));
+	scope_decl_var(&outer->scope, ID("b"));
+	scope_decl_var(&outer->scope, ID("g"));
+	scope_decl_var(&inner->scope, ID("y"));
 
-	int64_t a = env_resolve_upval_index(inner, NULL, "a");
-	int64_t b = env_resolve_upval_index(inner, NULL, "b");
+	int64_t a = env_resolve_upval_index(inner, &stack, ID("a"));
+	int64_t b = env_resolve_upval_index(inner, &stack, ID("b"));
 
 	ASSERT_EQ(a, 0);
 	ASSERT_EQ(b, 1);
@@ -90,28 +96,29 @@ echo tmp(1)
 echo tmp(3)
  */
 static void test_multi_reversed(void) {
+	struct Scope stack = NEW_SCOPE();
 	struct Env *outer = env_new(NULL);
 	struct Env *inner = env_new(outer);
 
 	ENTER_SCOPE(outer);
 	ENTER_SCOPE(inner);
 
-	scope_decl_var(outer->scope, "x");
-	scope_decl_var(outer->scope, "a");
-	scope_decl_var(outer->scope, "b");
-	scope_decl_var(outer->scope, "g");
-	scope_decl_var(inner->scope, "y");
+	scope_decl_var(&outer->scope, ID("x"));
+	scope_decl_var(&outer->scope, ID("a"));
+	scope_decl_var(&outer->scope, ID("b"));
+	scope_decl_var(&outer->scope, ID("g"));
+	scope_decl_var(&inner->scope, ID("y"));
 
-	int64_t b = env_resolve_upval_index(inner, NULL, "b");
-	int64_t a = env_resolve_upval_index(inner, NULL, "a");
-	int64_t a_again = env_resolve_upval_index(inner, NULL, "a");
+	int64_t b = env_resolve_upval_index(inner, &stack, ID("b"));
+	int64_t a = env_resolve_upval_index(inner, &stack, ID("a"));
+	int64_t a_again = env_resolve_upval_index(inner, &stack, ID("a"));
 
 	ASSERT_EQ(a, 1);
 	ASSERT_EQ(a_again, 1);
 	ASSERT_EQ(b, 0);
 
-	int64_t a_value = env_resolve_upval_value(inner, "a");
-	int64_t b_value = env_resolve_upval_value(inner, "b");
+	int64_t a_value = env_resolve_upval_value(inner, ID("a"));
+	int64_t b_value = env_resolve_upval_value(inner, ID("b"));
 	ASSERT_EQ(a_value, 1);
 	ASSERT_EQ(b_value, 2);
 
@@ -135,6 +142,7 @@ let inside = outer()
 inside()
  */
 static void test_deep(void) {
+	struct Scope stack = NEW_SCOPE();
 	struct Env *outer = env_new(NULL);
 	struct Env *middle = env_new(outer);
 	struct Env *inner = env_new(middle);
@@ -143,21 +151,22 @@ static void test_deep(void) {
 	ENTER_SCOPE(middle);
 	ENTER_SCOPE(inner);
 
-	scope_decl_var(outer->scope, "x");
-	scope_decl_var(outer->scope, "middle");
-	scope_decl_var(middle->scope, "inner");
-	scope_decl_var(outer->scope, "i");
+	scope_decl_var(&outer->scope, ID("x"));
+	scope_decl_var(&outer->scope, ID("middle"));
+	scope_decl_var(&middle->scope, ID("inner"));
+	scope_decl_var(&outer->scope, ID("i"));
 
-	ASSERT_EQ(env_resolve_upval_index(inner, NULL, "x"), 0);
-	ASSERT_EQ(env_resolve_upval_value(inner, "x"), ~0);
+	ASSERT_EQ(env_resolve_upval_index(inner, &stack, ID("x")), 0);
+	ASSERT_EQ(env_resolve_upval_value(inner, ID("x")), ~0);
 
-	ASSERT_EQ(env_resolve_upval_index(middle, NULL, "x"), 0);
-	ASSERT_EQ(env_resolve_upval_value(middle, "x"), 0);
+	ASSERT_EQ(env_resolve_upval_index(middle, &stack, ID("x")), 0);
+	ASSERT_EQ(env_resolve_upval_value(middle, ID("x")), 0);
 
 	env_del(inner);
 }
 
 static void test_deep_many_vars(void) {
+	struct Scope stack = NEW_SCOPE();
 	struct Env *outer = env_new(NULL);
 	struct Env *middle = env_new(outer);
 	struct Env *inner = env_new(middle);
@@ -166,30 +175,32 @@ static void test_deep_many_vars(void) {
 	ENTER_SCOPE(middle);
 	ENTER_SCOPE(inner);
 
-	scope_decl_var(outer->scope, "x");
-	scope_decl_var(outer->scope, "y");
-	scope_decl_var(outer->scope, "z");
-	scope_decl_var(outer->scope, "middle");
-	scope_decl_var(middle->scope, "inner");
-	scope_decl_var(outer->scope, "i");
+	scope_decl_var(&outer->scope, ID("x"));
+	scope_decl_var(&outer->scope, ID("y"));
+	scope_decl_var(&outer->scope, ID("z"));
+	scope_decl_var(&outer->scope, ID("middle"));
+	scope_decl_var(&middle->scope, ID("inner"));
+	scope_decl_var(&outer->scope, ID("i"));
 
-	ASSERT_EQ(env_resolve_upval_index(middle, NULL, "y"), 0);
-	ASSERT_EQ(env_resolve_upval_value(middle, "y"), 1);
+	ASSERT_EQ(env_resolve_upval_index(middle, &stack, ID("y")), 0);
+	ASSERT_EQ(env_resolve_upval_value(middle, ID("y")), 1);
 
-	ASSERT_EQ(env_resolve_upval_index(inner, NULL, "z"), 0);
-	ASSERT_EQ(env_resolve_upval_value(inner, "z"), ~1);
+	ASSERT_EQ(env_resolve_upval_index(inner, &stack, ID("z")), 0);
+	ASSERT_EQ(env_resolve_upval_value(inner, ID("z")), ~1);
 
-	ASSERT_EQ(env_resolve_upval_index(middle, NULL, "z"), 1);
-	ASSERT_EQ(env_resolve_upval_value(middle, "z"), 2);
+	ASSERT_EQ(env_resolve_upval_index(middle, &stack, ID("z")), 1);
+	ASSERT_EQ(env_resolve_upval_value(middle, ID("z")), 2);
 
 	env_del(inner);
 }
 
 int envtest(void) {
+	names = NEW_NAMES();
 	test_two();
 	test_multi();
 	test_multi_reversed();
 	test_deep();
 	test_deep_many_vars();
+	names_cleanup(&names);
 	return NUM_FAILED;
 }
@@ -652,6 +652,22 @@ static void test_string(void) {
 	);
 }
 
+static void test_long_runs(void) {
+	USING_LEX(lex, "# a line comment that is longer than one SIMD block\n"
+		       "/* a block comment\n that spans *lines* and is longer than one SIMD block */"
+		       "                                        x = 'a long string with an \\x41 escape in the middle of it'",
+	ASSERT_EATTOK(T_ID, lex);
+	ASSERT_EQ(lex.line, 3);
+	ASSERT_EATTOK(T_EQ, lex);
+	gettok(&lex);
+	ASSERT_TOK_EQ(T_STR, lex.type);
+	ASSERT_EQ(lex.buffer.count, strlen("a long string with an A escape in the middle of it"));
+	ASSERT_EQ(memcmp(lex.buffer.items, "a long string with an A escape in the middle of it", lex.buffer.count), 0);
+	free(lex.buffer.items);
+	ASSERT_EATTOK(T_EOF, lex);
+	);
+}
+
 static void test_division(void) {
 	USING_LEX(lex, "5 / 7.0",
 	ASSERT_EATTOK(T_INT, lex);
@@ -667,6 +683,7 @@ int lexertest(void) {
 	test_binary();
 	test_float();
 	test_string();
+	test_long_runs();
 	test_division();
 
 	test_semi();
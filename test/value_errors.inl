@@ -10,8 +10,32 @@ static const char *value_errors[] = {
   "test/errors/value/list/pop.yasl",
   "test/errors/value/list/__set.yasl",
   "test/errors/value/list/sort.yasl",
+  "test/errors/value/list/sort2.yasl",
+  "test/errors/value/list/sort3.yasl",
+  "test/errors/value/list/sort4.yasl",
   "test/errors/value/str/__get.yasl",
   "test/errors/value/str/replace.yasl",
   "test/errors/value/str/rep.yasl",
   "test/errors/value/str/split.yasl",
+  "test/errors/value/collections/array_dot.yasl",
+  "test/errors/value/collections/array_get.yasl",
+  "test/errors/value/collections/array_pop.yasl",
+  "test/errors/value/collections/bytearray.yasl",
+  "test/errors/value/iter/range.yasl",
+  "test/errors/value/range/step.yasl",
+  "test/errors/value/range/__get.yasl",
+  "test/errors/value/collections/deque_popleft.yasl",
+  "test/errors/value/collections/deque_get.yasl",
+  "test/errors/value/collections/deque.yasl",
+  "test/errors/value/collections/heap_pop.yasl",
+  "test/errors/value/collections/heap_push.yasl",
+  "test/errors/value/collections/sortedmap_set.yasl",
+  "test/errors/value/list/resize.yasl",
+  "test/errors/value/list/swap.yasl",
+  "test/errors/value/table/builtin_clear.yasl",
+  "test/errors/value/table/builtin_set.yasl",
+  "test/errors/value/thread/closed_send.yasl",
+  "test/errors/value/thread/join_twice.yasl",
+  "test/errors/value/coroutine/resume_dead.yasl",
+  "test/errors/value/coroutine/yield_from_c.yasl",
 };
@@ -4,6 +4,8 @@
 #include <string.h>
 #include <stdarg.h>
 
+#include "interpreter/alloc.h"
+
 void io_print_none(struct IO *const io, const char *const format, va_list args)
 {
 	(void)io;
@@ -22,9 +24,9 @@ void io_print_string(struct IO *const io, const char *const format, va_list args
 	va_copy(args_copy, args);
 	size_t len = vsnprintf(NULL, 0, format, args_copy);
 	va_end(args_copy);
+	io->string = (char *)mem_realloc(Y_UNDEF, io->string, io->len + len + 1);
+	vsprintf(io->string + io->len, format, args);
 	io->len += len;
-	io->string = (char *)realloc(io->string, io->len + 1);
-	vsprintf(io->string + io->len - len, format, args);
 }
 
 size_t io_str_strip_char(char *dest, const char *src, size_t n, char rem)
@@ -58,7 +60,7 @@ size_t io_str_strip_char(char *dest, const char *src, size_t n, char rem)
 }
 
 void io_cleanup(struct IO *const io) {
-	free(io->string);
+	mem_free(io->string);
 	//fclose(io->file);
 
 }
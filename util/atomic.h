@@ -0,0 +1,120 @@
+#ifndef YASL_ATOMIC_H_
+#define YASL_ATOMIC_H_
+
+#include <stdlib.h>
+
+/*
+ * The few atomic operations needed for data that several states (and so several threads) hold at once: reference
+ * counts on shared objects and a spin lock for setting them up, plus plain loads and stores of flags that other threads
+ * (or signal handlers) set. Everything else a single state owns is left unsynchronised.
+ */
+
+#if defined __GNUC__ || defined __clang__
+
+static inline size_t atomic_load(volatile size_t *p) {
+	return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+static inline size_t atomic_inc(volatile size_t *p) {
+	return __atomic_add_fetch(p, 1, __ATOMIC_ACQ_REL);
+}
+
+static inline size_t atomic_dec(volatile size_t *p) {
+	return __atomic_sub_fetch(p, 1, __ATOMIC_ACQ_REL);
+}
+
+static inline int atomic_loadint(volatile int *p) {
+	return __atomic_load_n(p, __ATOMIC_RELAXED);
+}
+
+static inline void atomic_storeint(volatile int *p, int v) {
+	__atomic_store_n(p, v, __ATOMIC_RELAXED);
+}
+
+static inline void spin_lock(volatile int *lock) {
+	while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) {
+		/* spin */
+	}
+}
+
+static inline void spin_unlock(volatile int *lock) {
+	__atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+#elif defined _MSC_VER
+#include <intrin.h>
+
+static inline size_t atomic_load(volatile size_t *p) {
+	return *p;
+}
+
+#if defined _WIN64
+static inline size_t atomic_inc(volatile size_t *p) {
+	return (size_t)_InterlockedIncrement64((volatile __int64 *)p);
+}
+
+static inline size_t atomic_dec(volatile size_t *p) {
+	return (size_t)_InterlockedDecrement64((volatile __int64 *)p);
+}
+#else
+static inline size_t atomic_inc(volatile size_t *p) {
+	return (size_t)_InterlockedIncrement((volatile long *)p);
+}
+
+static inline size_t atomic_dec(volatile size_t *p) {
+	return (size_t)_InterlockedDecrement((volatile long *)p);
+}
+#endif
+
+static inline int atomic_loadint(volatile int *p) {
+	return *p;
+}
+
+static inline void atomic_storeint(volatile int *p, int v) {
+	*p = v;
+}
+
+static inline void spin_lock(volatile int *lock) {
+	while (_InterlockedExchange((volatile long *)lock, 1)) {
+		/* spin */
+	}
+}
+
+static inline void spin_unlock(volatile int *lock) {
+	_InterlockedExchange((volatile long *)lock, 0);
+}
+
+#else
+/* Unknown compiler: no threads, so plain operations will do. */
+
+static inline size_t atomic_load(volatile size_t *p) {
+	return *p;
+}
+
+static inline size_t atomic_inc(volatile size_t *p) {
+	return ++*p;
+}
+
+static inline size_t atomic_dec(volatile size_t *p) {
+	return --*p;
+}
+
+static inline int atomic_loadint(volatile int *p) {
+	return *p;
+}
+
+static inline void atomic_storeint(volatile int *p, int v) {
+	*p = v;
+}
+
+static inline void spin_lock(volatile int *lock) {
+	*lock = 1;
+}
+
+static inline void spin_unlock(volatile int *lock) {
+	*lock = 0;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef YASL_CLOCK_H_
+#define YASL_CLOCK_H_
+
+#include <stdint.h>
+
+/*
+ * Milliseconds on a monotonic clock. Only differences between two readings mean anything.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+
+static inline int64_t clock_ms(void) {
+	return (int64_t)GetTickCount64();
+}
+
+#else
+#include <time.h>
+
+static inline int64_t clock_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef YASL_SORT_H_
+#define YASL_SORT_H_
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Stable, adaptive merge sort (a simplified timsort), instantiated per element type.
+ *
+ * DEFINE_SORT(name, T, C, LESS) defines `static void name(T *a, size_t n, C ctx)`, where `LESS(ctx, x, y)` must
+ * return true iff x sorts strictly before y. Runs that are already ordered (or strictly reversed) are found and
+ * merged as is, short runs are extended with a binary insertion sort, and elements that are already in place are
+ * skipped before each merge, so sorted and nearly sorted input take close to linear time.
+ *
+ * It also defines `name##_with(T *a, size_t n, T *tmp, C ctx)`, which takes its scratch space from the caller, for
+ * when LESS may not return. While a merge is in progress, some elements are only in tmp.
+ */
+
+#define SORT_MIN_MERGE 64
+#define SORT_MAX_RUNS 85
+
+// Elements of scratch space needed to sort n elements.
+#define SORT_TMP_LEN(n) ((n) / 2 + 1)
+
+static inline size_t sort_min_run(size_t n) {
+	size_t r = 0;
+	while (n >= SORT_MIN_MERGE) {
+		r |= n & 1;
+		n >>= 1;
+	}
+	return n + r;
+}
+
+#define DEFINE_SORT(name, T, C, LESS) \
+/* first index in [lo, hi) whose element sorts strictly after key */\
+static size_t name##_upper_bound(const T *const a, size_t lo, size_t hi, const T *const key, C ctx) {\
+	(void)ctx;\
+	while (lo < hi) {\
+		const size_t mid = lo + (hi - lo) / 2;\
+		if (LESS(ctx, *key, a[mid])) hi = mid;\
+		else lo = mid + 1;\
+	}\
+	return lo;\
+}\
+\
+/* first index in [lo, hi) whose element does not sort before key */\
+static size_t name##_lower_bound(const T *const a, size_t lo, size_t hi, const T *const key, C ctx) {\
+	(void)ctx;\
+	while (lo < hi) {\
+		const size_t mid = lo + (hi - lo) / 2;\
+		if (LESS(ctx, a[mid], *key)) lo = mid + 1;\
+		else hi = mid;\
+	}\
+	return lo;\
+}\
+\
+static void name##_insertion(T *const a, const size_t lo, size_t start, const size_t hi, C ctx) {\
+	for (; start < hi; start++) {\
+		const T pivot = a[start];\
+		const size_t pos = name##_upper_bound(a, lo, start, &pivot, ctx);\
+		memmove(a + pos + 1, a + pos, (start - pos) * sizeof(T));\
+		a[pos] = pivot;\
+	}\
+}\
+\
+static size_t name##_count_run(T *const a, const size_t lo, const size_t hi, C ctx) {\
+	(void)ctx;\
+	size_t run = lo + 1;\
+	if (run == hi) return 1;\
+	if (LESS(ctx, a[run], a[lo])) {\
+		while (run + 1 < hi && LESS(ctx, a[run + 1], a[run])) run++;\
+		for (size_t i = lo, j = run; i < j; i++, j--) {\
+			const T tmp = a[i];\
+			a[i] = a[j];\
+			a[j] = tmp;\
+		}\
+	} else {\
+		while (run + 1 < hi && !LESS(ctx, a[run + 1], a[run])) run++;\
+	}\
+	return run + 1 - lo;\
+}\
+\
+static void name##_merge_at(T *const a, T *const tmp, size_t *const bases, size_t *const lens, size_t *const num_runs, const size_t i, C ctx) {\
+	size_t base1 = bases[i], len1 = lens[i];\
+	const size_t base2 = bases[i + 1];\
+	size_t len2 = lens[i + 1];\
+	lens[i] = len1 + len2;\
+	if (i + 3 == *num_runs) {\
+		bases[i + 1] = bases[i + 2];\
+		lens[i + 1] = lens[i + 2];\
+	}\
+	(*num_runs)--;\
+\
+	/* skip what is already in place at either end */\
+	const size_t k = name##_upper_bound(a, base1, base2, a + base2, ctx);\
+	len1 -= k - base1;\
+	base1 = k;\
+	if (len1 == 0) return;\
+	len2 = name##_lower_bound(a, base2, base2 + len2, a + base2 - 1, ctx) - base2;\
+	if (len2 == 0) return;\
+\
+	if (len1 <= len2) {\
+		memcpy(tmp, a + base1, len1 * sizeof(T));\
+		size_t x = 0, y = base2, dest = base1;\
+		const size_t end2 = base2 + len2;\
+		while (x < len1 && y < end2) {\
+			if (LESS(ctx, a[y], tmp[x])) a[dest++] = a[y++];\
+			else a[dest++] = tmp[x++];\
+		}\
+		memcpy(a + dest, tmp + x, (len1 - x) * sizeof(T));\
+	} else {\
+		memcpy(tmp, a + base2, len2 * sizeof(T));\
+		size_t x = base1 + len1, y = len2, dest = base2 + len2;\
+		while (x > base1 && y > 0) {\
+			if (LESS(ctx, tmp[y - 1], a[x - 1])) a[--dest] = a[--x];\
+			else a[--dest] = tmp[--y];\
+		}\
+		memcpy(a + dest - y, tmp, y * sizeof(T));\
+	}\
+}\
+\
+/* sorts a using tmp, which must have room for SORT_TMP_LEN(n) elements, as scratch space */\
+static void name##_with(T *const a, const size_t n, T *const tmp, C ctx) {\
+	if (n < 2) return;\
+	if (n < SORT_MIN_MERGE) {\
+		name##_insertion(a, 0, name##_count_run(a, 0, n, ctx), n, ctx);\
+		return;\
+	}\
+\
+	size_t bases[SORT_MAX_RUNS], lens[SORT_MAX_RUNS];\
+	size_t num_runs = 0;\
+	const size_t min_run = sort_min_run(n);\
+	size_t lo = 0;\
+	while (lo < n) {\
+		size_t len = name##_count_run(a, lo, n, ctx);\
+		if (len < min_run) {\
+			const size_t forced = n - lo < min_run ? n - lo : min_run;\
+			name##_insertion(a, lo, lo + len, lo + forced, ctx);\
+			len = forced;\
+		}\
+		bases[num_runs] = lo;\
+		lens[num_runs] = len;\
+		num_runs++;\
+		lo += len;\
+\
+		while (num_runs > 1) {\
+			size_t i = num_runs - 2;\
+			if ((i > 0 && lens[i - 1] <= lens[i] + lens[i + 1]) || (i > 1 && lens[i - 2] <= lens[i - 1] + lens[i])) {\
+				if (lens[i - 1] < lens[i + 1]) i--;\
+			} else if (lens[i] > lens[i + 1]) {\
+				break;\
+			}\
+			name##_merge_at(a, tmp, bases, lens, &num_runs, i, ctx);\
+		}\
+	}\
+	while (num_runs > 1) {\
+		size_t i = num_runs - 2;\
+		if (i > 0 && lens[i - 1] < lens[i + 1]) i--;\
+		name##_merge_at(a, tmp, bases, lens, &num_runs, i, ctx);\
+	}\
+}\
+\
+static inline void name(T *const a, const size_t n, C ctx) {\
+	T *const tmp = n < SORT_MIN_MERGE ? NULL : (T *)malloc(SORT_TMP_LEN(n) * sizeof(T));\
+	name##_with(a, n, tmp, ctx);\
+	free(tmp);\
+}
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef YASL_THREAD_H_
+#define YASL_THREAD_H_
+
+#include <stdlib.h>
+
+/*
+ * Thin wrappers over the platform's threads, mutexes and condition variables, just enough for std/thread. Thread
+ * entry points are declared as `static THREAD_RETURN name(void *arg)` and end with `return THREAD_RESULT;`.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+
+typedef HANDLE yasl_thread;
+typedef CRITICAL_SECTION yasl_mutex;
+typedef CONDITION_VARIABLE yasl_cond;
+
+#define THREAD_RETURN DWORD WINAPI
+#define THREAD_RESULT 0
+
+static inline int thread_start(yasl_thread *thread, LPTHREAD_START_ROUTINE fn, void *arg) {
+	*thread = CreateThread(NULL, 0, fn, arg, 0, NULL);
+	return *thread != NULL;
+}
+
+static inline void thread_join(yasl_thread thread) {
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+}
+
+static inline void mutex_init(yasl_mutex *mutex) {
+	InitializeCriticalSection(mutex);
+}
+
+static inline void mutex_destroy(yasl_mutex *mutex) {
+	DeleteCriticalSection(mutex);
+}
+
+static inline void mutex_lock(yasl_mutex *mutex) {
+	EnterCriticalSection(mutex);
+}
+
+static inline void mutex_unlock(yasl_mutex *mutex) {
+	LeaveCriticalSection(mutex);
+}
+
+static inline void cond_init(yasl_cond *cond) {
+	InitializeConditionVariable(cond);
+}
+
+static inline void cond_destroy(yasl_cond *cond) {
+	(void)cond;
+}
+
+static inline void cond_wait(yasl_cond *cond, yasl_mutex *mutex) {
+	SleepConditionVariableCS(cond, mutex, INFINITE);
+}
+
+static inline void cond_signal(yasl_cond *cond) {
+	WakeConditionVariable(cond);
+}
+
+static inline void cond_broadcast(yasl_cond *cond) {
+	WakeAllConditionVariable(cond);
+}
+
+static inline size_t thread_numcpus(void) {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (size_t)info.dwNumberOfProcessors : 1;
+}
+
+#else
+#include <pthread.h>
+#include <unistd.h>
+
+typedef pthread_t yasl_thread;
+typedef pthread_mutex_t yasl_mutex;
+typedef pthread_cond_t yasl_cond;
+
+#define THREAD_RETURN void *
+#define THREAD_RESULT NULL
+
+static inline int thread_start(yasl_thread *thread, void *(*fn)(void *), void *arg) {
+	return pthread_create(thread, NULL, fn, arg) == 0;
+}
+
+static inline void thread_join(yasl_thread thread) {
+	pthread_join(thread, NULL);
+}
+
+static inline void mutex_init(yasl_mutex *mutex) {
+	pthread_mutex_init(mutex, NULL);
+}
+
+static inline void mutex_destroy(yasl_mutex *mutex) {
+	pthread_mutex_destroy(mutex);
+}
+
+static inline void mutex_lock(yasl_mutex *mutex) {
+	pthread_mutex_lock(mutex);
+}
+
+static inline void mutex_unlock(yasl_mutex *mutex) {
+	pthread_mutex_unlock(mutex);
+}
+
+static inline void cond_init(yasl_cond *cond) {
+	pthread_cond_init(cond, NULL);
+}
+
+static inline void cond_destroy(yasl_cond *cond) {
+	pthread_cond_destroy(cond);
+}
+
+static inline void cond_wait(yasl_cond *cond, yasl_mutex *mutex) {
+	pthread_cond_wait(cond, mutex);
+}
+
+static inline void cond_signal(yasl_cond *cond) {
+	pthread_cond_signal(cond);
+}
+
+static inline void cond_broadcast(yasl_cond *cond) {
+	pthread_cond_broadcast(cond);
+}
+
+static inline size_t thread_numcpus(void) {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (size_t)n : 1;
+}
+
+#endif
+
+#endif
@@ -4,11 +4,25 @@
 #include <interpreter/YASL_Object.h>
 
 #include "interpreter/table_methods.h"
+#include "interpreter/range_methods.h"
 #include "interpreter/userdata.h"
+#include "interpreter/clone.h"
 #include "yasl_state.h"
 #include "compiler/compiler.h"
 #include "interpreter/VM.h"
 #include "compiler/lexinput.h"
+#include "util/atomic.h"
+
+static void decl_global(struct YASL_State *S, const char *name, const size_t len) {
+	const size_t id = names_intern(&S->compiler.parser.names, name, len);
+	scope_decl_var_with_index(&S->compiler.globals, id, compiler_intern_string(&S->compiler, name, len));
+}
+
+static void decl_builtins(struct YASL_State *S) {
+	YASL_declglobal(S, "range");
+	YASL_pushcfunction(S, &range_new, 3);
+	YASL_setglobal(S, "range");
+}
 
 struct YASL_State *YASL_newstate_num(const char *filename, size_t num) {
 	FILE *fp = fopen(filename, "r");
@@ -52,6 +66,8 @@ struct YASL_State *YASL_newstate(const char *filename) {
 	YASL_pushlit(S, YASL_VERSION);
 	YASL_setglobal(S, "__VERSION__");
 
+	decl_builtins(S);
+
 	return S;
 }
 
@@ -105,9 +121,38 @@ struct YASL_State *YASL_newstate_bb(const char *buf, size_t len) {
 	S->compiler.num = 0;
 
 	vm_init((struct VM *) S, NULL, -1, 1);
+	decl_builtins(S);
 	return S;
 }
 
+struct YASL_State *YASL_clonestate(struct YASL_State *S) {
+	if (clone_cannotclone((struct VM *) S)) {
+		return NULL;
+	}
+
+	struct YASL_State *C = (struct YASL_State *) malloc(sizeof(struct YASL_State));
+
+	struct LEXINPUT *lp = lexinput_new_bb("", 0);
+	struct Compiler tcomp = NEW_COMPILER(lp);
+	C->compiler = tcomp;
+	C->compiler.num = S->compiler.num;
+
+	// Code compiled in C must agree with S's functions about where each constant is.
+	YASL_ByteBuffer_extend(C->compiler.header, S->compiler.header->items, S->compiler.header->count);
+	FOR_TABLE(i, item, S->compiler.strings) {
+		YASL_Table_insert_fast(C->compiler.strings, clone_freeze(&S->vm, item->key), item->value);
+	}
+
+	vm_init((struct VM *) C, NULL, -1, S->vm.headers_size);
+	clone_vm((struct VM *) C, (struct VM *) S);
+
+	FOR_TABLE(j, global, C->vm.globals) {
+		decl_global(C, YASL_String_chars(global->key.value.sval), YASL_String_len(global->key.value.sval));
+	}
+
+	return C;
+}
+
 int YASL_resetstate_bb(struct YASL_State *S, const char *buf, size_t len) {
 	S->compiler.status = YASL_SUCCESS;
 	S->compiler.parser.status = YASL_SUCCESS;
@@ -115,7 +160,7 @@ int YASL_resetstate_bb(struct YASL_State *S, const char *buf, size_t len) {
 	S->compiler.parser.lex = NEW_LEXER(lexinput_new_bb(buf, len));
 	S->compiler.code->count = 0;
 	S->compiler.buffer->count = 0;
-	if (S->vm.code)	free(S->vm.code);
+	if (S->vm.code && !S->vm.program) free(S->vm.code);
 	S->vm.code = NULL;
 
 	return YASL_SUCCESS;
@@ -167,9 +212,60 @@ int YASL_execute(struct YASL_State *S) {
 	return result;
 }
 
+struct YASL_Program *YASL_compileprogram(struct YASL_State *S) {
+	unsigned char *bc = compile(&S->compiler);
+	if (!bc) return NULL;
+
+	return program_new(bc);
+}
+
+int YASL_runprogram(struct YASL_State *S, struct YASL_Program *P) {
+	return vm_run_program((struct VM *) S, P);
+}
+
+int YASL_resume(struct YASL_State *S, int n) {
+	return vm_resume((struct VM *) S, n);
+}
+
+void YASL_setbudget(struct YASL_State *S, yasl_int steps, yasl_int ms) {
+	vm_setbudget((struct VM *) S, steps, ms);
+}
+
+void YASL_sethook(struct YASL_State *S, YASL_hook hook, void *data) {
+	S->vm.hook = hook;
+	S->vm.hook_data = data;
+}
+
+void YASL_interrupt(struct YASL_State *S) {
+	atomic_storeint(&S->vm.interrupted, 1);
+}
+
+void YASL_setmemlimit(struct YASL_State *S, size_t bytes) {
+	S->vm.alloc->limit = bytes;
+}
+
+size_t YASL_memused(struct YASL_State *S, int type) {
+	if (type == YASL_MEM_TOTAL) {
+		return S->vm.alloc->total;
+	}
+	YASL_ASSERT(0 <= type && type < MEM_NUM_TYPES, "type should be a type of object");
+	return S->vm.alloc->types[type].live;
+}
+
+size_t YASL_mempeak(struct YASL_State *S, int type) {
+	if (type == YASL_MEM_TOTAL) {
+		return S->vm.alloc->peak;
+	}
+	YASL_ASSERT(0 <= type && type < MEM_NUM_TYPES, "type should be a type of object");
+	return S->vm.alloc->types[type].peak;
+}
+
+void YASL_delprogram(struct YASL_Program *P) {
+	program_dec_ref(P);
+}
+
 int YASL_declglobal(struct YASL_State *S, const char *name) {
-	compiler_intern_string(&S->compiler, name, strlen(name));
-	scope_decl_var(S->compiler.globals, name);
+	decl_global(S, name, strlen(name));
 	return YASL_SUCCESS;
 }
 
@@ -179,9 +275,10 @@ static inline int is_const(int64_t value) {
 }
 
 int YASL_setglobal(struct YASL_State *S, const char *name) {
-	if (!scope_contains(S->compiler.globals, name)) return YASL_ERROR;
+	const size_t id = names_intern(&S->compiler.parser.names, name, strlen(name));
+	if (!scope_contains(&S->compiler.globals, id)) return YASL_ERROR;
 
-	int64_t index = scope_get(S->compiler.globals, name);
+	int64_t index = scope_get(&S->compiler.globals, id);
 	if (is_const(index)) return YASL_ERROR;
 
 	struct YASL_String *string = YASL_String_new_sized(strlen(name), name);
@@ -206,10 +303,37 @@ int YASL_registermt(struct YASL_State *S, const char *name) {
 	struct YASL_String *string = YASL_String_new_sized(strlen(name), name);
 	YASL_Table_insert_fast(S->vm.metatables, YASL_STR(string), vm_peek((struct VM *) S));
 	YASL_pop(S);
+	vm_clear_type_mts(&S->vm);
 
 	return YASL_SUCCESS;
 }
 
+/*
+ * Ids are handed out from one counter for the whole process, so a type has the same id in every state, and can be
+ * used from any thread.
+ */
+static volatile int type_lock = 0;
+static int num_types = 0;
+
+static int type_id(struct YASL_Type *type) {
+	int id = atomic_loadint(&type->id);
+	if (!id) {
+		spin_lock(&type_lock);
+		id = type->id;
+		if (!id) {
+			id = ++num_types;
+			atomic_storeint(&type->id, id);
+		}
+		spin_unlock(&type_lock);
+	}
+	return id;
+}
+
+int YASL_registertype(struct YASL_State *S, struct YASL_Type *type) {
+	type_id(type);
+	return YASL_registermt(S, type->name);
+}
+
 int YASL_loadmt(struct YASL_State *S, const char *name) {
 	struct YASL_String *string = YASL_String_new_sized(strlen(name), name);
 	struct YASL_Object mt = YASL_Table_search(S->vm.metatables, YASL_STR(string));
@@ -300,6 +424,18 @@ void YASL_pushuserdata(struct YASL_State *S, void *data, const char *tag, void (
 	vm_push(&S->vm, YASL_USERDATA(ud_new(data, tag, NULL, destructor)));
 }
 
+void *YASL_pushobject(struct YASL_State *S, struct YASL_Type *type) {
+	struct RC_UserData *mt = vm_type_mt(&S->vm, type_id(type), type->name);
+	struct RC_UserData *ud = ud_new_inline(type->size, type->name, mt, type->finalizer);
+	vm_push(&S->vm, YASL_USERDATA(ud));
+	return ud->data;
+}
+
+void YASL_pushobjectptr(struct YASL_State *S, struct YASL_Type *type, void *data) {
+	struct RC_UserData *mt = vm_type_mt(&S->vm, type_id(type), type->name);
+	vm_push(&S->vm, YASL_USERDATA(ud_new(data, type->name, mt, type->finalizer)));
+}
+
 void YASL_pushuserptr(struct YASL_State *S, void *userpointer) {
 	vm_push((struct VM *) S, YASL_USERPTR(userpointer));
 }
@@ -326,6 +462,10 @@ void YASL_pushlstr(struct YASL_State *S, const char *value, size_t len) {
 	vm_pushstr((struct VM *)S, YASL_String_new_sized_heap(0, len, buffer));
 }
 
+void YASL_pushextstr(struct YASL_State *S, const char *value, size_t len, void (*release)(void *), void *data) {
+	vm_pushstr(&S->vm, YASL_String_new_external(len, value, release, data));
+}
+
 void YASL_pushstring(struct YASL_State *S, const char *value, const size_t size) {
 	vm_pushstr((struct VM *) S, YASL_String_new_sized_heap(0, size, value));
 }
@@ -350,6 +490,43 @@ void YASL_pushlist(struct YASL_State *S) {
 	vm_push(&S->vm, YASL_LIST(list));
 }
 
+/*
+ * The list is pushed before it is filled in, so anything already in it is cleaned up if filling it in fails.
+ */
+static struct YASL_List *push_sized_list(struct YASL_State *S, const size_t n) {
+	struct RC_UserData *list = rcls_new_sized(n ? n : LIST_BASESIZE);
+	ud_setmt(list, S->vm.builtins_htable[Y_LIST]);
+	vm_push(&S->vm, YASL_LIST(list));
+	return (struct YASL_List *)list->data;
+}
+
+void YASL_pushintlist(struct YASL_State *S, const yasl_int *values, size_t n) {
+	struct YASL_List *ls = push_sized_list(S, n);
+	for (size_t i = 0; i < n; i++) {
+		ls->items[i] = YASL_INT(values[i]);
+	}
+	ls->count = n;
+}
+
+void YASL_pushfloatlist(struct YASL_State *S, const yasl_float *values, size_t n) {
+	struct YASL_List *ls = push_sized_list(S, n);
+	for (size_t i = 0; i < n; i++) {
+		ls->items[i] = YASL_FLOAT(values[i]);
+	}
+	ls->count = n;
+}
+
+void YASL_pushstrlist(struct YASL_State *S, const char *const *values, const size_t *lens, size_t n) {
+	struct YASL_List *ls = push_sized_list(S, n);
+	for (size_t i = 0; i < n; i++) {
+		const size_t len = lens ? lens[i] : strlen(values[i]);
+		struct YASL_String *str = YASL_String_new_sized_heap(0, len, copy_char_buffer(len, values[i]));
+		ls->items[i] = YASL_STR(str);
+		inc_ref(ls->items + i);
+		ls->count++;
+	}
+}
+
 yasl_int YASL_peekvargscount(struct YASL_State *S) {
 	struct VM *vm = (struct VM *)S;
 	yasl_int num_args = vm_peek(vm, vm->fp).value.cval->num_args;
@@ -392,6 +569,55 @@ bool YASL_tablenext(struct YASL_State *S) {
 	return true;
 }
 
+static struct YASL_Value value_view(const struct YASL_Object *const v) {
+	struct YASL_Value view;
+	view.type = v->type;
+	switch (v->type) {
+	case Y_BOOL:
+		view.value.bval = obj_getbool(v);
+		break;
+	case Y_INT:
+		view.value.ival = obj_getint(v);
+		break;
+	case Y_FLOAT:
+		view.value.dval = obj_getfloat(v);
+		break;
+	case Y_STR:
+		view.value.sval.chars = YASL_String_chars(obj_getstr(v));
+		view.value.sval.len = YASL_String_len(obj_getstr(v));
+		break;
+	case Y_USERDATA:
+		view.value.pval = YASL_GETUSERDATA(*v)->data;
+		break;
+	case Y_USERPTR:
+		view.value.pval = obj_getuserptr(v);
+		break;
+	default:
+		view.value.pval = NULL;
+		break;
+	}
+	return view;
+}
+
+size_t YASL_peektablevalues(struct YASL_State *S, struct YASL_Value *keys, struct YASL_Value *values, size_t n) {
+	if (!YASL_istable(S)) {
+		return 0;
+	}
+
+	const struct YASL_Table *table = vm_peektable(&S->vm);
+	size_t count = 0;
+	for (size_t i = 0; i < table->size && count < n; i++) {
+		const struct YASL_Table_Item *item = table->items + i;
+		if (item->key.type == Y_END || item->key.type == Y_UNDEF) {
+			continue;
+		}
+		keys[count] = value_view(&item->key);
+		values[count] = value_view(&item->value);
+		count++;
+	}
+	return count;
+}
+
 int YASL_tableset(struct YASL_State *S) {
 	struct YASL_Object value = vm_pop(&S->vm);
 	struct YASL_Object key = vm_pop(&S->vm);
@@ -399,6 +625,8 @@ int YASL_tableset(struct YASL_State *S) {
 
 	if (!obj_istable(&table))
 		return YASL_TYPE_ERROR;
+	if (rc_isimmortal(YASL_GETUSERDATA(table)->rc))
+		return YASL_VALUE_ERROR;
 	if (!YASL_Table_insert(YASL_GETTABLE(table), key, value)) {
 		return YASL_TYPE_ERROR;
 	}
@@ -447,6 +675,125 @@ int YASL_functioncall(struct YASL_State *S, int n) {
 	return old_sp - vm->sp - 1;
 }
 
+/*
+ * A function pinned by the host. The results of the last call through it are kept here, so that strings in them can be
+ * lent out until the next call.
+ */
+struct YASL_Function {
+	struct YASL_Object fn;
+	struct YASL_Object *results;
+	int num_results;
+	int results_size;
+};
+
+struct YASL_Function *YASL_popfunction(struct YASL_State *S) {
+	struct YASL_Object fn = vm_pop(&S->vm);
+	if (!obj_isfn(&fn) && !obj_isclosure(&fn) && !obj_iscfn(&fn)) {
+		return NULL;
+	}
+
+	struct YASL_Function *F = (struct YASL_Function *)malloc(sizeof(struct YASL_Function));
+	F->fn = fn;
+	inc_ref(&F->fn);
+	F->results = NULL;
+	F->num_results = 0;
+	F->results_size = 0;
+	return F;
+}
+
+static void function_release_results(struct YASL_Function *F) {
+	for (int i = 0; i < F->num_results; i++) {
+		dec_ref(F->results + i);
+	}
+	F->num_results = 0;
+}
+
+void YASL_delfunction(struct YASL_Function *F) {
+	function_release_results(F);
+	dec_ref(&F->fn);
+	free(F->results);
+	free(F);
+}
+
+static bool value_object(const struct YASL_Value *const v, struct YASL_Object *const obj) {
+	switch (v->type) {
+	case Y_UNDEF:
+		*obj = YASL_UNDEF();
+		return true;
+	case Y_BOOL:
+		*obj = YASL_BOOL(v->value.bval);
+		return true;
+	case Y_INT:
+		*obj = YASL_INT(v->value.ival);
+		return true;
+	case Y_FLOAT:
+		*obj = YASL_FLOAT(v->value.dval);
+		return true;
+	case Y_STR: {
+		const size_t len = v->value.sval.len;
+		*obj = YASL_STR(YASL_String_new_sized_heap(0, len, copy_char_buffer(len, v->value.sval.chars)));
+		return true;
+	}
+	case Y_USERPTR:
+		*obj = YASL_USERPTR(v->value.pval);
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * The function and its arguments are written straight into the stack after a single check for room, and the call
+ * skips the checks and metamethod lookups a general call needs, since F is known to be callable.
+ */
+int YASL_callfunction(struct YASL_State *S, struct YASL_Function *F, const struct YASL_Value *args, int nargs,
+		      struct YASL_Value *results, int nresults) {
+	struct VM *vm = &S->vm;
+	if (vm->sp + 1 + nargs >= vm->stack_size && !vm_growstack(vm, vm->sp + 2 + nargs)) {
+		vm_print_err(vm, "StackOverflow.");
+		return YASL_STACK_OVERFLOW_ERROR;
+	}
+
+	const int sp = vm->sp;
+	struct YASL_Object *slot = vm->stack + sp + 1;
+	vm_dec_ref(vm, slot);
+	*slot = F->fn;
+	inc_ref(slot);
+	vm->sp++;
+	for (int i = 0; i < nargs; i++) {
+		struct YASL_Object arg;
+		if (!value_object(args + i, &arg)) {
+			vm->sp = sp;
+			return YASL_TYPE_ERROR;
+		}
+		slot = vm->stack + vm->sp + 1;
+		vm_dec_ref(vm, slot);
+		*slot = arg;
+		inc_ref(slot);
+		vm->sp++;
+	}
+
+	const int status = vm_call_direct(vm, nargs, nresults);
+	if (status != YASL_SUCCESS) {
+		return status;
+	}
+
+	function_release_results(F);
+	if (nresults > F->results_size) {
+		F->results = (struct YASL_Object *)realloc(F->results, nresults * sizeof(struct YASL_Object));
+		F->results_size = nresults;
+	}
+	const struct YASL_Object *rets = vm->stack + vm->sp - nresults + 1;
+	for (int i = 0; i < nresults; i++) {
+		F->results[i] = rets[i];
+		inc_ref(F->results + i);
+		results[i] = value_view(F->results + i);
+	}
+	F->num_results = nresults;
+	vm->sp -= nresults;
+	return YASL_SUCCESS;
+}
+
 bool YASL_isundef(struct YASL_State *S) {
 	return vm_isundef(&S->vm);
 }
@@ -596,10 +943,56 @@ char *YASL_popcstr(struct YASL_State *S) {
 	return tmp;
 }
 
+size_t YASL_peeklistints(struct YASL_State *S, yasl_int *values, size_t n) {
+	if (!YASL_islist(S)) {
+		return 0;
+	}
+
+	const struct YASL_List *ls = vm_peeklist(&S->vm);
+	size_t i = 0;
+	for (; i < n && i < ls->count && obj_isint(ls->items + i); i++) {
+		values[i] = obj_getint(ls->items + i);
+	}
+	return i;
+}
+
+size_t YASL_peeklistfloats(struct YASL_State *S, yasl_float *values, size_t n) {
+	if (!YASL_islist(S)) {
+		return 0;
+	}
+
+	const struct YASL_List *ls = vm_peeklist(&S->vm);
+	size_t i = 0;
+	for (; i < n && i < ls->count && obj_isfloat(ls->items + i); i++) {
+		values[i] = obj_getfloat(ls->items + i);
+	}
+	return i;
+}
+
+size_t YASL_peeklistvalues(struct YASL_State *S, struct YASL_Value *values, size_t n) {
+	if (!YASL_islist(S)) {
+		return 0;
+	}
+
+	const struct YASL_List *ls = vm_peeklist(&S->vm);
+	size_t i = 0;
+	for (; i < n && i < ls->count; i++) {
+		values[i] = value_view(ls->items + i);
+	}
+	return i;
+}
+
 void *YASL_peeknuserdata(struct YASL_State *S, unsigned n) {
 	return YASL_GETUSERDATA(vm_peek(&S->vm, S->vm.fp + 1 + n))->data;
 }
 
+void *YASL_peeknobject(struct YASL_State *S, const struct YASL_Type *type, unsigned n) {
+	if (!YASL_isnuserdata(S, type->name, n)) {
+		return NULL;
+	}
+	return YASL_GETUSERDATA(vm_peek(&S->vm, S->vm.fp + 1 + n))->data;
+}
+
 void *YASL_popuserdata(struct YASL_State *S) {
 	return YASL_GETUSERDATA(vm_pop(&S->vm))->data;
 }
@@ -13,13 +13,55 @@
 #define YASL_FLOAT_NAME "float"
 #define YASL_TABLE_NAME "table"
 
+// Passed to YASL_memused and YASL_mempeak for the memory used by everything in the state.
+#define YASL_MEM_TOTAL (-1)
+
 struct YASL_State;
+struct YASL_Program;
+struct YASL_Function;
 
 /**
  * Typedef for YASL functions defined through the C API.
  */
 typedef int (*YASL_cfn)(struct YASL_State *);
 
+/**
+ * Typedef for hooks, see YASL_sethook.
+ */
+typedef int (*YASL_hook)(struct YASL_State *, void *);
+
+/**
+ * A value read out of a list or table in bulk, see YASL_peeklistvalues and
+ * YASL_peektablevalues. Strings are borrowed, not copied: their chars stay valid only as
+ * long as the string is still in the list or table.
+ */
+struct YASL_Value {
+	int type;                   // as returned by YASL_peektype
+	union {
+		bool bval;
+		yasl_int ival;
+		yasl_float dval;
+		struct {
+			const char *chars;  // not nul-terminated
+			size_t len;
+		} sval;
+		void *pval;             // for userdata and userptrs, as returned by YASL_peekuserdata or YASL_peekuserptr
+	} value;
+};
+
+/**
+ * A type of userdata whose data is stored inline, see YASL_pushobject. Declare one
+ * statically for each type, with id set to 0; YASL gives it an id the first time it is
+ * used, which is the same in every state. Objects of the type are tagged with name, so
+ * they can also be checked with YASL_isnuserdata(S, type.name, n).
+ */
+struct YASL_Type {
+	const char *name;            // tag of the objects, and name of their metatable
+	size_t size;                 // bytes of data in each object
+	void (*finalizer)(void *);   // called with the data when an object is freed, or NULL
+	int id;
+};
+
 /**
  * [-0, +0]
  * compiles the source for the given YASL_State, but doesn't
@@ -39,12 +81,15 @@ int YASL_compile(struct YASL_State *S);
 int YASL_declglobal(struct YASL_State *S, const char *name);
 
 int YASL_decllib_collections(struct YASL_State *S);
+int YASL_decllib_coroutine(struct YASL_State *S);
 int YASL_decllib_error(struct YASL_State *S);
 int YASL_decllib_io(struct YASL_State *S);
+int YASL_decllib_iter(struct YASL_State *S);
 int YASL_decllib_math(struct YASL_State *S);
 int YASL_decllib_require(struct YASL_State *S);
 int YASL_decllib_require_c(struct YASL_State *S);
 int YASL_decllib_mt(struct YASL_State *S);
+int YASL_decllib_thread(struct YASL_State *S);
 
 /**
  * deletes the given YASL_State.
@@ -79,6 +124,124 @@ int YASL_execute(struct YASL_State *S);
  */
 int YASL_execute_REPL(struct YASL_State *S);
 
+/**
+ * [-0, +0]
+ * Compiles the source of the given YASL_State into a YASL_Program, which can then be run
+ * in any number of YASL_States without compiling it again. Any state that runs the program
+ * must declare the same globals as S did before compiling (for example, by calling
+ * YASLX_decllibs on both); a state made with YASL_newstate_bb("", 0) works for this.
+ * @param S the YASL_State whose source to compile.
+ * @return the compiled program, or NULL if compilation failed, in which case the error can
+ * be loaded with YASL_loadprinterr.
+ */
+struct YASL_Program *YASL_compileprogram(struct YASL_State *S);
+
+/**
+ * [-0, +0]
+ * Runs a YASL_Program from the start in the given YASL_State. A state may run the same
+ * program any number of times, but running a different program in it is an error.
+ * @param S the YASL_State to run the program in.
+ * @param P the program to run.
+ * @return 0 on successful execution, else an error code.
+ */
+int YASL_runprogram(struct YASL_State *S, struct YASL_Program *P);
+
+/**
+ * [-n, +r]
+ * Continues a state that was suspended by a call to coroutine.yield outside of any
+ * coroutine. When that happens, YASL_execute (or YASL_execute_REPL, YASL_runprogram, or
+ * YASL_resume itself) returns YASL_YIELD, and the values passed to yield are left on top
+ * of the stack, with YASL_peekvargscount giving how many there are. The host may pop them,
+ * then push the n values the yield should return, and call YASL_resume once it is ready,
+ * e.g. from its event loop once some I/O is done. Yields from inside a function called
+ * from C are not allowed.
+ * @param S the suspended YASL_State.
+ * @param n the number of values to return from the yield.
+ * A state preempted by YASL_setbudget is continued the same way, with n = 0.
+ * @return the same as YASL_execute: 0 once the script finishes, YASL_YIELD if it yields
+ * again, YASL_PREEMPTED if it is preempted, else an error code.
+ */
+int YASL_resume(struct YASL_State *S, int n);
+
+/**
+ * [-0, +0]
+ * Limits how long the state may run before it is preempted. Every time a loop goes around
+ * or a function is called counts as a step. Once the state has taken the given number of
+ * steps, or the given number of milliseconds have passed since this call, the script is
+ * suspended as soon as it is back in its own code (not in a coroutine or a call from C),
+ * and YASL_execute (or whatever was running it) returns YASL_PREEMPTED. Call
+ * YASL_setbudget again, then YASL_resume(S, 0), to continue it. A script that is still in
+ * a coroutine or a call from C YASL_POLL_INTERVAL steps after running out can't be
+ * suspended, so it stops with YASL_BUDGET_ERROR instead, like any other error.
+ * @param S the YASL_State.
+ * @param steps how many steps the state may take, or 0 for no limit.
+ * @param ms how many milliseconds the state may run for, or 0 for no limit.
+ */
+void YASL_setbudget(struct YASL_State *S, yasl_int steps, yasl_int ms);
+
+/**
+ * [-0, +0]
+ * Sets a function that the state calls every YASL_POLL_INTERVAL steps while it runs (see
+ * YASL_setbudget), with data as its second argument. The hook must leave the stack as it
+ * found it. If it returns YASL_SUCCESS, the script continues; if it returns YASL_PREEMPTED,
+ * the script is preempted as if it had run out of budget; anything else stops the script
+ * with that error code. Pass NULL to remove the hook.
+ * @param S the YASL_State.
+ * @param hook the hook, or NULL.
+ * @param data passed to the hook.
+ */
+void YASL_sethook(struct YASL_State *S, YASL_hook hook, void *data);
+
+/**
+ * [-0, +0]
+ * Makes the script running in the state stop with YASL_INTERRUPT_ERROR the next time it
+ * checks (every YASL_POLL_INTERVAL steps). Safe to call from a signal handler, or from
+ * another thread.
+ * @param S the YASL_State.
+ */
+void YASL_interrupt(struct YASL_State *S);
+
+/**
+ * [-0, +0]
+ * Limits how much memory the state's objects may use. Once a script would go over the
+ * limit, it stops with YASL_MEMORY_ERROR instead, the same as for any other error, and the
+ * state can be used again afterwards. Only memory for objects made while the state is
+ * running code is counted. The limit is checked between steps rather than as objects are
+ * made, so a single step (such as a call to a C function) may go past it before the script
+ * stops, and the state may already be over it by the time it is set.
+ * @param S the YASL_State.
+ * @param bytes the most memory the state may use, or 0 for no limit.
+ */
+void YASL_setmemlimit(struct YASL_State *S, size_t bytes);
+
+/**
+ * [-0, +0]
+ * Returns how much memory the state's objects of the given type use right now, counted
+ * the same way as for YASL_setmemlimit.
+ * @param S the YASL_State.
+ * @param type one of the types returned by YASL_peektype, or YASL_MEM_TOTAL for all of
+ * them, along with memory that belongs to no object, such as the state's stacks.
+ * @return the number of bytes in use.
+ */
+size_t YASL_memused(struct YASL_State *S, int type);
+
+/**
+ * [-0, +0]
+ * Returns the most memory the state's objects of the given type have used at once.
+ * @param S the YASL_State.
+ * @param type as for YASL_memused.
+ * @return the number of bytes.
+ */
+size_t YASL_mempeak(struct YASL_State *S, int type);
+
+/**
+ * [-0, +0]
+ * Releases the reference to a YASL_Program returned by YASL_compileprogram. States that
+ * have run the program keep it alive until they are deleted.
+ * @param P the program to release.
+ */
+void YASL_delprogram(struct YASL_Program *P);
+
 /**
  * [-(n+1), +r]
  * Calls a function with n parameters. The function should be located below all n
@@ -90,6 +253,44 @@ int YASL_execute_REPL(struct YASL_State *S);
  */
 int YASL_functioncall(struct YASL_State *S, int n);
 
+/**
+ * [-1, +0]
+ * Pops a function off the stack and returns a handle to it, so it can be called again and
+ * again with YASL_callfunction without looking it up each time. The handle keeps the
+ * function alive until it is deleted with YASL_delfunction, which must happen on the
+ * state's thread, before the state is reset or deleted.
+ * @param S the YASL_State.
+ * @return the handle, or NULL if the top of the stack was not a function.
+ */
+struct YASL_Function *YASL_popfunction(struct YASL_State *S);
+
+/**
+ * [-0, +0]
+ * Releases a handle made by YASL_popfunction.
+ * @param F the handle to release.
+ */
+void YASL_delfunction(struct YASL_Function *F);
+
+/**
+ * [-0, +0]
+ * Calls the function F with the nargs arguments in args, and writes its first nresults
+ * results to results (padded with undef if it returns fewer). Arguments may be undef,
+ * bools, ints, floats, strings (which are copied) or userptrs. Strings in results are
+ * borrowed from F, and stay valid until the next call through F or until it is deleted.
+ * Errors are caught, leaving the state as it was before the call. This may be called
+ * from the host, or from a C function while a script is running.
+ * @param S the YASL_State F came from.
+ * @param F the function to call.
+ * @param args the arguments to call it with.
+ * @param nargs the number of arguments.
+ * @param results where to write the results.
+ * @param nresults the number of results wanted.
+ * @return YASL_SUCCESS, YASL_TYPE_ERROR if one of args can't be passed, else the error the
+ * function raised.
+ */
+int YASL_callfunction(struct YASL_State *S, struct YASL_Function *F, const struct YASL_Value *args, int nargs,
+		      struct YASL_Value *results, int nresults);
+
 /**
  * [-0, +0]
  * checks if the top of the stack is bool.
@@ -299,6 +500,29 @@ struct YASL_State *YASL_newstate(const char *filename);
  */
 struct YASL_State *YASL_newstate_bb(const char *buf, size_t len);
 
+/**
+ * Makes a new YASL_State that starts from where S is, without running any of S's setup again. The
+ * new state has the same globals (with any libraries S declared) and metatables as S, and can
+ * use functions defined by S. Tables, lists, closures, and sets, deques, heaps and arrays
+ * reachable from these are copied, so the new state can change them without affecting S; strings
+ * and C functions are made read-only and shared. Userdata without a destructor, such as
+ * io.stdout, point at the same data in both states. Other userdata, such as open files and
+ * coroutines, can't be copied, so S can't be cloned while it holds any. S must not be deleted
+ * before the new state.
+ * Use YASL_resetstate_bb to give the new state source to run.
+ * @param S the YASL_State to clone.
+ * @return the new YASL_State, or NULL if S holds a value that can't be copied.
+ */
+struct YASL_State *YASL_clonestate(struct YASL_State *S);
+
+/*
+ * Threads: states never share anything mutable, so different states may be used on different threads at the same
+ * time, as long as each state is only used by one thread at a time. Builtin method tables are built once per process
+ * and shared read-only by every state, and a YASL_Program (along with its string constants) can be run by states on
+ * any number of threads at once. Strings sent between states by the thread library are shared too, and counted
+ * atomically from then on.
+ */
+
 /**
  * [-0, +0]
  * Returns the bool value of the top of the stack, if it is a boolean.
@@ -335,6 +559,39 @@ yasl_float YASL_peekfloat(struct YASL_State *S);
  */
 yasl_int YASL_peekint(struct YASL_State *S);
 
+/**
+ * [-0, +0]
+ * Copies the floats in the list on top of the stack into values, in one go. Stops after n
+ * of them, or at the first item that isn't a float. Does not modify the stack.
+ * @param S the YASL_State.
+ * @param values where to put the floats.
+ * @param n the most floats to copy.
+ * @return the number of floats copied, or 0 if the top of the stack is not a list.
+ */
+size_t YASL_peeklistfloats(struct YASL_State *S, yasl_float *values, size_t n);
+
+/**
+ * [-0, +0]
+ * Copies the ints in the list on top of the stack into values, in one go. Stops after n
+ * of them, or at the first item that isn't an int. Does not modify the stack.
+ * @param S the YASL_State.
+ * @param values where to put the ints.
+ * @param n the most ints to copy.
+ * @return the number of ints copied, or 0 if the top of the stack is not a list.
+ */
+size_t YASL_peeklistints(struct YASL_State *S, yasl_int *values, size_t n);
+
+/**
+ * [-0, +0]
+ * Reads up to n items of the list on top of the stack into values, in one go. Strings
+ * are borrowed rather than copied (see struct YASL_Value). Does not modify the stack.
+ * @param S the YASL_State.
+ * @param values where to put the items.
+ * @param n the most items to read.
+ * @return the number of items read, or 0 if the top of the stack is not a list.
+ */
+size_t YASL_peeklistvalues(struct YASL_State *S, struct YASL_Value *values, size_t n);
+
 /**
  * [-0, +0]
  * Returns the bool value at index n, if it is a boolean.
@@ -371,6 +628,17 @@ yasl_int YASL_peeknint(struct YASL_State *S, unsigned n);
  */
 void *YASL_peeknuserdata(struct YASL_State *S, unsigned n);
 
+/**
+ * [-0, +0]
+ * Returns the data of the object at index n, if it is an object of the given type.
+ * Otherwise returns NULL. Does not modify the stack.
+ * @param S the YASL_State.
+ * @param type the type of object expected.
+ * @param n the index.
+ * @return the object's data, or NULL if it's not an object of that type.
+ */
+void *YASL_peeknobject(struct YASL_State *S, const struct YASL_Type *type, unsigned n);
+
 /**
  * [-0, +0]
  * returns the type of index n as a string.
@@ -379,6 +647,19 @@ void *YASL_peeknuserdata(struct YASL_State *S, unsigned n);
  */
 const char *YASL_peekntypename(struct YASL_State *S, unsigned n);
 
+/**
+ * [-0, +0]
+ * Reads up to n entries of the table on top of the stack into keys and values, in one go,
+ * in the same order YASL_tablenext visits them. Strings are borrowed rather than copied
+ * (see struct YASL_Value). Does not modify the stack.
+ * @param S the YASL_State.
+ * @param keys where to put the keys.
+ * @param values where to put the values.
+ * @param n the most entries to read.
+ * @return the number of entries read, or 0 if the top of the stack is not a table.
+ */
+size_t YASL_peektablevalues(struct YASL_State *S, struct YASL_Value *keys, struct YASL_Value *values, size_t n);
+
 /**
  * [-0, +0]
  * returns the type of the top of the stack.
@@ -487,6 +768,20 @@ void YASL_pushbool(struct YASL_State *S, bool value);
  */
 void YASL_pushcfunction(struct YASL_State *S, YASL_cfn value, int num_args);
 
+/**
+ * [-0, +1]
+ * Pushes a string with length len onto the stack without copying it. The memory stays
+ * owned by the caller: once YASL no longer needs it, release is called with data, from
+ * whichever thread the state is running on. The memory must not change until then. The
+ * string may have embedded 0s.
+ * @param S the YASL_State.
+ * @param value the string to be pushed onto the stack.
+ * @param len the length of value.
+ * @param release called once value is no longer needed, or NULL if it must simply outlive S.
+ * @param data passed to release.
+ */
+void YASL_pushextstr(struct YASL_State *S, const char *value, size_t len, void (*release)(void *), void *data);
+
 /**
  * [-0, +1]
  * Pushes a double value onto the stack.
@@ -495,6 +790,15 @@ void YASL_pushcfunction(struct YASL_State *S, YASL_cfn value, int num_args);
  */
 void YASL_pushfloat(struct YASL_State *S, yasl_float value);
 
+/**
+ * [-0, +1]
+ * Pushes a list of the n floats in values onto the stack, in one go.
+ * @param S the YASL_State.
+ * @param values the floats to put in the list.
+ * @param n the number of floats.
+ */
+void YASL_pushfloatlist(struct YASL_State *S, const yasl_float *values, size_t n);
+
 /**
  * [-0, +1]
  * Pushes an integer value onto the stack.
@@ -503,6 +807,15 @@ void YASL_pushfloat(struct YASL_State *S, yasl_float value);
  */
 void YASL_pushint(struct YASL_State *S, yasl_int value);
 
+/**
+ * [-0, +1]
+ * Pushes a list of the n ints in values onto the stack, in one go.
+ * @param S the YASL_State.
+ * @param values the ints to put in the list.
+ * @param n the number of ints.
+ */
+void YASL_pushintlist(struct YASL_State *S, const yasl_int *values, size_t n);
+
 /**
  * [-0, +1]
  * Pushes a string with length len onto the stack. YASL makes a copy of the
@@ -530,6 +843,17 @@ void YASL_pushlist(struct YASL_State *S);
  */
 void YASL_pushlit(struct YASL_State *S, const char *value);
 
+/**
+ * [-0, +1]
+ * Pushes a list of the n strings in values onto the stack, in one go. YASL makes a copy
+ * of each string, as for YASL_pushlstr.
+ * @param S the YASL_State.
+ * @param values the strings to put in the list.
+ * @param lens the length of each string, or NULL if they are all nul-terminated.
+ * @param n the number of strings.
+ */
+void YASL_pushstrlist(struct YASL_State *S, const char *const *values, const size_t *lens, size_t n);
+
 /**
  * [-0, +1]
  * Pushes an empty table onto the stack.
@@ -552,6 +876,30 @@ void YASL_pushundef(struct YASL_State *S);
  */
 void YASL_pushuserdata(struct YASL_State *S, void *data, const char *tag, void (*destructor)(void *));
 
+/**
+ * [-0, +1]
+ * Pushes a new object of the given type onto the stack. Its type->size bytes of data are
+ * zeroed, and allocated along with the object itself, so they are freed with it; they
+ * stay at the same address for as long as the object is alive. The object is given the
+ * metatable registered for the type, if there is one, which is found by id rather than
+ * by name after the first time.
+ * @param S the YASL_State.
+ * @param type the type of the object.
+ * @return the object's data.
+ */
+void *YASL_pushobject(struct YASL_State *S, struct YASL_Type *type);
+
+/**
+ * [-0, +1]
+ * Pushes a new object of the given type onto the stack, like YASL_pushobject, but whose
+ * data has already been allocated elsewhere. type->size is ignored, and type->finalizer is
+ * called with data when the object is freed.
+ * @param S the YASL_State.
+ * @param type the type of the object.
+ * @param data the object's data.
+ */
+void YASL_pushobjectptr(struct YASL_State *S, struct YASL_Type *type, void *data);
+
 /**
  * [-0, +1]
  * Pushes a user-pointer onto the stack
@@ -580,6 +928,16 @@ void YASL_pushzstr(struct YASL_State *S, const char *value);
  */
 int YASL_registermt(struct YASL_State *S, const char *name);
 
+/**
+ * [-1, +0]
+ * Registers a metatable for objects of the given type, under type->name, as
+ * YASL_registermt does. Objects pushed with YASL_pushobject after this are given it.
+ * @param S the YASL_State.
+ * @param type the type of object.
+ * @return YASL_SUCCESS.
+ */
+int YASL_registertype(struct YASL_State *S, struct YASL_Type *type);
+
 /**
  * resets S to the same state it would be in if newly created using
  * YASL_newstate.
@@ -3,12 +3,15 @@
 
 int YASLX_decllibs(struct YASL_State *S) {
 	YASL_decllib_collections(S);
+	YASL_decllib_coroutine(S);
 	YASL_decllib_error(S);
 	YASL_decllib_io(S);
+	YASL_decllib_iter(S);
 	YASL_decllib_math(S);
 	YASL_decllib_require(S);
 	YASL_decllib_require_c(S);
 	YASL_decllib_mt(S);
+	YASL_decllib_thread(S);
 
 	return YASL_SUCCESS;
 }
@@ -45,6 +45,19 @@
 // How big the stack is for the YASL VM
 #define STACK_SIZE 1024
 
+// @@ CO_STACK_SIZE
+// How big the stack is for each coroutine to begin with. Smaller than the main stack, so that many coroutines can be
+// alive at once; it grows as needed, up to STACK_SIZE.
+#define CO_STACK_SIZE 256
+
+// @@ CO_NUM_FRAMES
+// How many calls deep each coroutine can go before its frames have to grow, which they do up to the main script's.
+#define CO_NUM_FRAMES 200
+
+// @@ YASL_POLL_INTERVAL
+// How many steps (loop iterations and calls) the VM takes between checks for interrupts, budgets and hooks.
+#define YASL_POLL_INTERVAL 1024
+
 // @@ YASL_PATH_SEP
 // What to use to separate paths.
 #define YASL_PATH_SEP ';'
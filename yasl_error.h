@@ -17,7 +17,12 @@ enum YASL_Error {
 	YASL_TOO_MANY_VAR_ERROR,   // Too many variables in current scope.
 	YASL_PLATFORM_NOT_SUPP,    // Platform specific code not supported for this platform.
 	YASL_ASSERT_ERROR,         // Assertion failed.
-	YASL_STACK_OVERFLOW_ERROR  // Stack overflow happened.
+	YASL_STACK_OVERFLOW_ERROR, // Stack overflow happened.
+	YASL_YIELD,                // Execution was suspended by a yield, and can be continued with YASL_resume.
+	YASL_PREEMPTED,            // Execution ran out of budget and was suspended, see YASL_setbudget.
+	YASL_INTERRUPT_ERROR,      // Execution was stopped by YASL_interrupt.
+	YASL_MEMORY_ERROR,         // Ran out of memory, or went over the limit set by YASL_setmemlimit.
+	YASL_BUDGET_ERROR          // Ran out of budget where execution couldn't be suspended, see YASL_setbudget.
 };
 
 #endif